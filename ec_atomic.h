@@ -0,0 +1,42 @@
+#ifndef EC_ATOMIC_H_
+#define EC_ATOMIC_H_
+
+// Minimal atomics for the few places that need them (lazy contexts, lock-free
+// queues and pools). GCC/Clang builtins need no header and no runtime library;
+// on word-sized operands they compile to plain instructions (LDREX/STREX on
+// Cortex-M, LOCK-prefixed ops on x86).
+// Other compilers get a single-threaded fallback: correct as long as the
+// objects involved are only touched from one thread.
+
+#if defined(__GNUC__) || defined(__clang__)
+
+#define EC_ATOMIC_LOAD_ACQUIRE(p)       __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define EC_ATOMIC_LOAD_RELAXED(p)       __atomic_load_n((p), __ATOMIC_RELAXED)
+#define EC_ATOMIC_STORE_RELEASE(p, v)   __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define EC_ATOMIC_FETCH_ADD(p, v)       __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+// Evaluates to non-zero on success; *expected_ptr is updated on failure.
+#define EC_ATOMIC_CAS(p, expected_ptr, desired) \
+	__atomic_compare_exchange_n((p), (expected_ptr), (desired), 0, \
+			__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define EC_ATOMIC_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define EC_ATOMIC_PAUSE() __asm__ __volatile__("yield")
+#else
+#define EC_ATOMIC_PAUSE() ((void)0)
+#endif
+
+#else
+
+#define EC_ATOMIC_LOAD_ACQUIRE(p)       (*(p))
+#define EC_ATOMIC_LOAD_RELAXED(p)       (*(p))
+#define EC_ATOMIC_STORE_RELEASE(p, v)   ((void)(*(p) = (v)))
+#define EC_ATOMIC_FETCH_ADD(p, v)       ((*(p) += (v)) - (v))
+#define EC_ATOMIC_CAS(p, expected_ptr, desired) \
+	((*(p) == *(expected_ptr)) ? (*(p) = (desired), 1) : (*(expected_ptr) = *(p), 0))
+#define EC_ATOMIC_PAUSE() ((void)0)
+
+#endif
+
+#endif /* EC_ATOMIC_H_ */
@@ -0,0 +1,14 @@
+#include "ec_crc32.h"
+
+unsigned int ec_crc32_update(unsigned int crc, const unsigned char *in, unsigned long bytelen) {
+	for (unsigned long i = 0; i < bytelen; ++i) {
+		crc ^= in[i];
+		for (int bit = 0; bit < 8; ++bit)
+			crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+	}
+	return crc;
+}
+
+unsigned int ec_crc32(const unsigned char *in, unsigned long bytelen) {
+	return ~ec_crc32_update(0xFFFFFFFFU, in, bytelen);
+}
@@ -0,0 +1,13 @@
+#ifndef EC_CRC32_H_
+#define EC_CRC32_H_
+
+// CRC-32 (IEEE 802.3, reflected), shared by the table and tuning files.
+// Bitwise: files are checked once per load, a 1 KB table is not worth it.
+
+// Chains over several buffers: start with 0xFFFFFFFF, complement the result.
+unsigned int ec_crc32_update(unsigned int crc, const unsigned char *in, unsigned long bytelen);
+
+// ~ec_crc32_update(0xFFFFFFFF, in, bytelen)
+unsigned int ec_crc32(const unsigned char *in, unsigned long bytelen);
+
+#endif /* EC_CRC32_H_ */
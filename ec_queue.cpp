@@ -0,0 +1,99 @@
+#include "ec_queue.h"
+#include "ec_atomic.h"
+
+static int queue_capacity_valid(unsigned long capacity) {
+	return capacity >= 2 && (capacity & (capacity - 1)) == 0;
+}
+
+int ec_spsc_queue_init(EcSpscQueue *q, void **slots, unsigned long capacity) {
+	if (!queue_capacity_valid(capacity))
+		return 0;
+	q->slots = slots;
+	q->mask = capacity - 1;
+	q->head = 0;
+	q->tail = 0;
+	return 1;
+}
+
+int ec_spsc_queue_push(EcSpscQueue *q, void *item) {
+	unsigned long tail = EC_ATOMIC_LOAD_RELAXED(&q->tail);
+	if (tail - EC_ATOMIC_LOAD_ACQUIRE(&q->head) > q->mask)
+		return 0;
+	q->slots[tail & q->mask] = item;
+	EC_ATOMIC_STORE_RELEASE(&q->tail, tail + 1);
+	return 1;
+}
+
+void* ec_spsc_queue_pop(EcSpscQueue *q) {
+	unsigned long head = EC_ATOMIC_LOAD_RELAXED(&q->head);
+	if (head == EC_ATOMIC_LOAD_ACQUIRE(&q->tail))
+		return 0;
+	void *item = q->slots[head & q->mask];
+	EC_ATOMIC_STORE_RELEASE(&q->head, head + 1);
+	return item;
+}
+
+unsigned long ec_spsc_queue_size(const EcSpscQueue *q) {
+	unsigned long head = EC_ATOMIC_LOAD_ACQUIRE(&q->head);
+	return EC_ATOMIC_LOAD_ACQUIRE(&q->tail) - head;
+}
+
+int ec_mpmc_queue_init(EcMpmcQueue *q, EcMpmcSlot *slots, unsigned long capacity) {
+	if (!queue_capacity_valid(capacity))
+		return 0;
+	q->slots = slots;
+	q->mask = capacity - 1;
+	for (unsigned long i = 0; i < capacity; ++i) {
+		slots[i].sequence = i;
+		slots[i].item = 0;
+	}
+	q->head = 0;
+	q->tail = 0;
+	return 1;
+}
+
+// A slot at position pos is free for the producer of lap pos when its
+// sequence is pos, and holds that producer's item when it is pos + 1.
+int ec_mpmc_queue_push(EcMpmcQueue *q, void *item) {
+	unsigned long pos = EC_ATOMIC_LOAD_RELAXED(&q->tail);
+	for (;;) {
+		EcMpmcSlot *slot = &q->slots[pos & q->mask];
+		long diff = (long) (EC_ATOMIC_LOAD_ACQUIRE(&slot->sequence) - pos);
+		if (diff == 0) {
+			if (EC_ATOMIC_CAS(&q->tail, &pos, pos + 1)) {
+				slot->item = item;
+				EC_ATOMIC_STORE_RELEASE(&slot->sequence, pos + 1);
+				return 1;
+			}
+		} else if (diff < 0) {
+			return 0;                       // full: the slot is a lap behind
+		} else {
+			pos = EC_ATOMIC_LOAD_RELAXED(&q->tail);
+		}
+	}
+}
+
+void* ec_mpmc_queue_pop(EcMpmcQueue *q) {
+	unsigned long pos = EC_ATOMIC_LOAD_RELAXED(&q->head);
+	for (;;) {
+		EcMpmcSlot *slot = &q->slots[pos & q->mask];
+		long diff = (long) (EC_ATOMIC_LOAD_ACQUIRE(&slot->sequence) - (pos + 1));
+		if (diff == 0) {
+			if (EC_ATOMIC_CAS(&q->head, &pos, pos + 1)) {
+				void *item = slot->item;
+				EC_ATOMIC_STORE_RELEASE(&slot->sequence, pos + q->mask + 1);
+				return item;
+			}
+		} else if (diff < 0) {
+			return 0;                       // empty
+		} else {
+			pos = EC_ATOMIC_LOAD_RELAXED(&q->head);
+		}
+	}
+}
+
+unsigned long ec_mpmc_queue_size(const EcMpmcQueue *q) {
+	unsigned long head = EC_ATOMIC_LOAD_ACQUIRE(&q->head);
+	unsigned long tail = EC_ATOMIC_LOAD_ACQUIRE(&q->tail);
+	return (tail > head) ? tail - head : 0;
+}
@@ -0,0 +1,47 @@
+#ifndef EC_QUEUE_H_
+#define EC_QUEUE_H_
+
+// Bounded lock-free queues of pointers over caller-supplied slot arrays.
+// Capacities must be powers of two. Neither queue blocks: push fails when the
+// queue is full and pop when it is empty, the caller decides whether to spin,
+// yield or shed load.
+//
+//  - EcSpscQueue: one producer thread and one consumer thread, a ring with
+//    two indices.
+//  - EcMpmcQueue: any number of producers and consumers (D. Vyukov's bounded
+//    queue); every slot carries a sequence number telling whether it is
+//    ready to be written or read in the current lap.
+
+typedef struct {
+	void **slots;
+	unsigned long mask;                     // capacity - 1
+	alignas(64) unsigned long head;         // next slot to pop
+	alignas(64) unsigned long tail;         // next slot to push
+}EcSpscQueue;
+
+typedef struct {
+	unsigned long sequence;
+	void *item;
+}EcMpmcSlot;
+
+typedef struct {
+	EcMpmcSlot *slots;
+	unsigned long mask;
+	alignas(64) unsigned long head;
+	alignas(64) unsigned long tail;
+}EcMpmcQueue;
+
+// Return 0 if capacity is not a power of two (>= 2).
+int ec_spsc_queue_init(EcSpscQueue *q, void **slots, unsigned long capacity);
+int ec_spsc_queue_push(EcSpscQueue *q, void *item);
+void* ec_spsc_queue_pop(EcSpscQueue *q);
+// Items queued right now; exact for the producer and the consumer, a
+// snapshot for anyone else.
+unsigned long ec_spsc_queue_size(const EcSpscQueue *q);
+
+int ec_mpmc_queue_init(EcMpmcQueue *q, EcMpmcSlot *slots, unsigned long capacity);
+int ec_mpmc_queue_push(EcMpmcQueue *q, void *item);
+void* ec_mpmc_queue_pop(EcMpmcQueue *q);
+unsigned long ec_mpmc_queue_size(const EcMpmcQueue *q);
+
+#endif /* EC_QUEUE_H_ */
@@ -0,0 +1,109 @@
+#ifndef EC_TEST_UTIL_H_
+#define EC_TEST_UTIL_H_
+
+#include <chrono>
+#include "elliptic_curve.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+
+// Fixture shared by the *_test.cpp files. Everything is static, so each test
+// file gets its own copy and its own random sequence; define
+// EC_TEST_RNG_SEED before the include to pick the sequence.
+
+#ifndef EC_TEST_RNG_SEED
+#define EC_TEST_RNG_SEED (0x2545F491UL)
+#endif
+
+// LCG, reproducible across runs and platforms
+static inline unsigned char ec_test_random_byte() {
+	static unsigned long state = EC_TEST_RNG_SEED;
+	state = state * 1103515245UL + 12345UL;
+	return (unsigned char) (state >> 16);
+}
+
+// Random field element, bits at and above degree cleared
+static inline void ec_test_random_element(unsigned char *out, unsigned long bytelen,
+		long degree) {
+	for (unsigned long i = 0; i < bytelen; ++i)
+		out[i] = ec_test_random_byte();
+	for (unsigned long bit = (unsigned long) degree; bit < bytelen * 8; ++bit)
+		out[bit >> 3] &= (unsigned char) ~(1U << (bit & 7));
+}
+
+// Random private key below the group order (top byte zero)
+static inline void ec_test_random_key(const EllipticCurve *curve, unsigned char *key) {
+	unsigned long len = curve->field_size_bytes;
+	for (unsigned long i = 0; i < len; ++i)
+		key[i] = (i + 1 < len) ? ec_test_random_byte() : 0;
+}
+
+static inline int ec_test_bytes_equal(const unsigned char *a, const unsigned char *b,
+		unsigned long bytelen) {
+	unsigned char diff = 0;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		diff |= a[i] ^ b[i];
+	return diff == 0;
+}
+
+static inline int ec_test_points_equal(const EllipticCurve *curve,
+		const EllipticCurvePoint *p, const EllipticCurvePoint *q) {
+	return ec_test_bytes_equal(p->point_mem, q->point_mem,
+			elliptic_curve_point_get_coord_full_bytelen(curve));
+}
+
+static inline void ec_test_load_base(const EllipticCurve *curve, EllipticCurvePoint *G) {
+	for (unsigned long i = 0; i < curve->field_size_bytes; ++i) {
+		elliptic_curve_point_get_coord_x(curve, G)[i] = curve->xG[i];
+		elliptic_curve_point_get_coord_y(curve, G)[i] = curve->yG[i];
+	}
+}
+
+// Registry curve with an acceleration context: the registry's own with
+// EC_REGISTRY_CONTEXTS, else a copy with a context owned by the test file
+static inline const EllipticCurve* ec_test_registry_curve(unsigned long index) {
+	static EllipticCurve copies[EC_REGISTRY_MAX_CURVES];
+	static EllipticCurveContext contexts[EC_REGISTRY_MAX_CURVES];
+	const EllipticCurve *curve = elliptic_curve_registry_get(index)->curve;
+	if (curve->context)
+		return curve;
+	if (!copies[index].context) {
+		copies[index] = *curve;
+		elliptic_curve_attach_context(&copies[index], &contexts[index]);
+	}
+	return &copies[index];
+}
+
+static inline unsigned int ec_test_hex_digit(char c) {
+	return (unsigned int) ((c >= 'a') ? c - 'a' + 10 : (c >= 'A') ? c - 'A' + 10 : c - '0');
+}
+
+// Hex digit pairs to bytes in the order written, returns the byte count
+static inline unsigned long ec_test_hex(const char *hex, unsigned char *out) {
+	unsigned long n = 0;
+	for (; hex[0] && hex[1]; hex += 2)
+		out[n++] = (unsigned char) (16 * ec_test_hex_digit(hex[0]) + ec_test_hex_digit(hex[1]));
+	return n;
+}
+
+// Hex number (any digit count) to an LSB-first vector, out[0] from the last
+// two digits. Clears bytelen bytes of out first; returns the bytes the
+// digits fill.
+static inline unsigned long ec_test_hex_lsb(const char *hex, unsigned char *out,
+		unsigned long bytelen) {
+	unsigned long n = 0;
+	while (hex[n])
+		++n;
+	unsigned long filled = (n + 1) / 2;
+	for (unsigned long i = 0; i < filled || i < bytelen; ++i)
+		out[i] = 0;
+	for (unsigned long i = 0; i < n; ++i)
+		out[i / 2] |= (unsigned char) (ec_test_hex_digit(hex[n - 1 - i]) << (4 * (i % 2)));
+	return filled;
+}
+
+static inline double ec_test_microseconds(std::chrono::steady_clock::time_point t0,
+		std::chrono::steady_clock::time_point t1, int runs) {
+	return std::chrono::duration<double, std::micro>(t1 - t0).count() / runs;
+}
+
+#endif /* EC_TEST_UTIL_H_ */
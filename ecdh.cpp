@@ -1,21 +1,16 @@
 #include "ecdh.h"
 
-void ecdh_generate_public_key(EllipticCurve *curve,
+void ecdh_generate_public_key(const EllipticCurve *curve,
 		unsigned char *in_private_key, unsigned char *out_public_key) {
-	EllipticCurvePoint base_point = { 0 };
-	unsigned char *base_x = elliptic_curve_point_get_coord_x(curve,
-			&base_point);
-	unsigned char *base_y = elliptic_curve_point_get_coord_y(curve,
-			&base_point);
-	for (unsigned long i = 0; i < curve->field_size_bytes; i++) {
-		base_x[i] = curve->xG[i];
-		base_y[i] = curve->yG[i];
-	}
-	elliptic_curve_binary_point_multiply(curve,
-			(EllipticCurvePoint*) out_public_key, &base_point, in_private_key,
+#if ECDH_CONSTANT_TIME
+	ecdh_generate_public_key_ct(curve, in_private_key, out_public_key);
+#else
+	elliptic_curve_binary_point_multiply_base(curve,
+			(EllipticCurvePoint*) out_public_key, in_private_key,
 			curve->field_size_bytes);
+#endif
 }
-int ecdh_public_key_verify(EllipticCurve *curve, unsigned char *public_key) {
+int ecdh_public_key_verify(const EllipticCurve *curve, unsigned char *public_key) {
 	unsigned long len = curve->field_size_bytes;
 	unsigned char *pk_x = elliptic_curve_point_get_coord_x(curve,
 			(EllipticCurvePoint*) public_key);
@@ -57,9 +52,13 @@ int ecdh_public_key_verify(EllipticCurve *curve, unsigned char *public_key) {
 		return 0; //multiplication by base order didn't yield zero
 	return 1;
 }
-void ecdh_generate_shared_secret(EllipticCurve *curve,
+void ecdh_generate_shared_secret(const EllipticCurve *curve,
 		unsigned char *in_private_key, unsigned char *in_public_key,
 		unsigned char *out_shared_secret) {
+#if ECDH_CONSTANT_TIME
+	ecdh_generate_shared_secret_ct(curve, in_private_key, in_public_key,
+			out_shared_secret);
+#else
 	EllipticCurvePoint *in_public_key_point =
 			(EllipticCurvePoint*) in_public_key;
 	EllipticCurvePoint output_shared_secret = { 0 };
@@ -69,4 +68,27 @@ void ecdh_generate_shared_secret(EllipticCurve *curve,
 	for (unsigned long i = 0; i < len; i++) {
 		out_shared_secret[i] = output_shared_secret.point_mem[i];
 	}
+#endif
+}
+void ecdh_generate_public_key_ct(const EllipticCurve *curve,
+		unsigned char *in_private_key, unsigned char *out_public_key) {
+	elliptic_curve_binary_point_multiply_base_ct(curve,
+			(EllipticCurvePoint*) out_public_key, in_private_key,
+			curve->field_size_bytes);
+}
+void ecdh_generate_shared_secret_ct(const EllipticCurve *curve,
+		unsigned char *in_private_key, unsigned char *in_public_key,
+		unsigned char *out_shared_secret) {
+	EllipticCurvePoint output_shared_secret = { 0 };
+	elliptic_curve_binary_point_multiply_ct(curve, &output_shared_secret,
+			(EllipticCurvePoint*) in_public_key, in_private_key,
+			curve->field_size_bytes);
+	unsigned long len = curve->field_size_bytes;
+	for (unsigned long i = 0; i < len; i++) {
+		out_shared_secret[i] = output_shared_secret.point_mem[i];
+	}
+	// do not leave the shared point behind on the stack
+	for (unsigned long i = 0; i < sizeof(output_shared_secret.point_mem); i++) {
+		((volatile unsigned char*) output_shared_secret.point_mem)[i] = 0;
+	}
 }
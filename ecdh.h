@@ -3,13 +3,30 @@
 
 #include "elliptic_curve.h"
 
-void ecdh_generate_public_key(EllipticCurve *curve,
+// Build-wide constant-time mode: when non-zero, ecdh_generate_public_key and
+// ecdh_generate_shared_secret run the regular-execution Montgomery ladder
+// (elliptic_curve_binary_point_multiply_ct) instead of the faster
+// variable-time paths. The *_ct functions below are always available and can
+// be used per call regardless of this setting.
+#ifndef ECDH_CONSTANT_TIME
+#define ECDH_CONSTANT_TIME (0)
+#endif
+
+void ecdh_generate_public_key(const EllipticCurve *curve,
+		unsigned char *in_private_key, unsigned char *out_public_key);
+int ecdh_public_key_verify(const EllipticCurve *curve, unsigned char *public_key);
+void ecdh_generate_shared_secret(const EllipticCurve *curve,
+		unsigned char *in_private_key, unsigned char *in_public_key,
+		unsigned char *out_shared_secret);
+
+void ecdh_generate_public_key_ct(const EllipticCurve *curve,
 		unsigned char *in_private_key, unsigned char *out_public_key);
-int ecdh_public_key_verify(EllipticCurve *curve, unsigned char *public_key);
-void ecdh_generate_shared_secret(EllipticCurve *curve,
+void ecdh_generate_shared_secret_ct(const EllipticCurve *curve,
 		unsigned char *in_private_key, unsigned char *in_public_key,
 		unsigned char *out_shared_secret);
 
+// One session's key material, sized for the largest curve. Servers holding
+// many sessions can use the denser ecdh_session.h store instead.
 typedef struct
 	alignas(8) {
 		alignas(8) unsigned char private_key[GF2_VECTOR_MAX_BYTELEN];
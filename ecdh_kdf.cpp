@@ -0,0 +1,469 @@
+#include "ecdh_kdf.h"
+#include "elliptic_curve_batch.h"
+
+static const unsigned int sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const unsigned int sha256_h0[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#define SHA256_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define SHA256_S0(x) (SHA256_ROTR(x, 2) ^ SHA256_ROTR(x, 13) ^ SHA256_ROTR(x, 22))
+#define SHA256_S1(x) (SHA256_ROTR(x, 6) ^ SHA256_ROTR(x, 11) ^ SHA256_ROTR(x, 25))
+#define SHA256_s0(x) (SHA256_ROTR(x, 7) ^ SHA256_ROTR(x, 18) ^ ((x) >> 3))
+#define SHA256_s1(x) (SHA256_ROTR(x, 17) ^ SHA256_ROTR(x, 19) ^ ((x) >> 10))
+
+static void kdf_wipe(void *p, unsigned long bytelen) {
+	volatile unsigned char *raw = (volatile unsigned char*) p;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		raw[i] = 0;
+}
+
+static unsigned int sha256_load_be(const unsigned char *in) {
+	return ((unsigned int) in[0] << 24) | ((unsigned int) in[1] << 16)
+			| ((unsigned int) in[2] << 8) | (unsigned int) in[3];
+}
+
+static void sha256_compress(unsigned int *state, const unsigned char *block) {
+	unsigned int w[64];
+	unsigned int v[8];
+
+	for (int t = 0; t < 16; ++t)
+		w[t] = sha256_load_be(block + 4 * t);
+	for (int t = 16; t < 64; ++t)
+		w[t] = SHA256_s1(w[t - 2]) + w[t - 7] + SHA256_s0(w[t - 15]) + w[t - 16];
+	for (int i = 0; i < 8; ++i)
+		v[i] = state[i];
+	for (int t = 0; t < 64; ++t) {
+		unsigned int t1 = v[7] + SHA256_S1(v[4]) + ((v[4] & v[5]) ^ (~v[4] & v[6]))
+				+ sha256_k[t] + w[t];
+		unsigned int t2 = SHA256_S0(v[0]) + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+		v[7] = v[6];
+		v[6] = v[5];
+		v[5] = v[4];
+		v[4] = v[3] + t1;
+		v[3] = v[2];
+		v[2] = v[1];
+		v[1] = v[0];
+		v[0] = t1 + t2;
+	}
+	for (int i = 0; i < 8; ++i)
+		state[i] += v[i];
+	kdf_wipe(w, sizeof(w));
+}
+
+void ecdh_sha256_init(EcdhSha256 *ctx) {
+	for (int i = 0; i < 8; ++i)
+		ctx->state[i] = sha256_h0[i];
+	ctx->bytelen = 0;
+}
+
+void ecdh_sha256_update(EcdhSha256 *ctx, const unsigned char *in, unsigned long bytelen) {
+	for (unsigned long i = 0; i < bytelen; ++i) {
+		unsigned long pos = (unsigned long) (ctx->bytelen++ & 63);
+		ctx->block[pos] = in[i];
+		if (pos == 63)
+			sha256_compress(ctx->state, ctx->block);
+	}
+}
+
+void ecdh_sha256_final(EcdhSha256 *ctx, unsigned char *out) {
+	unsigned long long bits = ctx->bytelen * 8;
+	unsigned char pad = 0x80;
+	ecdh_sha256_update(ctx, &pad, 1);
+	pad = 0;
+	while ((ctx->bytelen & 63) != 56)
+		ecdh_sha256_update(ctx, &pad, 1);
+	unsigned char length[8];
+	for (int i = 0; i < 8; ++i)
+		length[i] = (unsigned char) (bits >> (56 - 8 * i));
+	ecdh_sha256_update(ctx, length, 8);
+	for (int i = 0; i < 32; ++i)
+		out[i] = (unsigned char) (ctx->state[i >> 2] >> (24 - 8 * (i & 3)));
+	kdf_wipe(ctx, sizeof(EcdhSha256));
+}
+
+void ecdh_sha256(const unsigned char *in, unsigned long bytelen, unsigned char *out) {
+	EcdhSha256 ctx;
+	ecdh_sha256_init(&ctx);
+	ecdh_sha256_update(&ctx, in, bytelen);
+	ecdh_sha256_final(&ctx, out);
+}
+
+// Multi-buffer SHA-256: ECDH_KDF_LANES messages of equal length hashed in
+// lock step. The working variables are arrays over the lanes, so every
+// step of a round is one loop the vectorizer can turn into SIMD operations;
+// a single active lane takes the scalar compression instead.
+typedef struct alignas(8){
+	unsigned int state[8][ECDH_KDF_LANES];
+	unsigned char block[ECDH_KDF_LANES][ECDH_SHA256_BLOCK_BYTELEN];
+	unsigned long long bytelen;             // the same in every lane
+	unsigned long lanes;                    // active lanes
+}KdfSha256Lanes;
+
+static void kdf_lanes_compress(KdfSha256Lanes *h) {
+	if (h->lanes == 1) {
+		unsigned int state[8];
+		for (int i = 0; i < 8; ++i)
+			state[i] = h->state[i][0];
+		sha256_compress(state, h->block[0]);
+		for (int i = 0; i < 8; ++i)
+			h->state[i][0] = state[i];
+		return;
+	}
+
+	unsigned int w[64][ECDH_KDF_LANES];
+	unsigned int v[8][ECDH_KDF_LANES];
+	for (int t = 0; t < 16; ++t)
+		for (int l = 0; l < ECDH_KDF_LANES; ++l)
+			w[t][l] = sha256_load_be(h->block[l] + 4 * t);
+	for (int t = 16; t < 64; ++t)
+		for (int l = 0; l < ECDH_KDF_LANES; ++l)
+			w[t][l] = SHA256_s1(w[t - 2][l]) + w[t - 7][l] + SHA256_s0(w[t - 15][l]) + w[t - 16][l];
+	for (int i = 0; i < 8; ++i)
+		for (int l = 0; l < ECDH_KDF_LANES; ++l)
+			v[i][l] = h->state[i][l];
+	for (int t = 0; t < 64; ++t) {
+		for (int l = 0; l < ECDH_KDF_LANES; ++l) {
+			unsigned int e = v[4][l];
+			unsigned int a = v[0][l];
+			unsigned int t1 = v[7][l] + SHA256_S1(e) + ((e & v[5][l]) ^ (~e & v[6][l]))
+					+ sha256_k[t] + w[t][l];
+			unsigned int t2 = SHA256_S0(a) + ((a & v[1][l]) ^ (a & v[2][l]) ^ (v[1][l] & v[2][l]));
+			v[7][l] = v[6][l];
+			v[6][l] = v[5][l];
+			v[5][l] = e;
+			v[4][l] = v[3][l] + t1;
+			v[3][l] = v[2][l];
+			v[2][l] = v[1][l];
+			v[1][l] = a;
+			v[0][l] = t1 + t2;
+		}
+	}
+	for (int i = 0; i < 8; ++i)
+		for (int l = 0; l < ECDH_KDF_LANES; ++l)
+			h->state[i][l] += v[i][l];
+	kdf_wipe(w, sizeof(w));
+	kdf_wipe(v, sizeof(v));
+}
+
+static void kdf_lanes_init(KdfSha256Lanes *h, unsigned long lanes) {
+	for (int i = 0; i < 8; ++i)
+		for (int l = 0; l < ECDH_KDF_LANES; ++l)
+			h->state[i][l] = sha256_h0[i];
+	// idle lanes run along on zeros
+	for (unsigned long l = lanes; l < ECDH_KDF_LANES; ++l)
+		for (int i = 0; i < ECDH_SHA256_BLOCK_BYTELEN; ++i)
+			h->block[l][i] = 0;
+	h->bytelen = 0;
+	h->lanes = lanes;
+}
+
+// Appends bytelen bytes to every lane, in[l][0 ..] or, reversed, in[l][bytelen - 1]
+// down to in[l][0] (a field element's LSB-first bytes read as big endian)
+static void kdf_lanes_update(KdfSha256Lanes *h, const unsigned char *const *in,
+		unsigned long bytelen, int reversed) {
+	unsigned long done = 0;
+	while (done < bytelen) {
+		unsigned long pos = (unsigned long) (h->bytelen & 63);
+		unsigned long take = 64 - pos;
+		if (take > bytelen - done)
+			take = bytelen - done;
+		for (unsigned long l = 0; l < h->lanes; ++l) {
+			for (unsigned long i = 0; i < take; ++i)
+				h->block[l][pos + i] = reversed ? in[l][bytelen - 1 - done - i] : in[l][done + i];
+		}
+		h->bytelen += take;
+		done += take;
+		if (pos + take == 64)
+			kdf_lanes_compress(h);
+	}
+}
+
+static void kdf_lanes_update_common(KdfSha256Lanes *h, const unsigned char *in,
+		unsigned long bytelen) {
+	const unsigned char *same[ECDH_KDF_LANES];
+	for (int l = 0; l < ECDH_KDF_LANES; ++l)
+		same[l] = in;
+	kdf_lanes_update(h, same, bytelen, 0);
+}
+
+static void kdf_lanes_final(KdfSha256Lanes *h, unsigned char (*out)[ECDH_SHA256_BYTELEN]) {
+	unsigned long long bits = h->bytelen * 8;
+	unsigned char pad[ECDH_SHA256_BLOCK_BYTELEN + 8] = { 0x80 };
+	unsigned long pad_bytelen = (unsigned long) ((119 - (h->bytelen & 63)) & 63) + 1;
+	for (int i = 0; i < 8; ++i)
+		pad[pad_bytelen + i] = (unsigned char) (bits >> (56 - 8 * i));
+	kdf_lanes_update_common(h, pad, pad_bytelen + 8);
+	for (unsigned long l = 0; l < h->lanes; ++l)
+		for (int i = 0; i < 32; ++i)
+			out[l][i] = (unsigned char) (h->state[i >> 2][l] >> (24 - 8 * (i & 3)));
+	kdf_wipe(h, sizeof(KdfSha256Lanes));
+}
+
+// HMAC-SHA256 in lanes, keys of at most one block: begin absorbs
+// key ^ ipad, the caller the message, end the outer hash
+static void kdf_hmac_begin(KdfSha256Lanes *h, unsigned long lanes,
+		const unsigned char *const *key, unsigned long key_bytelen) {
+	unsigned char pad[ECDH_KDF_LANES][ECDH_SHA256_BLOCK_BYTELEN];
+	const unsigned char *pads[ECDH_KDF_LANES];
+	for (unsigned long l = 0; l < lanes; ++l) {
+		for (unsigned long i = 0; i < ECDH_SHA256_BLOCK_BYTELEN; ++i)
+			pad[l][i] = (unsigned char) ((i < key_bytelen ? key[l][i] : 0) ^ 0x36);
+		pads[l] = pad[l];
+	}
+	kdf_lanes_init(h, lanes);
+	kdf_lanes_update(h, pads, ECDH_SHA256_BLOCK_BYTELEN, 0);
+	kdf_wipe(pad, sizeof(pad));
+}
+
+static void kdf_hmac_end(KdfSha256Lanes *h, const unsigned char *const *key,
+		unsigned long key_bytelen, unsigned char (*out)[ECDH_SHA256_BYTELEN]) {
+	unsigned long lanes = h->lanes;
+	unsigned char inner[ECDH_KDF_LANES][ECDH_SHA256_BYTELEN];
+	unsigned char pad[ECDH_KDF_LANES][ECDH_SHA256_BLOCK_BYTELEN];
+	const unsigned char *ptrs[ECDH_KDF_LANES] = { 0 };
+	kdf_lanes_final(h, inner);
+	for (unsigned long l = 0; l < lanes; ++l) {
+		for (unsigned long i = 0; i < ECDH_SHA256_BLOCK_BYTELEN; ++i)
+			pad[l][i] = (unsigned char) ((i < key_bytelen ? key[l][i] : 0) ^ 0x5c);
+		ptrs[l] = pad[l];
+	}
+	kdf_lanes_init(h, lanes);
+	kdf_lanes_update(h, ptrs, ECDH_SHA256_BLOCK_BYTELEN, 0);
+	for (unsigned long l = 0; l < lanes; ++l)
+		ptrs[l] = inner[l];
+	kdf_lanes_update(h, ptrs, ECDH_SHA256_BYTELEN, 0);
+	kdf_lanes_final(h, out);
+	kdf_wipe(inner, sizeof(inner));
+	kdf_wipe(pad, sizeof(pad));
+}
+
+static int kdf_out_bytelen_valid(int kdf, unsigned long out_bytelen) {
+	if (kdf == ECDH_KDF_X963_SHA256)
+		return out_bytelen / ECDH_SHA256_BYTELEN < 0xFFFFFFFFUL;
+	if (kdf == ECDH_KDF_HKDF_SHA256)
+		return out_bytelen <= ECDH_HKDF_MAX_BYTELEN;
+	return 0;
+}
+
+// X9.63: block i = SHA-256(Z || i as 4 bytes big endian || SharedInfo), i = 1, 2, ...
+static void kdf_x963_lanes(unsigned long lanes, const unsigned char *const *z,
+		unsigned long z_bytelen, int z_reversed,
+		const unsigned char *info, unsigned long info_bytelen,
+		unsigned char *const *out, unsigned long out_bytelen) {
+	KdfSha256Lanes h;
+	unsigned char digest[ECDH_KDF_LANES][ECDH_SHA256_BYTELEN];
+	unsigned long counter = 1;
+	for (unsigned long done = 0; done < out_bytelen; done += ECDH_SHA256_BYTELEN, ++counter) {
+		unsigned char count_be[4] = { (unsigned char) (counter >> 24), (unsigned char) (counter >> 16),
+				(unsigned char) (counter >> 8), (unsigned char) counter };
+		kdf_lanes_init(&h, lanes);
+		kdf_lanes_update(&h, z, z_bytelen, z_reversed);
+		kdf_lanes_update_common(&h, count_be, 4);
+		kdf_lanes_update_common(&h, info, info_bytelen);
+		kdf_lanes_final(&h, digest);
+		unsigned long take = out_bytelen - done;
+		if (take > ECDH_SHA256_BYTELEN)
+			take = ECDH_SHA256_BYTELEN;
+		for (unsigned long l = 0; l < lanes; ++l)
+			for (unsigned long i = 0; i < take; ++i)
+				out[l][done + i] = digest[l][i];
+	}
+	kdf_wipe(digest, sizeof(digest));
+}
+
+// HKDF: PRK = HMAC(salt, Z), T(i) = HMAC(PRK, T(i - 1) || info || i)
+static void kdf_hkdf_lanes(unsigned long lanes, const unsigned char *const *z,
+		unsigned long z_bytelen, int z_reversed,
+		const unsigned char *salt, unsigned long salt_bytelen,
+		const unsigned char *info, unsigned long info_bytelen,
+		unsigned char *const *out, unsigned long out_bytelen) {
+	KdfSha256Lanes h;
+	unsigned char salt_hash[ECDH_SHA256_BYTELEN];
+	unsigned char prk[ECDH_KDF_LANES][ECDH_SHA256_BYTELEN];
+	unsigned char t[ECDH_KDF_LANES][ECDH_SHA256_BYTELEN];
+	const unsigned char *keys[ECDH_KDF_LANES] = { 0 };
+	const unsigned char *prev[ECDH_KDF_LANES] = { 0 };
+
+	// Longer keys are hashed first; an empty salt is HashLen zeros, which
+	// pads to the same block
+	if (salt_bytelen > ECDH_SHA256_BLOCK_BYTELEN) {
+		ecdh_sha256(salt, salt_bytelen, salt_hash);
+		salt = salt_hash;
+		salt_bytelen = ECDH_SHA256_BYTELEN;
+	}
+	for (unsigned long l = 0; l < lanes; ++l)
+		keys[l] = salt;
+	kdf_hmac_begin(&h, lanes, keys, salt_bytelen);
+	kdf_lanes_update(&h, z, z_bytelen, z_reversed);
+	kdf_hmac_end(&h, keys, salt_bytelen, prk);
+
+	for (unsigned long l = 0; l < lanes; ++l) {
+		keys[l] = prk[l];
+		prev[l] = t[l];
+	}
+	unsigned char counter = 1;
+	for (unsigned long done = 0; done < out_bytelen; done += ECDH_SHA256_BYTELEN, ++counter) {
+		kdf_hmac_begin(&h, lanes, keys, ECDH_SHA256_BYTELEN);
+		if (done)
+			kdf_lanes_update(&h, prev, ECDH_SHA256_BYTELEN, 0);
+		kdf_lanes_update_common(&h, info, info_bytelen);
+		kdf_lanes_update_common(&h, &counter, 1);
+		kdf_hmac_end(&h, keys, ECDH_SHA256_BYTELEN, t);
+		unsigned long take = out_bytelen - done;
+		if (take > ECDH_SHA256_BYTELEN)
+			take = ECDH_SHA256_BYTELEN;
+		for (unsigned long l = 0; l < lanes; ++l)
+			for (unsigned long i = 0; i < take; ++i)
+				out[l][done + i] = t[l][i];
+	}
+	kdf_wipe(prk, sizeof(prk));
+	kdf_wipe(t, sizeof(t));
+}
+
+static void kdf_lanes(int kdf, unsigned long lanes, const unsigned char *const *z,
+		unsigned long z_bytelen, int z_reversed,
+		const unsigned char *salt, unsigned long salt_bytelen,
+		const unsigned char *info, unsigned long info_bytelen,
+		unsigned char *const *out, unsigned long out_bytelen) {
+	if (kdf == ECDH_KDF_X963_SHA256)
+		kdf_x963_lanes(lanes, z, z_bytelen, z_reversed, info, info_bytelen, out, out_bytelen);
+	else
+		kdf_hkdf_lanes(lanes, z, z_bytelen, z_reversed, salt, salt_bytelen,
+				info, info_bytelen, out, out_bytelen);
+}
+
+int ecdh_x963_kdf_sha256(const unsigned char *z, unsigned long z_bytelen,
+		const unsigned char *shared_info, unsigned long shared_info_bytelen,
+		unsigned char *out, unsigned long out_bytelen) {
+	if (!kdf_out_bytelen_valid(ECDH_KDF_X963_SHA256, out_bytelen))
+		return 0;
+	kdf_x963_lanes(1, &z, z_bytelen, 0, shared_info, shared_info_bytelen, &out, out_bytelen);
+	return 1;
+}
+
+int ecdh_hkdf_sha256(const unsigned char *ikm, unsigned long ikm_bytelen,
+		const unsigned char *salt, unsigned long salt_bytelen,
+		const unsigned char *info, unsigned long info_bytelen,
+		unsigned char *out, unsigned long out_bytelen) {
+	if (!kdf_out_bytelen_valid(ECDH_KDF_HKDF_SHA256, out_bytelen))
+		return 0;
+	kdf_hkdf_lanes(1, &ikm, ikm_bytelen, 0, salt, salt_bytelen, info, info_bytelen,
+			&out, out_bytelen);
+	return 1;
+}
+
+static int kdf_point_is_infinity(const EllipticCurve *curve, const EllipticCurvePoint *p) {
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < elliptic_curve_point_get_coord_full_bytelen(curve); ++i)
+		acc |= p->point_mem[i];
+	return acc == 0;
+}
+
+int ecdh_derive_key(const EllipticCurve *curve,
+		const unsigned char *private_key, const unsigned char *public_key,
+		int kdf, const unsigned char *salt, unsigned long salt_bytelen,
+		const unsigned char *info, unsigned long info_bytelen,
+		unsigned char *out, unsigned long out_bytelen) {
+	const unsigned char *z[1];
+	alignas(8) EllipticCurvePoint shared = { };
+	int ok = kdf_out_bytelen_valid(kdf, out_bytelen);
+
+	if (ok) {
+#if ECDH_CONSTANT_TIME
+		elliptic_curve_binary_point_multiply_ct(curve, &shared,
+				(const EllipticCurvePoint*) public_key, private_key, curve->field_size_bytes);
+#else
+		elliptic_curve_binary_point_multiply(curve, &shared,
+				(const EllipticCurvePoint*) public_key, private_key, curve->field_size_bytes);
+#endif
+		ok = !kdf_point_is_infinity(curve, &shared);
+	}
+	if (ok) {
+		// Z is x, big endian: the point's LSB-first x bytes read backwards
+		z[0] = shared.point_mem;
+		kdf_lanes(kdf, 1, z, curve->field_size_bytes, 1, salt, salt_bytelen,
+				info, info_bytelen, &out, out_bytelen);
+	} else if (kdf_out_bytelen_valid(kdf, out_bytelen)) {
+		for (unsigned long i = 0; i < out_bytelen; ++i)
+			out[i] = 0;
+	}
+	kdf_wipe(&shared, sizeof(shared));
+	return ok;
+}
+
+unsigned long ecdh_derive_key_batch(const EllipticCurve *curve,
+		const unsigned char *const *private_keys,
+		const unsigned char *const *public_keys, unsigned long count,
+		int kdf, const unsigned char *salt, unsigned long salt_bytelen,
+		const unsigned char *info, unsigned long info_bytelen,
+		unsigned char *const *out, unsigned long out_bytelen, int *ok) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long succeeded = 0;
+	EllipticCurvePoint shared[ECDH_KDF_MAX_BATCH];
+#if !ECDH_CONSTANT_TIME
+	EllipticCurvePoint *outs[ECDH_KDF_MAX_BATCH];
+	const EllipticCurvePoint *ins[ECDH_KDF_MAX_BATCH];
+	alignas(8) unsigned char scratch[ECDH_KDF_MAX_BATCH * EC_BATCH_LANE_BYTELEN];
+#endif
+
+	if (!kdf_out_bytelen_valid(kdf, out_bytelen)) {
+		for (unsigned long i = 0; i < count; ++i)
+			ok[i] = 0;
+		return 0;
+	}
+	for (unsigned long first = 0; first < count; first += ECDH_KDF_MAX_BATCH) {
+		unsigned long n = count - first;
+		if (n > ECDH_KDF_MAX_BATCH)
+			n = ECDH_KDF_MAX_BATCH;
+#if ECDH_CONSTANT_TIME
+		for (unsigned long i = 0; i < n; ++i)
+			elliptic_curve_binary_point_multiply_ct(curve, &shared[i],
+					(const EllipticCurvePoint*) public_keys[first + i], private_keys[first + i], len);
+#else
+		for (unsigned long i = 0; i < n; ++i) {
+			outs[i] = &shared[i];
+			ins[i] = (const EllipticCurvePoint*) public_keys[first + i];
+		}
+		elliptic_curve_binary_point_multiply_batch(curve, outs, ins, private_keys + first, n,
+				len, scratch, sizeof(scratch));
+#endif
+
+		// Sessions with a usable shared point go through the KDF
+		// ECDH_KDF_LANES at a time
+		const unsigned char *z[ECDH_KDF_LANES];
+		unsigned char *dst[ECDH_KDF_LANES];
+		unsigned long lanes = 0;
+		for (unsigned long i = 0; i < n; ++i) {
+			ok[first + i] = !kdf_point_is_infinity(curve, &shared[i]);
+			if (!ok[first + i]) {
+				for (unsigned long b = 0; b < out_bytelen; ++b)
+					out[first + i][b] = 0;
+			} else {
+				z[lanes] = shared[i].point_mem;
+				dst[lanes++] = out[first + i];
+				++succeeded;
+			}
+			if (lanes == ECDH_KDF_LANES || (i + 1 == n && lanes)) {
+				kdf_lanes(kdf, lanes, z, len, 1, salt, salt_bytelen, info, info_bytelen,
+						dst, out_bytelen);
+				lanes = 0;
+			}
+		}
+	}
+	kdf_wipe(shared, sizeof(shared));
+#if !ECDH_CONSTANT_TIME
+	kdf_wipe(scratch, sizeof(scratch));
+#endif
+	return succeeded;
+}
@@ -0,0 +1,81 @@
+#ifndef ECDH_KDF_H_
+#define ECDH_KDF_H_
+
+#include "ecdh.h"
+
+// Key derivation from ECDH shared secrets, dependency free: SHA-256
+// (FIPS 180-4), the ANSI X9.63 KDF (SEC 1 3.6.1) and HKDF (RFC 5869), both
+// over SHA-256.
+//
+// The shared secret Z is the x coordinate of the shared point as a big
+// endian octet string of field_size_bytes bytes (SEC 1). ecdh_derive_key()
+// hashes it straight out of the point, walking its LSB-first bytes
+// backwards, so the x coordinate is neither copied out nor byte reversed
+// first, and the point is wiped before returning.
+//
+// ecdh_derive_key_batch() runs whole batches: the shared points in lock
+// step with one shared inversion per step (elliptic_curve_batch.h; per key
+// ladders with ECDH_CONSTANT_TIME), then every hash in the KDF as a
+// multi-buffer SHA-256 over ECDH_KDF_LANES sessions. All sessions of a batch
+// hash messages of the same length, so their blocks line up and one
+// compression runs every lane in the same loop (laid out for the compiler's
+// vectorizer: 32-bit lanes, innermost loop over the lanes).
+//
+// As with ecdh_generate_shared_secret, the peer key must have been checked
+// with ecdh_public_key_verify; the derivations only refuse a shared point
+// at infinity.
+
+#ifndef ECDH_KDF_LANES
+#define ECDH_KDF_LANES (8)
+#endif
+
+#define ECDH_SHA256_BYTELEN      (32)
+#define ECDH_SHA256_BLOCK_BYTELEN (64)
+#define ECDH_HKDF_MAX_BYTELEN    (255 * ECDH_SHA256_BYTELEN)
+#define ECDH_KDF_MAX_BATCH       (32)
+
+#define ECDH_KDF_X963_SHA256 (0)    // info is the SharedInfo, salt unused
+#define ECDH_KDF_HKDF_SHA256 (1)    // salt and info as in RFC 5869
+
+typedef struct alignas(8){
+	unsigned int state[8];
+	unsigned long long bytelen;             // hashed so far
+	unsigned char block[ECDH_SHA256_BLOCK_BYTELEN];
+}EcdhSha256;
+
+void ecdh_sha256_init(EcdhSha256 *ctx);
+void ecdh_sha256_update(EcdhSha256 *ctx, const unsigned char *in, unsigned long bytelen);
+// Writes ECDH_SHA256_BYTELEN bytes and wipes the context.
+void ecdh_sha256_final(EcdhSha256 *ctx, unsigned char *out);
+void ecdh_sha256(const unsigned char *in, unsigned long bytelen, unsigned char *out);
+
+// Byte-string forms of the two KDFs. Return 0 if out_bytelen is out of
+// range (X9.63: below 2^32 - 1 blocks; HKDF: up to ECDH_HKDF_MAX_BYTELEN).
+int ecdh_x963_kdf_sha256(const unsigned char *z, unsigned long z_bytelen,
+		const unsigned char *shared_info, unsigned long shared_info_bytelen,
+		unsigned char *out, unsigned long out_bytelen);
+int ecdh_hkdf_sha256(const unsigned char *ikm, unsigned long ikm_bytelen,
+		const unsigned char *salt, unsigned long salt_bytelen,
+		const unsigned char *info, unsigned long info_bytelen,
+		unsigned char *out, unsigned long out_bytelen);
+
+// out = KDF(x(private_key * public_key)), keys as in ecdh.h. Returns 1, or 0
+// on an unknown kdf, a bad out_bytelen or a shared point at infinity (out
+// is then zeroed).
+int ecdh_derive_key(const EllipticCurve *curve,
+		const unsigned char *private_key, const unsigned char *public_key,
+		int kdf, const unsigned char *salt, unsigned long salt_bytelen,
+		const unsigned char *info, unsigned long info_bytelen,
+		unsigned char *out, unsigned long out_bytelen);
+
+// count independent derivations (any count, processed ECDH_KDF_MAX_BATCH at
+// a time) sharing kdf, salt, info and out_bytelen. ok[i] receives the
+// return value of the single-session call. Returns how many succeeded.
+unsigned long ecdh_derive_key_batch(const EllipticCurve *curve,
+		const unsigned char *const *private_keys,
+		const unsigned char *const *public_keys, unsigned long count,
+		int kdf, const unsigned char *salt, unsigned long salt_bytelen,
+		const unsigned char *info, unsigned long info_bytelen,
+		unsigned char *const *out, unsigned long out_bytelen, int *ok);
+
+#endif /* ECDH_KDF_H_ */
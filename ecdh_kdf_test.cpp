@@ -0,0 +1,213 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "ecdh_kdf.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x4B4D0046UL)
+#include "ec_test_util.h"
+
+static void kdf_test_print(const char *name, int ok) {
+	std::cout << std::left << std::setw(24) << name << (ok ? "PASS" : "FAIL") << "\n";
+}
+
+// FIPS 180-4, RFC 5869 and NIST CAVS X9.63 vectors, then ecdh_derive_key
+// and its batch form against the KDFs applied to ecdh_generate_shared_secret
+int test_ecdh_kdf() {
+	int failures = 0;
+	std::cout << "\n--- Testing SHA-256, X9.63 KDF, HKDF and ecdh_derive_key ---\n";
+	unsigned char expected[128], got[128], a[128], b[128], c[128];
+
+	{
+		int ok = 1;
+		ecdh_sha256((const unsigned char*) "abc", 3, got);
+		ec_test_hex("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", expected);
+		ok &= ec_test_bytes_equal(got, expected, 32);
+		ecdh_sha256(0, 0, got);
+		ec_test_hex("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", expected);
+		ok &= ec_test_bytes_equal(got, expected, 32);
+		const char *two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+		ecdh_sha256((const unsigned char*) two_blocks, 56, got);
+		ec_test_hex("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", expected);
+		ok &= ec_test_bytes_equal(got, expected, 32);
+		EcdhSha256 ctx;
+		ecdh_sha256_init(&ctx);
+		std::vector<unsigned char> as(1000, 'a');
+		for (int i = 0; i < 1000; ++i)
+			ecdh_sha256_update(&ctx, as.data(), as.size());
+		ecdh_sha256_final(&ctx, got);
+		ec_test_hex("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", expected);
+		ok &= ec_test_bytes_equal(got, expected, 32);
+		kdf_test_print("sha256", ok);
+		failures += !ok;
+	}
+
+	{
+		int ok = 1;
+		unsigned long ikm_len = ec_test_hex("0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b", a);
+		unsigned long salt_len = ec_test_hex("000102030405060708090a0b0c", b);
+		unsigned long info_len = ec_test_hex("f0f1f2f3f4f5f6f7f8f9", c);
+		ec_test_hex("3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf"
+				"34007208d5b887185865", expected);
+		ok &= ecdh_hkdf_sha256(a, ikm_len, b, salt_len, c, info_len, got, 42);
+		ok &= ec_test_bytes_equal(got, expected, 42);
+		ec_test_hex("8da4e775a563c18f715f802a063c5a31b8a11f5c5ee1879ec3454e5f3c738d2d"
+				"9d201395faa4b61a96c8", expected);
+		ok &= ecdh_hkdf_sha256(a, ikm_len, 0, 0, 0, 0, got, 42);
+		ok &= ec_test_bytes_equal(got, expected, 42);
+		// RFC 5869 case 2: 80-byte salt, hashed down to a key
+		for (int i = 0; i < 80; ++i) {
+			a[i] = (unsigned char) i;
+			b[i] = (unsigned char) (0x60 + i);
+			c[i] = (unsigned char) (0xb0 + i);
+		}
+		ec_test_hex("b11e398dc80327a1c8e7f78c596a49344f012eda2d4efad8a050cc4c19afa97c"
+				"59045a99cac7827271cb41c65e590e09da3275600c2f09b8367793a9aca3db71"
+				"cc30c58179ec3e87c14c01d5c1f3434f1d87", expected);
+		ok &= ecdh_hkdf_sha256(a, 80, b, 80, c, 80, got, 82);
+		ok &= ec_test_bytes_equal(got, expected, 82);
+		ok &= !ecdh_hkdf_sha256(a, 80, b, 80, c, 80, got, ECDH_HKDF_MAX_BYTELEN + 1);
+		kdf_test_print("hkdf rfc 5869", ok);
+		failures += !ok;
+	}
+
+	{
+		int ok = 1;
+		unsigned long z_len = ec_test_hex("96c05619d56c328ab95fe84b18264b08725b85e33fd34f08", a);
+		ec_test_hex("443024c3dae66b95e6f5670601558f71", expected);
+		ok &= ecdh_x963_kdf_sha256(a, z_len, 0, 0, got, 16);
+		ok &= ec_test_bytes_equal(got, expected, 16);
+		kdf_test_print("x9.63 cavs", ok);
+		failures += !ok;
+	}
+
+	// Derivation from key pairs on every registry curve; batches of every
+	// size up to two lane groups, a degenerate (zero) key among them
+	const unsigned char info[] = "handshake";
+	const unsigned char salt[] = "salt";
+	for (unsigned long cv = 0; cv < elliptic_curve_registry_count(); ++cv) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(cv)->curve;
+		unsigned long len = curve->field_size_bytes;
+		const unsigned long count = 2 * ECDH_KDF_LANES + 3;
+		std::vector<std::vector<unsigned char> > priv(count), pub(count), out(count), single(count);
+		std::vector<const unsigned char*> priv_ptrs(count), pub_ptrs(count);
+		std::vector<unsigned char*> out_ptrs(count);
+		std::vector<int> oks(count);
+		int ok = 1;
+
+		for (int kdf = ECDH_KDF_X963_SHA256; kdf <= ECDH_KDF_HKDF_SHA256; ++kdf) {
+			const unsigned long out_len = 70;
+			for (unsigned long i = 0; i < count; ++i) {
+				unsigned char peer_priv[GF2_VECTOR_MAX_BYTELEN] = { };
+				priv[i].assign(GF2_VECTOR_MAX_BYTELEN, 0);
+				pub[i].assign(sizeof(EllipticCurvePoint), 0);
+				out[i].assign(out_len, 0xEE);
+				single[i].assign(out_len, 0);
+				ec_test_random_key(curve, priv[i].data());
+				ec_test_random_key(curve, peer_priv);
+				if (i == 5)
+					priv[i].assign(GF2_VECTOR_MAX_BYTELEN, 0);
+				ecdh_generate_public_key(curve, peer_priv, pub[i].data());
+				priv_ptrs[i] = priv[i].data();
+				pub_ptrs[i] = pub[i].data();
+				out_ptrs[i] = out[i].data();
+
+				int expect_ok = i != 5;
+				ok &= ecdh_derive_key(curve, priv[i].data(), pub[i].data(), kdf, salt, 4,
+						info, 9, single[i].data(), out_len) == expect_ok;
+				if (!expect_ok)
+					continue;
+				unsigned char z[GF2_VECTOR_MAX_BYTELEN], z_be[GF2_VECTOR_MAX_BYTELEN];
+				ecdh_generate_shared_secret(curve, priv[i].data(), pub[i].data(), z);
+				for (unsigned long j = 0; j < len; ++j)
+					z_be[j] = z[len - 1 - j];
+				if (kdf == ECDH_KDF_X963_SHA256)
+					ecdh_x963_kdf_sha256(z_be, len, info, 9, expected, out_len);
+				else
+					ecdh_hkdf_sha256(z_be, len, salt, 4, info, 9, expected, out_len);
+				ok &= ec_test_bytes_equal(single[i].data(), expected, out_len);
+			}
+			for (unsigned long n = 1; n <= count; n += (n < 3) ? 1 : 7) {
+				unsigned long good = ecdh_derive_key_batch(curve, priv_ptrs.data(), pub_ptrs.data(),
+						n, kdf, salt, 4, info, 9, out_ptrs.data(), out_len, oks.data());
+				ok &= good == n - (n > 5);
+				for (unsigned long i = 0; i < n; ++i) {
+					ok &= oks[i] == (i != 5);
+					ok &= ec_test_bytes_equal(out[i].data(), single[i].data(), out_len);
+				}
+			}
+		}
+		std::cout << std::left << std::setw(24) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Handshakes per second from key pair to 32-byte HKDF key: the shared
+// secret copied out, reversed and hashed by the caller vs. ecdh_derive_key
+// vs. the batch; then SHA-256 throughput
+void benchmark_ecdh_kdf() {
+	const unsigned long sessions = 64;
+	std::cout << "\n--- Benchmark: shared secret + HKDF-SHA256, handshakes/s ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right << std::setw(12) << "copy+kdf"
+			<< std::setw(12) << "derive" << std::setw(12) << "batch" << "\n";
+
+	for (unsigned long cv = 0; cv < elliptic_curve_registry_count(); ++cv) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(cv)->curve;
+		elliptic_curve_context_acquire(curve);
+		unsigned long len = curve->field_size_bytes;
+		std::vector<std::vector<unsigned char> > priv(sessions), pub(sessions), out(sessions);
+		std::vector<const unsigned char*> priv_ptrs(sessions), pub_ptrs(sessions);
+		std::vector<unsigned char*> out_ptrs(sessions);
+		std::vector<int> oks(sessions);
+		for (unsigned long i = 0; i < sessions; ++i) {
+			unsigned char peer_priv[GF2_VECTOR_MAX_BYTELEN] = { };
+			priv[i].assign(GF2_VECTOR_MAX_BYTELEN, 0);
+			pub[i].assign(sizeof(EllipticCurvePoint), 0);
+			out[i].assign(32, 0);
+			ec_test_random_key(curve, priv[i].data());
+			ec_test_random_key(curve, peer_priv);
+			ecdh_generate_public_key(curve, peer_priv, pub[i].data());
+			priv_ptrs[i] = priv[i].data();
+			pub_ptrs[i] = pub[i].data();
+			out_ptrs[i] = out[i].data();
+		}
+
+		double rate[3];
+		for (int v = 0; v < 3; ++v) {
+			auto t0 = std::chrono::steady_clock::now();
+			if (v == 0) {
+				for (unsigned long i = 0; i < sessions; ++i) {
+					unsigned char z[GF2_VECTOR_MAX_BYTELEN], z_be[GF2_VECTOR_MAX_BYTELEN];
+					ecdh_generate_shared_secret(curve, priv[i].data(), pub[i].data(), z);
+					for (unsigned long j = 0; j < len; ++j)
+						z_be[j] = z[len - 1 - j];
+					ecdh_hkdf_sha256(z_be, len, 0, 0, 0, 0, out_ptrs[i], 32);
+				}
+			} else if (v == 1) {
+				for (unsigned long i = 0; i < sessions; ++i)
+					ecdh_derive_key(curve, priv_ptrs[i], pub_ptrs[i], ECDH_KDF_HKDF_SHA256,
+							0, 0, 0, 0, out_ptrs[i], 32);
+			} else {
+				ecdh_derive_key_batch(curve, priv_ptrs.data(), pub_ptrs.data(), sessions,
+						ECDH_KDF_HKDF_SHA256, 0, 0, 0, 0, out_ptrs.data(), 32, oks.data());
+			}
+			auto t1 = std::chrono::steady_clock::now();
+			rate[v] = sessions / std::chrono::duration<double>(t1 - t0).count();
+		}
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::right << std::fixed << std::setprecision(0) << std::setw(12) << rate[0]
+				<< std::setw(12) << rate[1] << std::setw(12) << rate[2] << "\n";
+	}
+
+	// The hash alone
+	std::vector<unsigned char> data(1 << 20, 0x5A);
+	unsigned char digest[ECDH_SHA256_BYTELEN];
+	auto t0 = std::chrono::steady_clock::now();
+	ecdh_sha256(data.data(), data.size(), digest);
+	auto t1 = std::chrono::steady_clock::now();
+	std::cout << "sha256: " << std::fixed << std::setprecision(0)
+			<< data.size() / std::chrono::duration<double>(t1 - t0).count() / 1e6 << " MB/s\n";
+}
@@ -0,0 +1,231 @@
+#include "ecdh_keypool.h"
+#include "ec_atomic.h"
+#include "elliptic_curve_batch.h"
+
+// Bounds the redraws of one private key; with n above half the range a
+// draw is rejected less than half of the time, so only a broken random
+// source gets here
+#define KEYPOOL_MAX_DRAWS (64)
+
+void ecdh_keypool_config_default(EcdhKeyPoolConfig *config) {
+	config->capacity = 32;
+	config->batch = 8;
+	config->low_water = 16;
+	config->max_age_ns = 0;
+	config->random = 0;
+	config->random_arg = 0;
+	config->clock_ns = 0;
+	config->clock_arg = 0;
+}
+
+int ecdh_keypool_init(EcdhKeyPool *pool, const EllipticCurve *curve,
+		const EcdhKeyPoolConfig *config) {
+	unsigned long capacity = config->capacity;
+	if (capacity < 2 || capacity > ECDH_KEYPOOL_MAX_CAPACITY || (capacity & (capacity - 1)))
+		return 0;
+	if (config->batch < 1 || config->batch > ECDH_KEYPOOL_MAX_BATCH
+			|| config->low_water > capacity || !config->random)
+		return 0;
+
+	unsigned char *raw = (unsigned char*) pool;
+	for (unsigned long i = 0; i < sizeof(EcdhKeyPool); ++i)
+		raw[i] = 0;
+	pool->curve = curve;
+	pool->config = *config;
+	ec_mpmc_queue_init(&pool->ready, pool->ready_mem, capacity);
+	ec_mpmc_queue_init(&pool->free_slots, pool->free_mem, capacity);
+	for (unsigned long i = 0; i < capacity; ++i)
+		ec_mpmc_queue_push(&pool->free_slots, &pool->pairs[i]);
+	return 1;
+}
+
+static unsigned long long keypool_now(const EcdhKeyPool *pool) {
+	if (!pool->config.clock_ns)
+		return 0;
+	return pool->config.clock_ns(pool->config.clock_arg);
+}
+
+static void keypool_wipe(void *p, unsigned long bytelen) {
+	volatile unsigned char *raw = (volatile unsigned char*) p;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		raw[i] = 0;
+}
+
+// k in [1, n - 1]: draw bits(n) random bits until the value fits. The
+// comparison runs over all bytes without branching on the key.
+static int keypool_draw_private_key(const EcdhKeyPool *pool, unsigned char *key) {
+	const EllipticCurve *curve = pool->curve;
+	unsigned long len = curve->field_size_bytes;
+	long top = gf2_degree_lsb(curve->order, len);   // bits(n) - 1
+
+	for (int draw = 0; draw < KEYPOOL_MAX_DRAWS; ++draw) {
+		if (!pool->config.random(pool->config.random_arg, key, len))
+			return 0;
+		for (long bit = top + 1; bit < (long) (8 * len); ++bit)
+			key[bit >> 3] &= (unsigned char) ~(1U << (bit & 7));
+
+		unsigned int borrow = 0;                    // of key - n
+		unsigned char nonzero = 0;
+		for (unsigned long i = 0; i < len; ++i) {
+			unsigned int d = (unsigned int) key[i] - curve->order[i] - borrow;
+			borrow = (d >> 8) & 1;
+			nonzero |= key[i];
+		}
+		if (borrow && nonzero)
+			return 1;
+	}
+	return 0;
+}
+
+static int keypool_generate(const EcdhKeyPool *pool, unsigned char *private_key,
+		unsigned char *public_key) {
+	if (!keypool_draw_private_key(pool, private_key))
+		return 0;
+	ecdh_generate_public_key(pool->curve, private_key, public_key);
+	return 1;
+}
+
+// Public keys of a refill batch. The affine comb of ecdh_generate_public_key
+// pays an inversion per point operation; run in lock step the batch shares
+// one per step (elliptic_curve_batch.h), which is the faster way to produce
+// many keys. Same variable-time caveat as ecdh_generate_public_key, so the
+// constant-time build keeps the per-key ladder.
+static void keypool_public_keys(const EcdhKeyPool *pool, EcdhKeyPoolPair *const *batch,
+		unsigned long count) {
+	const EllipticCurve *curve = pool->curve;
+#if ECDH_CONSTANT_TIME
+	for (unsigned long i = 0; i < count; ++i)
+		ecdh_generate_public_key(curve, batch[i]->private_key, batch[i]->public_key);
+#else
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	alignas(8) EllipticCurvePoint base = { };
+	EllipticCurvePoint *out[ECDH_KEYPOOL_MAX_BATCH];
+	const EllipticCurvePoint *in[ECDH_KEYPOOL_MAX_BATCH];
+	const unsigned char *exp[ECDH_KEYPOOL_MAX_BATCH];
+	alignas(8) unsigned char scratch[ECDH_KEYPOOL_MAX_BATCH * EC_BATCH_LANE_BYTELEN];
+
+	for (unsigned long i = 0; i < len; ++i) {
+		base.point_mem[i] = curve->xG[i];
+		base.point_mem[i + y_offset] = curve->yG[i];
+	}
+	for (unsigned long i = 0; i < count; ++i) {
+		out[i] = (EllipticCurvePoint*) batch[i]->public_key;
+		in[i] = &base;
+		exp[i] = batch[i]->private_key;
+	}
+	elliptic_curve_binary_point_multiply_batch(curve, out, in, exp, count, len,
+			scratch, sizeof(scratch));
+	keypool_wipe(scratch, sizeof(scratch));
+#endif
+}
+
+unsigned long ecdh_keypool_refill(EcdhKeyPool *pool) {
+	EcdhKeyPoolPair *batch[ECDH_KEYPOOL_MAX_BATCH];
+	unsigned long count = 0;
+	unsigned long filled = 0;
+
+	while (count < pool->config.batch) {
+		EcdhKeyPoolPair *pair = (EcdhKeyPoolPair*) ec_mpmc_queue_pop(&pool->free_slots);
+		if (!pair)
+			break;
+		batch[count++] = pair;
+	}
+	if (!count)
+		return 0;
+
+	for (unsigned long i = 0; i < count; ++i) {
+		if (!keypool_draw_private_key(pool, batch[i]->private_key)) {
+			EC_ATOMIC_FETCH_ADD(&pool->random_failures, 1UL);
+			break;
+		}
+		++filled;
+	}
+	keypool_public_keys(pool, batch, filled);
+	unsigned long long now = keypool_now(pool);
+	for (unsigned long i = 0; i < count; ++i) {
+		if (i < filled) {
+			batch[i]->generated_ns = now;
+			ec_mpmc_queue_push(&pool->ready, batch[i]);
+		} else {
+			keypool_wipe(batch[i], sizeof(EcdhKeyPoolPair));
+			ec_mpmc_queue_push(&pool->free_slots, batch[i]);
+		}
+	}
+	if (filled) {
+		unsigned long long unset = 0;
+		EC_ATOMIC_CAS(&pool->first_refill_ns, &unset, now);
+		EC_ATOMIC_STORE_RELEASE(&pool->last_refill_ns, now);
+		EC_ATOMIC_FETCH_ADD(&pool->generated, filled);
+		EC_ATOMIC_FETCH_ADD(&pool->refills, 1UL);
+	}
+	return filled;
+}
+
+int ecdh_keypool_needs_refill(const EcdhKeyPool *pool) {
+	return ec_mpmc_queue_size(&pool->ready) < pool->config.low_water;
+}
+
+// Wipes a taken or expired slot and hands it back to the refills
+static void keypool_release(EcdhKeyPool *pool, EcdhKeyPoolPair *pair) {
+	keypool_wipe(pair, sizeof(EcdhKeyPoolPair));
+	ec_mpmc_queue_push(&pool->free_slots, pair);
+}
+
+int ecdh_keypool_take(EcdhKeyPool *pool, unsigned char *out_private_key,
+		unsigned char *out_public_key) {
+	const EllipticCurve *curve = pool->curve;
+	int check_age = pool->config.max_age_ns && pool->config.clock_ns;
+	unsigned long long now = check_age ? keypool_now(pool) : 0;
+	EcdhKeyPoolPair *pair;
+
+	while ((pair = (EcdhKeyPoolPair*) ec_mpmc_queue_pop(&pool->ready)) != 0) {
+		if (check_age && now > pair->generated_ns + pool->config.max_age_ns) {
+			keypool_release(pool, pair);
+			EC_ATOMIC_FETCH_ADD(&pool->evicted, 1UL);
+			continue;
+		}
+		for (unsigned long i = 0; i < curve->field_size_bytes; ++i)
+			out_private_key[i] = pair->private_key[i];
+		for (unsigned long i = 0; i < elliptic_curve_point_get_coord_full_bytelen(curve); ++i)
+			out_public_key[i] = pair->public_key[i];
+		keypool_release(pool, pair);
+		EC_ATOMIC_FETCH_ADD(&pool->hits, 1UL);
+		return ECDH_KEYPOOL_HIT;
+	}
+
+	EC_ATOMIC_FETCH_ADD(&pool->misses, 1UL);
+	if (!keypool_generate(pool, out_private_key, out_public_key)) {
+		keypool_wipe(out_private_key, curve->field_size_bytes);
+		EC_ATOMIC_FETCH_ADD(&pool->random_failures, 1UL);
+		return ECDH_KEYPOOL_ERROR;
+	}
+	return ECDH_KEYPOOL_MISS;
+}
+
+unsigned long ecdh_keypool_evict(EcdhKeyPool *pool) {
+	unsigned long count = 0;
+	EcdhKeyPoolPair *pair;
+
+	while ((pair = (EcdhKeyPoolPair*) ec_mpmc_queue_pop(&pool->ready)) != 0) {
+		keypool_release(pool, pair);
+		++count;
+	}
+	EC_ATOMIC_FETCH_ADD(&pool->evicted, count);
+	return count;
+}
+
+void ecdh_keypool_get_stats(const EcdhKeyPool *pool, EcdhKeyPoolStats *out) {
+	out->ready = ec_mpmc_queue_size(&pool->ready);
+	out->hits = EC_ATOMIC_LOAD_ACQUIRE(&pool->hits);
+	out->misses = EC_ATOMIC_LOAD_ACQUIRE(&pool->misses);
+	out->generated = EC_ATOMIC_LOAD_ACQUIRE(&pool->generated);
+	out->refills = EC_ATOMIC_LOAD_ACQUIRE(&pool->refills);
+	out->evicted = EC_ATOMIC_LOAD_ACQUIRE(&pool->evicted);
+	out->random_failures = EC_ATOMIC_LOAD_ACQUIRE(&pool->random_failures);
+
+	unsigned long long first = EC_ATOMIC_LOAD_ACQUIRE(&pool->first_refill_ns);
+	unsigned long long last = EC_ATOMIC_LOAD_ACQUIRE(&pool->last_refill_ns);
+	out->refill_per_s = (last > first)
+			? (unsigned long long) out->generated * 1000000000ULL / (last - first) : 0;
+}
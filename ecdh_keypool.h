@@ -0,0 +1,128 @@
+#ifndef ECDH_KEYPOOL_H_
+#define ECDH_KEYPOOL_H_
+
+#include "ecdh.h"
+#include "ec_queue.h"
+
+// Pool of precomputed ephemeral ECDH key pairs, to take key generation off a
+// handshake's critical path.
+//
+// Pairs live in a fixed array of slots that circulate between two MPMC
+// queues (ec_queue.h): free slots wait for a refill, filled ones wait for a
+// taker. ecdh_keypool_take() pops a filled slot, so each pair is handed out
+// exactly once without locks, copies it out, wipes the slot and returns it
+// to the free queue. On an empty pool it generates the pair on the caller's
+// thread instead (a miss).
+//
+// Private keys are drawn from the caller's random source by rejection
+// sampling, uniform in [1, n - 1]. A refill computes the public keys of its
+// batch in lock step with one shared inversion per step
+// (elliptic_curve_batch.h); with ECDH_CONSTANT_TIME it runs the ladder per
+// key instead. Either way the public key equals ecdh_generate_public_key of
+// the private key.
+//
+// The pool owns no threads. A refill worker calls ecdh_keypool_refill(),
+// which fills up to `batch` free slots per call and publishes them together.
+// Once the pool drops below low_water the worker should refill until the
+// pool is full. On POSIX hosts ecdh_keypool_worker_start() runs that loop on
+// a low-priority thread (ecdh_keypool_posix.cpp).
+//
+// Evicted pairs are wiped: by ecdh_keypool_evict(), and by take() when a
+// pair is older than max_age_ns (needs clock_ns), so that a key generated
+// long ago is never used for a new handshake.
+
+#define ECDH_KEYPOOL_MAX_CAPACITY (64)      // pairs, power of two
+#define ECDH_KEYPOOL_MAX_BATCH    (16)
+
+#define ECDH_KEYPOOL_ERROR (0)              // random source failed
+#define ECDH_KEYPOOL_HIT   (1)              // pair taken from the pool
+#define ECDH_KEYPOOL_MISS  (2)              // pool empty, pair generated inline
+
+typedef struct {
+	unsigned long capacity;                 // power of two, 2..ECDH_KEYPOOL_MAX_CAPACITY
+	unsigned long batch;                    // pairs per refill call, 1..ECDH_KEYPOOL_MAX_BATCH
+	unsigned long low_water;                // refill below this many ready pairs
+	unsigned long long max_age_ns;          // 0: pairs never expire
+	// Fills out with bytelen random bytes, returns 1 on success
+	int (*random)(void *arg, unsigned char *out, unsigned long bytelen);
+	void *random_arg;
+	unsigned long long (*clock_ns)(void *arg);  // monotonic clock, 0: no ages or rates
+	void *clock_arg;
+}EcdhKeyPoolConfig;
+
+typedef struct alignas(8){
+	alignas(8) unsigned char private_key[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char public_key[2 * GF2_VECTOR_MAX_BYTELEN];
+	unsigned long long generated_ns;
+}EcdhKeyPoolPair;
+
+typedef struct {
+	const EllipticCurve *curve;
+	EcdhKeyPoolConfig config;
+	EcMpmcQueue ready;
+	EcMpmcQueue free_slots;
+	EcMpmcSlot ready_mem[ECDH_KEYPOOL_MAX_CAPACITY];
+	EcMpmcSlot free_mem[ECDH_KEYPOOL_MAX_CAPACITY];
+	EcdhKeyPoolPair pairs[ECDH_KEYPOOL_MAX_CAPACITY];
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long generated;                // pairs produced by refills
+	unsigned long refills;                  // refill calls that produced pairs
+	unsigned long evicted;
+	unsigned long random_failures;
+	unsigned long long first_refill_ns;
+	unsigned long long last_refill_ns;
+}EcdhKeyPool;
+
+typedef struct {
+	unsigned long ready;                    // snapshot
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long generated;
+	unsigned long refills;
+	unsigned long evicted;
+	unsigned long random_failures;
+	unsigned long long refill_per_s;        // generated over first .. last refill
+}EcdhKeyPoolStats;
+
+// capacity 32, batch 8, low_water 16, no expiry; random must still be set.
+void ecdh_keypool_config_default(EcdhKeyPoolConfig *config);
+
+// Returns 0 on an invalid config. The pool starts empty.
+int ecdh_keypool_init(EcdhKeyPool *pool, const EllipticCurve *curve,
+		const EcdhKeyPoolConfig *config);
+
+// Generates up to batch pairs into free slots; returns how many (0: the pool
+// is full or the random source failed).
+unsigned long ecdh_keypool_refill(EcdhKeyPool *pool);
+
+// Non-zero when fewer than low_water pairs are ready.
+int ecdh_keypool_needs_refill(const EcdhKeyPool *pool);
+
+// Writes a private key (field_size_bytes, LSB first) and its public key
+// (point layout, as ecdh_generate_public_key). Returns ECDH_KEYPOOL_HIT,
+// ECDH_KEYPOOL_MISS or ECDH_KEYPOOL_ERROR.
+int ecdh_keypool_take(EcdhKeyPool *pool, unsigned char *out_private_key,
+		unsigned char *out_public_key);
+
+// Wipes every ready pair (key rotation, shutdown); returns how many.
+unsigned long ecdh_keypool_evict(EcdhKeyPool *pool);
+
+void ecdh_keypool_get_stats(const EcdhKeyPool *pool, EcdhKeyPoolStats *out);
+
+// POSIX hosts only, implemented in ecdh_keypool_posix.cpp: a thread at the
+// lowest scheduling priority refilling the pool whenever it needs it, and
+// polling every poll_ns otherwise.
+typedef struct {
+	EcdhKeyPool *pool;
+	unsigned long long poll_ns;
+	int stop;
+	alignas(8) unsigned char thread[16];    // pthread_t
+}EcdhKeyPoolWorker;
+
+// Returns 0 if the thread could not be created.
+int ecdh_keypool_worker_start(EcdhKeyPoolWorker *worker, EcdhKeyPool *pool,
+		unsigned long long poll_ns);
+void ecdh_keypool_worker_stop(EcdhKeyPoolWorker *worker);
+
+#endif /* ECDH_KEYPOOL_H_ */
@@ -0,0 +1,54 @@
+// POSIX host glue for ecdh_keypool: not part of the dependency-free core,
+// leave it out of bare-metal builds.
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "ecdh_keypool.h"
+#include "ec_atomic.h"
+
+static_assert(sizeof(pthread_t) <= sizeof(((EcdhKeyPoolWorker*)0)->thread),
+		"EcdhKeyPoolWorker::thread too small for pthread_t");
+
+static void* keypool_worker_main(void *arg) {
+	EcdhKeyPoolWorker *worker = (EcdhKeyPoolWorker*) arg;
+	struct timespec poll;
+	poll.tv_sec = (time_t) (worker->poll_ns / 1000000000ULL);
+	poll.tv_nsec = (long) (worker->poll_ns % 1000000000ULL);
+
+	while (!EC_ATOMIC_LOAD_ACQUIRE(&worker->stop)) {
+		// Below the low-water mark: fill up completely, then go back to polling
+		if (ecdh_keypool_needs_refill(worker->pool)) {
+			while (!EC_ATOMIC_LOAD_ACQUIRE(&worker->stop) && ecdh_keypool_refill(worker->pool))
+				;
+		}
+		nanosleep(&poll, 0);
+	}
+	return 0;
+}
+
+int ecdh_keypool_worker_start(EcdhKeyPoolWorker *worker, EcdhKeyPool *pool,
+		unsigned long long poll_ns) {
+	pthread_t *thread = (pthread_t*) worker->thread;
+	worker->pool = pool;
+	worker->poll_ns = poll_ns ? poll_ns : 1000000ULL;
+	worker->stop = 0;
+	if (pthread_create(thread, 0, keypool_worker_main, worker) != 0)
+		return 0;
+	// Lowest priority the host offers without privileges: the refill only
+	// uses otherwise idle cycles
+	struct sched_param param;
+	param.sched_priority = 0;
+#if defined(SCHED_IDLE)
+	pthread_setschedparam(*thread, SCHED_IDLE, &param);
+#else
+	param.sched_priority = sched_get_priority_min(SCHED_OTHER);
+	pthread_setschedparam(*thread, SCHED_OTHER, &param);
+#endif
+	return 1;
+}
+
+void ecdh_keypool_worker_stop(EcdhKeyPoolWorker *worker) {
+	EC_ATOMIC_STORE_RELEASE(&worker->stop, 1);
+	pthread_join(*(pthread_t*) worker->thread, 0);
+}
@@ -0,0 +1,253 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include "ecdh_keypool.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+
+// Thread-safe test random source: splitmix64 over a shared counter
+static std::atomic<unsigned long long> keypool_test_counter(0x0EC0044ULL);
+static int keypool_test_random_ok = 1;
+
+static int keypool_test_random(void*, unsigned char *out, unsigned long bytelen) {
+	if (!keypool_test_random_ok)
+		return 0;
+	for (unsigned long i = 0; i < bytelen; i += 8) {
+		unsigned long long z = keypool_test_counter.fetch_add(0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z ^= z >> 31;
+		for (unsigned long j = 0; j < 8 && i + j < bytelen; ++j)
+			out[i + j] = (unsigned char) (z >> (8 * j));
+	}
+	return 1;
+}
+
+static unsigned long long keypool_test_fake_now = 0;
+
+static unsigned long long keypool_test_fake_clock(void*) {
+	return keypool_test_fake_now;
+}
+
+static unsigned long long keypool_test_clock(void*) {
+	return (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The pair is consistent and the private key is in [1, n - 1]
+static int keypool_test_pair_valid(const EllipticCurve *curve, unsigned char *priv,
+		const unsigned char *pub) {
+	unsigned long len = curve->field_size_bytes;
+	EllipticCurvePoint expected = { };
+	ecdh_generate_public_key(curve, priv, expected.point_mem);
+	unsigned char diff = 0, nonzero = 0;
+	for (unsigned long i = 0; i < elliptic_curve_point_get_coord_full_bytelen(curve); ++i)
+		diff |= expected.point_mem[i] ^ pub[i];
+	int below_n = 0;
+	for (long i = (long) len - 1; i >= 0; --i) {
+		if (priv[i] != curve->order[i]) {
+			below_n = priv[i] < curve->order[i];
+			break;
+		}
+	}
+	for (unsigned long i = 0; i < len; ++i)
+		nonzero |= priv[i];
+	return diff == 0 && nonzero && below_n;
+}
+
+static int keypool_test_slots_wiped(const EcdhKeyPool *pool) {
+	const unsigned char *raw = (const unsigned char*) pool->pairs;
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < sizeof(pool->pairs); ++i)
+		acc |= raw[i];
+	return acc == 0;
+}
+
+static EcdhKeyPool keypool_test_pool;
+
+int test_ecdh_keypool() {
+	int failures = 0;
+	std::cout << "\n--- Testing the ephemeral key-pair pool ---\n";
+	const EllipticCurve *curve = elliptic_curve_registry_get(0)->curve;
+	elliptic_curve_context_acquire(curve);
+	EcdhKeyPool *pool = &keypool_test_pool;
+	unsigned long len = curve->field_size_bytes;
+	unsigned char priv[GF2_VECTOR_MAX_BYTELEN];
+	unsigned char pub[2 * GF2_VECTOR_MAX_BYTELEN];
+	EcdhKeyPoolConfig config;
+	EcdhKeyPoolStats stats;
+
+	// Fill, drain, miss; every slot wiped once handed out
+	{
+		ecdh_keypool_config_default(&config);
+		int ok = !ecdh_keypool_init(pool, curve, &config);     // no random source
+		config.random = keypool_test_random;
+		config.capacity = 24;
+		ok &= !ecdh_keypool_init(pool, curve, &config);
+		config.capacity = 16;
+		config.batch = 4;
+		config.low_water = 8;
+		ok &= ecdh_keypool_init(pool, curve, &config) && ecdh_keypool_needs_refill(pool);
+		unsigned long filled = 0, n;
+		while ((n = ecdh_keypool_refill(pool)) != 0)
+			filled += n;
+		ecdh_keypool_get_stats(pool, &stats);
+		ok &= filled == 16 && stats.ready == 16 && stats.generated == 16 && stats.refills == 4;
+		ok &= !ecdh_keypool_needs_refill(pool);
+
+		unsigned char keys[16][GF2_VECTOR_MAX_BYTELEN];
+		for (int i = 0; i < 16; ++i) {
+			ok &= ecdh_keypool_take(pool, keys[i], pub) == ECDH_KEYPOOL_HIT;
+			ok &= keypool_test_pair_valid(curve, keys[i], pub);
+			for (int j = 0; j < i; ++j) {
+				unsigned char diff = 0;
+				for (unsigned long b = 0; b < len; ++b)
+					diff |= keys[i][b] ^ keys[j][b];
+				ok &= diff != 0;
+			}
+		}
+		ok &= keypool_test_slots_wiped(pool);
+		ok &= ecdh_keypool_take(pool, priv, pub) == ECDH_KEYPOOL_MISS
+				&& keypool_test_pair_valid(curve, priv, pub);
+		ecdh_keypool_get_stats(pool, &stats);
+		ok &= stats.hits == 16 && stats.misses == 1 && stats.ready == 0;
+		std::cout << std::left << std::setw(24) << "fill / take / miss" << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// Eviction, explicit and by age, wipes the pairs
+	{
+		config.clock_ns = keypool_test_fake_clock;
+		config.max_age_ns = 1000;
+		keypool_test_fake_now = 5000;
+		int ok = ecdh_keypool_init(pool, curve, &config);
+		ok &= ecdh_keypool_refill(pool) == 4 && ecdh_keypool_refill(pool) == 4;
+		ok &= ecdh_keypool_evict(pool) == 8 && keypool_test_slots_wiped(pool);
+		ok &= ecdh_keypool_refill(pool) == 4;
+		keypool_test_fake_now = 5000 + 1000;
+		ok &= ecdh_keypool_take(pool, priv, pub) == ECDH_KEYPOOL_HIT;
+		keypool_test_fake_now = 5000 + 1001;
+		ok &= ecdh_keypool_take(pool, priv, pub) == ECDH_KEYPOOL_MISS;
+		ok &= keypool_test_slots_wiped(pool);
+		ecdh_keypool_get_stats(pool, &stats);
+		ok &= stats.evicted == 8 + 3 && stats.hits == 1 && stats.misses == 1;
+		config.clock_ns = 0;
+		config.max_age_ns = 0;
+		std::cout << std::left << std::setw(24) << "evict" << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// A failing random source: nothing pooled, take reports the error
+	{
+		int ok = ecdh_keypool_init(pool, curve, &config);
+		keypool_test_random_ok = 0;
+		ok &= ecdh_keypool_refill(pool) == 0;
+		ok &= ecdh_keypool_take(pool, priv, pub) == ECDH_KEYPOOL_ERROR;
+		keypool_test_random_ok = 1;
+		ecdh_keypool_get_stats(pool, &stats);
+		ok &= stats.random_failures == 2 && stats.ready == 0 && keypool_test_slots_wiped(pool);
+		ok &= ecdh_keypool_refill(pool) == 4;
+		std::cout << std::left << std::setw(24) << "random failure" << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// Refill worker and three takers on a pre-filled pool: every pair handed
+	// out once
+	{
+		const unsigned long takers = 3, per_thread = 40;
+		config.capacity = 32;
+		config.batch = 8;
+		config.low_water = 16;
+		int ok = ecdh_keypool_init(pool, curve, &config);
+		while (ecdh_keypool_refill(pool))
+			;
+		EcdhKeyPoolWorker worker;
+		ok &= ecdh_keypool_worker_start(&worker, pool, 100000ULL);
+		std::vector<unsigned char> keys(takers * per_thread * len);
+		std::vector<int> results(takers * per_thread);
+		std::vector<std::thread> threads;
+		for (unsigned long t = 0; t < takers; ++t) {
+			threads.emplace_back([pool, &keys, &results, t, per_thread, len]() {
+				unsigned char pub_local[2 * GF2_VECTOR_MAX_BYTELEN];
+				for (unsigned long i = 0; i < per_thread; ++i) {
+					unsigned long k = t * per_thread + i;
+					results[k] = ecdh_keypool_take(pool, &keys[k * len], pub_local);
+					std::this_thread::sleep_for(std::chrono::microseconds(200));
+				}
+			});
+		}
+		for (auto &th : threads)
+			th.join();
+		ecdh_keypool_worker_stop(&worker);
+
+		unsigned long hits = 0;
+		for (unsigned long k = 0; k < results.size(); ++k) {
+			ok &= results[k] != ECDH_KEYPOOL_ERROR;
+			hits += results[k] == ECDH_KEYPOOL_HIT;
+			for (unsigned long j = 0; j < k; ++j) {
+				unsigned char diff = 0;
+				for (unsigned long b = 0; b < len; ++b)
+					diff |= keys[k * len + b] ^ keys[j * len + b];
+				ok &= diff != 0;
+			}
+		}
+		ecdh_keypool_get_stats(pool, &stats);
+		ok &= stats.hits == hits && stats.hits + stats.misses == takers * per_thread;
+		ok &= stats.generated >= stats.hits && hits >= 32;
+		ecdh_keypool_evict(pool);
+		ok &= keypool_test_slots_wiped(pool);
+		std::cout << std::left << std::setw(24) << "worker + 3 takers" << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Handshake-path cost of an ephemeral key: taken from a full pool vs.
+// generated on the spot, and the refill rate of one thread
+void benchmark_ecdh_keypool() {
+	const unsigned long runs = 64;
+	std::cout << "\n--- Benchmark: ephemeral key from the pool / generated inline ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right << std::setw(12)
+			<< "take ns" << std::setw(14) << "inline ns" << std::setw(14) << "refill/s" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		elliptic_curve_context_acquire(curve);
+		EcdhKeyPool *pool = &keypool_test_pool;
+		EcdhKeyPoolConfig config;
+		EcdhKeyPoolStats stats;
+		unsigned char priv[GF2_VECTOR_MAX_BYTELEN];
+		unsigned char pub[2 * GF2_VECTOR_MAX_BYTELEN];
+		ecdh_keypool_config_default(&config);
+		config.capacity = ECDH_KEYPOOL_MAX_CAPACITY;
+		config.batch = ECDH_KEYPOOL_MAX_BATCH;
+		config.random = keypool_test_random;
+		config.clock_ns = keypool_test_clock;
+		ecdh_keypool_init(pool, curve, &config);
+
+		double take_ns = 0, inline_ns = 0;
+		for (unsigned long r = 0; r < runs; r += ECDH_KEYPOOL_MAX_CAPACITY) {
+			while (ecdh_keypool_refill(pool))
+				;
+			auto t0 = std::chrono::steady_clock::now();
+			for (unsigned long i = 0; i < ECDH_KEYPOOL_MAX_CAPACITY; ++i)
+				ecdh_keypool_take(pool, priv, pub);
+			auto t1 = std::chrono::steady_clock::now();
+			take_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+		}
+		ecdh_keypool_get_stats(pool, &stats);
+		auto t0 = std::chrono::steady_clock::now();
+		for (unsigned long i = 0; i < runs; ++i)
+			ecdh_keypool_take(pool, priv, pub);     // empty pool: every take a miss
+		auto t1 = std::chrono::steady_clock::now();
+		inline_ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::right << std::fixed << std::setprecision(0)
+				<< std::setw(12) << take_ns / runs << std::setw(14) << inline_ns / runs
+				<< std::setw(14) << stats.refill_per_s << "\n";
+	}
+}
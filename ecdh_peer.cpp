@@ -0,0 +1,257 @@
+#include "ecdh_peer.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_scalar.h"
+
+#define PEER_DIGIT_COUNT EC_SCALAR_DIGIT_COUNT(GF2_VECTOR_MAX_BYTELEN)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PEER_NOINLINE __attribute__((noinline))
+#else
+#define PEER_NOINLINE
+#endif
+
+static void peer_wipe(void *p, unsigned long bytelen) {
+	volatile unsigned char *raw = (volatile unsigned char*) p;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		raw[i] = 0;
+}
+
+// Reduced coordinates and the ecdh_public_key_verify() checks
+static int peer_check(const EllipticCurve *curve, const unsigned char *public_key) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	long degree = gf2_degree_lsb(curve->modulus, len);
+
+	if (gf2_degree_lsb(public_key, len) >= degree
+			|| gf2_degree_lsb(public_key + y_offset, len) >= degree)
+		return 0;
+	// The verification only reads the key
+	return ecdh_public_key_verify(curve, (unsigned char*) public_key);
+}
+
+// Copies the key (dropping whatever the caller had in the padding between x
+// and y) and builds the odd multiples. Validated keys lie in the odd-order
+// subgroup, so with the halving maps every one of them is halvable; Koblitz
+// curves take tau-and-add for any point.
+static void peer_build(const EllipticCurve *curve, EcdhPreparedPeer *peer,
+		const unsigned char *public_key) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	alignas(8) EllipticCurvePoint twice = { };
+
+	peer_wipe(peer, sizeof(EcdhPreparedPeer));
+	for (unsigned long i = 0; i < len; ++i) {
+		peer->point.point_mem[i] = public_key[i];
+		peer->point.point_mem[i + y_offset] = public_key[i + y_offset];
+	}
+	peer->curve = curve;
+	gf2_mul_fixed_init(&peer->x_fixed, peer->point.point_mem, len);
+	if ((ctx && (ctx->flags & EC_CONTEXT_FLAG_HALVING))
+			|| elliptic_curve_binary_is_koblitz(curve)) {
+		peer->direct = 1;
+		return;
+	}
+	peer->table[0] = peer->point;
+	elliptic_curve_binary_point_double(curve, &twice, &peer->point);
+	for (unsigned long j = 1; j < EC_PEER_TABLE_SIZE; ++j)
+		elliptic_curve_binary_point_add(curve, &peer->table[j], &peer->table[j - 1], &twice);
+}
+
+int ecdh_peer_prepare(const EllipticCurve *curve, EcdhPreparedPeer *peer,
+		const unsigned char *public_key) {
+	if (!peer_check(curve, public_key)) {
+		peer_wipe(peer, sizeof(EcdhPreparedPeer));
+		return 0;
+	}
+	peer_build(curve, peer, public_key);
+	return 1;
+}
+
+// Keeps the digit array out of the frame that calls the halve-and-add path
+static PEER_NOINLINE void peer_multiply_wnaf(const EcdhPreparedPeer *peer,
+		const unsigned char *exp, EllipticCurvePoint *acc) {
+	const EllipticCurve *curve = peer->curve;
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	signed char digits[PEER_DIGIT_COUNT];
+	long top = 8 * (long) len;
+	elliptic_curve_scalar_recode_wnaf(exp, len, EC_PEER_WNAF_WIDTH, digits);
+	while (top >= 0 && !digits[top])
+		--top;
+
+	for (long d = top; d >= 0; --d) {
+		elliptic_curve_binary_point_double(curve, acc, acc);
+		int digit = digits[d];
+		if (digit > 0) {
+			elliptic_curve_binary_point_add(curve, acc, acc, &peer->table[digit >> 1]);
+		} else if (digit < 0) {
+			// -(x, y) = (x, x + y)
+			const EllipticCurvePoint *p = &peer->table[(-digit) >> 1];
+			alignas(8) EllipticCurvePoint neg = { };
+			for (unsigned long i = 0; i < len; ++i) {
+				neg.point_mem[i] = p->point_mem[i];
+				neg.point_mem[i + y_offset] = p->point_mem[i] ^ p->point_mem[i + y_offset];
+			}
+			elliptic_curve_binary_point_add(curve, acc, acc, &neg);
+		}
+	}
+	peer_wipe(digits, sizeof(digits));
+}
+
+void ecdh_generate_shared_secret_prepared(const EcdhPreparedPeer *peer,
+		const unsigned char *in_private_key, unsigned char *out_shared_secret) {
+	const EllipticCurve *curve = peer->curve;
+	unsigned long len = curve->field_size_bytes;
+	alignas(8) EllipticCurvePoint acc = { };
+#if ECDH_CONSTANT_TIME
+	elliptic_curve_binary_point_multiply_ct_fixed(curve, &acc, &peer->point,
+			&peer->x_fixed, in_private_key, len);
+#else
+	if (peer->direct)
+		elliptic_curve_binary_point_multiply(curve, &acc, &peer->point, in_private_key, len);
+	else
+		peer_multiply_wnaf(peer, in_private_key, &acc);
+#endif
+	for (unsigned long i = 0; i < len; ++i)
+		out_shared_secret[i] = acc.point_mem[i];
+	peer_wipe(&acc, sizeof(acc));
+}
+
+// FNV-1a 64 over both coordinates
+static unsigned long long peer_hash(const EllipticCurve *curve,
+		const unsigned char *public_key) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	unsigned long long h = 0xCBF29CE484222325ULL;
+	for (unsigned long i = 0; i < len; ++i) {
+		h = (h ^ public_key[i]) * 0x100000001B3ULL;
+		h = (h ^ public_key[i + y_offset]) * 0x100000001B3ULL;
+	}
+	return h ^ (h >> 29);
+}
+
+static int peer_matches(const EcdhPeerCacheEntry *e, const EllipticCurve *curve,
+		unsigned long long hash, const unsigned char *public_key) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	if (e->hash != hash || e->peer.curve != curve)
+		return 0;
+	for (unsigned long i = 0; i < len; ++i) {
+		if (e->peer.point.point_mem[i] != public_key[i]
+				|| e->peer.point.point_mem[i + y_offset] != public_key[i + y_offset])
+			return 0;
+	}
+	return 1;
+}
+
+static void peer_lru_unlink(EcdhPeerCache *cache, unsigned int index) {
+	EcdhPeerCacheEntry *e = &cache->entries[index];
+	if (e->lru_prev != EC_PEER_CACHE_NONE)
+		cache->entries[e->lru_prev].lru_next = e->lru_next;
+	else
+		cache->lru_head = e->lru_next;
+	if (e->lru_next != EC_PEER_CACHE_NONE)
+		cache->entries[e->lru_next].lru_prev = e->lru_prev;
+	else
+		cache->lru_tail = e->lru_prev;
+}
+
+static void peer_lru_push_front(EcdhPeerCache *cache, unsigned int index) {
+	EcdhPeerCacheEntry *e = &cache->entries[index];
+	e->lru_prev = EC_PEER_CACHE_NONE;
+	e->lru_next = cache->lru_head;
+	if (cache->lru_head != EC_PEER_CACHE_NONE)
+		cache->entries[cache->lru_head].lru_prev = index;
+	else
+		cache->lru_tail = index;
+	cache->lru_head = index;
+}
+
+static void peer_bucket_remove(EcdhPeerCache *cache, unsigned int index) {
+	unsigned int *link = &cache->buckets[cache->entries[index].hash & cache->bucket_mask];
+	while (*link != index)
+		link = &cache->entries[*link].chain_next;
+	*link = cache->entries[index].chain_next;
+}
+
+int ecdh_peer_cache_init(EcdhPeerCache *cache, EcdhPeerCacheEntry *entries,
+		unsigned int *buckets, unsigned long capacity) {
+	if (!cache || !entries || !buckets || !capacity
+			|| capacity > 0x80000000UL || (capacity & (capacity - 1)))
+		return 0;
+	peer_wipe(cache, sizeof(EcdhPeerCache));
+	cache->entries = entries;
+	cache->buckets = buckets;
+	cache->capacity = (unsigned int) capacity;
+	cache->bucket_mask = (unsigned int) (capacity - 1);
+	ecdh_peer_cache_clear(cache);
+	return 1;
+}
+
+void ecdh_peer_cache_clear(EcdhPeerCache *cache) {
+	peer_wipe(cache->entries, cache->capacity * sizeof(EcdhPeerCacheEntry));
+	for (unsigned int i = 0; i < cache->capacity; ++i) {
+		cache->buckets[i] = EC_PEER_CACHE_NONE;
+		cache->entries[i].chain_next = (i + 1 < cache->capacity) ? i + 1 : EC_PEER_CACHE_NONE;
+	}
+	cache->free_head = 0;
+	cache->lru_head = EC_PEER_CACHE_NONE;
+	cache->lru_tail = EC_PEER_CACHE_NONE;
+	cache->count = 0;
+}
+
+const EcdhPreparedPeer* ecdh_peer_cache_get(EcdhPeerCache *cache,
+		const EllipticCurve *curve, const unsigned char *public_key) {
+	unsigned long long hash = peer_hash(curve, public_key);
+	unsigned int *bucket = &cache->buckets[hash & cache->bucket_mask];
+
+	for (unsigned int i = *bucket; i != EC_PEER_CACHE_NONE; i = cache->entries[i].chain_next) {
+		if (peer_matches(&cache->entries[i], curve, hash, public_key)) {
+			++cache->hits;
+			if (cache->lru_head != i) {
+				peer_lru_unlink(cache, i);
+				peer_lru_push_front(cache, i);
+			}
+			return &cache->entries[i].peer;
+		}
+	}
+	++cache->misses;
+	// Checked before anything is evicted, so that invalid keys cannot flush
+	// the cache
+	if (!peer_check(curve, public_key)) {
+		++cache->rejected;
+		return 0;
+	}
+
+	unsigned int index = cache->free_head;
+	if (index != EC_PEER_CACHE_NONE) {
+		cache->free_head = cache->entries[index].chain_next;
+	} else {
+		index = cache->lru_tail;
+		peer_lru_unlink(cache, index);
+		peer_bucket_remove(cache, index);
+		--cache->count;
+		++cache->evictions;
+	}
+
+	EcdhPeerCacheEntry *e = &cache->entries[index];
+	peer_build(curve, &e->peer, public_key);
+	e->hash = hash;
+	e->in_use = 1;
+	e->chain_next = *bucket;
+	*bucket = index;
+	peer_lru_push_front(cache, index);
+	++cache->count;
+	return &e->peer;
+}
+
+int ecdh_generate_shared_secret_cached(EcdhPeerCache *cache,
+		const EllipticCurve *curve, const unsigned char *in_private_key,
+		const unsigned char *in_public_key, unsigned char *out_shared_secret) {
+	const EcdhPreparedPeer *peer = ecdh_peer_cache_get(cache, curve, in_public_key);
+	if (!peer)
+		return 0;
+	ecdh_generate_shared_secret_prepared(peer, in_private_key, out_shared_secret);
+	return 1;
+}
@@ -0,0 +1,95 @@
+#ifndef ECDH_PEER_H_
+#define ECDH_PEER_H_
+
+#include "ecdh.h"
+
+// Prepared peer keys, for repeated key agreement against the same static
+// public key (a server's long-term key, a fixed peer).
+//
+// ecdh_peer_prepare() does the per-key work once: it rejects non-canonical
+// coordinates, runs the ecdh_public_key_verify() checks (including the
+// subgroup multiplication, as expensive as a shared secret itself) and
+// builds a table of odd multiples for a width-EC_PEER_WNAF_WIDTH NAF.
+// ecdh_generate_shared_secret_prepared() then costs one wNAF multiplication:
+// about m doublings and m / (w + 1) additions instead of a verification plus
+// a double-and-add with m additions. On Koblitz curves (tau-and-add) and on
+// curves whose context enables point halving (halve-and-add)
+// elliptic_curve_binary_point_multiply is faster still; there the table is
+// not built and only the validation is saved.
+//
+// EcdhPeerCache keeps the most recently used prepared keys in caller-supplied
+// storage, keyed by curve and public-key bytes, and evicts the least recently
+// used one when full. Invalid keys are never cached. A cache is not
+// thread-safe: use one per thread, or lock around it.
+
+#ifndef EC_PEER_WNAF_WIDTH
+#define EC_PEER_WNAF_WIDTH (5)          // table of 2^(w-2) points
+#endif
+
+#define EC_PEER_TABLE_SIZE (1 << (EC_PEER_WNAF_WIDTH - 2))
+#define EC_PEER_CACHE_NONE (0xFFFFFFFFU)
+
+typedef struct alignas(8){
+	const EllipticCurve *curve;             // 0 until prepared
+	EllipticCurvePoint point;               // validated, zero padded
+	EllipticCurvePoint table[EC_PEER_TABLE_SIZE];   // table[j] = (2j + 1) point
+	int direct;                             // no table, elliptic_curve_binary_point_multiply
+	GF2FixedOperand x_fixed;                // x(point) multiplication table for the ladder
+}EcdhPreparedPeer;
+
+// public_key in the library's point layout (as ecdh_generate_public_key
+// writes it). Returns 1 and fills peer if the key is valid, 0 otherwise
+// (peer is then cleared).
+int ecdh_peer_prepare(const EllipticCurve *curve, EcdhPreparedPeer *peer,
+		const unsigned char *public_key);
+
+// Same result as ecdh_generate_shared_secret() with the prepared key.
+// Honours ECDH_CONSTANT_TIME (ladder on the validated point, no point
+// table; x_fixed spares the ladder building its x(P) table per call).
+void ecdh_generate_shared_secret_prepared(const EcdhPreparedPeer *peer,
+		const unsigned char *in_private_key, unsigned char *out_shared_secret);
+
+typedef struct alignas(8){
+	EcdhPreparedPeer peer;
+	unsigned long long hash;
+	unsigned int lru_prev;                  // towards the most recently used
+	unsigned int lru_next;
+	unsigned int chain_next;                // bucket chain / free list
+	unsigned int in_use;
+}EcdhPeerCacheEntry;
+
+typedef struct alignas(8){
+	EcdhPeerCacheEntry *entries;
+	unsigned int *buckets;
+	unsigned int capacity;
+	unsigned int bucket_mask;
+	unsigned int lru_head;                  // most recently used
+	unsigned int lru_tail;                  // next to be evicted
+	unsigned int free_head;
+	unsigned int count;
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned long long evictions;
+	unsigned long long rejected;            // invalid keys seen
+}EcdhPeerCache;
+
+// entries[capacity] and buckets[capacity]; capacity must be a power of two
+// (1 .. 2^31). Returns 0 on bad arguments.
+int ecdh_peer_cache_init(EcdhPeerCache *cache, EcdhPeerCacheEntry *entries,
+		unsigned int *buckets, unsigned long capacity);
+
+// Drops (and wipes) every entry; statistics are kept.
+void ecdh_peer_cache_clear(EcdhPeerCache *cache);
+
+// Looks the key up, preparing and inserting it on a miss. Returns 0 for an
+// invalid key. The pointer stays valid until the next call on this cache.
+const EcdhPreparedPeer* ecdh_peer_cache_get(EcdhPeerCache *cache,
+		const EllipticCurve *curve, const unsigned char *public_key);
+
+// ecdh_peer_cache_get() + ecdh_generate_shared_secret_prepared(). Returns 0
+// (and writes nothing) for an invalid peer key.
+int ecdh_generate_shared_secret_cached(EcdhPeerCache *cache,
+		const EllipticCurve *curve, const unsigned char *in_private_key,
+		const unsigned char *in_public_key, unsigned char *out_shared_secret);
+
+#endif /* ECDH_PEER_H_ */
@@ -0,0 +1,157 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "ecdh_peer.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x1CEB00DAUL)
+#include "ec_test_util.h"
+
+#define PEER_TEST_CACHE_CAPACITY (4)
+
+// Prepared and cached shared secrets against ecdh_generate_shared_secret,
+// rejection of bad keys, LRU order and counters
+static int peer_test_curve(const EllipticCurve *curve) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	static EcdhPeerCacheEntry entries[PEER_TEST_CACHE_CAPACITY];
+	static unsigned int buckets[PEER_TEST_CACHE_CAPACITY];
+	static EcdhPreparedPeer peer;
+	EcdhPeerCache cache;
+	alignas(8) unsigned char priv[6][GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char pub[6][2 * GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char expected[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char secret[GF2_VECTOR_MAX_BYTELEN];
+	int ok = ecdh_peer_cache_init(&cache, entries, buckets, PEER_TEST_CACHE_CAPACITY);
+	ok &= !ecdh_peer_cache_init(&cache, entries, buckets, 3);
+	ok &= ecdh_peer_cache_init(&cache, entries, buckets, PEER_TEST_CACHE_CAPACITY);
+
+	for (int k = 0; k < 6; ++k) {
+		ec_test_random_key(curve, priv[k]);
+		for (unsigned long i = 0; i < sizeof(pub[k]); ++i)
+			pub[k][i] = 0;
+		ecdh_generate_public_key(curve, priv[k], pub[k]);
+	}
+
+	// Prepared == plain, for every private key including 0 and 1
+	for (int k = 0; k < 6; ++k) {
+		ok &= ecdh_peer_prepare(curve, &peer, pub[k]);
+		for (int j = 0; j < 8; ++j) {
+			alignas(8) unsigned char d[GF2_VECTOR_MAX_BYTELEN] = { };
+			if (j < 6)
+				ec_test_random_key(curve, d);
+			else
+				d[0] = (unsigned char) (j - 6);
+			ecdh_generate_shared_secret(curve, d, pub[k], expected);
+			ecdh_generate_shared_secret_prepared(&peer, d, secret);
+			ok &= ec_test_bytes_equal(secret, expected, len);
+		}
+	}
+
+	// Bad keys: infinity, off the curve, unreduced x; none of them evicts
+	alignas(8) unsigned char bad[3][2 * GF2_VECTOR_MAX_BYTELEN] = { };
+	for (unsigned long i = 0; i < sizeof(bad[1]); ++i)
+		bad[1][i] = bad[2][i] = pub[0][i];
+	bad[1][y_offset] ^= 1;
+	bad[2][len - 1] ^= (unsigned char) (1U << ((curve->binary_degree & 7) ? (curve->binary_degree & 7) : 7));
+	for (int b = 0; b < 3; ++b) {
+		ok &= !ecdh_peer_prepare(curve, &peer, bad[b]);
+		ok &= peer.curve == 0;
+	}
+
+	// LRU: fill, touch key 0, insert key 4 -> key 1 is evicted
+	for (int k = 0; k < 4; ++k) {
+		ok &= ecdh_generate_shared_secret_cached(&cache, curve, priv[5], pub[k], secret);
+		ecdh_generate_shared_secret(curve, priv[5], pub[k], expected);
+		ok &= ec_test_bytes_equal(secret, expected, len);
+	}
+	ok &= ecdh_peer_cache_get(&cache, curve, pub[0]) != 0;
+	for (int b = 0; b < 3; ++b)
+		ok &= !ecdh_generate_shared_secret_cached(&cache, curve, priv[5], bad[b], secret);
+	ok &= cache.count == 4 && cache.evictions == 0 && cache.rejected == 3;
+	ok &= ecdh_peer_cache_get(&cache, curve, pub[4]) != 0;
+	ok &= cache.evictions == 1 && cache.count == 4;
+	unsigned long long misses = cache.misses;
+	ok &= ecdh_peer_cache_get(&cache, curve, pub[0]) != 0;
+	ok &= ecdh_peer_cache_get(&cache, curve, pub[2]) != 0;
+	ok &= ecdh_peer_cache_get(&cache, curve, pub[3]) != 0;
+	ok &= ecdh_peer_cache_get(&cache, curve, pub[4]) != 0;
+	ok &= cache.misses == misses;
+	ok &= ecdh_peer_cache_get(&cache, curve, pub[1]) != 0;
+	ok &= cache.misses == misses + 1 && cache.evictions == 2;
+	ok &= cache.hits == 5;
+
+	// Cached entries still give the right secrets after the churn
+	for (int k = 1; k < 5; ++k) {
+		ok &= ecdh_generate_shared_secret_cached(&cache, curve, priv[5], pub[k], secret);
+		ecdh_generate_shared_secret(curve, priv[5], pub[k], expected);
+		ok &= ec_test_bytes_equal(secret, expected, len);
+	}
+	ecdh_peer_cache_clear(&cache);
+	ok &= cache.count == 0 && ecdh_peer_cache_get(&cache, curve, pub[0]) != 0;
+	return ok;
+}
+
+int test_ecdh_peer() {
+	int failures = 0;
+	std::cout << "\n--- Testing prepared peer keys and the peer cache ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		int ok = peer_test_curve(curve);
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Per handshake against one static peer: verify + shared secret every time,
+// prepared key, and cache hits
+void benchmark_ecdh_peer() {
+	const int runs = 10;
+	static EcdhPeerCacheEntry entries[PEER_TEST_CACHE_CAPACITY];
+	static unsigned int buckets[PEER_TEST_CACHE_CAPACITY];
+	static EcdhPreparedPeer peer;
+	std::cout << "\n--- Benchmark: repeated ECDH against one static key (us/op) ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right
+			<< std::setw(16) << "verify+secret" << std::setw(10) << "prepare"
+			<< std::setw(10) << "prepared" << std::setw(12) << "cache hit" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		EcdhPeerCache cache;
+		alignas(8) unsigned char priv[GF2_VECTOR_MAX_BYTELEN];
+		alignas(8) unsigned char pub[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char secret[GF2_VECTOR_MAX_BYTELEN];
+		ecdh_peer_cache_init(&cache, entries, buckets, PEER_TEST_CACHE_CAPACITY);
+		ec_test_random_key(curve, priv);
+		ecdh_generate_public_key(curve, priv, pub);
+		ec_test_random_key(curve, priv);
+		ecdh_generate_shared_secret(curve, priv, pub, secret); // warm context
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r) {
+			ecdh_public_key_verify(curve, pub);
+			ecdh_generate_shared_secret(curve, priv, pub, secret);
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			ecdh_peer_prepare(curve, &peer, pub);
+		auto t2 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			ecdh_generate_shared_secret_prepared(&peer, priv, secret);
+		auto t3 = std::chrono::steady_clock::now();
+		ecdh_peer_cache_get(&cache, curve, pub);
+		auto t4 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			ecdh_generate_shared_secret_cached(&cache, curve, priv, pub, secret);
+		auto t5 = std::chrono::steady_clock::now();
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::right << std::fixed << std::setprecision(1)
+				<< std::setw(16) << ec_test_microseconds(t0, t1, runs)
+				<< std::setw(10) << ec_test_microseconds(t1, t2, runs)
+				<< std::setw(10) << ec_test_microseconds(t2, t3, runs)
+				<< std::setw(12) << ec_test_microseconds(t4, t5, runs) << "\n";
+	}
+}
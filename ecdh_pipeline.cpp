@@ -0,0 +1,318 @@
+#include "ecdh_pipeline.h"
+#include "elliptic_curve_batch.h"
+#include "ec_atomic.h"
+
+void ecdh_pipeline_config_default(EcdhPipelineConfig *config) {
+	config->capacity = 64;
+	for (int s = 0; s < ECDH_PIPELINE_STAGE_COUNT; ++s) {
+		config->batch[s] = 16;
+		config->workers[s] = 1;
+	}
+	config->submitters = 1;
+	config->collectors = 1;
+	config->clock_ns = 0;
+	config->clock_arg = 0;
+}
+
+static void pipeline_link_init(EcdhPipelineLink *link, unsigned long capacity,
+		unsigned int producers, unsigned int consumers) {
+	link->spsc = producers == 1 && consumers == 1;
+	if (link->spsc)
+		ec_spsc_queue_init(&link->spsc_queue, link->spsc_slots, capacity);
+	else
+		ec_mpmc_queue_init(&link->mpmc_queue, link->mpmc_slots, capacity);
+}
+
+// In-flight requests never exceed the queue capacity, so a push can only
+// fail while a consumer is between claiming a slot and releasing it
+static void pipeline_link_push(EcdhPipelineLink *link, EcdhPipelineRequest *req) {
+	if (link->spsc) {
+		while (!ec_spsc_queue_push(&link->spsc_queue, req))
+			EC_ATOMIC_PAUSE();
+	} else {
+		while (!ec_mpmc_queue_push(&link->mpmc_queue, req))
+			EC_ATOMIC_PAUSE();
+	}
+}
+
+static EcdhPipelineRequest* pipeline_link_pop(EcdhPipelineLink *link) {
+	if (link->spsc)
+		return (EcdhPipelineRequest*) ec_spsc_queue_pop(&link->spsc_queue);
+	return (EcdhPipelineRequest*) ec_mpmc_queue_pop(&link->mpmc_queue);
+}
+
+int ecdh_pipeline_init(EcdhPipeline *pipe, const EllipticCurve *curve,
+		const EcdhPipelineConfig *config) {
+	unsigned long capacity = config->capacity;
+	if (capacity < 2 || capacity > ECDH_PIPELINE_MAX_CAPACITY || (capacity & (capacity - 1)))
+		return 0;
+	for (int s = 0; s < ECDH_PIPELINE_STAGE_COUNT; ++s) {
+		if (config->batch[s] < 1 || config->batch[s] > ECDH_PIPELINE_MAX_BATCH
+				|| config->workers[s] < 1)
+			return 0;
+	}
+	if (config->submitters < 1 || config->collectors < 1)
+		return 0;
+
+	unsigned char *raw = (unsigned char*) pipe;
+	for (unsigned long i = 0; i < sizeof(EcdhPipeline); ++i)
+		raw[i] = 0;
+	pipe->curve = curve;
+	pipe->config = *config;
+	for (int l = 0; l <= ECDH_PIPELINE_STAGE_COUNT; ++l) {
+		unsigned int producers = l ? config->workers[l - 1] : config->submitters;
+		unsigned int consumers = (l < ECDH_PIPELINE_STAGE_COUNT)
+				? config->workers[l] : config->collectors;
+		pipeline_link_init(&pipe->links[l], capacity, producers, consumers);
+	}
+	return 1;
+}
+
+static unsigned long long pipeline_now(const EcdhPipeline *pipe) {
+	if (!pipe->config.clock_ns)
+		return 0;
+	return pipe->config.clock_ns(pipe->config.clock_arg);
+}
+
+int ecdh_pipeline_submit(EcdhPipeline *pipe, EcdhPipelineRequest *req) {
+	// Take a credit first; give it back if the pipeline was already full
+	if (EC_ATOMIC_FETCH_ADD(&pipe->in_flight, 1UL) >= pipe->config.capacity) {
+		EC_ATOMIC_FETCH_ADD(&pipe->in_flight, (unsigned long) -1L);
+		EC_ATOMIC_FETCH_ADD(&pipe->rejected, 1UL);
+		return 0;
+	}
+	req->status = ECDH_PIPELINE_STATUS_PENDING;
+	req->submit_ns = pipeline_now(pipe);
+	unsigned long long unset = 0;
+	EC_ATOMIC_CAS(&pipe->first_submit_ns, &unset, req->submit_ns);
+	EC_ATOMIC_FETCH_ADD(&pipe->submitted, 1UL);
+	pipeline_link_push(&pipe->links[0], req);
+	return 1;
+}
+
+// SEC 1 uncompressed point, big endian coordinates, into the LSB-first
+// point layout; rejects coordinates with bits at or above the field degree
+static int pipeline_decode_point(const EllipticCurve *curve, EcdhPipelineRequest *req) {
+	unsigned long len = curve->field_size_bytes;
+	const unsigned char *in = req->peer_public_key;
+	unsigned char *x = elliptic_curve_point_get_coord_x(curve, &req->point);
+	unsigned char *y = elliptic_curve_point_get_coord_y(curve, &req->point);
+
+	if (!in || req->peer_public_key_bytelen != 1 + 2 * len || in[0] != 0x04)
+		return 0;
+	for (unsigned long i = 0; i < len; ++i) {
+		x[i] = in[len - i];
+		y[i] = in[2 * len - i];
+	}
+	return gf2_degree_lsb(x, len) < (long) curve->binary_degree
+			&& gf2_degree_lsb(y, len) < (long) curve->binary_degree;
+}
+
+static int pipeline_point_is_infinity(const EllipticCurve *curve,
+		const EllipticCurvePoint *p) {
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < elliptic_curve_point_get_coord_full_bytelen(curve); ++i)
+		acc |= p->point_mem[i];
+	return acc == 0;
+}
+
+static void pipeline_wipe(void *p, unsigned long bytelen) {
+	volatile unsigned char *raw = (volatile unsigned char*) p;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		raw[i] = 0;
+}
+
+// Same checks as ecdh_public_key_verify, with the n * P subgroup test of the
+// whole batch run in lock step
+static void pipeline_validate(EcdhPipeline *pipe, EcdhPipelineRequest **reqs,
+		unsigned long count) {
+	const EllipticCurve *curve = pipe->curve;
+	EllipticCurvePoint results[ECDH_PIPELINE_MAX_BATCH];
+	EllipticCurvePoint *out[ECDH_PIPELINE_MAX_BATCH] = { };
+	const EllipticCurvePoint *in[ECDH_PIPELINE_MAX_BATCH] = { };
+	const unsigned char *exp[ECDH_PIPELINE_MAX_BATCH] = { };
+	EcdhPipelineRequest *checked[ECDH_PIPELINE_MAX_BATCH];
+	alignas(8) unsigned char scratch[ECDH_PIPELINE_MAX_BATCH * EC_BATCH_LANE_BYTELEN];
+	unsigned long n = 0;
+
+	for (unsigned long i = 0; i < count; ++i) {
+		EcdhPipelineRequest *req = reqs[i];
+		if (!pipeline_decode_point(curve, req) || pipeline_point_is_infinity(curve, &req->point)
+				|| !elliptic_curve_binary_point_on_curve(curve, &req->point)) {
+			req->status = ECDH_PIPELINE_STATUS_INVALID_KEY;
+			continue;
+		}
+		out[n] = &results[n];
+		in[n] = &req->point;
+		exp[n] = curve->order;
+		checked[n++] = req;
+	}
+	elliptic_curve_binary_point_multiply_batch(curve, out, in, exp, n,
+			curve->field_size_bytes, scratch, sizeof(scratch));
+	pipeline_wipe(scratch, sizeof(scratch));
+	for (unsigned long i = 0; i < n; ++i) {
+		if (!pipeline_point_is_infinity(curve, &results[i]))
+			checked[i]->status = ECDH_PIPELINE_STATUS_INVALID_KEY;
+	}
+}
+
+static void pipeline_compute(EcdhPipeline *pipe, EcdhPipelineRequest **reqs,
+		unsigned long count) {
+	const EllipticCurve *curve = pipe->curve;
+	EllipticCurvePoint *points[ECDH_PIPELINE_MAX_BATCH];
+	const unsigned char *exp[ECDH_PIPELINE_MAX_BATCH] = { };
+	unsigned long n = 0;
+
+	for (unsigned long i = 0; i < count; ++i) {
+		if (reqs[i]->status != ECDH_PIPELINE_STATUS_PENDING)
+			continue;
+		points[n] = &reqs[i]->point;
+		exp[n++] = reqs[i]->private_key;
+	}
+#if ECDH_CONSTANT_TIME
+	for (unsigned long i = 0; i < n; ++i)
+		elliptic_curve_binary_point_multiply_ct(curve, points[i], points[i], exp[i],
+				curve->field_size_bytes);
+#else
+	alignas(8) unsigned char scratch[ECDH_PIPELINE_MAX_BATCH * EC_BATCH_LANE_BYTELEN];
+	elliptic_curve_binary_point_multiply_batch(curve, points, points, exp, n,
+			curve->field_size_bytes, scratch, sizeof(scratch));
+	// The lanes hold scalar-dependent intermediates and the shared points
+	pipeline_wipe(scratch, sizeof(scratch));
+#endif
+}
+
+static unsigned long pipeline_latency_bucket(unsigned long long ns) {
+	const unsigned int sub = ECDH_PIPELINE_LATENCY_SUB_BITS;
+	if (ns < (1ULL << sub))
+		return (unsigned long) ns;
+	unsigned int e = 63;
+	while (!((ns >> e) & 1))
+		--e;
+	return ((e - sub + 1) << sub) + (unsigned long) ((ns >> (e - sub)) & ((1U << sub) - 1));
+}
+
+static unsigned long long pipeline_latency_bucket_upper(unsigned long bucket) {
+	const unsigned int sub = ECDH_PIPELINE_LATENCY_SUB_BITS;
+	if (bucket < (1UL << sub))
+		return bucket;
+	unsigned int e = (unsigned int) (bucket >> sub) + sub - 1;
+	unsigned long long lower = ((1ULL << sub) + (bucket & ((1UL << sub) - 1))) << (e - sub);
+	return lower + (1ULL << (e - sub)) - 1;
+}
+
+static void pipeline_encode(EcdhPipeline *pipe, EcdhPipelineRequest **reqs,
+		unsigned long count) {
+	const EllipticCurve *curve = pipe->curve;
+	unsigned long len = curve->field_size_bytes;
+	unsigned long long now = pipeline_now(pipe);
+
+	for (unsigned long i = 0; i < count; ++i) {
+		EcdhPipelineRequest *req = reqs[i];
+		if (req->status == ECDH_PIPELINE_STATUS_PENDING) {
+			if (pipeline_point_is_infinity(curve, &req->point)) {
+				req->status = ECDH_PIPELINE_STATUS_DEGENERATE;
+			} else {
+				for (unsigned long b = 0; b < len; ++b)
+					req->shared_secret[b] = req->point.point_mem[len - 1 - b];
+				req->status = ECDH_PIPELINE_STATUS_OK;
+			}
+		}
+		if (req->status != ECDH_PIPELINE_STATUS_OK)
+			EC_ATOMIC_FETCH_ADD(&pipe->invalid, 1UL);
+		for (unsigned long b = 0; b < sizeof(EllipticCurvePoint); ++b)
+			req->point.point_mem[b] = 0;    // the shared point is secret
+
+		if (pipe->config.clock_ns) {
+			unsigned long long latency = now - req->submit_ns;
+			unsigned long long max = EC_ATOMIC_LOAD_RELAXED(&pipe->latency_max_ns);
+			while (latency > max && !EC_ATOMIC_CAS(&pipe->latency_max_ns, &max, latency))
+				;
+			EC_ATOMIC_FETCH_ADD(&pipe->latency_buckets[pipeline_latency_bucket(latency)], 1UL);
+		}
+	}
+	if (pipe->config.clock_ns) {
+		// Workers finish out of order: keep the latest timestamp
+		unsigned long long last = EC_ATOMIC_LOAD_RELAXED(&pipe->last_complete_ns);
+		while (now > last && !EC_ATOMIC_CAS(&pipe->last_complete_ns, &last, now))
+			;
+	}
+	EC_ATOMIC_FETCH_ADD(&pipe->completed, count);
+}
+
+unsigned long ecdh_pipeline_run_stage(EcdhPipeline *pipe, int stage) {
+	EcdhPipelineRequest *reqs[ECDH_PIPELINE_MAX_BATCH];
+	unsigned long count = 0;
+
+	if (stage < 0 || stage >= ECDH_PIPELINE_STAGE_COUNT)
+		return 0;
+	while (count < pipe->config.batch[stage]) {
+		EcdhPipelineRequest *req = pipeline_link_pop(&pipe->links[stage]);
+		if (!req)
+			break;
+		reqs[count++] = req;
+	}
+	if (!count)
+		return 0;
+
+	if (stage == ECDH_PIPELINE_STAGE_VALIDATE)
+		pipeline_validate(pipe, reqs, count);
+	else if (stage == ECDH_PIPELINE_STAGE_COMPUTE)
+		pipeline_compute(pipe, reqs, count);
+	else
+		pipeline_encode(pipe, reqs, count);
+
+	EC_ATOMIC_FETCH_ADD(&pipe->stage_items[stage], count);
+	EC_ATOMIC_FETCH_ADD(&pipe->stage_batches[stage], 1UL);
+	for (unsigned long i = 0; i < count; ++i)
+		pipeline_link_push(&pipe->links[stage + 1], reqs[i]);
+	return count;
+}
+
+EcdhPipelineRequest* ecdh_pipeline_collect(EcdhPipeline *pipe) {
+	EcdhPipelineRequest *req = pipeline_link_pop(&pipe->links[ECDH_PIPELINE_STAGE_COUNT]);
+	if (req)
+		EC_ATOMIC_FETCH_ADD(&pipe->in_flight, (unsigned long) -1L);
+	return req;
+}
+
+void ecdh_pipeline_get_stats(const EcdhPipeline *pipe, EcdhPipelineStats *out) {
+	unsigned long total = 0;
+
+	out->submitted = EC_ATOMIC_LOAD_ACQUIRE(&pipe->submitted);
+	out->rejected = EC_ATOMIC_LOAD_ACQUIRE(&pipe->rejected);
+	out->completed = EC_ATOMIC_LOAD_ACQUIRE(&pipe->completed);
+	out->invalid = EC_ATOMIC_LOAD_ACQUIRE(&pipe->invalid);
+	out->in_flight = EC_ATOMIC_LOAD_ACQUIRE(&pipe->in_flight);
+	for (int s = 0; s < ECDH_PIPELINE_STAGE_COUNT; ++s) {
+		out->stage_items[s] = EC_ATOMIC_LOAD_ACQUIRE(&pipe->stage_items[s]);
+		out->stage_batches[s] = EC_ATOMIC_LOAD_ACQUIRE(&pipe->stage_batches[s]);
+	}
+	out->latency_max_ns = EC_ATOMIC_LOAD_ACQUIRE(&pipe->latency_max_ns);
+
+	unsigned long counts[ECDH_PIPELINE_LATENCY_BUCKETS];
+	for (unsigned long b = 0; b < ECDH_PIPELINE_LATENCY_BUCKETS; ++b) {
+		counts[b] = EC_ATOMIC_LOAD_RELAXED(&pipe->latency_buckets[b]);
+		total += counts[b];
+	}
+	out->latency_p50_ns = 0;
+	out->latency_p99_ns = 0;
+	unsigned long seen = 0;
+	int have_p50 = 0;
+	for (unsigned long b = 0; b < ECDH_PIPELINE_LATENCY_BUCKETS && total; ++b) {
+		seen += counts[b];
+		if (!have_p50 && 2 * seen >= total) {
+			out->latency_p50_ns = pipeline_latency_bucket_upper(b);
+			have_p50 = 1;
+		}
+		if (100 * seen >= 99 * total) {
+			out->latency_p99_ns = pipeline_latency_bucket_upper(b);
+			break;
+		}
+	}
+
+	unsigned long long first = EC_ATOMIC_LOAD_ACQUIRE(&pipe->first_submit_ns);
+	unsigned long long last = EC_ATOMIC_LOAD_ACQUIRE(&pipe->last_complete_ns);
+	out->throughput_per_s = (last > first)
+			? (unsigned long long) out->completed * 1000000000ULL / (last - first) : 0;
+}
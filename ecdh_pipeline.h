@@ -0,0 +1,130 @@
+#ifndef ECDH_PIPELINE_H_
+#define ECDH_PIPELINE_H_
+
+#include "ecdh.h"
+#include "ec_queue.h"
+
+// Streaming ECDH key agreement: requests flow through three stages,
+//   validate: decode the peer key (SEC 1 uncompressed, 04 || X || Y, big
+//             endian) and check it like ecdh_public_key_verify;
+//   compute:  shared point = private key * peer key;
+//   encode:   X of the shared point, big endian, into the caller's buffer;
+// and are then collected by the caller. Stages are linked by bounded
+// lock-free queues: SPSC where a link has one producer and one consumer
+// thread (per the config), MPMC otherwise.
+//
+// Backpressure: at most `capacity` requests are in flight (submitted but not
+// yet collected), so no queue can overflow; ecdh_pipeline_submit() fails
+// instead and the caller sheds or retries.
+//
+// The pipeline owns no threads. Workers call ecdh_pipeline_run_stage() in a
+// loop; one thread can also drive all stages round-robin. Each call takes up
+// to batch[stage] requests, and the arithmetic stages process the batch in
+// lock step so that every step needs one shared inversion
+// (elliptic_curve_batch.h). That path is variable time; with
+// ECDH_CONSTANT_TIME the compute stage runs the ladder per request instead.
+//
+// Latency is measured from submit to the end of the encode stage with the
+// caller's clock and kept in a log-linear histogram (8 sub-buckets per power
+// of two, i.e. percentiles within 12.5%).
+
+#define ECDH_PIPELINE_MAX_CAPACITY (256)    // in-flight requests, power of two
+#define ECDH_PIPELINE_MAX_BATCH    (32)
+
+#define ECDH_PIPELINE_STAGE_VALIDATE (0)
+#define ECDH_PIPELINE_STAGE_COMPUTE  (1)
+#define ECDH_PIPELINE_STAGE_ENCODE   (2)
+#define ECDH_PIPELINE_STAGE_COUNT    (3)
+
+#define ECDH_PIPELINE_STATUS_PENDING     (0)
+#define ECDH_PIPELINE_STATUS_OK          (1)
+#define ECDH_PIPELINE_STATUS_INVALID_KEY (2)    // malformed, not on the curve or not in the subgroup
+#define ECDH_PIPELINE_STATUS_DEGENERATE  (3)    // shared point is O (private key = 0 mod n)
+
+#define ECDH_PIPELINE_LATENCY_SUB_BITS (3)
+#define ECDH_PIPELINE_LATENCY_BUCKETS  ((64 - ECDH_PIPELINE_LATENCY_SUB_BITS + 1) << ECDH_PIPELINE_LATENCY_SUB_BITS)
+
+typedef struct {
+	// Filled in by the caller; the buffers must stay valid until collected
+	const unsigned char *peer_public_key;   // 1 + 2 * field_size_bytes bytes
+	unsigned long peer_public_key_bytelen;
+	const unsigned char *private_key;       // field_size_bytes, LSB first like ecdh.h
+	unsigned char *shared_secret;           // field_size_bytes out, big endian
+	void *user;
+	// Owned by the pipeline
+	int status;                             // ECDH_PIPELINE_STATUS_*
+	unsigned long long submit_ns;
+	alignas(8) EllipticCurvePoint point;    // decoded peer key, then the shared point
+}EcdhPipelineRequest;
+
+typedef struct {
+	unsigned long capacity;                 // power of two, <= ECDH_PIPELINE_MAX_CAPACITY
+	unsigned long batch[ECDH_PIPELINE_STAGE_COUNT];     // 1..ECDH_PIPELINE_MAX_BATCH
+	unsigned int submitters;                // threads calling ecdh_pipeline_submit
+	unsigned int workers[ECDH_PIPELINE_STAGE_COUNT];    // threads running each stage
+	unsigned int collectors;                // threads calling ecdh_pipeline_collect
+	unsigned long long (*clock_ns)(void *arg);  // monotonic clock, 0: no latency figures
+	void *clock_arg;
+}EcdhPipelineConfig;
+
+typedef struct {
+	int spsc;
+	EcSpscQueue spsc_queue;
+	EcMpmcQueue mpmc_queue;
+	void *spsc_slots[ECDH_PIPELINE_MAX_CAPACITY];
+	EcMpmcSlot mpmc_slots[ECDH_PIPELINE_MAX_CAPACITY];
+}EcdhPipelineLink;
+
+typedef struct {
+	const EllipticCurve *curve;
+	EcdhPipelineConfig config;
+	EcdhPipelineLink links[ECDH_PIPELINE_STAGE_COUNT + 1];  // [stage] feeds stage, last one feeds collect
+	unsigned long in_flight;
+	unsigned long submitted;
+	unsigned long rejected;                 // submit refused, pipeline full
+	unsigned long completed;
+	unsigned long invalid;                  // completed with an error status
+	unsigned long stage_items[ECDH_PIPELINE_STAGE_COUNT];
+	unsigned long stage_batches[ECDH_PIPELINE_STAGE_COUNT];
+	unsigned long long first_submit_ns;
+	unsigned long long last_complete_ns;
+	unsigned long long latency_max_ns;
+	unsigned long latency_buckets[ECDH_PIPELINE_LATENCY_BUCKETS];
+}EcdhPipeline;
+
+typedef struct {
+	unsigned long submitted;
+	unsigned long rejected;
+	unsigned long completed;
+	unsigned long invalid;
+	unsigned long in_flight;
+	unsigned long stage_items[ECDH_PIPELINE_STAGE_COUNT];
+	unsigned long stage_batches[ECDH_PIPELINE_STAGE_COUNT];
+	unsigned long long latency_p50_ns;      // bucket upper bounds
+	unsigned long long latency_p99_ns;
+	unsigned long long latency_max_ns;
+	unsigned long long throughput_per_s;    // completed over first submit .. last completion
+}EcdhPipelineStats;
+
+// Fills a config for one thread driving everything, batches of 16.
+void ecdh_pipeline_config_default(EcdhPipelineConfig *config);
+
+// Returns 0 on an invalid config.
+int ecdh_pipeline_init(EcdhPipeline *pipe, const EllipticCurve *curve,
+		const EcdhPipelineConfig *config);
+
+// Queues a request. Returns 0 (request untouched) when capacity requests are
+// already in flight.
+int ecdh_pipeline_submit(EcdhPipeline *pipe, EcdhPipelineRequest *req);
+
+// Runs one batch of a stage, returns the number of requests it moved on
+// (0: its input queue was empty).
+unsigned long ecdh_pipeline_run_stage(EcdhPipeline *pipe, int stage);
+
+// Takes one finished request out of the pipeline (status set, shared_secret
+// written if OK) and frees its slot; 0 if none is ready.
+EcdhPipelineRequest* ecdh_pipeline_collect(EcdhPipeline *pipe);
+
+void ecdh_pipeline_get_stats(const EcdhPipeline *pipe, EcdhPipelineStats *out);
+
+#endif /* ECDH_PIPELINE_H_ */
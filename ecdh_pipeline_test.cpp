@@ -0,0 +1,357 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include "ecdh_pipeline.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x3C6EF372UL)
+#include "ec_test_util.h"
+
+static unsigned long long pipeline_test_clock(void*) {
+	return (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int test_ec_queue() {
+	int failures = 0;
+	std::cout << "\n--- Testing lock-free SPSC / MPMC queues ---\n";
+
+	// SPSC: order preserved across threads, full and empty reported
+	{
+		static void *slots[64];
+		EcSpscQueue q;
+		int ok = ec_spsc_queue_init(&q, slots, 64) && !ec_spsc_queue_init(&q, slots, 48);
+		for (unsigned long i = 1; i <= 64; ++i)
+			ok &= ec_spsc_queue_push(&q, (void*) i);
+		ok &= !ec_spsc_queue_push(&q, (void*) 65UL) && ec_spsc_queue_size(&q) == 64;
+		for (unsigned long i = 1; i <= 64; ++i)
+			ok &= ec_spsc_queue_pop(&q) == (void*) i;
+		ok &= ec_spsc_queue_pop(&q) == 0;
+
+		const unsigned long n = 200000;
+		std::thread producer([&q, n]() {
+			for (unsigned long i = 1; i <= n; ++i)
+				while (!ec_spsc_queue_push(&q, (void*) i))
+					std::this_thread::yield();
+		});
+		for (unsigned long i = 1; i <= n; ++i) {
+			void *item;
+			while (!(item = ec_spsc_queue_pop(&q)))
+				std::this_thread::yield();
+			ok &= item == (void*) i;
+		}
+		producer.join();
+		std::cout << std::left << std::setw(24) << "spsc" << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// MPMC: 4 producers, 4 consumers, every item seen exactly once
+	{
+		static EcMpmcSlot slots[128];
+		EcMpmcQueue q;
+		int ok = ec_mpmc_queue_init(&q, slots, 128);
+		for (unsigned long i = 1; i <= 128; ++i)
+			ok &= ec_mpmc_queue_push(&q, (void*) i);
+		ok &= !ec_mpmc_queue_push(&q, (void*) 129UL);
+		for (unsigned long i = 1; i <= 128; ++i)
+			ok &= ec_mpmc_queue_pop(&q) == (void*) i;
+		ok &= ec_mpmc_queue_pop(&q) == 0;
+
+		const unsigned long per_thread = 50000;
+		std::vector<std::atomic<unsigned char> > seen(4 * per_thread + 1);
+		for (auto &s : seen)
+			s = 0;
+		std::atomic<unsigned long> consumed(0);
+		std::vector<std::thread> threads;
+		for (unsigned long t = 0; t < 4; ++t) {
+			threads.emplace_back([&q, t, per_thread]() {
+				for (unsigned long i = 1; i <= per_thread; ++i)
+					while (!ec_mpmc_queue_push(&q, (void*) (t * per_thread + i)))
+						std::this_thread::yield();
+			});
+			threads.emplace_back([&q, &seen, &consumed, per_thread]() {
+				while (consumed.load() < 4 * per_thread) {
+					void *item = ec_mpmc_queue_pop(&q);
+					if (!item) {
+						std::this_thread::yield();
+						continue;
+					}
+					seen[(unsigned long) item]++;
+					consumed++;
+				}
+			});
+		}
+		for (auto &t : threads)
+			t.join();
+		for (unsigned long i = 1; i <= 4 * per_thread; ++i)
+			ok &= seen[i] == 1;
+		std::cout << std::left << std::setw(24) << "mpmc 4x4" << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// One handshake: our private key, the peer's SEC 1 encoded public key and
+// the expected result
+typedef struct {
+	unsigned char private_key[GF2_VECTOR_MAX_BYTELEN];
+	unsigned char peer[1 + 2 * GF2_VECTOR_MAX_BYTELEN];
+	unsigned long peer_bytelen;
+	unsigned char expected[GF2_VECTOR_MAX_BYTELEN];
+	int expected_status;
+	unsigned char secret[GF2_VECTOR_MAX_BYTELEN];
+	EcdhPipelineRequest req;
+} PipelineTestCase;
+
+static void pipeline_test_encode(const EllipticCurve *curve, const unsigned char *pub,
+		unsigned char *out) {
+	unsigned long len = curve->field_size_bytes;
+	const unsigned char *x = elliptic_curve_point_get_coord_x(curve, (EllipticCurvePoint*) pub);
+	const unsigned char *y = elliptic_curve_point_get_coord_y(curve, (EllipticCurvePoint*) pub);
+	out[0] = 0x04;
+	for (unsigned long i = 0; i < len; ++i) {
+		out[1 + i] = x[len - 1 - i];
+		out[1 + len + i] = y[len - 1 - i];
+	}
+}
+
+// Valid keys plus one of each failure: bad prefix, truncated, off the curve,
+// the point of order 2 (on the curve, outside the subgroup), O, and a
+// private key of 0
+static void pipeline_test_make_cases(const EllipticCurve *curve,
+		std::vector<PipelineTestCase> &cases, unsigned long count) {
+	unsigned long len = curve->field_size_bytes;
+	cases.assign(count, PipelineTestCase());
+	for (unsigned long n = 0; n < count; ++n) {
+		PipelineTestCase &tc = cases[n];
+		alignas(8) unsigned char peer_priv[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char peer_pub[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char secret[GF2_VECTOR_MAX_BYTELEN] = { };
+		for (unsigned long i = 0; i + 1 < len; ++i) {
+			tc.private_key[i] = ec_test_random_byte();
+			peer_priv[i] = ec_test_random_byte();
+		}
+		ecdh_generate_public_key(curve, peer_priv, peer_pub);
+		tc.expected_status = ECDH_PIPELINE_STATUS_OK;
+
+		switch (n % 16) {
+		case 3:
+			peer_pub[0] ^= 1;       // off the curve
+			tc.expected_status = ECDH_PIPELINE_STATUS_INVALID_KEY;
+			break;
+		case 7:
+			for (unsigned long i = 0; i < 2 * GF2_VECTOR_MAX_BYTELEN; ++i)
+				peer_pub[i] = 0;
+			gf2_sqrt_lsb(curve->b, elliptic_curve_point_get_coord_y(curve,
+					(EllipticCurvePoint*) peer_pub), len, curve->modulus);
+			tc.expected_status = ECDH_PIPELINE_STATUS_INVALID_KEY;
+			break;
+		case 9:
+			for (unsigned long i = 0; i < 2 * GF2_VECTOR_MAX_BYTELEN; ++i)
+				peer_pub[i] = 0;
+			tc.expected_status = ECDH_PIPELINE_STATUS_INVALID_KEY;
+			break;
+		case 12:
+			for (unsigned long i = 0; i < len; ++i)
+				tc.private_key[i] = 0;
+			tc.expected_status = ECDH_PIPELINE_STATUS_DEGENERATE;
+			break;
+		}
+		pipeline_test_encode(curve, peer_pub, tc.peer);
+		tc.peer_bytelen = 1 + 2 * len;
+		if (n % 16 == 5) {
+			tc.peer[0] = 0x02;
+			tc.expected_status = ECDH_PIPELINE_STATUS_INVALID_KEY;
+		} else if (n % 16 == 10) {
+			tc.peer_bytelen -= 1;
+			tc.expected_status = ECDH_PIPELINE_STATUS_INVALID_KEY;
+		}
+		if (tc.expected_status == ECDH_PIPELINE_STATUS_OK) {
+			ecdh_generate_shared_secret(curve, tc.private_key, peer_pub, secret);
+			for (unsigned long i = 0; i < len; ++i)
+				tc.expected[i] = secret[len - 1 - i];
+		}
+		tc.req.peer_public_key = tc.peer;
+		tc.req.peer_public_key_bytelen = tc.peer_bytelen;
+		tc.req.private_key = tc.private_key;
+		tc.req.shared_secret = tc.secret;
+		tc.req.user = &tc;
+	}
+}
+
+static int pipeline_test_check(const EllipticCurve *curve, const PipelineTestCase &tc) {
+	if (tc.req.status != tc.expected_status)
+		return 0;
+	if (tc.expected_status != ECDH_PIPELINE_STATUS_OK)
+		return 1;
+	for (unsigned long i = 0; i < curve->field_size_bytes; ++i)
+		if (tc.secret[i] != tc.expected[i])
+			return 0;
+	return 1;
+}
+
+// One thread: submit until the pipeline pushes back, drive every stage,
+// collect; returns the number of requests collected correctly
+static unsigned long pipeline_test_drive(EcdhPipeline *pipe, const EllipticCurve *curve,
+		std::vector<PipelineTestCase> &cases, unsigned long *refusals) {
+	unsigned long next = 0, done = 0, good = 0;
+	while (done < cases.size()) {
+		while (next < cases.size() && ecdh_pipeline_submit(pipe, &cases[next].req))
+			++next;
+		if (next < cases.size())
+			++*refusals;
+		for (int s = 0; s < ECDH_PIPELINE_STAGE_COUNT; ++s)
+			ecdh_pipeline_run_stage(pipe, s);
+		while (EcdhPipelineRequest *req = ecdh_pipeline_collect(pipe)) {
+			good += pipeline_test_check(curve, *(PipelineTestCase*) req->user);
+			++done;
+		}
+	}
+	return good;
+}
+
+int test_ecdh_pipeline() {
+	int failures = 0;
+	std::cout << "\n--- Testing the streaming ECDH pipeline against ecdh_generate_shared_secret ---\n";
+	static EcdhPipeline pipe;
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		std::vector<PipelineTestCase> cases;
+		pipeline_test_make_cases(curve, cases, 64);
+
+		// Single thread, small capacity so that backpressure kicks in
+		EcdhPipelineConfig config;
+		ecdh_pipeline_config_default(&config);
+		config.capacity = 16;
+		config.batch[ECDH_PIPELINE_STAGE_COMPUTE] = 8;
+		config.clock_ns = pipeline_test_clock;
+		int ok = ecdh_pipeline_init(&pipe, curve, &config);
+		unsigned long refusals = 0;
+		ok &= pipeline_test_drive(&pipe, curve, cases, &refusals) == cases.size();
+		EcdhPipelineStats stats;
+		ecdh_pipeline_get_stats(&pipe, &stats);
+		ok &= refusals > 0 && stats.rejected >= refusals && stats.completed == cases.size()
+				&& stats.submitted == cases.size() && stats.in_flight == 0
+				&& stats.invalid == 6 * cases.size() / 16
+				&& stats.latency_p50_ns > 0 && stats.latency_p50_ns <= stats.latency_p99_ns
+				&& stats.latency_p99_ns <= 2 * stats.latency_max_ns;
+
+		// Two submitters, two workers per stage (MPMC links), one collector
+		for (PipelineTestCase &tc : cases)
+			tc.req.status = -1;
+		config.capacity = 32;
+		config.submitters = 2;
+		for (int s = 0; s < ECDH_PIPELINE_STAGE_COUNT; ++s)
+			config.workers[s] = 2;
+		ok &= ecdh_pipeline_init(&pipe, curve, &config);
+		std::atomic<int> stop(0);
+		std::vector<std::thread> threads;
+		for (unsigned long t = 0; t < 2; ++t) {
+			threads.emplace_back([&cases, t]() {
+				for (unsigned long n = t; n < cases.size(); n += 2)
+					while (!ecdh_pipeline_submit(&pipe, &cases[n].req))
+						std::this_thread::yield();
+			});
+			for (int s = 0; s < ECDH_PIPELINE_STAGE_COUNT; ++s) {
+				threads.emplace_back([&stop, s]() {
+					while (!stop.load())
+						if (!ecdh_pipeline_run_stage(&pipe, s))
+							std::this_thread::yield();
+				});
+			}
+		}
+		unsigned long good = 0;
+		for (unsigned long done = 0; done < cases.size();) {
+			EcdhPipelineRequest *req = ecdh_pipeline_collect(&pipe);
+			if (!req) {
+				std::this_thread::yield();
+				continue;
+			}
+			good += pipeline_test_check(curve, *(PipelineTestCase*) req->user);
+			++done;
+		}
+		stop = 1;
+		for (auto &t : threads)
+			t.join();
+		ok &= good == cases.size();
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	EcdhPipelineConfig bad;
+	ecdh_pipeline_config_default(&bad);
+	bad.capacity = 48;
+	int ok = !ecdh_pipeline_init(&pipe, elliptic_curve_registry_get(0)->curve, &bad);
+	ecdh_pipeline_config_default(&bad);
+	bad.batch[1] = ECDH_PIPELINE_MAX_BATCH + 1;
+	ok &= !ecdh_pipeline_init(&pipe, elliptic_curve_registry_get(0)->curve, &bad);
+	std::cout << std::left << std::setw(12) << "bad config" << (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+	return failures;
+}
+
+// Throughput and latency for a steady stream, batch size 1 (no shared
+// inversions) vs. 16, one thread driving everything vs. one thread per stage
+void benchmark_ecdh_pipeline() {
+	static EcdhPipeline pipe;
+	const EllipticCurve *curve = elliptic_curve_registry_find_curve("sect233k1");
+	if (!curve)
+		return;
+	std::vector<PipelineTestCase> cases;
+	pipeline_test_make_cases(curve, cases, 128);
+
+	std::cout << "\n--- Benchmark: ECDH pipeline, sect233k1, 128 requests ---\n";
+	std::cout << std::left << std::setw(26) << "setup" << std::right << std::setw(12) << "req/s"
+			<< std::setw(12) << "p50 (ms)" << std::setw(12) << "p99 (ms)" << "\n";
+	for (int threaded = 0; threaded < 2; ++threaded) {
+		for (unsigned long batch = 1; batch <= 16; batch *= 16) {
+			EcdhPipelineConfig config;
+			ecdh_pipeline_config_default(&config);
+			config.capacity = 64;
+			for (int s = 0; s < ECDH_PIPELINE_STAGE_COUNT; ++s)
+				config.batch[s] = batch;
+			config.clock_ns = pipeline_test_clock;
+			ecdh_pipeline_init(&pipe, curve, &config);
+
+			if (!threaded) {
+				unsigned long refusals = 0;
+				pipeline_test_drive(&pipe, curve, cases, &refusals);
+			} else {
+				std::atomic<int> stop(0);
+				std::vector<std::thread> threads;
+				threads.emplace_back([&cases]() {
+					for (PipelineTestCase &tc : cases)
+						while (!ecdh_pipeline_submit(&pipe, &tc.req))
+							std::this_thread::yield();
+				});
+				for (int s = 0; s < ECDH_PIPELINE_STAGE_COUNT; ++s) {
+					threads.emplace_back([&stop, s]() {
+						while (!stop.load())
+							if (!ecdh_pipeline_run_stage(&pipe, s))
+								std::this_thread::yield();
+					});
+				}
+				for (unsigned long done = 0; done < cases.size();)
+					done += ecdh_pipeline_collect(&pipe) != 0;
+				stop = 1;
+				for (auto &t : threads)
+					t.join();
+			}
+
+			EcdhPipelineStats stats;
+			ecdh_pipeline_get_stats(&pipe, &stats);
+			std::cout << std::left << std::setw(26)
+					<< (std::string(threaded ? "thread per stage" : "one thread")
+							+ ", batch " + std::to_string(batch))
+					<< std::right << std::setw(12) << stats.throughput_per_s
+					<< std::fixed << std::setprecision(1)
+					<< std::setw(12) << stats.latency_p50_ns / 1e6
+					<< std::setw(12) << stats.latency_p99_ns / 1e6 << "\n";
+		}
+	}
+}
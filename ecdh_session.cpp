@@ -0,0 +1,320 @@
+#include "ecdh_session.h"
+#include "elliptic_curve_batch.h"
+
+#define SESSION_LINE (64UL)
+
+static unsigned long session_round_line(unsigned long bytelen) {
+	return (bytelen + SESSION_LINE - 1) & ~(SESSION_LINE - 1);
+}
+
+static unsigned long session_stride(const EllipticCurve *curve) {
+	return (curve->field_size_bytes + 7UL) & (~7UL);
+}
+
+unsigned long ecdh_session_store_bytelen(const EllipticCurve *curve,
+		unsigned long capacity) {
+	return 4 * session_round_line(capacity * session_stride(curve))
+			+ session_round_line(capacity);
+}
+
+int ecdh_session_store_init(EcdhSessionStore *store, const EllipticCurve *curve,
+		unsigned long capacity, void *mem, unsigned long mem_bytelen) {
+	unsigned char *base = (unsigned char*) mem;
+	unsigned long stride = session_stride(curve);
+	unsigned long array_bytelen = session_round_line(capacity * stride);
+
+	if (!capacity || ((unsigned long) base & 7UL)
+			|| mem_bytelen < ecdh_session_store_bytelen(curve, capacity))
+		return 0;
+	for (unsigned long i = 0; i < ecdh_session_store_bytelen(curve, capacity); ++i)
+		base[i] = 0;
+	store->curve = curve;
+	store->capacity = capacity;
+	store->stride = stride;
+	store->used = 0;
+	store->hint = 0;
+	store->x = base;
+	store->y = base + array_bytelen;
+	store->scalar = base + 2 * array_bytelen;
+	store->secret = base + 3 * array_bytelen;
+	store->state = base + 4 * array_bytelen;
+	return 1;
+}
+
+static void session_wipe(unsigned char *p, unsigned long bytelen) {
+	volatile unsigned char *raw = (volatile unsigned char*) p;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		raw[i] = 0;
+}
+
+unsigned long ecdh_session_alloc(EcdhSessionStore *store) {
+	unsigned long capacity = store->capacity;
+	if (store->used == capacity)
+		return capacity;
+	for (unsigned long n = 0; n < capacity; ++n) {
+		unsigned long i = store->hint + n;
+		if (i >= capacity)
+			i -= capacity;
+		if (store->state[i] == ECDH_SESSION_FREE) {
+			store->state[i] = ECDH_SESSION_ALLOCATED;
+			store->hint = (i + 1 < capacity) ? i + 1 : 0;
+			++store->used;
+			return i;
+		}
+	}
+	return capacity;
+}
+
+unsigned long ecdh_session_alloc_range(EcdhSessionStore *store, unsigned long count) {
+	unsigned long capacity = store->capacity;
+	unsigned long run = 0;
+	if (!count || count > capacity - store->used)
+		return capacity;
+	for (unsigned long i = 0; i < capacity; ++i) {
+		run = (store->state[i] == ECDH_SESSION_FREE) ? run + 1 : 0;
+		if (run == count) {
+			unsigned long first = i + 1 - count;
+			for (unsigned long j = first; j <= i; ++j)
+				store->state[j] = ECDH_SESSION_ALLOCATED;
+			store->used += count;
+			return first;
+		}
+	}
+	return capacity;
+}
+
+void ecdh_session_free(EcdhSessionStore *store, unsigned long index) {
+	unsigned long stride = store->stride;
+	if (index >= store->capacity || store->state[index] == ECDH_SESSION_FREE)
+		return;
+	session_wipe(store->x + index * stride, stride);
+	session_wipe(store->y + index * stride, stride);
+	session_wipe(store->scalar + index * stride, stride);
+	session_wipe(store->secret + index * stride, stride);
+	store->state[index] = ECDH_SESSION_FREE;
+	--store->used;
+	if (index < store->hint)
+		store->hint = index;
+}
+
+int ecdh_session_state(const EcdhSessionStore *store, unsigned long index) {
+	return (index < store->capacity) ? store->state[index] : ECDH_SESSION_FREE;
+}
+
+unsigned char* ecdh_session_scalar(EcdhSessionStore *store, unsigned long index) {
+	return store->scalar + index * store->stride;
+}
+
+const unsigned char* ecdh_session_secret(const EcdhSessionStore *store, unsigned long index) {
+	return store->secret + index * store->stride;
+}
+
+// Slot coordinates to and from the point layout the multiplications take
+static void session_load_point(const EcdhSessionStore *store, unsigned long index,
+		EllipticCurvePoint *out) {
+	const EllipticCurve *curve = store->curve;
+	unsigned char *x = elliptic_curve_point_get_coord_x(curve, out);
+	unsigned char *y = elliptic_curve_point_get_coord_y(curve, out);
+	for (unsigned long i = 0; i < sizeof(out->point_mem); ++i)
+		out->point_mem[i] = 0;
+	for (unsigned long i = 0; i < curve->field_size_bytes; ++i) {
+		x[i] = store->x[index * store->stride + i];
+		y[i] = store->y[index * store->stride + i];
+	}
+}
+
+static void session_store_point(EcdhSessionStore *store, unsigned long index,
+		EllipticCurvePoint *in) {
+	const EllipticCurve *curve = store->curve;
+	const unsigned char *x = elliptic_curve_point_get_coord_x(curve, in);
+	const unsigned char *y = elliptic_curve_point_get_coord_y(curve, in);
+	for (unsigned long i = 0; i < curve->field_size_bytes; ++i) {
+		store->x[index * store->stride + i] = x[i];
+		store->y[index * store->stride + i] = y[i];
+	}
+}
+
+static int session_point_is_infinity(const EllipticCurve *curve,
+		const EllipticCurvePoint *p) {
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < elliptic_curve_point_get_coord_full_bytelen(curve); ++i)
+		acc |= p->point_mem[i];
+	return acc == 0;
+}
+
+int ecdh_session_get_public_key(const EcdhSessionStore *store, unsigned long index,
+		unsigned char *out_public_key) {
+	if (ecdh_session_state(store, index) != ECDH_SESSION_KEYED)
+		return 0;
+	session_load_point(store, index, (EllipticCurvePoint*) out_public_key);
+	return 1;
+}
+
+int ecdh_session_set_peer(EcdhSessionStore *store, unsigned long index,
+		const unsigned char *peer_public_key) {
+	if (ecdh_session_state(store, index) != ECDH_SESSION_KEYED)
+		return 0;
+	session_store_point(store, index, (EllipticCurvePoint*) peer_public_key);
+	store->state[index] = ECDH_SESSION_PEER;
+	return 1;
+}
+
+// Indices of up to ECDH_SESSION_BATCH slots in state, from *cursor on
+// (advanced past them) and before end
+static unsigned long session_gather(const EcdhSessionStore *store, unsigned long *cursor,
+		unsigned long end, int state, unsigned long *indices) {
+	unsigned long n = 0;
+	while (*cursor < end && n < ECDH_SESSION_BATCH) {
+		if (store->state[*cursor] == state)
+			indices[n++] = *cursor;
+		++*cursor;
+	}
+	return n;
+}
+
+static unsigned long session_range_end(const EcdhSessionStore *store,
+		unsigned long first, unsigned long count) {
+	if (first >= store->capacity)
+		return first;
+	return (count > store->capacity - first) ? store->capacity : first + count;
+}
+
+unsigned long ecdh_session_batch_keygen(EcdhSessionStore *store,
+		unsigned long first, unsigned long count) {
+	const EllipticCurve *curve = store->curve;
+	unsigned long end = session_range_end(store, first, count);
+	unsigned long cursor = first, done = 0, n;
+	unsigned long indices[ECDH_SESSION_BATCH];
+	EllipticCurvePoint points[ECDH_SESSION_BATCH];
+#if !ECDH_CONSTANT_TIME
+	alignas(8) EllipticCurvePoint base = { };
+	EllipticCurvePoint *out[ECDH_SESSION_BATCH];
+	const EllipticCurvePoint *in[ECDH_SESSION_BATCH];
+	const unsigned char *exp[ECDH_SESSION_BATCH];
+	alignas(8) unsigned char scratch[ECDH_SESSION_BATCH * EC_BATCH_LANE_BYTELEN];
+	for (unsigned long i = 0; i < curve->field_size_bytes; ++i) {
+		elliptic_curve_point_get_coord_x(curve, &base)[i] = curve->xG[i];
+		elliptic_curve_point_get_coord_y(curve, &base)[i] = curve->yG[i];
+	}
+#endif
+
+	while ((n = session_gather(store, &cursor, end, ECDH_SESSION_ALLOCATED, indices)) != 0) {
+#if ECDH_CONSTANT_TIME
+		for (unsigned long i = 0; i < n; ++i)
+			elliptic_curve_binary_point_multiply_base_ct(curve, &points[i],
+					ecdh_session_scalar(store, indices[i]), curve->field_size_bytes);
+#else
+		for (unsigned long i = 0; i < n; ++i) {
+			out[i] = &points[i];
+			in[i] = &base;
+			exp[i] = ecdh_session_scalar(store, indices[i]);
+		}
+		elliptic_curve_binary_point_multiply_batch(curve, out, in, exp, n,
+				curve->field_size_bytes, scratch, sizeof(scratch));
+#endif
+		for (unsigned long i = 0; i < n; ++i) {
+			session_store_point(store, indices[i], &points[i]);
+			store->state[indices[i]] = ECDH_SESSION_KEYED;
+		}
+		done += n;
+	}
+#if !ECDH_CONSTANT_TIME
+	session_wipe(scratch, sizeof(scratch));
+#endif
+	return done;
+}
+
+// ecdh_public_key_verify's checks, the n * P test run in lock step
+unsigned long ecdh_session_batch_verify(EcdhSessionStore *store,
+		unsigned long first, unsigned long count) {
+	const EllipticCurve *curve = store->curve;
+	unsigned long len = curve->field_size_bytes;
+	unsigned long end = session_range_end(store, first, count);
+	unsigned long cursor = first, done = 0, n;
+	unsigned long indices[ECDH_SESSION_BATCH];
+	unsigned long checked[ECDH_SESSION_BATCH];
+	EllipticCurvePoint points[ECDH_SESSION_BATCH];
+	EllipticCurvePoint *out[ECDH_SESSION_BATCH];
+	const EllipticCurvePoint *in[ECDH_SESSION_BATCH];
+	const unsigned char *exp[ECDH_SESSION_BATCH];
+	alignas(8) unsigned char scratch[ECDH_SESSION_BATCH * EC_BATCH_LANE_BYTELEN];
+
+	while ((n = session_gather(store, &cursor, end, ECDH_SESSION_PEER, indices)) != 0) {
+		unsigned long m = 0;
+		for (unsigned long i = 0; i < n; ++i) {
+			unsigned long index = indices[i];
+			session_load_point(store, index, &points[m]);
+			if (gf2_degree_lsb(store->x + index * store->stride, len) >= (long) curve->binary_degree
+					|| gf2_degree_lsb(store->y + index * store->stride, len) >= (long) curve->binary_degree
+					|| session_point_is_infinity(curve, &points[m])
+					|| !elliptic_curve_binary_point_on_curve(curve, &points[m])) {
+				store->state[index] = ECDH_SESSION_INVALID;
+				continue;
+			}
+			out[m] = &points[m];
+			in[m] = &points[m];
+			exp[m] = curve->order;
+			checked[m++] = index;
+		}
+		elliptic_curve_binary_point_multiply_batch(curve, out, in, exp, m, len,
+				scratch, sizeof(scratch));
+		for (unsigned long i = 0; i < m; ++i) {
+			int ok = session_point_is_infinity(curve, &points[i]);
+			store->state[checked[i]] = ok ? ECDH_SESSION_VERIFIED : ECDH_SESSION_INVALID;
+			done += ok;
+		}
+	}
+	return done;
+}
+
+unsigned long ecdh_session_batch_secret(EcdhSessionStore *store,
+		unsigned long first, unsigned long count) {
+	const EllipticCurve *curve = store->curve;
+	unsigned long len = curve->field_size_bytes;
+	unsigned long end = session_range_end(store, first, count);
+	unsigned long cursor = first, done = 0, n;
+	unsigned long indices[ECDH_SESSION_BATCH];
+	EllipticCurvePoint points[ECDH_SESSION_BATCH];
+#if !ECDH_CONSTANT_TIME
+	EllipticCurvePoint *out[ECDH_SESSION_BATCH];
+	const EllipticCurvePoint *in[ECDH_SESSION_BATCH];
+	const unsigned char *exp[ECDH_SESSION_BATCH];
+	alignas(8) unsigned char scratch[ECDH_SESSION_BATCH * EC_BATCH_LANE_BYTELEN];
+#endif
+
+	while ((n = session_gather(store, &cursor, end, ECDH_SESSION_VERIFIED, indices)) != 0) {
+		for (unsigned long i = 0; i < n; ++i)
+			session_load_point(store, indices[i], &points[i]);
+#if ECDH_CONSTANT_TIME
+		for (unsigned long i = 0; i < n; ++i)
+			elliptic_curve_binary_point_multiply_ct(curve, &points[i], &points[i],
+					ecdh_session_scalar(store, indices[i]), len);
+#else
+		for (unsigned long i = 0; i < n; ++i) {
+			out[i] = &points[i];
+			in[i] = &points[i];
+			exp[i] = ecdh_session_scalar(store, indices[i]);
+		}
+		elliptic_curve_binary_point_multiply_batch(curve, out, in, exp, n, len,
+				scratch, sizeof(scratch));
+#endif
+		for (unsigned long i = 0; i < n; ++i) {
+			unsigned long index = indices[i];
+			if (session_point_is_infinity(curve, &points[i])) {
+				store->state[index] = ECDH_SESSION_INVALID;
+			} else {
+				for (unsigned long b = 0; b < len; ++b)
+					store->secret[index * store->stride + b] = points[i].point_mem[b];
+				store->state[index] = ECDH_SESSION_SECRET;
+				++done;
+			}
+			session_wipe(store->scalar + index * store->stride, store->stride);
+		}
+	}
+	// the shared points are secret
+	session_wipe((unsigned char*) points, sizeof(points));
+#if !ECDH_CONSTANT_TIME
+	session_wipe(scratch, sizeof(scratch));
+#endif
+	return done;
+}
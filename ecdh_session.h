@@ -0,0 +1,95 @@
+#ifndef ECDH_SESSION_H_
+#define ECDH_SESSION_H_
+
+#include "ecdh.h"
+
+// Structure-of-arrays session table for servers holding many concurrent ECDH
+// sessions, in place of one ecdh_keygroup_t per session.
+//
+// ecdh_keygroup_t sizes every field by GF2_VECTOR_MAX_BYTELEN (128 bytes a
+// session whatever the curve). The store keeps x, y, scalar and secret in
+// four separate arrays, each element curve-sized (field_size_bytes rounded
+// up to 8) and each array starting on a cache line, plus one state byte per
+// slot: 97 bytes a session on a 163-bit curve, and a batch walks four dense
+// streams instead of strided blobs.
+//
+// A session goes through
+//   ecdh_session_alloc()                 FREE     -> ALLOCATED
+//   write ecdh_session_scalar()          (private key, LSB first)
+//   ecdh_session_batch_keygen()          ALLOCATED -> KEYED    x, y = own public key
+//   ecdh_session_set_peer()              KEYED    -> PEER      x, y = peer public key
+//   ecdh_session_batch_verify()          PEER     -> VERIFIED or INVALID
+//   ecdh_session_batch_secret()          VERIFIED -> SECRET or INVALID
+//   ecdh_session_free()                  any      -> FREE, slot wiped
+// The batch calls take an index range and act on the slots in it that are
+// in the matching state; the rest are skipped. They process up to
+// ECDH_SESSION_BATCH sessions in lock step with one shared inversion per
+// step (elliptic_curve_batch.h), or run the ladder per session with
+// ECDH_CONSTANT_TIME. The secret step wipes the scalar, the session's key
+// material is then only the secret.
+//
+// The caller supplies the memory (ecdh_session_store_bytelen() bytes,
+// 64-byte aligned for the cache-line claim). The store is not thread safe;
+// give each thread its own store or its own index ranges, and keep
+// allocation on one thread.
+
+#define ECDH_SESSION_BATCH (32)
+
+#define ECDH_SESSION_FREE      (0)
+#define ECDH_SESSION_ALLOCATED (1)
+#define ECDH_SESSION_KEYED     (2)
+#define ECDH_SESSION_PEER      (3)
+#define ECDH_SESSION_VERIFIED  (4)
+#define ECDH_SESSION_SECRET    (5)
+#define ECDH_SESSION_INVALID   (6)  // peer key rejected or shared point O
+
+typedef struct {
+	const EllipticCurve *curve;
+	unsigned long capacity;
+	unsigned long stride;                   // bytes per element
+	unsigned long used;
+	unsigned long hint;                     // where the allocator looks next
+	unsigned char *x;
+	unsigned char *y;
+	unsigned char *scalar;
+	unsigned char *secret;
+	unsigned char *state;
+}EcdhSessionStore;
+
+unsigned long ecdh_session_store_bytelen(const EllipticCurve *curve,
+		unsigned long capacity);
+
+// Returns 0 if mem is too small or not 8-byte aligned. All slots start FREE.
+int ecdh_session_store_init(EcdhSessionStore *store, const EllipticCurve *curve,
+		unsigned long capacity, void *mem, unsigned long mem_bytelen);
+
+// Returns a slot index, or capacity when the store is full.
+unsigned long ecdh_session_alloc(EcdhSessionStore *store);
+// count adjacent slots (first fit), for batch calls over one range; returns
+// the first index, or capacity when there is no such run.
+unsigned long ecdh_session_alloc_range(EcdhSessionStore *store, unsigned long count);
+void ecdh_session_free(EcdhSessionStore *store, unsigned long index);
+
+int ecdh_session_state(const EcdhSessionStore *store, unsigned long index);
+unsigned char* ecdh_session_scalar(EcdhSessionStore *store, unsigned long index);
+const unsigned char* ecdh_session_secret(const EcdhSessionStore *store, unsigned long index);
+
+// Own public key of a KEYED session in the point layout of ecdh.h
+// (out has room for an EllipticCurvePoint). Returns 0 in any other state.
+int ecdh_session_get_public_key(const EcdhSessionStore *store, unsigned long index,
+		unsigned char *out_public_key);
+// Peer public key, point layout; the session must be KEYED. Returns 0
+// otherwise.
+int ecdh_session_set_peer(EcdhSessionStore *store, unsigned long index,
+		const unsigned char *peer_public_key);
+
+// Each returns how many sessions of [first, first + count) reached the next
+// state.
+unsigned long ecdh_session_batch_keygen(EcdhSessionStore *store,
+		unsigned long first, unsigned long count);
+unsigned long ecdh_session_batch_verify(EcdhSessionStore *store,
+		unsigned long first, unsigned long count);
+unsigned long ecdh_session_batch_secret(EcdhSessionStore *store,
+		unsigned long first, unsigned long count);
+
+#endif /* ECDH_SESSION_H_ */
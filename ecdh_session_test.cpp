@@ -0,0 +1,157 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "ecdh_session.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x5E550045UL)
+#include "ec_test_util.h"
+
+static int session_test_zero(const unsigned char *a, unsigned long len) {
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < len; ++i)
+		acc |= a[i];
+	return acc == 0;
+}
+
+// Whole session life cycle through the batch calls against ecdh.h on every
+// registry curve, with invalid peers mixed in, and the slot allocator
+int test_ecdh_session() {
+	int failures = 0;
+	std::cout << "\n--- Testing the structure-of-arrays session store ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned long len = curve->field_size_bytes;
+		unsigned long full = elliptic_curve_point_get_coord_full_bytelen(curve);
+		const unsigned long capacity = 45;              // two batches, the second partial
+		std::vector<unsigned long long> mem((ecdh_session_store_bytelen(curve, capacity) + 7) / 8);
+		EcdhSessionStore store;
+		int ok = !ecdh_session_store_init(&store, curve, capacity, mem.data(), 8 * mem.size() - 64);
+		ok &= ecdh_session_store_init(&store, curve, capacity, mem.data(), 8 * mem.size());
+		ok &= store.stride == ((len + 7) & ~7UL);
+
+		// Fill the store, then punch holes and refill them
+		for (unsigned long i = 0; i < capacity; ++i)
+			ok &= ecdh_session_alloc(&store) == i;
+		ok &= ecdh_session_alloc(&store) == capacity;
+		ecdh_session_free(&store, 7);
+		ecdh_session_free(&store, 3);
+		ok &= ecdh_session_alloc(&store) == 3 && ecdh_session_alloc(&store) == 7;
+		for (unsigned long i = 10; i < 14; ++i)
+			ecdh_session_free(&store, i);
+		ok &= ecdh_session_alloc_range(&store, 5) == capacity;
+		ok &= ecdh_session_alloc_range(&store, 4) == 10 && store.used == capacity;
+
+		// Peers: generated with ecdh.h; every 5th one broken
+		unsigned char peer_keys[capacity][GF2_VECTOR_MAX_BYTELEN];
+		EllipticCurvePoint peers[capacity], own[capacity];
+		for (unsigned long i = 0; i < capacity; ++i) {
+			ec_test_random_key(curve, ecdh_session_scalar(&store, i));
+			ec_test_random_key(curve, peer_keys[i]);
+			peers[i] = EllipticCurvePoint { };
+			own[i] = EllipticCurvePoint { };
+			ecdh_generate_public_key(curve, peer_keys[i], peers[i].point_mem);
+			if (i % 5 == 4)
+				elliptic_curve_point_get_coord_y(curve, &peers[i])[0] ^= 1;
+		}
+		// Slot 0 stays ALLOCATED while the rest move on: the range calls skip it
+		ok &= ecdh_session_batch_keygen(&store, 1, capacity - 1) == capacity - 1;
+		ok &= ecdh_session_state(&store, 0) == ECDH_SESSION_ALLOCATED;
+		ok &= ecdh_session_batch_keygen(&store, 0, 1) == 1;
+
+		for (unsigned long i = 0; i < capacity; ++i) {
+			unsigned char expected[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+			ok &= ecdh_session_get_public_key(&store, i, own[i].point_mem);
+			ecdh_generate_public_key(curve, ecdh_session_scalar(&store, i), expected);
+			ok &= ec_test_bytes_equal(own[i].point_mem, expected, full);
+			ok &= ecdh_session_set_peer(&store, i, peers[i].point_mem);
+		}
+		ok &= !ecdh_session_set_peer(&store, 0, peers[0].point_mem);
+
+		unsigned long valid = capacity - capacity / 5;
+		ok &= ecdh_session_batch_verify(&store, 0, capacity) == valid;
+		ok &= ecdh_session_batch_secret(&store, 0, 2 * capacity) == valid;
+		for (unsigned long i = 0; i < capacity; ++i) {
+			int broken = i % 5 == 4;
+			ok &= ecdh_session_state(&store, i)
+					== (broken ? ECDH_SESSION_INVALID : ECDH_SESSION_SECRET);
+			if (broken)
+				continue;
+			unsigned char secret[GF2_VECTOR_MAX_BYTELEN];
+			ecdh_generate_shared_secret(curve, peer_keys[i], own[i].point_mem, secret);
+			ok &= ec_test_bytes_equal(ecdh_session_secret(&store, i), secret, len);
+			ok &= session_test_zero(ecdh_session_scalar(&store, i), store.stride);
+		}
+
+		// Freeing wipes every array
+		for (unsigned long i = 0; i < capacity; ++i)
+			ecdh_session_free(&store, i);
+		ok &= store.used == 0;
+		ok &= session_test_zero(store.x, capacity * store.stride)
+				&& session_test_zero(store.y, capacity * store.stride)
+				&& session_test_zero(store.scalar, capacity * store.stride)
+				&& session_test_zero(store.secret, capacity * store.stride);
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Sessions per second for keygen + verify + secret: one ecdh_keygroup_t per
+// session through ecdh.h vs. the store's batch calls, and bytes per session
+void benchmark_ecdh_session() {
+	const unsigned long sessions = 128;
+	std::cout << "\n--- Benchmark: per-session ecdh_keygroup_t / session store batches ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right << std::setw(16)
+			<< "bytes/session" << std::setw(24) << "handshakes/s" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		elliptic_curve_context_acquire(curve);
+		std::vector<ecdh_keygroup_t> groups(sessions);
+		std::vector<EllipticCurvePoint> peers(sessions);
+		for (unsigned long i = 0; i < sessions; ++i) {
+			unsigned char key[GF2_VECTOR_MAX_BYTELEN] = { };
+			ec_test_random_key(curve, key);
+			ecdh_generate_public_key(curve, key, peers[i].point_mem);
+			ec_test_random_key(curve, groups[i].private_key);
+		}
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (unsigned long i = 0; i < sessions; ++i) {
+			ecdh_generate_public_key(curve, groups[i].private_key, groups[i].public_key);
+			if (ecdh_public_key_verify(curve, peers[i].point_mem))
+				ecdh_generate_shared_secret(curve, groups[i].private_key, peers[i].point_mem,
+						groups[i].shared_secret);
+		}
+		auto t1 = std::chrono::steady_clock::now();
+
+		std::vector<unsigned long long> mem((ecdh_session_store_bytelen(curve, sessions) + 7) / 8);
+		EcdhSessionStore store;
+		ecdh_session_store_init(&store, curve, sessions, mem.data(), 8 * mem.size());
+		unsigned long first = ecdh_session_alloc_range(&store, sessions);
+		for (unsigned long i = 0; i < sessions; ++i) {
+			for (unsigned long b = 0; b < curve->field_size_bytes; ++b)
+				ecdh_session_scalar(&store, first + i)[b] = groups[i].private_key[b];
+		}
+		auto t2 = std::chrono::steady_clock::now();
+		ecdh_session_batch_keygen(&store, first, sessions);
+		for (unsigned long i = 0; i < sessions; ++i)
+			ecdh_session_set_peer(&store, first + i, peers[i].point_mem);
+		ecdh_session_batch_verify(&store, first, sessions);
+		ecdh_session_batch_secret(&store, first, sessions);
+		auto t3 = std::chrono::steady_clock::now();
+
+		double blob = sessions / std::chrono::duration<double>(t1 - t0).count();
+		double soa = sessions / std::chrono::duration<double>(t3 - t2).count();
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::right << std::setw(8) << sizeof(ecdh_keygroup_t) << " /"
+				<< std::setw(6) << ecdh_session_store_bytelen(curve, sessions) / sessions
+				<< std::fixed << std::setprecision(0) << std::setw(14) << blob << " /"
+				<< std::setw(7) << soa << "\n";
+	}
+}
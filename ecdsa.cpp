@@ -0,0 +1,349 @@
+#include "ecdsa.h"
+#include "ecdh_kdf.h"
+#include "elliptic_curve_batch.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_modn.h"
+#include "elliptic_curve_msm.h"
+
+typedef struct {
+	unsigned char k[ECDH_SHA256_BYTELEN];
+	unsigned char v[ECDH_SHA256_BYTELEN];
+	int started;
+}EcdsaNonceState;
+
+static void ecdsa_wipe(void *p, unsigned long bytelen) {
+	volatile unsigned char *raw = (volatile unsigned char*) p;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		raw[i] = 0;
+}
+
+// bits2int (RFC 6979 2.3.2): the leftmost bits bits of the big-endian in,
+// as (bits + 7) / 8 bytes LSB first
+static void ecdsa_bits2int(const unsigned char *in, unsigned long bytelen,
+		unsigned long bits, unsigned char *out) {
+	unsigned long shift = (8 * bytelen > bits) ? 8 * bytelen - bits : 0;
+	for (unsigned long i = 0; i < (bits + 7) / 8; ++i) {
+		unsigned long j = shift / 8 + i;    // byte j of the value, LSB first
+		unsigned int lo = (j < bytelen) ? in[bytelen - 1 - j] : 0;
+		unsigned int hi = (j + 1 < bytelen) ? in[bytelen - 2 - j] : 0;
+		out[i] = (unsigned char) ((lo >> (shift % 8)) | (hi << (8 - shift % 8)));
+	}
+}
+
+// out = in mod n; returns 1 if in (bytelen bytes, LSB first) already was in
+// [1, n - 1]
+static int ecdsa_scalar_load(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned char *in, unsigned long bytelen) {
+	unsigned char back[GF2_VECTOR_MAX_BYTELEN] = { };
+	unsigned char diff = 0;
+	elliptic_curve_modn_from_bytes(m, out, in, bytelen);
+	elliptic_curve_modn_to_bytes(m, back, out);
+	for (unsigned long i = 0; i < bytelen; ++i)
+		diff |= in[i] ^ back[i];
+	ecdsa_wipe(back, sizeof(back));
+	return (diff == 0) & !elliptic_curve_modn_is_zero(m, out);
+}
+
+// bytelen bytes LSB first, zero above n's bytes
+static void ecdsa_scalar_store(const EllipticCurveModN *m, unsigned char *out,
+		const unsigned long long *in, unsigned long bytelen) {
+	for (unsigned long i = m->bytelen; i < bytelen; ++i)
+		out[i] = 0;
+	elliptic_curve_modn_to_bytes(m, out, in);
+}
+
+// e = bits2int(digest) mod n
+static void ecdsa_digest_load(const EllipticCurveModN *m, unsigned long long *e,
+		const unsigned char *digest, unsigned long digest_bytelen) {
+	unsigned char buf[GF2_VECTOR_MAX_BYTELEN];
+	ecdsa_bits2int(digest, digest_bytelen, m->bits, buf);
+	elliptic_curve_modn_from_bytes(m, e, buf, m->bytelen);
+}
+
+static int ecdsa_point_is_infinity(const EllipticCurve *curve, const EllipticCurvePoint *p) {
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < elliptic_curve_point_get_coord_full_bytelen(curve); ++i)
+		acc |= p->point_mem[i];
+	return acc == 0;
+}
+
+static void ecdsa_base_point(const EllipticCurve *curve, EllipticCurvePoint *out) {
+	for (unsigned long i = 0; i < sizeof(out->point_mem); ++i)
+		out->point_mem[i] = 0;
+	unsigned char *x = elliptic_curve_point_get_coord_x(curve, out);
+	unsigned char *y = elliptic_curve_point_get_coord_y(curve, out);
+	for (unsigned long i = 0; i < curve->field_size_bytes; ++i) {
+		x[i] = curve->xG[i];
+		y[i] = curve->yG[i];
+	}
+}
+
+// x(X) mod n == r, for the point X = u1 G + u2 Q
+static int ecdsa_x_matches(const EllipticCurve *curve, const EllipticCurveModN *m,
+		const EllipticCurvePoint *X, const unsigned long long *r) {
+	unsigned long long v[EC_MODN_LIMBS];
+	if (ecdsa_point_is_infinity(curve, X))
+		return 0;
+	elliptic_curve_modn_from_bytes(m, v, X->point_mem, curve->field_size_bytes);
+	return elliptic_curve_modn_equal(m, v, r);
+}
+
+// X = u1 G + u2 Q. The joint sparse form costs a doubling per bit plus an
+// addition per third of the bits. Where a single multiplication is cheaper
+// than that (Frobenius on Koblitz curves, halving), the comb for u1 G, that
+// multiplication for u2 Q and one addition win instead.
+static void ecdsa_joint_multiply(const EllipticCurve *curve, EllipticCurvePoint *X,
+		const EllipticCurvePoint *G, const unsigned char *u1,
+		const EllipticCurvePoint *Q, const unsigned char *u2) {
+	unsigned long len = curve->field_size_bytes;
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	if (elliptic_curve_binary_is_koblitz(curve)
+			|| (ctx && (ctx->flags & EC_CONTEXT_FLAG_HALVING))) {
+		alignas(8) EllipticCurvePoint P1, P2;
+		elliptic_curve_binary_point_multiply_base(curve, &P1, u1, len);
+		elliptic_curve_binary_point_multiply(curve, &P2, Q, u2, len);
+		elliptic_curve_binary_point_add(curve, X, &P1, &P2);
+	} else {
+		elliptic_curve_msm2(curve, X, G, u1, Q, u2, len);
+	}
+}
+
+// HMAC-SHA-256 keyed with a 32-byte key over the concatenation of parts.
+// out may alias the key or a part.
+static void ecdsa_hmac(const unsigned char *key, const unsigned char *const *parts,
+		const unsigned long *bytelens, int count, unsigned char *out) {
+	unsigned char pad[ECDH_SHA256_BLOCK_BYTELEN];
+	unsigned char inner[ECDH_SHA256_BYTELEN];
+	EcdhSha256 h;
+	for (unsigned long i = 0; i < ECDH_SHA256_BLOCK_BYTELEN; ++i)
+		pad[i] = (unsigned char) ((i < ECDH_SHA256_BYTELEN ? key[i] : 0) ^ 0x36);
+	ecdh_sha256_init(&h);
+	ecdh_sha256_update(&h, pad, sizeof(pad));
+	for (int i = 0; i < count; ++i)
+		ecdh_sha256_update(&h, parts[i], bytelens[i]);
+	ecdh_sha256_final(&h, inner);
+	for (unsigned long i = 0; i < ECDH_SHA256_BLOCK_BYTELEN; ++i)
+		pad[i] ^= 0x36 ^ 0x5c;
+	ecdh_sha256_init(&h);
+	ecdh_sha256_update(&h, pad, sizeof(pad));
+	ecdh_sha256_update(&h, inner, sizeof(inner));
+	ecdh_sha256_final(&h, out);
+	ecdsa_wipe(pad, sizeof(pad));
+	ecdsa_wipe(inner, sizeof(inner));
+}
+
+// K = HMAC_K(V || sep || extra), V = HMAC_K(V); extra may be empty
+static void ecdsa_nonce_update(EcdsaNonceState *st, unsigned char sep,
+		const unsigned char *x, const unsigned char *h, unsigned long rlen) {
+	const unsigned char *parts[4] = { st->v, &sep, x, h };
+	unsigned long bytelens[4] = { ECDH_SHA256_BYTELEN, 1, rlen, rlen };
+	ecdsa_hmac(st->k, parts, bytelens, x ? 4 : 2, st->k);
+	parts[0] = st->v;
+	ecdsa_hmac(st->k, parts, bytelens, 1, st->v);
+}
+
+// RFC 6979 3.2 b-f with int2octets(x) and bits2octets(h1) = int2octets(e)
+static void ecdsa_nonce_init(EcdsaNonceState *st, const EllipticCurveModN *m,
+		const unsigned long long *d, const unsigned long long *e) {
+	unsigned char x[GF2_VECTOR_MAX_BYTELEN], h[GF2_VECTOR_MAX_BYTELEN];
+	unsigned char le[GF2_VECTOR_MAX_BYTELEN];
+	unsigned long rlen = m->bytelen;
+	elliptic_curve_modn_to_bytes(m, le, d);
+	for (unsigned long i = 0; i < rlen; ++i)
+		x[i] = le[rlen - 1 - i];
+	elliptic_curve_modn_to_bytes(m, le, e);
+	for (unsigned long i = 0; i < rlen; ++i)
+		h[i] = le[rlen - 1 - i];
+	for (unsigned long i = 0; i < ECDH_SHA256_BYTELEN; ++i) {
+		st->v[i] = 0x01;
+		st->k[i] = 0x00;
+	}
+	st->started = 0;
+	ecdsa_nonce_update(st, 0x00, x, h, rlen);
+	ecdsa_nonce_update(st, 0x01, x, h, rlen);
+	ecdsa_wipe(x, sizeof(x));
+	ecdsa_wipe(le, sizeof(le));
+}
+
+// RFC 6979 3.2 h: the next candidate k = bits2int(T); every call after the
+// first steps K and V past the rejected one. Returns 1 if k is in [1, n - 1].
+static int ecdsa_nonce_next(EcdsaNonceState *st, const EllipticCurveModN *m,
+		unsigned long long *k) {
+	unsigned char t[GF2_VECTOR_MAX_BYTELEN + ECDH_SHA256_BYTELEN];
+	unsigned char buf[GF2_VECTOR_MAX_BYTELEN];
+	unsigned long rlen = m->bytelen;
+	const unsigned char *parts[1] = { st->v };
+	unsigned long bytelens[1] = { ECDH_SHA256_BYTELEN };
+
+	if (st->started)
+		ecdsa_nonce_update(st, 0x00, 0, 0, 0);
+	st->started = 1;
+	for (unsigned long got = 0; got < rlen; got += ECDH_SHA256_BYTELEN) {
+		ecdsa_hmac(st->k, parts, bytelens, 1, st->v);
+		for (unsigned long i = 0; i < ECDH_SHA256_BYTELEN; ++i)
+			t[got + i] = st->v[i];
+	}
+	ecdsa_bits2int(t, rlen, m->bits, buf);
+	int ok = ecdsa_scalar_load(m, k, buf, rlen);
+	ecdsa_wipe(t, sizeof(t));
+	ecdsa_wipe(buf, sizeof(buf));
+	return ok;
+}
+
+int ecdsa_sign(const EllipticCurve *curve, const unsigned char *private_key,
+		const unsigned char *digest, unsigned long digest_bytelen,
+		int (*random)(void *arg, unsigned char *out, unsigned long bytelen), void *random_arg,
+		unsigned char *r, unsigned char *s) {
+	unsigned long len = curve->field_size_bytes;
+	EllipticCurveModN scratch;
+	const EllipticCurveModN *m = elliptic_curve_modn_get(curve, &scratch);
+	unsigned long long d[EC_MODN_LIMBS], e[EC_MODN_LIMBS], k[EC_MODN_LIMBS];
+	unsigned long long rr[EC_MODN_LIMBS], ss[EC_MODN_LIMBS];
+	unsigned char k_bytes[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) EllipticCurvePoint R = { };
+	EcdsaNonceState nonce;
+	int ok = 0;
+
+	for (unsigned long i = 0; i < len; ++i)
+		r[i] = s[i] = 0;
+	if (!m)
+		return 0;
+	elliptic_curve_modn_from_bytes(m, d, private_key, len);
+	ecdsa_digest_load(m, e, digest, digest_bytelen);
+	if (!random)
+		ecdsa_nonce_init(&nonce, m, d, e);
+
+	for (int attempt = 0; attempt < ECDSA_MAX_NONCES && !ok
+			&& !elliptic_curve_modn_is_zero(m, d); ++attempt) {
+		if (random) {
+			if (!elliptic_curve_modn_random(m, k, random, random_arg))
+				break;
+		} else if (!ecdsa_nonce_next(&nonce, m, k)) {
+			continue;
+		}
+		elliptic_curve_modn_to_bytes(m, k_bytes, k);
+#if ECDH_CONSTANT_TIME
+		elliptic_curve_binary_point_multiply_base_ct(curve, &R, k_bytes, len);
+#else
+		elliptic_curve_binary_point_multiply_base(curve, &R, k_bytes, len);
+#endif
+		// r = x(k G) mod n, s = k^-1 (e + r d) mod n
+		elliptic_curve_modn_from_bytes(m, rr, R.point_mem, len);
+		if (elliptic_curve_modn_is_zero(m, rr))
+			continue;
+		elliptic_curve_modn_mul(m, ss, rr, d);
+		elliptic_curve_modn_add(m, ss, ss, e);
+		elliptic_curve_modn_inv(m, k, k);
+		elliptic_curve_modn_mul(m, ss, k, ss);
+		ok = !elliptic_curve_modn_is_zero(m, ss);
+	}
+	if (ok) {
+		ecdsa_scalar_store(m, r, rr, len);
+		ecdsa_scalar_store(m, s, ss, len);
+	}
+	ecdsa_wipe(d, sizeof(d));
+	ecdsa_wipe(k, sizeof(k));
+	ecdsa_wipe(k_bytes, sizeof(k_bytes));
+	ecdsa_wipe(&R, sizeof(R));
+	ecdsa_wipe(&nonce, sizeof(nonce));
+	return ok;
+}
+
+int ecdsa_verify(const EllipticCurve *curve, const unsigned char *public_key,
+		const unsigned char *digest, unsigned long digest_bytelen,
+		const unsigned char *r, const unsigned char *s) {
+	unsigned long len = curve->field_size_bytes;
+	EllipticCurveModN scratch;
+	const EllipticCurveModN *m = elliptic_curve_modn_get(curve, &scratch);
+	const EllipticCurvePoint *Q = (const EllipticCurvePoint*) public_key;
+	unsigned long long rr[EC_MODN_LIMBS], w[EC_MODN_LIMBS], e[EC_MODN_LIMBS];
+	unsigned long long u[EC_MODN_LIMBS];
+	unsigned char u1[GF2_VECTOR_MAX_BYTELEN] = { }, u2[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) EllipticCurvePoint G, X = { };
+
+	if (!m || !ecdsa_scalar_load(m, rr, r, len) || !ecdsa_scalar_load(m, w, s, len)
+			|| ecdsa_point_is_infinity(curve, Q)
+			|| !elliptic_curve_binary_point_on_curve(curve, Q))
+		return 0;
+	ecdsa_digest_load(m, e, digest, digest_bytelen);
+
+	// u1 = e / s, u2 = r / s, X = u1 G + u2 Q
+	elliptic_curve_modn_inv(m, w, w);
+	elliptic_curve_modn_mul(m, u, e, w);
+	elliptic_curve_modn_to_bytes(m, u1, u);
+	elliptic_curve_modn_mul(m, u, rr, w);
+	elliptic_curve_modn_to_bytes(m, u2, u);
+	ecdsa_base_point(curve, &G);
+	ecdsa_joint_multiply(curve, &X, &G, u1, Q, u2);
+	return ecdsa_x_matches(curve, m, &X, rr);
+}
+
+unsigned long ecdsa_verify_batch(const EllipticCurve *curve,
+		const unsigned char *const *public_keys, const unsigned char *const *digests,
+		unsigned long digest_bytelen, const unsigned char *const *r,
+		const unsigned char *const *s, unsigned long count, int *ok) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long valid_total = 0;
+	EllipticCurveModN scratch_modn;
+	const EllipticCurveModN *m = elliptic_curve_modn_get(curve, &scratch_modn);
+	unsigned long long rr[ECDSA_VERIFY_BATCH][EC_MODN_LIMBS];
+	unsigned long long ss[ECDSA_VERIFY_BATCH][EC_MODN_LIMBS];
+	unsigned long long w[ECDSA_VERIFY_BATCH][EC_MODN_LIMBS];
+	unsigned long long e[ECDSA_VERIFY_BATCH][EC_MODN_LIMBS];
+	unsigned long long u[EC_MODN_LIMBS];
+	unsigned char u_bytes[2 * ECDSA_VERIFY_BATCH][GF2_VECTOR_MAX_BYTELEN];
+	const unsigned char *exps[2 * ECDSA_VERIFY_BATCH];
+	alignas(8) EllipticCurvePoint G, X, P[2 * ECDSA_VERIFY_BATCH];
+	EllipticCurvePoint *outs[2 * ECDSA_VERIFY_BATCH];
+	const EllipticCurvePoint *ins[2 * ECDSA_VERIFY_BATCH];
+	alignas(8) unsigned char scratch[2 * ECDSA_VERIFY_BATCH * EC_BATCH_LANE_BYTELEN];
+	unsigned long index[ECDSA_VERIFY_BATCH];
+
+	for (unsigned long i = 0; i < count; ++i)
+		ok[i] = 0;
+	if (!m)
+		return 0;
+	ecdsa_base_point(curve, &G);
+
+	for (unsigned long first = 0; first < count; first += ECDSA_VERIFY_BATCH) {
+		unsigned long n = count - first, valid = 0;
+		if (n > ECDSA_VERIFY_BATCH)
+			n = ECDSA_VERIFY_BATCH;
+
+		// Signatures failing the range and key checks drop out here
+		for (unsigned long i = 0; i < n; ++i) {
+			const EllipticCurvePoint *Q = (const EllipticCurvePoint*) public_keys[first + i];
+			if (!ecdsa_scalar_load(m, rr[valid], r[first + i], len)
+					|| !ecdsa_scalar_load(m, ss[valid], s[first + i], len)
+					|| ecdsa_point_is_infinity(curve, Q)
+					|| !elliptic_curve_binary_point_on_curve(curve, Q))
+				continue;
+			ecdsa_digest_load(m, e[valid], digests[first + i], digest_bytelen);
+			index[valid++] = first + i;
+		}
+		if (!valid)
+			continue;
+
+		elliptic_curve_modn_batch_inv(m, w, (const unsigned long long (*)[EC_MODN_LIMBS]) ss, valid);
+		for (unsigned long j = 0; j < valid; ++j) {
+			for (unsigned long b = 0; b < 2; ++b) {
+				for (unsigned long i = 0; i < len; ++i)
+					u_bytes[2 * j + b][i] = 0;
+				elliptic_curve_modn_mul(m, u, b ? rr[j] : e[j], w[j]);
+				elliptic_curve_modn_to_bytes(m, u_bytes[2 * j + b], u);
+				exps[2 * j + b] = u_bytes[2 * j + b];
+				outs[2 * j + b] = &P[2 * j + b];
+			}
+			ins[2 * j] = &G;
+			ins[2 * j + 1] = (const EllipticCurvePoint*) public_keys[index[j]];
+		}
+		elliptic_curve_binary_point_multiply_batch(curve, outs, ins, exps, 2 * valid, len,
+				scratch, sizeof(scratch));
+		for (unsigned long j = 0; j < valid; ++j) {
+			elliptic_curve_binary_point_add(curve, &X, &P[2 * j], &P[2 * j + 1]);
+			ok[index[j]] = ecdsa_x_matches(curve, m, &X, rr[j]);
+			valid_total += (unsigned long) ok[index[j]];
+		}
+	}
+	return valid_total;
+}
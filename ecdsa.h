@@ -0,0 +1,58 @@
+#ifndef ECDSA_H_
+#define ECDSA_H_
+
+#include "ecdh.h"
+
+// ECDSA (SEC 1 4.1, FIPS 186) over the binary curves, with the key layout
+// of ecdh.h: private keys field_size_bytes bytes LSB first, public keys in
+// the point layout. r and s are field_size_bytes bytes each, LSB first. The
+// digest is the hash output as it comes (big endian octets, any length); its
+// leftmost bits(n) bits are the integer e.
+//
+// Signing computes k G with the fixed-base comb of the curve context
+// (elliptic_curve_binary_point_multiply_base, the ladder with
+// ECDH_CONSTANT_TIME), the scalar arithmetic with elliptic_curve_modn.h. The
+// nonce comes from the caller's random source, or with random == 0 from
+// RFC 6979 (HMAC-SHA-256), deterministic per key and digest. A few leaked
+// bits of many nonces are enough to recover the key, so builds signing on
+// shared hardware want ECDH_CONSTANT_TIME.
+//
+// Verification checks r, s in [1, n - 1] and that the public key is a point
+// of the curve other than O, then computes u1 G + u2 Q: as one joint-sparse-
+// form multiplication (elliptic_curve_msm2), or on Koblitz curves and curves
+// with point halving as the comb for u1 G plus one Frobenius or halving
+// multiplication for u2 Q, which needs fewer affine additions there. Full key
+// validation (n Q = O, ecdh_public_key_verify) is left to the caller, once
+// per key.
+//
+// ecdsa_verify_batch() gives the same verdict per signature, for batches of
+// signatures under any keys: one batch inversion of the s values, then all
+// 2 count multiplications u1 G, u2 Q in lock step with one shared field
+// inversion per step (elliptic_curve_batch.h). Verification only handles
+// public values and is variable time.
+
+#ifndef ECDSA_MAX_NONCES
+#define ECDSA_MAX_NONCES (64)       // nonce candidates; RFC 6979 rejects up to half
+#endif
+#define ECDSA_VERIFY_BATCH (16)     // signatures per lock-step pass
+
+// Returns 1, or 0 on a zero private key, a failing random source or no
+// usable nonce (r and s are then zeroed).
+int ecdsa_sign(const EllipticCurve *curve, const unsigned char *private_key,
+		const unsigned char *digest, unsigned long digest_bytelen,
+		int (*random)(void *arg, unsigned char *out, unsigned long bytelen), void *random_arg,
+		unsigned char *r, unsigned char *s);
+
+// Returns 1 if (r, s) is a valid signature of digest under public_key.
+int ecdsa_verify(const EllipticCurve *curve, const unsigned char *public_key,
+		const unsigned char *digest, unsigned long digest_bytelen,
+		const unsigned char *r, const unsigned char *s);
+
+// ok[i] = ecdsa_verify(curve, public_keys[i], digests[i], digest_bytelen,
+// r[i], s[i]) for count signatures. Returns how many are valid.
+unsigned long ecdsa_verify_batch(const EllipticCurve *curve,
+		const unsigned char *const *public_keys, const unsigned char *const *digests,
+		unsigned long digest_bytelen, const unsigned char *const *r,
+		const unsigned char *const *s, unsigned long count, int *ok);
+
+#endif /* ECDSA_H_ */
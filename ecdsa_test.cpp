@@ -0,0 +1,255 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "ecdsa.h"
+#include "ecdh_kdf.h"
+#include "elliptic_curve_msm.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0xEC050048UL)
+#include "ec_test_util.h"
+
+static int ecdsa_test_random_source(void *arg, unsigned char *out, unsigned long bytelen) {
+	for (unsigned long i = 0; i < bytelen; ++i)
+		out[i] = ec_test_random_byte();
+	return arg == 0;
+}
+
+typedef struct {
+	const char *curve;
+	const char *x, *ux, *uy;
+	const char *r_sample, *s_sample, *r_test, *s_test;
+}EcdsaTestVector;
+
+// RFC 6979 A.2 keys and messages with SHA-256 (K-163, B-163, K-233, B-233)
+static const EcdsaTestVector ecdsa_test_vectors[] = {
+	{ "sect163k1", "09A4D6792295A7F730FC3F2B49CBC0F62E862272F",
+		"79AEE090DB05EC252D5CB4452F356BE198A4FF96F", "782E29634DDC9A31EF40386E896BAA18B53AFA5A3",
+		"113A63990598A3828C407C0F4D2438D990DF99A7F", "1313A2E03F5412DDB296A22E2C455335545672D9F",
+		"354D5CD24F9C41F85D02E856FA2B0001C83AF53E", "20B200677731CD4FE48612A92F72A19853A82B65" },
+	{ "sect163r2", "35318FC447D48D7E6BC93B48617DDDEDF26AA658F",
+		"126CF562D95A1D77D387BA75A3EA3A1407F23425A", "7D7CB5273C94DA8CA93049AFDA18721C24672BD71",
+		"134E00F78FC1CB9501675D91C401DE20DDF228CDC", "373273AEC6C36CB7BAFBB1903A5F5EA6A1D50B624",
+		"227DF377B3FA50F90C1CB3CDCBBDBA552C1D35104", "1F7BEAD92583FE920D353F368C1960D0E88B46A56" },
+	{ "sect233k1", "103B2142BDC2A3C3B55080D09DF1808F79336DA2399F5CA7171D1BE9B0",
+		"682886F36C68473C1A221720C2B12B9BE13458BA907E1C4736595779F2",
+		"1B20639B41BE0927090999B7817A3B3928D20503A39546044EC13A10309",
+		"38AD9C1D2CB29906E7D63C24601AC55736B438FB14F4093D6C32F63A10",
+		"647AAD2599C21B6EE89BE7FF957D98F684B7921DE1FD3CC82C079624F4",
+		"5E4E6B4DB0E13034E7F1F2E5DBAB766D37C15AE4056C7EE607C8AC7F4",
+		"5FC46AA489BF828B34FBAD25EC432190F161BEA8F60D3FCADB0EE3B725" },
+	{ "sect233r1", "07ADC13DD5BF34D1DDEEB50B2CE23B5F5E6D18067306D60C5F6FF11E5D3",
+		"FB348B3246B473AA7FBB2A01B78D61B62C4221D0F9AB55FC72DB3DF478",
+		"1162FA1F6C6ACF7FD8D19FC7D74BDD9104076E833898BC4C042A6E6BEBF",
+		"A797F3B8AEFCE7456202DF1E46CCC291EA5A49DA3D4BDDA9A4B62D5E0D",
+		"1F6F81DA55C22DA4152134C661588F4BD6F82FDBAF0C5877096B070DC2",
+		"35C3D6DFEEA1CFB29B93BE3FDB91A7B130951770C2690C16833A159677",
+		"600F7301D12AB376B56D4459774159ADB51F97E282FF384406AFD53A02" },
+};
+
+static const EllipticCurve* ecdsa_test_find_curve(const char *name) {
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		const char *a = (const char*) curve->curve_name_ascii;
+		unsigned long i = 0;
+		while (a[i] && a[i] == name[i])
+			++i;
+		if (a[i] == name[i])
+			return curve;
+	}
+	return 0;
+}
+
+// RFC 6979 deterministic signatures, then on every registry curve signatures
+// with random nonces through single and batch verification, forged and
+// malformed ones mixed in
+int test_ecdsa() {
+	int failures = 0;
+	std::cout << "\n--- Testing ECDSA sign / verify / batch verify ---\n";
+
+	for (unsigned long v = 0; v < sizeof(ecdsa_test_vectors) / sizeof(ecdsa_test_vectors[0]); ++v) {
+		const EcdsaTestVector *tv = &ecdsa_test_vectors[v];
+		const EllipticCurve *curve = ecdsa_test_find_curve(tv->curve);
+		if (!curve)
+			continue;
+		unsigned long len = curve->field_size_bytes;
+		unsigned long y_offset = (len + 7) & ~7UL;
+		unsigned char x[GF2_VECTOR_MAX_BYTELEN] = { }, r[GF2_VECTOR_MAX_BYTELEN], s[GF2_VECTOR_MAX_BYTELEN];
+		unsigned char expected[GF2_VECTOR_MAX_BYTELEN];
+		alignas(8) unsigned char q[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		int ok = 1;
+
+		ec_test_hex_lsb(tv->x, x, len);
+		ecdh_generate_public_key(curve, x, q);
+		ec_test_hex_lsb(tv->ux, expected, len);
+		ok &= ec_test_bytes_equal(q, expected, len);
+		ec_test_hex_lsb(tv->uy, expected, len);
+		ok &= ec_test_bytes_equal(q + y_offset, expected, len);
+
+		for (int msg = 0; msg < 2; ++msg) {
+			unsigned char digest[ECDH_SHA256_BYTELEN];
+			ecdh_sha256((const unsigned char*) (msg ? "test" : "sample"), msg ? 4 : 6, digest);
+			ok &= ecdsa_sign(curve, x, digest, sizeof(digest), 0, 0, r, s);
+			ec_test_hex_lsb(msg ? tv->r_test : tv->r_sample, expected, len);
+			ok &= ec_test_bytes_equal(r, expected, len);
+			ec_test_hex_lsb(msg ? tv->s_test : tv->s_sample, expected, len);
+			ok &= ec_test_bytes_equal(s, expected, len);
+			ok &= ecdsa_verify(curve, q, digest, sizeof(digest), r, s);
+			digest[0] ^= 1;             // the last byte is cut off by bits2int
+			ok &= !ecdsa_verify(curve, q, digest, sizeof(digest), r, s);
+		}
+		std::cout << std::left << std::setw(24) << (std::string("rfc 6979 ") + tv->curve)
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned long len = curve->field_size_bytes;
+		const unsigned long count = ECDSA_VERIFY_BATCH + 9;
+		std::vector<std::vector<unsigned char> > keys(count), pubs(count), digests(count), rs(count), ss(count);
+		std::vector<const unsigned char*> pub_ptrs(count), digest_ptrs(count), r_ptrs(count), s_ptrs(count);
+		std::vector<int> oks(count);
+		int ok = 1;
+
+		// 20-byte digests are shorter than n on every curve; the RFC vectors
+		// above cover truncation
+		for (unsigned long i = 0; i < count; ++i) {
+			keys[i].assign(GF2_VECTOR_MAX_BYTELEN, 0);
+			pubs[i].assign(2 * GF2_VECTOR_MAX_BYTELEN, 0);
+			digests[i].assign(20, 0);
+			rs[i].assign(GF2_VECTOR_MAX_BYTELEN, 0);
+			ss[i].assign(GF2_VECTOR_MAX_BYTELEN, 0);
+			ec_test_random_key(curve, keys[i].data());
+			ecdh_generate_public_key(curve, keys[i].data(), pubs[i].data());
+			for (unsigned long b = 0; b < 20; ++b)
+				digests[i][b] = ec_test_random_byte();
+			ok &= ecdsa_sign(curve, keys[i].data(), digests[i].data(), 20,
+					ecdsa_test_random_source, 0, rs[i].data(), ss[i].data());
+			pub_ptrs[i] = pubs[i].data();
+			digest_ptrs[i] = digests[i].data();
+			r_ptrs[i] = rs[i].data();
+			s_ptrs[i] = ss[i].data();
+		}
+		// Forgeries: another key, a changed digest, s = 0, r = n, a point
+		// off the curve
+		pub_ptrs[3] = pubs[4].data();
+		digests[7][0] ^= 0x80;
+		ss[11].assign(GF2_VECTOR_MAX_BYTELEN, 0);
+		for (unsigned long b = 0; b < len; ++b)
+			rs[17][b] = curve->order[b];
+		pubs[20][0] ^= 1;
+
+		unsigned long expected_valid = 0;
+		std::vector<int> single(count);
+		for (unsigned long i = 0; i < count; ++i) {
+			single[i] = ecdsa_verify(curve, pub_ptrs[i], digest_ptrs[i], 20, r_ptrs[i], s_ptrs[i]);
+			int forged = i == 3 || i == 7 || i == 11 || i == 17 || i == 20;
+			ok &= single[i] == !forged;
+			expected_valid += (unsigned long) single[i];
+		}
+		ok &= ecdsa_verify_batch(curve, pub_ptrs.data(), digest_ptrs.data(), 20, r_ptrs.data(),
+				s_ptrs.data(), count, oks.data()) == expected_valid;
+		for (unsigned long i = 0; i < count; ++i)
+			ok &= oks[i] == single[i];
+
+		// A failing random source and a zero key both leave r and s zeroed
+		unsigned char zero[GF2_VECTOR_MAX_BYTELEN] = { }, r[GF2_VECTOR_MAX_BYTELEN], s[GF2_VECTOR_MAX_BYTELEN];
+		int fail = 1;
+		ok &= !ecdsa_sign(curve, keys[0].data(), digests[0].data(), 20,
+				ecdsa_test_random_source, &fail, r, s);
+		ok &= ec_test_bytes_equal(r, zero, len) && ec_test_bytes_equal(s, zero, len);
+		ok &= !ecdsa_sign(curve, zero, digests[0].data(), 20, 0, 0, r, s);
+
+		std::cout << std::left << std::setw(24) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Signatures per second on every registry curve: signing (comb), u1 G + u2 Q
+// by the joint sparse form and split into comb + one multiplication,
+// ecdsa_verify (whichever of the two suits the curve) and batch
+// verification. K-283 needs field elements above
+// GF2_VECTOR_MAX_BYTELEN; sect233k1 is the largest Koblitz curve here.
+void benchmark_ecdsa() {
+	const unsigned long count = 64;
+	std::cout << "\n--- Benchmark: ECDSA, signatures/s ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right << std::setw(10) << "sign"
+			<< std::setw(10) << "jsf" << std::setw(10) << "split" << std::setw(10) << "verify"
+			<< std::setw(10) << "batch" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		elliptic_curve_context_acquire(curve);
+		unsigned long len = curve->field_size_bytes;
+		std::vector<std::vector<unsigned char> > keys(count), pubs(count), rs(count), ss(count);
+		std::vector<const unsigned char*> pub_ptrs(count), digest_ptrs(count), r_ptrs(count), s_ptrs(count);
+		std::vector<int> oks(count);
+		unsigned char digest[ECDH_SHA256_BYTELEN];
+		ecdh_sha256((const unsigned char*) "benchmark", 9, digest);
+		for (unsigned long i = 0; i < count; ++i) {
+			keys[i].assign(GF2_VECTOR_MAX_BYTELEN, 0);
+			pubs[i].assign(2 * GF2_VECTOR_MAX_BYTELEN, 0);
+			rs[i].assign(GF2_VECTOR_MAX_BYTELEN, 0);
+			ss[i].assign(GF2_VECTOR_MAX_BYTELEN, 0);
+			ec_test_random_key(curve, keys[i].data());
+			ecdh_generate_public_key(curve, keys[i].data(), pubs[i].data());
+			pub_ptrs[i] = pubs[i].data();
+			digest_ptrs[i] = digest;
+			r_ptrs[i] = rs[i].data();
+			s_ptrs[i] = ss[i].data();
+		}
+		double rate[5];
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (unsigned long i = 0; i < count; ++i)
+			ecdsa_sign(curve, keys[i].data(), digest, sizeof(digest), 0, 0, rs[i].data(), ss[i].data());
+		auto t1 = std::chrono::steady_clock::now();
+		rate[0] = count / std::chrono::duration<double>(t1 - t0).count();
+
+		// Both ways to u1 G + u2 Q, timed on stand-in scalars r and s
+		alignas(8) EllipticCurvePoint G = { };
+		for (unsigned long b = 0; b < len; ++b) {
+			elliptic_curve_point_get_coord_x(curve, &G)[b] = curve->xG[b];
+			elliptic_curve_point_get_coord_y(curve, &G)[b] = curve->yG[b];
+		}
+		for (int v = 0; v < 2; ++v) {
+			t0 = std::chrono::steady_clock::now();
+			for (unsigned long i = 0; i < count / 4; ++i) {
+				alignas(8) EllipticCurvePoint P1, P2, X;
+				const EllipticCurvePoint *Q = (const EllipticCurvePoint*) pub_ptrs[i];
+				if (v == 0) {
+					elliptic_curve_msm2(curve, &X, &G, rs[i].data(), Q, ss[i].data(), len);
+				} else {
+					elliptic_curve_binary_point_multiply_base(curve, &P1, rs[i].data(), len);
+					elliptic_curve_binary_point_multiply(curve, &P2, Q, ss[i].data(), len);
+					elliptic_curve_binary_point_add(curve, &X, &P1, &P2);
+				}
+			}
+			t1 = std::chrono::steady_clock::now();
+			rate[1 + v] = (count / 4) / std::chrono::duration<double>(t1 - t0).count();
+		}
+
+		t0 = std::chrono::steady_clock::now();
+		for (unsigned long i = 0; i < count / 4; ++i)
+			ecdsa_verify(curve, pub_ptrs[i], digest, sizeof(digest), rs[i].data(), ss[i].data());
+		t1 = std::chrono::steady_clock::now();
+		rate[3] = (count / 4) / std::chrono::duration<double>(t1 - t0).count();
+
+		t0 = std::chrono::steady_clock::now();
+		ecdsa_verify_batch(curve, pub_ptrs.data(), digest_ptrs.data(), sizeof(digest),
+				r_ptrs.data(), s_ptrs.data(), count, oks.data());
+		t1 = std::chrono::steady_clock::now();
+		rate[4] = count / std::chrono::duration<double>(t1 - t0).count();
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::right << std::fixed << std::setprecision(0);
+		for (int v = 0; v < 5; ++v)
+			std::cout << std::setw(10) << rate[v];
+		std::cout << "\n";
+	}
+}
@@ -1,30 +1,133 @@
 #include "elliptic_curve.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_scalar.h"
 #include "galois_field2.h"
 
 unsigned long elliptic_curve_get_maximum_vector_bytelen() {
 	return GF2_VECTOR_MAX_BYTELEN;
 }
 
-void elliptic_curve_binary_point_add(EllipticCurve *curve,
-		EllipticCurvePoint *out, EllipticCurvePoint *in1,
-		EllipticCurvePoint *in2) {
+#if EC_OPERATION_COUNTS
+static EllipticCurveOperationCounts operation_counts;
+#define COUNT_OPERATIONS(op, n) (operation_counts.op += (n))
+#else
+#define COUNT_OPERATIONS(op, n) ((void) 0)
+#endif
+
+void elliptic_curve_operation_counts_get(EllipticCurveOperationCounts *out) {
+#if EC_OPERATION_COUNTS
+	*out = operation_counts;
+#else
+	out->multiply = 0;
+	out->square = 0;
+	out->inverse = 0;
+#endif
+}
+
+void elliptic_curve_operation_counts_reset() {
+#if EC_OPERATION_COUNTS
+	operation_counts.multiply = 0;
+	operation_counts.square = 0;
+	operation_counts.inverse = 0;
+#endif
+}
+
+void elliptic_curve_field_reduce(const EllipticCurve *curve,
+		unsigned char *inout, unsigned long bytelen) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	if (ctx && (ctx->flags & EC_CONTEXT_FLAG_SPARSE_REDUCTION))
+		gf2_reduce_sparse_lsb(inout, bytelen, &ctx->reduction);
+	else
+		gf2_reduce_lsb(inout, bytelen, curve->modulus, curve->field_size_bytes);
+}
+
+static const GF2ReductionDescriptor* field_reduction(const EllipticCurve *curve) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	if (ctx && (ctx->flags & EC_CONTEXT_FLAG_SPARSE_REDUCTION))
+		return &ctx->reduction;
+	return 0;
+}
+
+// The context's tuned multiplication plan, 0 (the default plan) otherwise
+static const GF2MultiplyPlan* field_plan(const EllipticCurve *curve) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	if (ctx && (ctx->flags & EC_CONTEXT_FLAG_TUNED))
+		return &ctx->tuning.plan;
+	return 0;
+}
+
+void elliptic_curve_field_inverse(const EllipticCurve *curve, unsigned char *out,
+		const unsigned char *in) {
+	COUNT_OPERATIONS(inverse, 1);
+	gf2_binary_inverse_lsb(in, out, curve->field_size_bytes, curve->modulus);
+}
+
+// EC_CONTEXT_FLAG_A_ZERO / _A_ONE / _B_ONE, none without a context
+static unsigned int curve_shape(const EllipticCurve *curve) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	if (!ctx)
+		return 0;
+	return ctx->flags & (EC_CONTEXT_FLAG_A_ZERO | EC_CONTEXT_FLAG_A_ONE | EC_CONTEXT_FLAG_B_ONE);
+}
+
+void elliptic_curve_field_add_a(const EllipticCurve *curve, unsigned char *inout) {
+	unsigned int shape = curve_shape(curve);
+	if (shape & EC_CONTEXT_FLAG_A_ONE) {
+		inout[0] ^= 1;
+	} else if (!(shape & EC_CONTEXT_FLAG_A_ZERO)) {
+		for (unsigned long i = 0; i < curve->field_size_bytes; ++i)
+			inout[i] ^= curve->a[i];
+	}
+}
+
+void elliptic_curve_field_multiply(const EllipticCurve *curve, unsigned char *out,
+		const unsigned char *in1, const unsigned char *in2) {
+	COUNT_OPERATIONS(multiply, 1);
+	gf2_field_multiply_planned_lsb(in1, in2, out, curve->field_size_bytes, curve->modulus,
+			field_reduction(curve), field_plan(curve));
+}
+
+void elliptic_curve_field_square(const EllipticCurve *curve, unsigned char *out,
+		const unsigned char *in) {
+	COUNT_OPERATIONS(square, 1);
+	gf2_field_square_lsb(in, out, curve->field_size_bytes, curve->modulus,
+			field_reduction(curve));
+}
+
+void elliptic_curve_field_multiply_add(const EllipticCurve *curve, unsigned char *out,
+		const unsigned char *in1, const unsigned char *in2, const unsigned char *add) {
+	COUNT_OPERATIONS(multiply, 1);
+	gf2_field_multiply_add_planned_lsb(in1, in2, add, out, curve->field_size_bytes,
+			curve->modulus, field_reduction(curve), field_plan(curve));
+}
+
+void elliptic_curve_field_multiply2_add(const EllipticCurve *curve, unsigned char *out,
+		const unsigned char *in1, const unsigned char *in2,
+		const unsigned char *in3, const unsigned char *in4) {
+	COUNT_OPERATIONS(multiply, 2);
+	gf2_field_multiply2_add_planned_lsb(in1, in2, in3, in4, out, curve->field_size_bytes,
+			curve->modulus, field_reduction(curve), field_plan(curve));
+}
+
+void elliptic_curve_binary_point_add(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const EllipticCurvePoint *in1,
+		const EllipticCurvePoint *in2) {
 
 	unsigned long len = curve->field_size_bytes;
-	unsigned long dbl_len = 2 * len;
 	unsigned long y_offset = (len + 7UL) & (~7UL);
 	unsigned long zero_count = 0;
 	unsigned long zero_count2 = 0;
 
 	alignas(8) unsigned char x1[GF2_VECTOR_MAX_BYTELEN] = { };
 	alignas(8) unsigned char y1[GF2_VECTOR_MAX_BYTELEN] = { };
-	alignas(8) unsigned char x2[GF2_VECTOR_MAX_BYTELEN] = { }; // reused for x1 + x3
+	alignas(8) unsigned char x2[GF2_VECTOR_MAX_BYTELEN] = { }; // reused for x1 + x2, x1 + x3
 	alignas(8) unsigned char y2[GF2_VECTOR_MAX_BYTELEN] = { }; // reused for lambda inv
 
 	alignas(8) unsigned char x3[GF2_VECTOR_MAX_BYTELEN] = { };
 	alignas(8) unsigned char y3[GF2_VECTOR_MAX_BYTELEN] = { };
 
-	alignas(8) unsigned char lambda[2 * GF2_VECTOR_MAX_BYTELEN] = { }; // holds lambda and lambda sq.
-	alignas(8) unsigned char temp[2 * GF2_VECTOR_MAX_BYTELEN] = { }; // holds lambda numerator, denominator, intermediate
+	alignas(8) unsigned char lambda[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char temp[GF2_VECTOR_MAX_BYTELEN] = { }; // lambda numerator, then x3 + y1
 
 	for (unsigned long i = 0; i < len; ++i) {
 		x1[i] = in1->point_mem[i];
@@ -92,26 +195,23 @@ void elliptic_curve_binary_point_add(EllipticCurve *curve,
 
 	for (unsigned long i = 0; i < len; ++i) {
 		temp[i] = y1[i] ^ y2[i];                   // numerator
-		temp[i + y_offset] = x1[i] ^ x2[i];        // denominator
+		x2[i] ^= x1[i];                            // denominator
 	}
 
-	gf2_binary_inverse_lsb(&temp[y_offset], y2, len, curve->modulus);
-	gf2_multiply_lsb(temp, y2, lambda, len);
-	gf2_reduce_lsb(lambda, dbl_len, curve->modulus, len);
-
-	gf2_multiply_lsb(lambda, lambda, temp, len);
-	gf2_reduce_lsb(temp, dbl_len, curve->modulus, len);
-
+	// lambda = (y1 + y2) / (x1 + x2)
+	// x3 = lambda^2 + lambda + x1 + x2 + a
+	// y3 = lambda (x1 + x3) + x3 + y1
+	elliptic_curve_field_inverse(curve, y2, x2);
+	elliptic_curve_field_multiply(curve, lambda, temp, y2);
+	elliptic_curve_field_square(curve, x3, lambda);
+	for (unsigned long i = 0; i < len; ++i)
+		x3[i] ^= lambda[i] ^ x2[i];
+	elliptic_curve_field_add_a(curve, x3);
 	for (unsigned long i = 0; i < len; ++i) {
-		x3[i] = temp[i] ^ lambda[i] ^ x1[i] ^ x2[i] ^ curve->a[i];
 		x2[i] = x1[i] ^ x3[i];
-
+		temp[i] = x3[i] ^ y1[i];
 	}
-	gf2_multiply_lsb(lambda, x2, temp, len);
-	gf2_reduce_lsb(temp, dbl_len, curve->modulus, len);
-
-	for (unsigned long i = 0; i < len; ++i)
-		y3[i] = temp[i] ^ x3[i] ^ y1[i];
+	elliptic_curve_field_multiply_add(curve, y3, lambda, x2, temp);
 
 	for (unsigned long i = 0; i < len; ++i) {
 		out->point_mem[i] = x3[i];
@@ -120,18 +220,17 @@ void elliptic_curve_binary_point_add(EllipticCurve *curve,
 }
 
 
-void elliptic_curve_binary_point_double(EllipticCurve *curve,
-		EllipticCurvePoint *out, EllipticCurvePoint *in) {
+void elliptic_curve_binary_point_double(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const EllipticCurvePoint *in) {
 	unsigned long len = curve->field_size_bytes; //byte len of a gf(2) vector
 	unsigned long y_offset = (len + 7UL) & (~7UL); //placement of y coordinate in curve object
-	unsigned long dbl_len = 2 * len; //length of vector after multiplication
 	unsigned long zero_cnt = 0; //helper
 
 	alignas(8) unsigned char x1[GF2_VECTOR_MAX_BYTELEN] = { };
 	alignas(8) unsigned char y1[GF2_VECTOR_MAX_BYTELEN] = { };
-	alignas(8) unsigned char lambda[2 * GF2_VECTOR_MAX_BYTELEN] = { };
-	alignas(8) unsigned char temp1[2 * GF2_VECTOR_MAX_BYTELEN] = { };
-	alignas(8) unsigned char temp2[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char lambda[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char x3[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char temp[GF2_VECTOR_MAX_BYTELEN] = { };
 
 	for (unsigned long i = 0; i < len; ++i) {
 		if (in->point_mem[i] == 0x00)
@@ -145,85 +244,611 @@ void elliptic_curve_binary_point_double(EllipticCurve *curve,
 		return; //point at infinity
 	}
 
-	//Following formula from NIST SP 800-186
+	//Following formula from NIST SP 800-186:
+	// lambda = x1 + y1 / x1
+	// x3 = lambda^2 + lambda + a
+	// y3 = x1^2 + lambda x3 + x3
 	for (unsigned long i = 0; i < len; ++i) {
 		x1[i] = in->point_mem[i];
 		y1[i] = in->point_mem[i + y_offset];
 	}
-	gf2_binary_inverse_lsb(x1, temp1, len, curve->modulus);
-	gf2_multiply_lsb(y1, temp1, lambda, len);
-	gf2_reduce_lsb(lambda, dbl_len, curve->modulus, len);
+	elliptic_curve_field_inverse(curve, temp, x1);
+	elliptic_curve_field_multiply_add(curve, lambda, y1, temp, x1);
+	elliptic_curve_field_square(curve, x3, lambda);
 	for (unsigned long i = 0; i < len; ++i)
-		lambda[i] ^= x1[i];
-	gf2_multiply_lsb(x1, x1, temp1, len);
-	gf2_reduce_lsb(temp1, dbl_len, curve->modulus, len);
-	gf2_multiply_lsb(lambda, lambda, temp2, len);
-	gf2_reduce_lsb(temp2, dbl_len, curve->modulus, len);
+		x3[i] ^= lambda[i];
+	elliptic_curve_field_add_a(curve, x3);  //x3 contains coordinate X of the output
+
+	elliptic_curve_field_multiply2_add(curve, y1, x1, x1, lambda, x3);
 	for (unsigned long i = 0; i < len; ++i)
-		x1[i] = temp2[i] ^ lambda[i] ^ curve->a[i];   //x1 contains coordinate X of the output
+		y1[i] ^= x3[i]; //y1 contains coordinate Y of the output
+
+	for (unsigned long i = 0; i < len; ++i) {
+		out->point_mem[i] = x3[i];
+		out->point_mem[i + y_offset] = y1[i];
+	}
+}
+
+// ---- Point halving ----
+
+int elliptic_curve_binary_supports_halving(const EllipticCurve *curve) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned char other = 0;
+	for (unsigned long i = 1; i < len; ++i)
+		other |= curve->a[i] | curve->cofactor[i];
+	return (curve->binary_degree & 1) && (curve->modulus[0] & 1)
+			&& curve->a[0] == 1 && curve->cofactor[0] == 2 && other == 0;
+}
+
+int elliptic_curve_binary_is_koblitz(const EllipticCurve *curve) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned char other = 0;
+	for (unsigned long i = 1; i < len; ++i)
+		other |= curve->a[i] | curve->b[i];
+	return curve->binary_degree && curve->a[0] <= 1 && curve->b[0] == 1 && other == 0;
+}
+
+// The fast maps come from the context; without one the reference
+// definitions (about m squarings each) are used.
+static int halving_trace(const EllipticCurve *curve,
+		const EllipticCurveContextData *ctx, const unsigned char *in) {
+	if (!ctx)
+		return gf2_trace_lsb(in, curve->field_size_bytes, curve->modulus);
+	return gf2_trace(in, &ctx->linear_maps);
+}
+
+static void halving_sqrt(const EllipticCurve *curve,
+		const EllipticCurveContextData *ctx, unsigned char *out,
+		const unsigned char *in) {
+	if (!ctx)
+		gf2_sqrt_lsb(in, out, curve->field_size_bytes, curve->modulus);
+	else
+		gf2_sqrt(in, out, &ctx->linear_maps);
+}
+
+// A solution of l^2 + l = c for Tr(c) = 0
+static void halving_half_trace(const EllipticCurve *curve,
+		const EllipticCurveContextData *ctx, unsigned char *out,
+		const unsigned char *in) {
+	if (!ctx)
+		gf2_half_trace_lsb(in, out, curve->field_size_bytes, curve->modulus);
+	else
+		gf2_half_trace(in, out, &ctx->linear_maps);
+}
 
+// Q = P / 2 for P = (u, v) != O in the odd-order subgroup (Hankerson,
+// Menezes, Vanstone, Alg. 3.81):
+//   l^ = solution of l^2 + l = u + a,  t = v + u l^
+//   Tr(t) = 0: l = l^,     x = sqrt(t + u)
+//   Tr(t) = 1: l = l^ + 1, x = sqrt(t)
+//   y = x (l + x)          (l = x + y / x is Q's lambda coordinate)
+static void halving_halve(const EllipticCurve *curve,
+		const EllipticCurveContextData *ctx, EllipticCurvePoint *out,
+		const EllipticCurvePoint *in) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	alignas(8) unsigned char u[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char lambda[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char t[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char x[GF2_VECTOR_MAX_BYTELEN];
+
+	for (unsigned long i = 0; i < len; ++i)
+		u[i] = in->point_mem[i];
+	elliptic_curve_field_add_a(curve, u);
+	halving_half_trace(curve, ctx, lambda, u);
 	for (unsigned long i = 0; i < len; ++i)
-		temp1[i] = x1[i] ^ in->point_mem[i];
-	gf2_multiply_lsb(lambda, temp1, temp2, len);
-	gf2_reduce_lsb(temp2, dbl_len, curve->modulus, len);
+		u[i] = in->point_mem[i];
+	elliptic_curve_field_multiply(curve, t, u, lambda);
 	for (unsigned long i = 0; i < len; ++i)
-		y1[i] = temp2[i] ^ x1[i] ^ in->point_mem[i + y_offset]; //y1 contains coordinate Y of the output
+		t[i] ^= in->point_mem[i + y_offset];
 
+	if (halving_trace(curve, ctx, t) == 0) {
+		for (unsigned long i = 0; i < len; ++i)
+			t[i] ^= u[i];
+	} else {
+		lambda[0] ^= 1;
+	}
+	halving_sqrt(curve, ctx, x, t);
+
+	for (unsigned long i = 0; i < len; ++i)
+		lambda[i] ^= x[i];
+	elliptic_curve_field_multiply(curve, t, x, lambda);
 	for (unsigned long i = 0; i < len; ++i) {
-		out->point_mem[i] = x1[i];
-		out->point_mem[i + y_offset] = y1[i];
+		out->point_mem[i] = x[i];
+		out->point_mem[i + y_offset] = t[i];
 	}
 }
 
-void elliptic_curve_binary_point_multiply(EllipticCurve *curve, EllipticCurvePoint *out,
-		EllipticCurvePoint *in, const unsigned char *exp,
-		unsigned long bytelen) {
+static int halving_point_is_infinity(const EllipticCurve *curve,
+		const EllipticCurvePoint *in) {
 	unsigned long len = curve->field_size_bytes;
 	unsigned long y_offset = (len + 7UL) & (~7UL);
-	long total_bits = gf2_degree_lsb(exp, bytelen);
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < len; ++i)
+		acc |= in->point_mem[i] | in->point_mem[i + y_offset];
+	return acc == 0;
+}
+
+int elliptic_curve_binary_point_halve(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const EllipticCurvePoint *in) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+
+	if (!elliptic_curve_binary_supports_halving(curve))
+		return 0;
+	if (ctx && !(ctx->flags & EC_CONTEXT_FLAG_HALVING))
+		ctx = 0;
+	if (halving_point_is_infinity(curve, in)) {
+		for (unsigned long i = 0; i < len; ++i) {
+			out->point_mem[i] = 0;
+			out->point_mem[i + y_offset] = 0;
+		}
+		return 1;
+	}
+	// 2E = odd-order subgroup = { P : Tr(x) = Tr(a) = 1 }
+	if (halving_trace(curve, ctx, in->point_mem) != 1)
+		return 0;
+	halving_halve(curve, ctx, out, in);
+	return 1;
+}
+
+// ---- Scalar multiplication ----
+
+// Resumable scalar multiplication. Three schedules, chosen at init:
+//  - double-and-add, most significant bit first, with a dummy addition for
+//    zero bits, on the fixed-length form of k mod #E: always bits(#E) + 1
+//    iterations;
+//  - halve-and-add (Hankerson, Menezes, Vanstone, Alg. 3.91 with w = 2): with
+//    k' = 2^(t-1) k mod n = sum(k'_i 2^i), kP = sum(k'_i P / 2^(t-1-i)) + 2 k'_t P,
+//    so the NAF digits of k' are consumed from the least significant end,
+//    halving in between. Taken for points of the odd-order subgroup when the
+//    context has the halving maps;
+//  - tau-and-add on Koblitz curves: the Frobenius NAF of k, most significant
+//    digit first, with two squarings in place of each doubling.
+
+static void multiply_state_wipe(EllipticCurveMultiplyState *state) {
+	volatile unsigned char *raw = (volatile unsigned char*) state;
+	for (unsigned long i = 0; i < sizeof(EllipticCurveMultiplyState); ++i)
+		raw[i] = 0;
+}
+
+void elliptic_curve_binary_point_multiply_init(EllipticCurveMultiplyState *state,
+		const EllipticCurve *curve, const EllipticCurvePoint *in,
+		const unsigned char *exp, unsigned long bytelen) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+
+	multiply_state_wipe(state);
+	state->curve = curve;
+	for (unsigned long i = 0; i < len; ++i) {
+		state->in.point_mem[i] = in->point_mem[i];
+		state->in.point_mem[i + y_offset] = in->point_mem[i + y_offset];
+	}
+
+	for (unsigned long i = 0; i < len; ++i) {
+		state->negated.point_mem[i] = in->point_mem[i];
+		state->negated.point_mem[i + y_offset] = in->point_mem[i] ^ in->point_mem[i + y_offset];
+	}
+
+	// A tuning that found double-and-add faster overrides the shortcuts
+	int plain = ctx && (ctx->flags & EC_CONTEXT_FLAG_TUNED)
+			&& ctx->tuning.multiply == EC_TUNE_MULTIPLY_DOUBLE_AND_ADD;
+
+	if (!plain && elliptic_curve_binary_is_koblitz(curve)) {
+		state->mode = EC_MULTIPLY_MODE_TAU_AND_ADD;
+		state->next = elliptic_curve_scalar_recode_tnaf(curve, exp, bytelen, state->naf) - 1;
+		state->end = -1;
+		return;
+	}
+
+	if (!plain && ctx && (ctx->flags & EC_CONTEXT_FLAG_HALVING)
+			&& !halving_point_is_infinity(curve, in)
+			&& halving_trace(curve, ctx, in->point_mem) == 1) {
+		alignas(8) unsigned char k[GF2_VECTOR_MAX_BYTELEN];
+		long t = gf2_degree_lsb(curve->order, len) + 1;
+		elliptic_curve_scalar_reduce(curve->order, len, k, exp, bytelen, (unsigned long) t - 1);
+		elliptic_curve_scalar_recode_wnaf(k, len, 2, state->naf);
+		for (unsigned long i = 0; i < len; ++i)
+			k[i] = 0;
+		state->mode = EC_MULTIPLY_MODE_HALVE_AND_ADD;
+		state->next = 0;
+		state->end = t;
+		return;
+	}
+
+	alignas(8) unsigned char order[EC_SCALAR_MAX_BYTELEN];
+	elliptic_curve_scalar_group_order(curve, order);
+	elliptic_curve_scalar_reduce(order, len + 1, state->exp, exp, bytelen, 0);
+	state->mode = EC_MULTIPLY_MODE_DOUBLE_AND_ADD;
+	state->next = (long) elliptic_curve_scalar_fix_length(order, len + 1, state->exp, state->exp);
+	state->end = -1;
+}
+
+int elliptic_curve_binary_point_multiply_step(EllipticCurveMultiplyState *state,
+		unsigned long max_bits) {
+	const EllipticCurve *curve = state->curve;
+	unsigned long done = 0;
+
+	if (state->mode == EC_MULTIPLY_MODE_HALVE_AND_ADD) {
+		const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+		for (; state->next < state->end && (!max_bits || done < max_bits); ++state->next, ++done) {
+			signed char digit = state->naf[state->next];
+			if (!halving_point_is_infinity(curve, &state->acc))
+				halving_halve(curve, ctx, &state->acc, &state->acc);
+			if (digit > 0)
+				elliptic_curve_binary_point_add(curve, &state->acc, &state->acc, &state->in);
+			else if (digit < 0)
+				elliptic_curve_binary_point_add(curve, &state->acc, &state->acc, &state->negated);
+		}
+		if (state->next < state->end)
+			return 0;
+		if (state->next == state->end) {
+			signed char digit = state->naf[state->end];
+			if (digit) {
+				alignas(8) EllipticCurvePoint twice = { };
+				elliptic_curve_binary_point_double(curve, &twice,
+						(digit > 0) ? &state->in : &state->negated);
+				elliptic_curve_binary_point_add(curve, &state->acc, &state->acc, &twice);
+			}
+			++state->next;
+		}
+		return 1;
+	}
+
+	if (state->mode == EC_MULTIPLY_MODE_TAU_AND_ADD) {
+		unsigned long len = curve->field_size_bytes;
+		unsigned long y_offset = (len + 7UL) & (~7UL);
+		for (; state->next > state->end && (!max_bits || done < max_bits); --state->next, ++done) {
+			signed char digit = state->naf[state->next];
+			elliptic_curve_field_square(curve, state->acc.point_mem, state->acc.point_mem);
+			elliptic_curve_field_square(curve, state->acc.point_mem + y_offset,
+					state->acc.point_mem + y_offset);
+			if (digit > 0)
+				elliptic_curve_binary_point_add(curve, &state->acc, &state->acc, &state->in);
+			else if (digit < 0)
+				elliptic_curve_binary_point_add(curve, &state->acc, &state->acc, &state->negated);
+		}
+		return state->next == state->end;
+	}
 
-	alignas(8) EllipticCurvePoint tmp = { };
 	alignas(8) EllipticCurvePoint dummy = { };
+	for (; state->next > state->end && (!max_bits || done < max_bits); --state->next, ++done) {
+		unsigned long i = (unsigned long) state->next;
+		elliptic_curve_binary_point_double(curve, &state->acc, &state->acc);
+		if ((state->exp[i >> 3] >> (i & 7)) & 1)
+			elliptic_curve_binary_point_add(curve, &state->acc, &state->acc, &state->in);
+		else
+			elliptic_curve_binary_point_add(curve, &state->acc, &dummy, &state->acc);
+	}
+	return state->next == state->end;
+}
 
-	for (unsigned long i = 0; i < 2 * GF2_VECTOR_MAX_BYTELEN; ++i) {
-		tmp.point_mem[i] = 0x00;
-		dummy.point_mem[i] = 0x00;
+void elliptic_curve_binary_point_multiply_finish(EllipticCurveMultiplyState *state,
+		EllipticCurvePoint *out) {
+	unsigned long len = state->curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	for (unsigned long i = 0; i < len; ++i) {
+		out->point_mem[i] = state->acc.point_mem[i];
+		out->point_mem[i + y_offset] = state->acc.point_mem[i + y_offset];
 	}
+	multiply_state_wipe(state);
+}
 
-	for (long i = (long) (total_bits); i >= 0; --i) {
-		elliptic_curve_binary_point_double(curve, &tmp, &tmp);
-		unsigned long byte_index = (unsigned long) i >> 3;
-		unsigned long bit_index = (unsigned long) i & 7;
-		unsigned char bit = (exp[byte_index] >> bit_index) & 1;
-		if (bit) {
-			elliptic_curve_binary_point_add(curve, &tmp, &tmp, in);
-		} else {
-			elliptic_curve_binary_point_add(curve, &tmp, &dummy, &tmp);
+void elliptic_curve_binary_point_multiply(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const EllipticCurvePoint *in, const unsigned char *exp,
+		unsigned long bytelen) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	if (ctx && (ctx->flags & EC_CONTEXT_FLAG_TUNED)
+			&& ctx->tuning.multiply == EC_TUNE_MULTIPLY_LADDER) {
+		elliptic_curve_binary_point_multiply_ct(curve, out, in, exp, bytelen);
+		return;
+	}
+
+	EllipticCurveMultiplyState state;
+	elliptic_curve_binary_point_multiply_init(&state, curve, in, exp, bytelen);
+	elliptic_curve_binary_point_multiply_step(&state, 0);
+	elliptic_curve_binary_point_multiply_finish(&state, out);
+}
+
+void elliptic_curve_binary_point_multiply_base(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const unsigned char *exp,
+		unsigned long bytelen) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	alignas(8) unsigned char k[GF2_VECTOR_MAX_BYTELEN];
+
+	// G has order n: the comb always covers k mod n
+	elliptic_curve_scalar_reduce(curve->order, len, k, exp, bytelen, 0);
+	long total_bits = gf2_degree_lsb(k, len);
+
+	if (!ctx || !(ctx->flags & EC_CONTEXT_FLAG_BASE_COMB)
+			|| total_bits >= (long) (ctx->comb_width * ctx->comb_columns)) {
+		alignas(8) EllipticCurvePoint base = { };
+		for (unsigned long i = 0; i < len; ++i) {
+			base.point_mem[i] = curve->xG[i];
+			base.point_mem[i + y_offset] = curve->yG[i];
 		}
+		elliptic_curve_binary_point_multiply(curve, out, &base, k, len);
+		for (unsigned long i = 0; i < len; ++i)
+			k[i] = 0;
+		return;
 	}
 
+	alignas(8) EllipticCurvePoint tmp = { };
+	unsigned long d = ctx->comb_columns;
+
+	for (long col = (long) d - 1; col >= 0; --col) {
+		unsigned long index = 0;
+		for (unsigned long j = 0; j < ctx->comb_width; ++j) {
+			unsigned long bit = j * d + (unsigned long) col;
+			if ((long) bit <= total_bits && ((k[bit >> 3] >> (bit & 7)) & 1))
+				index |= 1UL << j;
+		}
+		elliptic_curve_binary_point_double(curve, &tmp, &tmp);
+		if (index)
+			elliptic_curve_binary_point_add(curve, &tmp, &tmp,
+					&ctx->base_comb[index - 1]);
+	}
+	for (unsigned long i = 0; i < len; ++i)
+		k[i] = 0;
+
 	for (unsigned long i = 0; i < len; ++i) {
 		out->point_mem[i] = tmp.point_mem[i];
 		out->point_mem[i + y_offset] = tmp.point_mem[i + y_offset];
 	}
 }
 
-int elliptic_curve_binary_point_on_curve(EllipticCurve *curve,
-                                         EllipticCurvePoint *point)
+// Field helpers for the constant-time paths: no branch or memory access
+// depends on operand values.
+static void ct_field_multiply(const unsigned char *modulus,
+		const GF2ReductionDescriptor *desc, unsigned long len,
+		unsigned char *out, const unsigned char *in1, const unsigned char *in2) {
+	alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN];
+	COUNT_OPERATIONS(multiply, 1);
+	gf2_multiply_ct_lsb(in1, in2, wide, len);
+	if (desc->degree)
+		gf2_reduce_sparse_lsb(wide, 2 * len, desc);
+	else
+		gf2_reduce_ct_lsb(wide, 2 * len, modulus, len);
+	for (unsigned long i = 0; i < len; ++i)
+		out[i] = wide[i];
+}
+
+static void ct_field_square(const unsigned char *modulus,
+		const GF2ReductionDescriptor *desc, unsigned long len,
+		unsigned char *out, const unsigned char *in) {
+	alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN];
+	COUNT_OPERATIONS(square, 1);
+	gf2_square_ct_lsb(in, wide, len);
+	if (desc->degree)
+		gf2_reduce_sparse_lsb(wide, 2 * len, desc);
+	else
+		gf2_reduce_ct_lsb(wide, 2 * len, modulus, len);
+	for (unsigned long i = 0; i < len; ++i)
+		out[i] = wide[i];
+}
+
+static void ct_field_multiply_fixed(const unsigned char *modulus,
+		const GF2ReductionDescriptor *desc, unsigned long len,
+		unsigned char *out, const GF2FixedOperand *fixed, const unsigned char *in) {
+	alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN];
+	COUNT_OPERATIONS(multiply, 1);
+	gf2_mul_fixed_ct_lsb(fixed, in, wide);
+	if (desc->degree)
+		gf2_reduce_sparse_lsb(wide, 2 * len, desc);
+	else
+		gf2_reduce_ct_lsb(wide, 2 * len, modulus, len);
+	for (unsigned long i = 0; i < len; ++i)
+		out[i] = wide[i];
+}
+
+static void ct_conditional_swap(unsigned char mask, unsigned char *a,
+		unsigned char *b, unsigned long len) {
+	for (unsigned long i = 0; i < len; ++i) {
+		unsigned char t = (a[i] ^ b[i]) & mask;
+		a[i] ^= t;
+		b[i] ^= t;
+	}
+}
+
+// 0xFF if all len bytes are zero, 0x00 otherwise
+static unsigned char ct_zero_mask(const unsigned char *in, unsigned long len) {
+	unsigned int acc = 0;
+	for (unsigned long i = 0; i < len; ++i)
+		acc |= in[i];
+	return (unsigned char) ((acc - 1U) >> 8);
+}
+
+void elliptic_curve_binary_point_multiply_ct_fixed(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const EllipticCurvePoint *in,
+		const GF2FixedOperand *x_fixed, const unsigned char *exp,
+		unsigned long bytelen) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	const unsigned char *mod = curve->modulus;
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	GF2ReductionDescriptor desc;
+
+	alignas(8) unsigned char x[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char y[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char x1[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char z1[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char x2[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char z2[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char t1[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char t2[GF2_VECTOR_MAX_BYTELEN] = { };
+
+	if (ctx && (ctx->flags & EC_CONTEXT_FLAG_SPARSE_REDUCTION))
+		desc = ctx->reduction;
+	else
+		gf2_reduction_descriptor_init(&desc, mod, len);
+
+	for (unsigned long i = 0; i < len; ++i) {
+		x[i] = in->point_mem[i];
+		y[i] = in->point_mem[i + y_offset];
+	}
+
+	// x = 0 means O or the 2-torsion point (0, sqrt(b)), both public inputs:
+	// k * P is P for odd k and O for even k.
+	if (ct_zero_mask(x, len)) {
+		unsigned char odd = (unsigned char) (0U - (exp[0] & 1U));
+		for (unsigned long i = 0; i < len; ++i) {
+			out->point_mem[i] = 0;
+			out->point_mem[i + y_offset] = y[i] & odd;
+		}
+		return;
+	}
+
+	// k = fixed-length form of exp mod #E, top bit t: the step count is public
+	alignas(8) unsigned char scalar[EC_SCALAR_MAX_BYTELEN];
+	alignas(8) unsigned char order[EC_SCALAR_MAX_BYTELEN];
+	elliptic_curve_scalar_group_order(curve, order);
+	elliptic_curve_scalar_reduce(order, len + 1, scalar, exp, bytelen, 0);
+	long top = (long) elliptic_curve_scalar_fix_length(order, len + 1, scalar, scalar);
+
+	// (X1 : Z1) = O = (1 : 0), (X2 : Z2) = P = (x : 1); invariant P2 - P1 = P
+	x1[0] = 1;
+	z2[0] = 1;
+	for (unsigned long i = 0; i < len; ++i)
+		x2[i] = x[i];
+
+	// The curve shape is public: the branches do not depend on the scalar.
+	// X1^4 + b Z1^4 = (X1^2 + sqrt(b) Z1^2)^2, sqrt(b) = 1 for b = 1.
+	int b_one = (curve_shape(curve) & EC_CONTEXT_FLAG_B_ONE) != 0;
+	const GF2FixedOperand *sqrt_b = 0;
+	if (!b_one && ctx && (ctx->flags & EC_CONTEXT_FLAG_FIXED_OPERANDS))
+		sqrt_b = &ctx->sqrt_b;
+	unsigned char swap = 0;
+	for (long bit = top; bit >= 0; --bit) {
+		unsigned char k = (scalar[bit >> 3] >> (bit & 7)) & 1;
+		unsigned char mask = (unsigned char) (0U - (unsigned int) (k ^ swap));
+		ct_conditional_swap(mask, x1, x2, len);
+		ct_conditional_swap(mask, z1, z2, len);
+		swap = k;
+
+		// P2 = P1 + P2: Z2 = (X1 Z2 + X2 Z1)^2, X2 = x Z2 + X1 Z2 X2 Z1
+		ct_field_multiply(mod, &desc, len, t1, x1, z2);
+		ct_field_multiply(mod, &desc, len, t2, x2, z1);
+		for (unsigned long i = 0; i < len; ++i)
+			z2[i] = t1[i] ^ t2[i];
+		ct_field_square(mod, &desc, len, z2, z2);
+		ct_field_multiply(mod, &desc, len, t1, t1, t2);
+		ct_field_multiply_fixed(mod, &desc, len, x2, x_fixed, z2);
+		for (unsigned long i = 0; i < len; ++i)
+			x2[i] ^= t1[i];
+
+		// P1 = 2 P1: Z1 = X1^2 Z1^2, X1 = X1^4 + b Z1^4
+		ct_field_square(mod, &desc, len, t1, x1);
+		ct_field_square(mod, &desc, len, t2, z1);
+		ct_field_multiply(mod, &desc, len, z1, t1, t2);
+		if (b_one || sqrt_b) {
+			if (sqrt_b)
+				ct_field_multiply_fixed(mod, &desc, len, t2, sqrt_b, t2);
+			for (unsigned long i = 0; i < len; ++i)
+				t1[i] ^= t2[i];
+			ct_field_square(mod, &desc, len, x1, t1);
+		} else {
+			ct_field_square(mod, &desc, len, x1, t1);
+			ct_field_square(mod, &desc, len, t2, t2);
+			ct_field_multiply(mod, &desc, len, t2, t2, curve->b);
+			for (unsigned long i = 0; i < len; ++i)
+				x1[i] ^= t2[i];
+		}
+	}
+	unsigned char last = (unsigned char) (0U - (unsigned int) swap);
+	ct_conditional_swap(last, x1, x2, len);
+	ct_conditional_swap(last, z1, z2, len);
+	for (unsigned long i = 0; i <= len; ++i)
+		scalar[i] = 0;
+
+	// Recover y (Lopez-Dahab): with inv = (x Z1 Z2)^-1
+	//   x_k = X1 x Z2 inv
+	//   y_k = (x + x_k) ((X1 + x Z1)(X2 + x Z2) + (x^2 + y) Z1 Z2) inv + y
+	alignas(8) unsigned char z1z2[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char inv[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char xk[GF2_VECTOR_MAX_BYTELEN] = { };
+	unsigned char z1_zero = ct_zero_mask(z1, len); // k P = O
+	unsigned char z2_zero = ct_zero_mask(z2, len); // (k + 1) P = O, k P = -P
+
+	ct_field_multiply(mod, &desc, len, z1z2, z1, z2);
+	ct_field_multiply_fixed(mod, &desc, len, t1, x_fixed, z1z2);
+	gf2_inverse_ct_lsb(t1, inv, len, mod, &desc);
+	COUNT_OPERATIONS(inverse, 1);
+
+	ct_field_multiply_fixed(mod, &desc, len, t1, x_fixed, z2);
+	ct_field_multiply(mod, &desc, len, t1, t1, x1);
+	ct_field_multiply(mod, &desc, len, xk, t1, inv);
+
+	ct_field_multiply_fixed(mod, &desc, len, t1, x_fixed, z1);
+	ct_field_multiply_fixed(mod, &desc, len, t2, x_fixed, z2);
+	for (unsigned long i = 0; i < len; ++i) {
+		t1[i] ^= x1[i];
+		t2[i] ^= x2[i];
+	}
+	ct_field_multiply(mod, &desc, len, t1, t1, t2);
+	ct_field_square(mod, &desc, len, t2, x);
+	for (unsigned long i = 0; i < len; ++i)
+		t2[i] ^= y[i];
+	ct_field_multiply(mod, &desc, len, t2, t2, z1z2);
+	for (unsigned long i = 0; i < len; ++i)
+		t1[i] ^= t2[i];
+	for (unsigned long i = 0; i < len; ++i)
+		t2[i] = x[i] ^ xk[i];
+	ct_field_multiply(mod, &desc, len, t1, t1, t2);
+	ct_field_multiply(mod, &desc, len, t1, t1, inv);
+
+	for (unsigned long i = 0; i < len; ++i) {
+		unsigned char rx = xk[i];
+		unsigned char ry = t1[i] ^ y[i];
+		rx = (rx & ~z2_zero) | (x[i] & z2_zero);
+		ry = (ry & ~z2_zero) | ((x[i] ^ y[i]) & z2_zero);
+		out->point_mem[i] = rx & ~z1_zero;
+		out->point_mem[i + y_offset] = ry & ~z1_zero;
+	}
+}
+
+void elliptic_curve_binary_point_multiply_ct(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const EllipticCurvePoint *in,
+		const unsigned char *exp, unsigned long bytelen) {
+	GF2FixedOperand x_fixed;
+	gf2_mul_fixed_init(&x_fixed, in->point_mem, curve->field_size_bytes);
+	elliptic_curve_binary_point_multiply_ct_fixed(curve, out, in, &x_fixed, exp, bytelen);
+}
+
+void elliptic_curve_binary_point_multiply_base_ct(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const unsigned char *exp,
+		unsigned long bytelen) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	alignas(8) EllipticCurvePoint base = { };
+
+	for (unsigned long i = 0; i < len; ++i) {
+		base.point_mem[i] = curve->xG[i];
+		base.point_mem[i + y_offset] = curve->yG[i];
+	}
+	if (ctx && (ctx->flags & EC_CONTEXT_FLAG_FIXED_OPERANDS))
+		elliptic_curve_binary_point_multiply_ct_fixed(curve, out, &base, &ctx->x_base,
+				exp, bytelen);
+	else
+		elliptic_curve_binary_point_multiply_ct(curve, out, &base, exp, bytelen);
+}
+
+int elliptic_curve_binary_point_on_curve(const EllipticCurve *curve,
+                                         const EllipticCurvePoint *point)
 {
     unsigned long len      = curve->field_size_bytes;
     unsigned long y_offset = (len + 7UL) & (~7UL);
-    unsigned long dbl_len  = 2 * len;
     unsigned char zero_flag = 0;
 
     alignas(8) unsigned char x[GF2_VECTOR_MAX_BYTELEN]     = {0};
     alignas(8) unsigned char y[GF2_VECTOR_MAX_BYTELEN]     = {0};
     alignas(8) unsigned char lhs[GF2_VECTOR_MAX_BYTELEN]   = {0};
     alignas(8) unsigned char rhs[GF2_VECTOR_MAX_BYTELEN]   = {0};
-    alignas(8) unsigned char tmp[2 * GF2_VECTOR_MAX_BYTELEN] = {0};
     alignas(8) unsigned char x2[GF2_VECTOR_MAX_BYTELEN]    = {0};
-    alignas(8) unsigned char x3[GF2_VECTOR_MAX_BYTELEN]    = {0};
-    alignas(8) unsigned char ax2[GF2_VECTOR_MAX_BYTELEN]   = {0};
 
     for (unsigned long i = 0; i < len; i++) {
         x[i] = point->point_mem[i];
@@ -235,33 +860,23 @@ int elliptic_curve_binary_point_on_curve(EllipticCurve *curve,
     if (zero_flag == 0)
         return 1;
 
-    gf2_multiply_lsb(y, y, tmp, len);
-    gf2_reduce_lsb(tmp, dbl_len, curve->modulus, len);
-    for (unsigned long i = 0; i < len; i++)
-        lhs[i] = tmp[i];
-
-    gf2_multiply_lsb(x, y, tmp, len);
-    gf2_reduce_lsb(tmp, dbl_len, curve->modulus, len);
-    for (unsigned long i = 0; i < len; i++)
-        lhs[i] ^= tmp[i];
-
-    gf2_multiply_lsb(x, x, tmp, len);
-    gf2_reduce_lsb(tmp, dbl_len, curve->modulus, len);
-    for (unsigned long i = 0; i < len; i++)
-        x2[i] = tmp[i];
-
-    gf2_multiply_lsb(x2, x, tmp, len);
-    gf2_reduce_lsb(tmp, dbl_len, curve->modulus, len);
-    for (unsigned long i = 0; i < len; i++)
-        x3[i] = tmp[i];
-
-    gf2_multiply_lsb(curve->a, x2, tmp, len);
-    gf2_reduce_lsb(tmp, dbl_len, curve->modulus, len);
-    for (unsigned long i = 0; i < len; i++)
-        ax2[i] = tmp[i];
-
-    for (unsigned long i = 0; i < len; i++)
-        rhs[i] = x3[i] ^ ax2[i] ^ curve->b[i];
+    // y^2 + xy = x^3 + a x^2 + b as y (y + x) = x^2 (x + a) + b: two
+    // multiplications and a squaring; + a and + b are bit flips on curves
+    // whose context found a, b in { 0, 1 }
+    for (unsigned long i = 0; i < len; i++) {
+        lhs[i] = y[i] ^ x[i];
+        rhs[i] = x[i];
+    }
+    elliptic_curve_field_multiply(curve, lhs, y, lhs);
+    elliptic_curve_field_square(curve, x2, x);
+    elliptic_curve_field_add_a(curve, rhs);
+    elliptic_curve_field_multiply(curve, rhs, x2, rhs);
+    if (curve_shape(curve) & EC_CONTEXT_FLAG_B_ONE) {
+        rhs[0] ^= 1;
+    } else {
+        for (unsigned long i = 0; i < len; i++)
+            rhs[i] ^= curve->b[i];
+    }
 
     unsigned char diff = 0;
     for (unsigned long i = 0; i < len; i++)
@@ -270,16 +885,16 @@ int elliptic_curve_binary_point_on_curve(EllipticCurve *curve,
     return (diff == 0);
 }
 
-unsigned char* elliptic_curve_point_get_coord_x(EllipticCurve *curve, EllipticCurvePoint *point){
+unsigned char* elliptic_curve_point_get_coord_x(const EllipticCurve *curve, EllipticCurvePoint *point){
 	(void)curve;
 	return &point->point_mem[0];
 }
-unsigned char* elliptic_curve_point_get_coord_y(EllipticCurve *curve, EllipticCurvePoint *point){
+unsigned char* elliptic_curve_point_get_coord_y(const EllipticCurve *curve, EllipticCurvePoint *point){
 	return &point->point_mem[(curve->field_size_bytes + 7UL) & (~7UL)];
 }
-unsigned long elliptic_curve_point_get_coord_one_bytelen(EllipticCurve *curve){
+unsigned long elliptic_curve_point_get_coord_one_bytelen(const EllipticCurve *curve){
 	return (curve->field_size_bytes);
 }
-unsigned long elliptic_curve_point_get_coord_full_bytelen(EllipticCurve *curve){
+unsigned long elliptic_curve_point_get_coord_full_bytelen(const EllipticCurve *curve){
 	return (((curve->field_size_bytes + 7UL) & (~7UL)) + curve->field_size_bytes);
 }
@@ -3,6 +3,8 @@
 
 #include "galois_field2.h"
 
+struct EllipticCurveContext;
+
 typedef struct alignas(8){
     unsigned char a[GF2_VECTOR_MAX_BYTELEN];        // Curve coefficient a
     unsigned char b[GF2_VECTOR_MAX_BYTELEN];        // Curve coefficient b
@@ -14,6 +16,7 @@ typedef struct alignas(8){
     unsigned char curve_name_ascii[16];				// optional name
     unsigned long field_size_bytes;                 // Actual size of field element in bytes
     unsigned long binary_degree;					// 0 for prime fields, non-zero for binary
+    struct EllipticCurveContext *context;           // optional acceleration context, see elliptic_curve_context.h
 }EllipticCurve;
 
 typedef struct alignas(8){
@@ -22,22 +25,149 @@ typedef struct alignas(8){
 
 unsigned long elliptic_curve_get_maximum_vector_bytelen();
 
+// Reduces a field product in place modulo curve->modulus, using the curve's
+// sparse reduction descriptor when its context provides one.
+void elliptic_curve_field_reduce(const EllipticCurve *curve,
+		unsigned char *inout, unsigned long bytelen);
+
+// Fused field operations (gf2_field_*_lsb) with the curve's sparse reduction
+// when its context provides one. Outputs are reduced, may alias the inputs.
+void elliptic_curve_field_multiply(const EllipticCurve *curve, unsigned char *out,
+		const unsigned char *in1, const unsigned char *in2);
+void elliptic_curve_field_square(const EllipticCurve *curve, unsigned char *out,
+		const unsigned char *in);
+// out = in1 * in2 + add
+void elliptic_curve_field_multiply_add(const EllipticCurve *curve, unsigned char *out,
+		const unsigned char *in1, const unsigned char *in2, const unsigned char *add);
+// out = in1 * in2 + in3 * in4
+void elliptic_curve_field_multiply2_add(const EllipticCurve *curve, unsigned char *out,
+		const unsigned char *in1, const unsigned char *in2,
+		const unsigned char *in3, const unsigned char *in4);
+
+// out = in^-1 (variable time), 0 for in = 0
+void elliptic_curve_field_inverse(const EllipticCurve *curve, unsigned char *out,
+		const unsigned char *in);
+
+// inout += a. On curves whose context found a in { 0, 1 } (every Koblitz
+// curve, most random ones) this is nothing or one bit flip.
+void elliptic_curve_field_add_a(const EllipticCurve *curve, unsigned char *inout);
+
+// Field operations done by the curve layer since the last reset: fused
+// operations count one multiplication per product, inversions include the
+// constant-time ones. Only compiled in with EC_OPERATION_COUNTS=1 (plain
+// globals, not thread-safe, meant for operation-count benchmarks); all
+// zero otherwise.
+#ifndef EC_OPERATION_COUNTS
+#define EC_OPERATION_COUNTS (0)
+#endif
+
+typedef struct alignas(8){
+	unsigned long multiply;
+	unsigned long square;
+	unsigned long inverse;
+}EllipticCurveOperationCounts;
+
+void elliptic_curve_operation_counts_get(EllipticCurveOperationCounts *out);
+void elliptic_curve_operation_counts_reset();
+
 void elliptic_curve_binary_point_double(
-    EllipticCurve* curve,
+    const EllipticCurve* curve,
     EllipticCurvePoint* out,
-    EllipticCurvePoint* in);
-void elliptic_curve_binary_point_add(EllipticCurve* curve, EllipticCurvePoint* out, EllipticCurvePoint* in1, EllipticCurvePoint* in2);
+    const EllipticCurvePoint* in);
+// Point halving, the inverse of doubling on the odd-order subgroup, for
+// curves with a = 1, cofactor 2 and odd degree (B-163, B-233, ..., K-163).
+// Costs a half-trace, a square root and two multiplications instead of an
+// inversion; fast with the curve's context, slow but correct without.
+// Returns 0 (out untouched) if the curve does not qualify or in is not a
+// halvable point, i.e. Tr(x) != Tr(a).
+int elliptic_curve_binary_supports_halving(const EllipticCurve *curve);
+// Koblitz (anomalous binary) curve: a in { 0, 1 } and b = 1, so the
+// Frobenius map is an endomorphism (tau-and-add multiplication).
+int elliptic_curve_binary_is_koblitz(const EllipticCurve *curve);
+int elliptic_curve_binary_point_halve(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const EllipticCurvePoint *in);
+
+void elliptic_curve_binary_point_add(const EllipticCurve* curve, EllipticCurvePoint* out, const EllipticCurvePoint* in1, const EllipticCurvePoint* in2);
 
-void elliptic_curve_binary_point_multiply(EllipticCurve *curve, EllipticCurvePoint *out,
-		EllipticCurvePoint *in, const unsigned char *exp,
+// out = exp * in, exp an integer (see elliptic_curve_scalar.h). Koblitz
+// curves use tau-and-add on the Frobenius NAF of exp; on curves whose context
+// provides halving constants, points of the odd-order subgroup take a
+// halve-and-add path on the NAF of exp mod n; everything else (and curves
+// without a context) uses double-and-add on the fixed-length form of
+// exp mod #E, so the loop length does not depend on the scalar. A tuned
+// context (elliptic_curve_tune.h) may instead ask for double-and-add on every
+// curve, or for the projective ladder of elliptic_curve_binary_point_multiply_ct
+// (one-shot calls only; the state machine below stays affine).
+void elliptic_curve_binary_point_multiply(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const EllipticCurvePoint *in, const unsigned char *exp,
+		unsigned long bytelen);
+
+// The same multiplication as a resumable state machine, for callers that
+// cannot block for a whole multiplication (event loops, cooperative
+// schedulers, slow MCUs): init, then step until it returns 1, then finish.
+// Each step processes at most max_bits scalar bits (0: all remaining ones),
+// one doubling or halving plus at most one addition per bit. The state holds
+// copies of the point and scalar and is wiped by finish; it does not
+// allocate and can live anywhere (stack, pool, coroutine frame).
+// Scalars are at most GF2_VECTOR_MAX_BYTELEN bytes long.
+#define EC_MULTIPLY_MODE_DOUBLE_AND_ADD (0)
+#define EC_MULTIPLY_MODE_HALVE_AND_ADD  (1)
+#define EC_MULTIPLY_MODE_TAU_AND_ADD    (2)
+#define EC_MULTIPLY_MAX_DIGITS (8 * GF2_VECTOR_MAX_BYTELEN + 16)
+
+typedef struct alignas(8){
+	const EllipticCurve *curve;
+	EllipticCurvePoint in;
+	EllipticCurvePoint negated;             // -in (halve-and-add, tau-and-add)
+	EllipticCurvePoint acc;
+	unsigned char exp[GF2_VECTOR_MAX_BYTELEN + 1];  // double-and-add, fixed length
+	signed char naf[EC_MULTIPLY_MAX_DIGITS];        // halve-and-add, tau-and-add
+	long next;                              // next bit / digit
+	long end;
+	int mode;                               // EC_MULTIPLY_MODE_*
+}EllipticCurveMultiplyState;
+
+void elliptic_curve_binary_point_multiply_init(EllipticCurveMultiplyState *state,
+		const EllipticCurve *curve, const EllipticCurvePoint *in,
+		const unsigned char *exp, unsigned long bytelen);
+int elliptic_curve_binary_point_multiply_step(EllipticCurveMultiplyState *state,
+		unsigned long max_bits);
+void elliptic_curve_binary_point_multiply_finish(EllipticCurveMultiplyState *state,
+		EllipticCurvePoint *out);
+
+// out = exp * G. Reduces exp mod n, then uses the fixed-base comb from the
+// curve's context when available, the generic multiply otherwise.
+void elliptic_curve_binary_point_multiply_base(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const unsigned char *exp,
+		unsigned long bytelen);
+
+// Constant-time scalar multiplication: Montgomery ladder in Lopez-Dahab
+// x-only projective coordinates with masked conditional swaps, branch-free
+// field multiplication and a fixed-length inversion. The scalar is reduced
+// mod #E and brought to its fixed length without branches, so the ladder
+// runs bits(#E) + 1 steps whatever the scalar value; only bytelen and the
+// curve are public. x(P) is a factor of every step: it is multiplied from a
+// gf2_mul_fixed table (built per call, taken from the context for G), and
+// with the context's sqrt(b) table the doubling saves a squaring.
+void elliptic_curve_binary_point_multiply_ct(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const EllipticCurvePoint *in,
+		const unsigned char *exp, unsigned long bytelen);
+// Same, with the caller's gf2_mul_fixed_init() table of x(in), for repeated
+// multiplications of one point (prepared peer keys).
+void elliptic_curve_binary_point_multiply_ct_fixed(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const EllipticCurvePoint *in,
+		const GF2FixedOperand *x_fixed, const unsigned char *exp,
+		unsigned long bytelen);
+void elliptic_curve_binary_point_multiply_base_ct(const EllipticCurve *curve,
+		EllipticCurvePoint *out, const unsigned char *exp,
 		unsigned long bytelen);
 
-int elliptic_curve_binary_point_on_curve(EllipticCurve *curve,
-                                         EllipticCurvePoint *point);
+int elliptic_curve_binary_point_on_curve(const EllipticCurve *curve,
+                                         const EllipticCurvePoint *point);
 
-unsigned char* elliptic_curve_point_get_coord_x(EllipticCurve *curve, EllipticCurvePoint *point);
-unsigned char* elliptic_curve_point_get_coord_y(EllipticCurve *curve, EllipticCurvePoint *point);
-unsigned long elliptic_curve_point_get_coord_one_bytelen(EllipticCurve *curve);
-unsigned long elliptic_curve_point_get_coord_full_bytelen(EllipticCurve *curve);
+unsigned char* elliptic_curve_point_get_coord_x(const EllipticCurve *curve, EllipticCurvePoint *point);
+unsigned char* elliptic_curve_point_get_coord_y(const EllipticCurve *curve, EllipticCurvePoint *point);
+unsigned long elliptic_curve_point_get_coord_one_bytelen(const EllipticCurve *curve);
+unsigned long elliptic_curve_point_get_coord_full_bytelen(const EllipticCurve *curve);
 
 #endif /* ELLIPTIC_CURVE_H_ */
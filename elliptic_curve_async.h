@@ -0,0 +1,115 @@
+#ifndef ELLIPTIC_CURVE_ASYNC_H_
+#define ELLIPTIC_CURVE_ASYNC_H_
+
+#include "elliptic_curve.h"
+
+// C++20 coroutine front end to the resumable scalar multiplication
+// (elliptic_curve_binary_point_multiply_init/_step/_finish), for servers that
+// run many handshakes on one event-loop thread and must not stall it for a
+// whole multiplication.
+//
+//	EllipticCurveMultiplyTask task = elliptic_curve_binary_point_multiply_async(
+//			curve, &out, &peer, key, len, 16);
+//	while (!task.done()) {
+//		task.resume();          // 16 bits of work, then back to the loop
+//		poll_other_work();
+//	}
+//
+// The task runs its first slice when it is created, so point and scalar are
+// copied into the coroutine frame before the call returns and need not stay
+// alive; out must stay valid until done() is true. Unlike the rest of the
+// library this header uses the standard library (the coroutine frame is
+// heap-allocated), so it is only available to hosted C++20 builds.
+
+#if defined(__cplusplus) && __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define EC_ASYNC_AVAILABLE (1)
+
+class EllipticCurveMultiplyTask {
+public:
+	struct promise_type {
+		EllipticCurveMultiplyTask get_return_object() {
+			return EllipticCurveMultiplyTask(
+					std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		std::suspend_never initial_suspend() noexcept { return { }; }
+		std::suspend_always final_suspend() noexcept { return { }; }
+		void return_void() { }
+		void unhandled_exception() { }
+		// The multiplication state lives in the promise so that a task
+		// destroyed half-way does not leave key material in freed memory
+		~promise_type() {
+			volatile unsigned char *raw = (volatile unsigned char*) &state;
+			for (unsigned long i = 0; i < sizeof(state); ++i)
+				raw[i] = 0;
+		}
+		EllipticCurveMultiplyState state;
+	};
+
+	// co_await'ed once by the coroutine body to reach its promise's state
+	struct state_access {
+		EllipticCurveMultiplyState *state;
+		bool await_ready() const noexcept { return false; }
+		bool await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+			state = &h.promise().state;
+			return false;
+		}
+		EllipticCurveMultiplyState* await_resume() const noexcept { return state; }
+	};
+
+	EllipticCurveMultiplyTask(EllipticCurveMultiplyTask &&other) noexcept :
+			handle(other.handle) {
+		other.handle = nullptr;
+	}
+	EllipticCurveMultiplyTask& operator=(EllipticCurveMultiplyTask &&other) noexcept {
+		if (this != &other) {
+			if (handle)
+				handle.destroy();
+			handle = other.handle;
+			other.handle = nullptr;
+		}
+		return *this;
+	}
+	EllipticCurveMultiplyTask(const EllipticCurveMultiplyTask&) = delete;
+	EllipticCurveMultiplyTask& operator=(const EllipticCurveMultiplyTask&) = delete;
+	~EllipticCurveMultiplyTask() {
+		if (handle)
+			handle.destroy();
+	}
+
+	// Runs the next slice. Returns 1 once the result has been written.
+	int resume() {
+		if (handle && !handle.done())
+			handle.resume();
+		return done();
+	}
+	int done() const {
+		return !handle || handle.done();
+	}
+
+private:
+	explicit EllipticCurveMultiplyTask(std::coroutine_handle<promise_type> h) :
+			handle(h) {
+	}
+	std::coroutine_handle<promise_type> handle;
+};
+
+// out = exp * in, bits_per_step scalar bits per slice (0: all at once).
+// An unfinished task may be destroyed at any point; its state is wiped.
+inline EllipticCurveMultiplyTask elliptic_curve_binary_point_multiply_async(
+		const EllipticCurve *curve, EllipticCurvePoint *out,
+		const EllipticCurvePoint *in, const unsigned char *exp,
+		unsigned long bytelen, unsigned long bits_per_step) {
+	EllipticCurveMultiplyState *state =
+			co_await EllipticCurveMultiplyTask::state_access { nullptr };
+	elliptic_curve_binary_point_multiply_init(state, curve, in, exp, bytelen);
+	while (!elliptic_curve_binary_point_multiply_step(state, bits_per_step))
+		co_await std::suspend_always { };
+	elliptic_curve_binary_point_multiply_finish(state, out);
+}
+
+#endif
+#endif
+
+#endif /* ELLIPTIC_CURVE_ASYNC_H_ */
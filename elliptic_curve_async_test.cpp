@@ -0,0 +1,166 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "elliptic_curve_async.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0xA5F0C3E1UL)
+#include "ec_test_util.h"
+
+// Stepped multiplication against the one-shot call, slice sizes 1..all.
+// Returns the number of steps of the last run (0 if a result differed).
+static unsigned long async_test_stepped(const EllipticCurve *curve,
+		const EllipticCurvePoint *in, const unsigned char *k, unsigned long len) {
+	static const unsigned long slices[] = { 1, 3, 16, 64, 0 };
+	EllipticCurvePoint expected = { }, R = { };
+	unsigned long steps = 0;
+	elliptic_curve_binary_point_multiply(curve, &expected, in, k, len);
+
+	for (unsigned long s = 0; s < sizeof(slices) / sizeof(slices[0]); ++s) {
+		EllipticCurveMultiplyState state;
+		elliptic_curve_binary_point_multiply_init(&state, curve, in, k, len);
+		steps = 1;
+		while (!elliptic_curve_binary_point_multiply_step(&state, slices[s]))
+			++steps;
+		// Stepping a finished state is a no-op
+		if (!elliptic_curve_binary_point_multiply_step(&state, slices[s]))
+			return 0;
+		elliptic_curve_binary_point_multiply_finish(&state, &R);
+		if (!ec_test_points_equal(curve, &R, &expected))
+			return 0;
+		if (slices[s] == 1 && steps > 8 * len + 1)
+			return 0;
+	}
+	return steps;
+}
+
+#ifdef EC_ASYNC_AVAILABLE
+static int async_test_coroutines(const EllipticCurve *curve,
+		const EllipticCurvePoint *G, const unsigned char *k, unsigned long len) {
+	EllipticCurvePoint expected = { }, R = { };
+	int ok = 1;
+	elliptic_curve_binary_point_multiply(curve, &expected, G, k, len);
+
+	// Inputs are copied by the first slice: clobber them right after creation
+	EllipticCurvePoint in = *G;
+	unsigned char exp[GF2_VECTOR_MAX_BYTELEN] = { };
+	for (unsigned long i = 0; i < len; ++i)
+		exp[i] = k[i];
+	EllipticCurveMultiplyTask task = elliptic_curve_binary_point_multiply_async(
+			curve, &R, &in, exp, len, 8);
+	in.point_mem[0] ^= 1;
+	exp[0] ^= 1;
+	unsigned long resumes = 0;
+	while (!task.resume())
+		++resumes;
+	ok &= resumes > 0 && task.done() && ec_test_points_equal(curve, &R, &expected);
+
+	// Interleaved tasks on one thread, round robin; one abandoned half-way
+	EllipticCurvePoint out[3] = { };
+	EllipticCurveMultiplyTask tasks[3] = {
+		elliptic_curve_binary_point_multiply_async(curve, &out[0], G, k, len, 5),
+		elliptic_curve_binary_point_multiply_async(curve, &out[1], G, k, len, 17),
+		elliptic_curve_binary_point_multiply_async(curve, &out[2], G, k, len, 1)
+	};
+	tasks[2].resume();
+	tasks[2] = elliptic_curve_binary_point_multiply_async(curve, &out[2], G, k, len, 0);
+	for (int busy = 1; busy;) {
+		busy = 0;
+		for (int t = 0; t < 3; ++t)
+			busy |= !tasks[t].resume();
+	}
+	for (int t = 0; t < 3; ++t)
+		ok &= ec_test_points_equal(curve, &out[t], &expected);
+	return ok;
+}
+#endif
+
+int test_elliptic_curve_async() {
+	int failures = 0;
+	std::cout << "\n--- Testing the resumable scalar multiplication ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned long len = curve->field_size_bytes;
+		EllipticCurve bare = *curve;
+		bare.context = 0;
+		EllipticCurvePoint G = { };
+		ec_test_load_base(curve, &G);
+		int ok = 1;
+
+		// Random, 0, 1 and n: both schedules (context / no context)
+		for (int iter = 0; iter < 6; ++iter) {
+			unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+			for (unsigned long i = 0; i < len; ++i) {
+				if (iter < 3)
+					k[i] = ec_test_random_byte();
+				else if (iter < 5)
+					k[i] = i ? 0 : (unsigned char) (iter - 3);
+				else
+					k[i] = curve->order[i];
+			}
+			ok &= async_test_stepped(curve, &G, k, len) != 0;
+			ok &= async_test_stepped(&bare, &G, k, len) != 0;
+#ifdef EC_ASYNC_AVAILABLE
+			if (iter == 0)
+				ok &= async_test_coroutines(curve, &G, k, len);
+#endif
+		}
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+#ifndef EC_ASYNC_AVAILABLE
+	std::cout << "(coroutine wrapper not tested: needs C++20)\n";
+#endif
+	return failures;
+}
+
+// Cost of slicing: one-shot vs. 16-bit slices, and the longest single slice,
+// which bounds how long an event loop is held up
+void benchmark_elliptic_curve_async() {
+	const int runs = 20;
+	std::cout << "\n--- Benchmark: resumable multiplication, 16-bit slices (us) ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right
+			<< std::setw(10) << "one-shot" << std::setw(10) << "stepped"
+			<< std::setw(8) << "steps" << std::setw(12) << "max slice" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned long len = curve->field_size_bytes;
+		EllipticCurvePoint G = { }, R = { };
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		ec_test_load_base(curve, &G);
+		for (unsigned long i = 0; i + 1 < len; ++i)
+			k[i] = (unsigned char) (0x6B * (i + 3));
+		elliptic_curve_binary_point_multiply(curve, &R, &G, k, len); // warm context
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			elliptic_curve_binary_point_multiply(curve, &R, &G, k, len);
+		auto t1 = std::chrono::steady_clock::now();
+		double max_slice = 0.0;
+		unsigned long steps = 0;
+		for (int r = 0; r < runs; ++r) {
+			EllipticCurveMultiplyState state;
+			elliptic_curve_binary_point_multiply_init(&state, curve, &G, k, len);
+			for (int finished = 0; !finished; ++steps) {
+				auto s0 = std::chrono::steady_clock::now();
+				finished = elliptic_curve_binary_point_multiply_step(&state, 16);
+				double us = ec_test_microseconds(s0, std::chrono::steady_clock::now(), 1);
+				if (us > max_slice)
+					max_slice = us;
+			}
+			elliptic_curve_binary_point_multiply_finish(&state, &R);
+		}
+		auto t2 = std::chrono::steady_clock::now();
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::right << std::fixed << std::setprecision(1)
+				<< std::setw(10) << ec_test_microseconds(t0, t1, runs)
+				<< std::setw(10) << ec_test_microseconds(t1, t2, runs)
+				<< std::setw(8) << steps / runs
+				<< std::setw(12) << max_slice << "\n";
+	}
+}
@@ -0,0 +1,219 @@
+#include "elliptic_curve_batch.h"
+
+// Per lane: accumulator, denominator (then its inverse), prefix product, state
+typedef struct alignas(8){
+	EllipticCurvePoint acc;
+	unsigned char den[GF2_VECTOR_MAX_BYTELEN];
+	unsigned char prefix[GF2_VECTOR_MAX_BYTELEN];
+	unsigned int active;                    // denominator takes part in the inversion
+	unsigned int infinity;                  // acc is O
+}BatchLane;
+
+static_assert(sizeof(BatchLane) == EC_BATCH_LANE_BYTELEN, "EC_BATCH_LANE_BYTELEN out of date");
+
+unsigned long elliptic_curve_batch_scratch_bytelen(unsigned long count) {
+	return count * EC_BATCH_LANE_BYTELEN;
+}
+
+static int batch_is_zero(const unsigned char *in, unsigned long len) {
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < len; ++i)
+		acc |= in[i];
+	return acc == 0;
+}
+
+// Replaces lanes[i].den by its inverse for every active lane
+static void batch_invert_lanes(const EllipticCurve *curve, BatchLane *lanes,
+		unsigned long count) {
+	unsigned long len = curve->field_size_bytes;
+	alignas(8) unsigned char inv[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char tmp[GF2_VECTOR_MAX_BYTELEN];
+	const unsigned char *running = 0;
+	long last = -1;
+
+	for (unsigned long i = 0; i < count; ++i) {
+		if (!lanes[i].active)
+			continue;
+		if (running)
+			elliptic_curve_field_multiply(curve, lanes[i].prefix, running, lanes[i].den);
+		else
+			for (unsigned long b = 0; b < len; ++b)
+				lanes[i].prefix[b] = lanes[i].den[b];
+		running = lanes[i].prefix;
+		last = (long) i;
+	}
+	if (last < 0)
+		return;
+
+	elliptic_curve_field_inverse(curve, inv, lanes[last].prefix);
+	// inv = 1 / (den_0 ... den_i); walking down, 1 / den_i = inv * prefix_(i-1)
+	for (long i = last; i >= 0; --i) {
+		if (!lanes[i].active)
+			continue;
+		long prev = i - 1;
+		while (prev >= 0 && !lanes[prev].active)
+			--prev;
+		if (prev < 0) {
+			for (unsigned long b = 0; b < len; ++b)
+				lanes[i].den[b] = inv[b];
+			break;
+		}
+		elliptic_curve_field_multiply(curve, tmp, inv, lanes[prev].prefix);
+		elliptic_curve_field_multiply(curve, inv, inv, lanes[i].den);
+		for (unsigned long b = 0; b < len; ++b)
+			lanes[i].den[b] = tmp[b];
+	}
+}
+
+int elliptic_curve_field_batch_inverse(const EllipticCurve *curve,
+		unsigned char *const *inout, unsigned long count,
+		void *scratch, unsigned long scratch_bytelen) {
+	unsigned long len = curve->field_size_bytes;
+	BatchLane *lanes = (BatchLane*) scratch;
+
+	if ((!scratch && count) || ((unsigned long) scratch & 7UL)
+			|| scratch_bytelen < elliptic_curve_batch_scratch_bytelen(count))
+		return 0;
+	for (unsigned long i = 0; i < count; ++i) {
+		lanes[i].active = !batch_is_zero(inout[i], len);
+		for (unsigned long b = 0; b < len; ++b)
+			lanes[i].den[b] = inout[i][b];
+	}
+	batch_invert_lanes(curve, lanes, count);
+	for (unsigned long i = 0; i < count; ++i) {
+		if (lanes[i].active)
+			for (unsigned long b = 0; b < len; ++b)
+				inout[i][b] = lanes[i].den[b];
+	}
+	return 1;
+}
+
+// (x3, y3) from lambda and the first operand (x1, y1), x2 = x1 for doubling:
+//   x3 = lambda^2 + lambda + x1 + x2 + a,  y3 = lambda (x1 + x3) + x3 + y1
+static void batch_finish(const EllipticCurve *curve, EllipticCurvePoint *acc,
+		const unsigned char *lambda, const unsigned char *x2) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	alignas(8) unsigned char x3[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char t[GF2_VECTOR_MAX_BYTELEN];
+
+	elliptic_curve_field_square(curve, x3, lambda);
+	for (unsigned long i = 0; i < len; ++i)
+		x3[i] ^= lambda[i] ^ acc->point_mem[i] ^ x2[i];
+	elliptic_curve_field_add_a(curve, x3);
+	for (unsigned long i = 0; i < len; ++i)
+		t[i] = acc->point_mem[i] ^ x3[i];
+	elliptic_curve_field_multiply(curve, t, lambda, t);
+	for (unsigned long i = 0; i < len; ++i) {
+		acc->point_mem[i + y_offset] ^= t[i] ^ x3[i];
+		acc->point_mem[i] = x3[i];
+	}
+}
+
+// acc = 2 acc for every lane; x = 0 is the point of order 2 (2T = O)
+static void batch_double(const EllipticCurve *curve, BatchLane *lanes,
+		unsigned long count) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	alignas(8) unsigned char lambda[GF2_VECTOR_MAX_BYTELEN];
+
+	for (unsigned long i = 0; i < count; ++i) {
+		lanes[i].active = 0;
+		if (lanes[i].infinity)
+			continue;
+		if (batch_is_zero(lanes[i].acc.point_mem, len)) {
+			for (unsigned long b = 0; b < 2 * GF2_VECTOR_MAX_BYTELEN; ++b)
+				lanes[i].acc.point_mem[b] = 0;
+			lanes[i].infinity = 1;
+			continue;
+		}
+		for (unsigned long b = 0; b < len; ++b)
+			lanes[i].den[b] = lanes[i].acc.point_mem[b];
+		lanes[i].active = 1;
+	}
+	batch_invert_lanes(curve, lanes, count);
+	// lambda = x + y / x
+	for (unsigned long i = 0; i < count; ++i) {
+		if (!lanes[i].active)
+			continue;
+		elliptic_curve_field_multiply(curve, lambda, &lanes[i].acc.point_mem[y_offset], lanes[i].den);
+		for (unsigned long b = 0; b < len; ++b)
+			lambda[b] ^= lanes[i].acc.point_mem[b];
+		alignas(8) unsigned char x1[GF2_VECTOR_MAX_BYTELEN];
+		for (unsigned long b = 0; b < len; ++b)
+			x1[b] = lanes[i].acc.point_mem[b];
+		batch_finish(curve, &lanes[i].acc, lambda, x1);
+	}
+}
+
+// acc += in for the lanes whose scalar bit is set. Equal x coordinates
+// (acc = +-in) are rare and go through the generic addition.
+static void batch_add(const EllipticCurve *curve, BatchLane *lanes,
+		const EllipticCurvePoint *const *in, const unsigned char *const *exp,
+		unsigned long count, unsigned long bit) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	alignas(8) unsigned char lambda[GF2_VECTOR_MAX_BYTELEN];
+
+	for (unsigned long i = 0; i < count; ++i) {
+		lanes[i].active = 0;
+		if (!((exp[i][bit >> 3] >> (bit & 7)) & 1))
+			continue;
+		if (batch_is_zero(in[i]->point_mem, len)
+				&& batch_is_zero(&in[i]->point_mem[y_offset], len))
+			continue;
+		if (lanes[i].infinity) {
+			for (unsigned long b = 0; b < len; ++b) {
+				lanes[i].acc.point_mem[b] = in[i]->point_mem[b];
+				lanes[i].acc.point_mem[b + y_offset] = in[i]->point_mem[b + y_offset];
+			}
+			lanes[i].infinity = 0;
+			continue;
+		}
+		for (unsigned long b = 0; b < len; ++b)
+			lanes[i].den[b] = lanes[i].acc.point_mem[b] ^ in[i]->point_mem[b];
+		if (batch_is_zero(lanes[i].den, len)) {
+			elliptic_curve_binary_point_add(curve, &lanes[i].acc, &lanes[i].acc, in[i]);
+			lanes[i].infinity = batch_is_zero(lanes[i].acc.point_mem, 2 * GF2_VECTOR_MAX_BYTELEN);
+			continue;
+		}
+		lanes[i].active = 1;
+	}
+	batch_invert_lanes(curve, lanes, count);
+	// lambda = (y1 + y2) / (x1 + x2)
+	for (unsigned long i = 0; i < count; ++i) {
+		if (!lanes[i].active)
+			continue;
+		for (unsigned long b = 0; b < len; ++b)
+			lambda[b] = lanes[i].acc.point_mem[b + y_offset] ^ in[i]->point_mem[b + y_offset];
+		elliptic_curve_field_multiply(curve, lambda, lambda, lanes[i].den);
+		batch_finish(curve, &lanes[i].acc, lambda, in[i]->point_mem);
+	}
+}
+
+int elliptic_curve_binary_point_multiply_batch(const EllipticCurve *curve,
+		EllipticCurvePoint *const *out, const EllipticCurvePoint *const *in,
+		const unsigned char *const *exp, unsigned long count,
+		unsigned long bytelen, void *scratch, unsigned long scratch_bytelen) {
+	BatchLane *lanes = (BatchLane*) scratch;
+	long top = -1;
+
+	if ((!scratch && count) || ((unsigned long) scratch & 7UL)
+			|| scratch_bytelen < elliptic_curve_batch_scratch_bytelen(count))
+		return 0;
+	for (unsigned long i = 0; i < count; ++i) {
+		long degree = gf2_degree_lsb(exp[i], bytelen);
+		if (degree > top)
+			top = degree;
+		for (unsigned long b = 0; b < 2 * GF2_VECTOR_MAX_BYTELEN; ++b)
+			lanes[i].acc.point_mem[b] = 0;
+		lanes[i].infinity = 1;
+	}
+	for (long bit = top; bit >= 0; --bit) {
+		batch_double(curve, lanes, count);
+		batch_add(curve, lanes, in, exp, count, (unsigned long) bit);
+	}
+	for (unsigned long i = 0; i < count; ++i)
+		*out[i] = lanes[i].acc;
+	return 1;
+}
@@ -0,0 +1,40 @@
+#ifndef ELLIPTIC_CURVE_BATCH_H_
+#define ELLIPTIC_CURVE_BATCH_H_
+
+#include "elliptic_curve.h"
+
+// Batched affine arithmetic.
+//
+// Every affine point operation needs one field inversion, which costs far
+// more than a multiplication. Independent operations run in lock step can
+// share it (Montgomery's trick): count inversions become one inversion and
+// 3 * (count - 1) multiplications.
+//
+// These are variable-time routines (the schedule follows the scalar bits);
+// keep them to public scalars or to builds that accept variable-time ECDH
+// (ECDH_CONSTANT_TIME == 0).
+//
+// Nothing is allocated: the caller supplies an 8-byte aligned scratch area
+// of elliptic_curve_batch_scratch_bytelen() bytes.
+
+// Scratch per operation in the batch (count * this in total)
+#define EC_BATCH_LANE_BYTELEN ((sizeof(EllipticCurvePoint) + 2 * GF2_VECTOR_MAX_BYTELEN + 8 + 7) & ~7UL)
+
+unsigned long elliptic_curve_batch_scratch_bytelen(unsigned long count);
+
+// inout[i] = 1 / inout[i] for count reduced field elements. Zeros stay zero
+// and don't disturb the others. Returns 0 if the scratch area is too small.
+int elliptic_curve_field_batch_inverse(const EllipticCurve *curve,
+		unsigned char *const *inout, unsigned long count,
+		void *scratch, unsigned long scratch_bytelen);
+
+// out[i] = exp[i] * in[i] for count independent multiplications (double-and-
+// add, one shared inversion per step). exp[i] are bytelen bytes, LSB first;
+// out[i] may alias in[i]. Returns 1 on success, 0 on a scratch area that is
+// too small (out is then untouched).
+int elliptic_curve_binary_point_multiply_batch(const EllipticCurve *curve,
+		EllipticCurvePoint *const *out, const EllipticCurvePoint *const *in,
+		const unsigned char *const *exp, unsigned long count,
+		unsigned long bytelen, void *scratch, unsigned long scratch_bytelen);
+
+#endif /* ELLIPTIC_CURVE_BATCH_H_ */
@@ -0,0 +1,151 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "elliptic_curve_batch.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x7A3D19E5UL)
+#include "ec_test_util.h"
+
+int test_elliptic_curve_batch() {
+	int failures = 0;
+	std::cout << "\n--- Testing batched inversion and lock-step multiplication ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned long len = curve->field_size_bytes;
+		const unsigned long count = 12;
+		std::vector<unsigned char> scratch_mem(elliptic_curve_batch_scratch_bytelen(count) + 8);
+		void *scratch = (void*) (((unsigned long) scratch_mem.data() + 7UL) & ~7UL);
+		unsigned long scratch_bytelen = elliptic_curve_batch_scratch_bytelen(count);
+		int ok = 1;
+
+		// Field: random elements and a zero in the middle
+		std::vector<std::vector<unsigned char> > elems(count, std::vector<unsigned char>(len, 0));
+		std::vector<unsigned char*> ptrs(count);
+		for (unsigned long i = 0; i < count; ++i) {
+			for (unsigned long b = 0; b + 1 < len; ++b)
+				elems[i][b] = (i == 5) ? 0 : ec_test_random_byte();
+			ptrs[i] = elems[i].data();
+		}
+		std::vector<std::vector<unsigned char> > expect = elems;
+		for (unsigned long i = 0; i < count; ++i)
+			if (i != 5)
+				gf2_binary_inverse_lsb(elems[i].data(), expect[i].data(), len, curve->modulus);
+		ok &= elliptic_curve_field_batch_inverse(curve, ptrs.data(), count, scratch, scratch_bytelen);
+		ok &= elems == expect;
+		ok &= !elliptic_curve_field_batch_inverse(curve, ptrs.data(), count, scratch, scratch_bytelen - 1);
+
+		// Points: multiples of G, a repeated point, a point and its negative,
+		// O, and scalars 0, 1, n, n - 1 and random
+		std::vector<EllipticCurvePoint> points(count), results(count), expected(count);
+		std::vector<std::vector<unsigned char> > scalars(count, std::vector<unsigned char>(len, 0));
+		std::vector<EllipticCurvePoint*> out(count);
+		std::vector<const EllipticCurvePoint*> in(count);
+		std::vector<const unsigned char*> exp(count);
+		unsigned long y_offset = (len + 7UL) & (~7UL);
+		for (unsigned long i = 0; i < count; ++i) {
+			unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+			k[0] = (unsigned char) (i + 3);
+			k[1] = ec_test_random_byte();
+			points[i] = EllipticCurvePoint();
+			elliptic_curve_binary_point_multiply_base(curve, &points[i], k, len);
+			for (unsigned long b = 0; b + 1 < len; ++b)
+				scalars[i][b] = ec_test_random_byte();
+		}
+		points[2] = points[1];
+		for (unsigned long b = 0; b < len; ++b) {
+			points[3].point_mem[b] = points[1].point_mem[b];
+			points[3].point_mem[b + y_offset] = points[1].point_mem[b] ^ points[1].point_mem[b + y_offset];
+		}
+		scalars[3] = scalars[1];
+		points[4] = EllipticCurvePoint();
+		scalars[6].assign(len, 0);
+		scalars[7].assign(len, 0);
+		scalars[7][0] = 1;
+		for (unsigned long b = 0; b < len; ++b) {
+			scalars[8][b] = curve->order[b];
+			scalars[9][b] = curve->order[b];
+		}
+		scalars[9][0] -= 1;
+		for (unsigned long i = 0; i < count; ++i) {
+			out[i] = &results[i];
+			in[i] = &points[i];
+			exp[i] = scalars[i].data();
+			elliptic_curve_binary_point_multiply(curve, &expected[i], &points[i], exp[i], len);
+		}
+		ok &= elliptic_curve_binary_point_multiply_batch(curve, out.data(), in.data(), exp.data(),
+				count, len, scratch, scratch_bytelen);
+		for (unsigned long i = 0; i < count; ++i)
+			ok &= ec_test_points_equal(curve, &results[i], &expected[i]);
+
+		// In place, batch of one, empty batch
+		ok &= elliptic_curve_binary_point_multiply_batch(curve, out.data(),
+				(const EllipticCurvePoint* const*) out.data(), exp.data(), 1, len, scratch, scratch_bytelen);
+		elliptic_curve_binary_point_multiply(curve, &expected[0], &expected[0], exp[0], len);
+		ok &= ec_test_points_equal(curve, &results[0], &expected[0]);
+		ok &= elliptic_curve_binary_point_multiply_batch(curve, out.data(), in.data(), exp.data(),
+				0, len, 0, 0);
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Cost per multiplication against the batch size
+void benchmark_elliptic_curve_batch() {
+	const unsigned long sizes[] = { 1, 4, 16, 32 };
+	std::cout << "\n--- Benchmark: lock-step batch multiplication, us per k*P ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right << std::setw(10) << "single";
+	for (unsigned long s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+		std::cout << std::setw(9) << "batch " << std::setw(3) << sizes[s];
+	std::cout << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned long len = curve->field_size_bytes;
+		const unsigned long max = 32;
+		std::vector<unsigned char> scratch_mem(elliptic_curve_batch_scratch_bytelen(max) + 8);
+		void *scratch = (void*) (((unsigned long) scratch_mem.data() + 7UL) & ~7UL);
+		std::vector<EllipticCurvePoint> points(max), results(max);
+		std::vector<std::vector<unsigned char> > scalars(max, std::vector<unsigned char>(len, 0));
+		std::vector<EllipticCurvePoint*> out(max);
+		std::vector<const EllipticCurvePoint*> in(max);
+		std::vector<const unsigned char*> exp(max);
+		for (unsigned long i = 0; i < max; ++i) {
+			unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+			k[0] = (unsigned char) (i + 2);
+			points[i] = EllipticCurvePoint();
+			elliptic_curve_binary_point_multiply_base(curve, &points[i], k, len);
+			for (unsigned long b = 0; b + 1 < len; ++b)
+				scalars[i][b] = ec_test_random_byte();
+			out[i] = &results[i];
+			in[i] = &points[i];
+			exp[i] = scalars[i].data();
+		}
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (unsigned long i = 0; i < 4; ++i)
+			elliptic_curve_binary_point_multiply(curve, &results[i], &points[i], exp[i], len);
+		auto t1 = std::chrono::steady_clock::now();
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::right << std::fixed << std::setprecision(0)
+				<< std::setw(10) << std::chrono::duration<double, std::micro>(t1 - t0).count() / 4;
+		for (unsigned long s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+			double best = 0;
+			for (int rep = 0; rep < 3; ++rep) {
+				t0 = std::chrono::steady_clock::now();
+				elliptic_curve_binary_point_multiply_batch(curve, out.data(), in.data(), exp.data(),
+						sizes[s], len, scratch, elliptic_curve_batch_scratch_bytelen(max));
+				t1 = std::chrono::steady_clock::now();
+				double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / sizes[s];
+				if (!rep || us < best)
+					best = us;
+			}
+			std::cout << std::setw(12) << best;
+		}
+		std::cout << "\n";
+	}
+}
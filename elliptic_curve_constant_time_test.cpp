@@ -0,0 +1,123 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "ecdh.h"
+#include "elliptic_curve_registry.h"
+#include "ec_test_util.h"
+
+int test_elliptic_curve_constant_time() {
+	int failures = 0;
+	std::cout << "\n--- Testing constant-time ladder against the generic multiply ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned long len = curve->field_size_bytes;
+		EllipticCurvePoint G = { }, R1 = { }, R2 = { };
+		for (unsigned long i = 0; i < len; ++i) {
+			elliptic_curve_point_get_coord_x(curve, &G)[i] = curve->xG[i];
+			elliptic_curve_point_get_coord_y(curve, &G)[i] = curve->yG[i];
+		}
+
+		int ok = 1;
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		// Small scalars, random scalars, the order (k P = O) and order - 1
+		// (k P = -P, which takes the Z2 = 0 branch of the y recovery)
+		for (int iter = 0; iter < 12; ++iter) {
+			for (unsigned long i = 0; i < len; ++i) {
+				if (iter < 4)
+					k[i] = i ? 0 : (unsigned char) iter;
+				else if (iter < 10)
+					k[i] = (unsigned char) (0x9D * (i + 1) * iter + c);
+				else
+					k[i] = curve->order[i];
+			}
+			if (iter == 11)
+				k[0] -= 1;  // order is odd
+			elliptic_curve_binary_point_multiply(curve, &R1, &G, k, len);
+			elliptic_curve_binary_point_multiply_ct(curve, &R2, &G, k, len);
+			ok &= ec_test_points_equal(curve, &R1, &R2);
+		}
+
+		// ECDH through the constant-time entry points
+		alignas(8) unsigned char priv_a[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char priv_b[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char pub_a[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char pub_b[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char pub_ref[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char secret_a[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char secret_b[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char secret_ref[GF2_VECTOR_MAX_BYTELEN] = { };
+		for (unsigned long i = 0; i + 1 < len; ++i) {
+			priv_a[i] = (unsigned char) (0x3B * i + 7);
+			priv_b[i] = (unsigned char) (0xC5 * i + 1);
+		}
+		ecdh_generate_public_key_ct(curve, priv_a, pub_a);
+		ecdh_generate_public_key_ct(curve, priv_b, pub_b);
+		ecdh_generate_public_key(curve, priv_a, pub_ref);
+		ok &= ec_test_points_equal(curve, (EllipticCurvePoint*) pub_a,
+				(EllipticCurvePoint*) pub_ref);
+		ecdh_generate_shared_secret_ct(curve, priv_a, pub_b, secret_a);
+		ecdh_generate_shared_secret_ct(curve, priv_b, pub_a, secret_b);
+		ecdh_generate_shared_secret(curve, priv_a, pub_b, secret_ref);
+		for (unsigned long i = 0; i < len; ++i)
+			ok &= secret_a[i] == secret_b[i] && secret_a[i] == secret_ref[i];
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Overhead of the constant-time path versus the fast paths, and the spread of
+// ladder timings between a sparse and a dense scalar (should be noise only).
+void benchmark_elliptic_curve_constant_time() {
+	const int runs = 20;
+	std::cout << "\n--- Benchmark: constant-time ladder vs. variable-time paths (us/op) ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right
+			<< std::setw(12) << "generic" << std::setw(12) << "comb(k*G)"
+			<< std::setw(12) << "ct ladder" << std::setw(12) << "ct k=1"
+			<< std::setw(12) << "ct k=~0" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned long len = curve->field_size_bytes;
+		EllipticCurvePoint G = { }, R = { };
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char k_one[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char k_dense[GF2_VECTOR_MAX_BYTELEN] = { };
+		for (unsigned long i = 0; i < len; ++i) {
+			elliptic_curve_point_get_coord_x(curve, &G)[i] = curve->xG[i];
+			elliptic_curve_point_get_coord_y(curve, &G)[i] = curve->yG[i];
+			k[i] = (unsigned char) (0x6B * (i + 3));
+			k_dense[i] = 0xFF;
+		}
+		k_one[0] = 1;
+		elliptic_curve_binary_point_multiply_base(curve, &R, k, len); // warm context
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			elliptic_curve_binary_point_multiply(curve, &R, &G, k, len);
+		auto t1 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			elliptic_curve_binary_point_multiply_base(curve, &R, k, len);
+		auto t2 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			elliptic_curve_binary_point_multiply_ct(curve, &R, &G, k, len);
+		auto t3 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			elliptic_curve_binary_point_multiply_ct(curve, &R, &G, k_one, len);
+		auto t4 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			elliptic_curve_binary_point_multiply_ct(curve, &R, &G, k_dense, len);
+		auto t5 = std::chrono::steady_clock::now();
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::right << std::fixed << std::setprecision(1)
+				<< std::setw(12) << ec_test_microseconds(t0, t1, runs)
+				<< std::setw(12) << ec_test_microseconds(t1, t2, runs)
+				<< std::setw(12) << ec_test_microseconds(t2, t3, runs)
+				<< std::setw(12) << ec_test_microseconds(t3, t4, runs)
+				<< std::setw(12) << ec_test_microseconds(t4, t5, runs) << "\n";
+	}
+}
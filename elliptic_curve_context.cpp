@@ -0,0 +1,228 @@
+#include "elliptic_curve_context.h"
+#include "ec_atomic.h"
+
+void elliptic_curve_context_init(EllipticCurveContext *ctx) {
+	unsigned char *raw = (unsigned char*) ctx;
+	for (unsigned long i = 0; i < sizeof(EllipticCurveContext); ++i)
+		raw[i] = 0;
+}
+
+void elliptic_curve_attach_context(EllipticCurve *curve, EllipticCurveContext *ctx) {
+	curve->context = ctx;
+}
+
+void elliptic_curve_tuning_default(EllipticCurveTuning *out) {
+	unsigned char *raw = (unsigned char*) out;
+	for (unsigned long i = 0; i < sizeof(EllipticCurveTuning); ++i)
+		raw[i] = 0;
+	gf2_multiply_plan_default(&out->plan);
+	out->comb_width = EC_CONTEXT_COMB_WIDTH;
+	out->multiply = EC_TUNE_MULTIPLY_AUTO;
+	out->origin = EC_TUNE_ORIGIN_DEFAULT;
+}
+
+// a in { 0, 1 }, b = 1
+static unsigned int context_curve_shape(const EllipticCurve *curve) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned char a_high = 0, b_high = 0;
+	unsigned int flags = 0;
+
+	for (unsigned long i = 1; i < len; ++i) {
+		a_high |= curve->a[i];
+		b_high |= curve->b[i];
+	}
+	if (!a_high && curve->a[0] == 0)
+		flags |= EC_CONTEXT_FLAG_A_ZERO;
+	if (!a_high && curve->a[0] == 1)
+		flags |= EC_CONTEXT_FLAG_A_ONE;
+	if (!b_high && curve->b[0] == 1)
+		flags |= EC_CONTEXT_FLAG_B_ONE;
+	return flags;
+}
+
+void elliptic_curve_context_build_comb(const EllipticCurve *curve,
+		EllipticCurveContextData *out, unsigned int width) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long w = width;
+	unsigned long d = (8 * len + w - 1) / w;
+	EllipticCurvePoint column = { };
+
+	// The context is not ready while it is being built, so point arithmetic
+	// here must not go back to it: work on a context-less copy of the curve.
+	EllipticCurve bare = *curve;
+	bare.context = 0;
+
+	for (unsigned long i = 0; i < len; ++i) {
+		elliptic_curve_point_get_coord_x(&bare, &column)[i] = curve->xG[i];
+		elliptic_curve_point_get_coord_y(&bare, &column)[i] = curve->yG[i];
+	}
+	// column = 2^(j*d) G; entries with top bit j are column + entry[i - 2^j]
+	for (unsigned long j = 0; j < w; ++j) {
+		unsigned long top = 1UL << j;
+		if (j) {
+			for (unsigned long k = 0; k < d; ++k)
+				elliptic_curve_binary_point_double(&bare, &column, &column);
+		}
+		out->base_comb[top - 1] = column;
+		for (unsigned long i = top + 1; i < 2 * top; ++i)
+			elliptic_curve_binary_point_add(&bare, &out->base_comb[i - 1],
+					&out->base_comb[i - top - 1], &column);
+	}
+	for (unsigned long i = (1UL << w) - 1; i < EC_CONTEXT_COMB_POINTS; ++i)
+		for (unsigned long k = 0; k < sizeof(EllipticCurvePoint); ++k)
+			out->base_comb[i].point_mem[k] = 0;
+	out->comb_width = (unsigned int) w;
+	out->comb_columns = (unsigned int) d;
+	out->flags |= EC_CONTEXT_FLAG_BASE_COMB;
+}
+
+// Multiplication tables for the ladder's loop-invariant factors. With
+// sqrt(b) the doubling is X = (X^2 + sqrt(b) Z^2)^2, one squaring less.
+static void context_build_fixed_operands(const EllipticCurve *curve,
+		EllipticCurveContextData *out) {
+	unsigned long len = curve->field_size_bytes;
+	alignas(8) unsigned char sqrt_b[GF2_VECTOR_MAX_BYTELEN] = { };
+
+	gf2_mul_fixed_init(&out->x_base, curve->xG, len);
+	if (!(out->flags & EC_CONTEXT_FLAG_B_ONE))
+		gf2_sqrt_lsb(curve->b, sqrt_b, len, curve->modulus);
+	gf2_mul_fixed_init(&out->sqrt_b, sqrt_b, len);
+	out->flags |= EC_CONTEXT_FLAG_FIXED_OPERANDS;
+}
+
+int elliptic_curve_context_build(const EllipticCurve *curve, EllipticCurveContextData *out) {
+	unsigned char *raw = (unsigned char*) out;
+	for (unsigned long i = 0; i < sizeof(EllipticCurveContextData); ++i)
+		raw[i] = 0;
+
+	out->field_size_bytes = (unsigned int) curve->field_size_bytes;
+	out->binary_degree = (unsigned int) curve->binary_degree;
+	out->flags |= context_curve_shape(curve);
+	if (gf2_reduction_descriptor_init(&out->reduction, curve->modulus,
+			curve->field_size_bytes))
+		out->flags |= EC_CONTEXT_FLAG_SPARSE_REDUCTION;
+	elliptic_curve_context_build_comb(curve, out, EC_CONTEXT_COMB_WIDTH);
+	if (gf2_linear_maps_init(&out->linear_maps, curve->modulus, curve->field_size_bytes))
+		out->flags |= EC_CONTEXT_FLAG_LINEAR_MAPS;
+	if ((out->flags & EC_CONTEXT_FLAG_LINEAR_MAPS)
+			&& elliptic_curve_binary_supports_halving(curve))
+		out->flags |= EC_CONTEXT_FLAG_HALVING;
+	context_build_fixed_operands(curve, out);
+	if (elliptic_curve_modn_init(&out->modn, curve->order, curve->field_size_bytes))
+		out->flags |= EC_CONTEXT_FLAG_MODN;
+	elliptic_curve_tuning_default(&out->tuning);
+	return 1;
+}
+
+const EllipticCurveContextData* elliptic_curve_context_acquire(const EllipticCurve *curve) {
+	EllipticCurveContext *ctx = curve->context;
+	if (!ctx)
+		return 0;
+
+	int state = EC_ATOMIC_LOAD_ACQUIRE(&ctx->state);
+	if (state == EC_CONTEXT_STATE_READY)
+		return ctx->data;
+
+	if (state == EC_CONTEXT_STATE_EMPTY
+			&& EC_ATOMIC_CAS(&ctx->state, &state, EC_CONTEXT_STATE_BUILDING)) {
+		elliptic_curve_context_build(curve, &ctx->storage);
+		if (ctx->tune_hook)
+			ctx->tune_hook(curve, ctx);
+		ctx->data = &ctx->storage;
+		EC_ATOMIC_STORE_RELEASE(&ctx->state, EC_CONTEXT_STATE_READY);
+		return ctx->data;
+	}
+
+	// Another thread is building it; that takes a bounded amount of work.
+	while (EC_ATOMIC_LOAD_ACQUIRE(&ctx->state) != EC_CONTEXT_STATE_READY)
+		EC_ATOMIC_PAUSE();
+	return ctx->data;
+}
+
+// FNV-1a 64 over every parameter that influences derived data
+static unsigned long long context_fnv1a(unsigned long long h,
+		const unsigned char *in, unsigned long bytelen) {
+	for (unsigned long i = 0; i < bytelen; ++i) {
+		h ^= in[i];
+		h *= 0x100000001B3ULL;
+	}
+	return h;
+}
+
+unsigned long long elliptic_curve_fingerprint(const EllipticCurve *curve) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned char sizes[8];
+	unsigned long long h = 0xCBF29CE484222325ULL;
+
+	for (int i = 0; i < 4; ++i) {
+		sizes[i] = (unsigned char) (len >> (8 * i));
+		sizes[i + 4] = (unsigned char) (curve->binary_degree >> (8 * i));
+	}
+	h = context_fnv1a(h, sizes, sizeof(sizes));
+	h = context_fnv1a(h, curve->a, len);
+	h = context_fnv1a(h, curve->b, len);
+	h = context_fnv1a(h, curve->xG, len);
+	h = context_fnv1a(h, curve->yG, len);
+	h = context_fnv1a(h, curve->modulus, len);
+	h = context_fnv1a(h, curve->order, len);
+	h = context_fnv1a(h, curve->cofactor, len);
+	return h;
+}
+
+unsigned long elliptic_curve_context_serialize(const EllipticCurve *curve,
+		unsigned char *out, unsigned long out_capacity) {
+	const unsigned long total = sizeof(EllipticCurveContextBlobHeader)
+			+ sizeof(EllipticCurveContextData);
+	const EllipticCurveContextData *data = elliptic_curve_context_acquire(curve);
+
+	if (out_capacity < total)
+		return 0;
+	// The data is too large for the stack: without a context it is built
+	// straight into the (aligned) output
+	if (!data) {
+		if ((unsigned long) out & 7UL)
+			return 0;
+		elliptic_curve_context_build(curve,
+				(EllipticCurveContextData*) (out + sizeof(EllipticCurveContextBlobHeader)));
+	}
+
+	EllipticCurveContextBlobHeader header = { };
+	header.magic = EC_CONTEXT_BLOB_MAGIC;
+	header.version = EC_CONTEXT_BLOB_VERSION;
+	header.data_bytelen = sizeof(EllipticCurveContextData);
+	header.fingerprint = elliptic_curve_fingerprint(curve);
+
+	const unsigned char *h = (const unsigned char*) &header;
+	for (unsigned long i = 0; i < sizeof(header); ++i)
+		out[i] = h[i];
+	if (data) {
+		const unsigned char *d = (const unsigned char*) data;
+		for (unsigned long i = 0; i < sizeof(EllipticCurveContextData); ++i)
+			out[sizeof(header) + i] = d[i];
+	}
+	return total;
+}
+
+int elliptic_curve_context_attach_blob(const EllipticCurve *curve,
+		const unsigned char *blob, unsigned long bytelen) {
+	EllipticCurveContext *ctx = curve->context;
+	const EllipticCurveContextBlobHeader *header =
+			(const EllipticCurveContextBlobHeader*) blob;
+
+	if (!ctx || !blob || ((unsigned long) blob & 7UL))
+		return 0;
+	if (bytelen < sizeof(EllipticCurveContextBlobHeader) + sizeof(EllipticCurveContextData))
+		return 0;
+	if (header->magic != EC_CONTEXT_BLOB_MAGIC
+			|| header->version != EC_CONTEXT_BLOB_VERSION
+			|| header->data_bytelen != sizeof(EllipticCurveContextData)
+			|| header->fingerprint != elliptic_curve_fingerprint(curve))
+		return 0;
+
+	int state = EC_CONTEXT_STATE_EMPTY;
+	if (!EC_ATOMIC_CAS(&ctx->state, &state, EC_CONTEXT_STATE_BUILDING))
+		return 0;
+	ctx->data = (const EllipticCurveContextData*) (blob + sizeof(EllipticCurveContextBlobHeader));
+	EC_ATOMIC_STORE_RELEASE(&ctx->state, EC_CONTEXT_STATE_READY);
+	return 1;
+}
@@ -0,0 +1,148 @@
+#ifndef ELLIPTIC_CURVE_CONTEXT_H_
+#define ELLIPTIC_CURVE_CONTEXT_H_
+
+#include "elliptic_curve.h"
+#include "elliptic_curve_modn.h"
+
+// Per-curve acceleration context.
+//
+// EllipticCurve only holds parameters; anything derived from them (reduction
+// descriptors, tables, constants) lives here. A context is attached to a
+// curve through EllipticCurve::context and built lazily the first time an
+// operation asks for it. Once built it is read-only and can be shared by any
+// number of threads.
+//
+// EllipticCurveContextData is plain data without pointers, so it can be
+// serialized into a blob and later used in place (e.g. from a mapped file)
+// instead of being recomputed.
+
+#define EC_CONTEXT_STATE_EMPTY    (0)
+#define EC_CONTEXT_STATE_BUILDING (1)
+#define EC_CONTEXT_STATE_READY    (2)
+
+#define EC_CONTEXT_FLAG_SPARSE_REDUCTION (1U << 0)  // reduction descriptor valid
+#define EC_CONTEXT_FLAG_BASE_COMB        (1U << 1)  // fixed-base comb table valid
+#define EC_CONTEXT_FLAG_HALVING          (1U << 2)  // curve qualifies for point halving
+#define EC_CONTEXT_FLAG_LINEAR_MAPS      (1U << 3)  // sqrt / trace / half-trace maps valid
+// Curve shape, selects specialized formulas (multiplications by a and b
+// become nothing or a bit flip). Blobs without these bits use the general ones.
+#define EC_CONTEXT_FLAG_A_ZERO           (1U << 4)  // a = 0
+#define EC_CONTEXT_FLAG_A_ONE            (1U << 5)  // a = 1
+#define EC_CONTEXT_FLAG_B_ONE            (1U << 6)  // b = 1
+#define EC_CONTEXT_FLAG_FIXED_OPERANDS   (1U << 7)  // x_base / sqrt_b multiplication tables valid
+#define EC_CONTEXT_FLAG_MODN             (1U << 8)  // Barrett / Montgomery constants for n valid
+#define EC_CONTEXT_FLAG_TUNED            (1U << 9)  // tuning measured or adopted, see below
+
+#define EC_CONTEXT_BLOB_MAGIC   (0x31584345U)       // "ECX1", little endian
+#define EC_CONTEXT_BLOB_VERSION (7U)
+
+// Fixed-base comb for k*G: 2^w - 1 precomputed points, one doubling and at
+// most one addition per d = ceil(8 * field_size_bytes / w) columns.
+// Costs (2^w - 1) * sizeof(EllipticCurvePoint) bytes per curve.
+#ifndef EC_CONTEXT_COMB_WIDTH
+#define EC_CONTEXT_COMB_WIDTH (4)
+#endif
+#define EC_CONTEXT_COMB_POINTS ((1 << EC_CONTEXT_COMB_WIDTH) - 1)
+
+// Per-curve configuration picked by elliptic_curve_tune.h. A context without
+// EC_CONTEXT_FLAG_TUNED holds the defaults and the library behaves as if
+// there were no tuning at all.
+#define EC_TUNE_MULTIPLY_AUTO           (0) // tau-, halve- or double-and-add, as the curve allows
+#define EC_TUNE_MULTIPLY_DOUBLE_AND_ADD (1) // affine double-and-add on every curve
+#define EC_TUNE_MULTIPLY_LADDER         (2) // Lopez-Dahab projective ladder
+
+#define EC_TUNE_ORIGIN_DEFAULT  (0)
+#define EC_TUNE_ORIGIN_MEASURED (1)         // benchmarked in this process
+#define EC_TUNE_ORIGIN_PRESET   (2)         // handed in (e.g. from a tuning file), checked only
+
+typedef struct alignas(8){
+	GF2MultiplyPlan plan;                   // field multiplication kernel and split thresholds
+	unsigned short comb_width;              // fixed-base comb window, 2 .. EC_CONTEXT_COMB_WIDTH
+	unsigned short multiply;                // EC_TUNE_MULTIPLY_*, variable-base multiplication
+	unsigned short origin;                  // EC_TUNE_ORIGIN_*
+	unsigned int field_multiply_ns;         // measured cost of the chosen configuration,
+	unsigned int point_multiply_ns;         // per operation; 0 when not measured
+	unsigned int base_multiply_ns;
+	unsigned int reserved;
+}EllipticCurveTuning;
+
+// Plan from gf2_multiply_plan_default(), comb width EC_CONTEXT_COMB_WIDTH,
+// EC_TUNE_MULTIPLY_AUTO: what an untuned context does.
+void elliptic_curve_tuning_default(EllipticCurveTuning *out);
+
+// Monotonic clock in nanoseconds for the tuning benchmarks.
+typedef unsigned long long (*EllipticCurveTuneClock)(void *arg);
+
+typedef struct alignas(8){
+	unsigned int field_size_bytes;
+	unsigned int binary_degree;
+	unsigned int flags;                     // EC_CONTEXT_FLAG_*
+	GF2ReductionDescriptor reduction;
+	unsigned int comb_width;                // w
+	unsigned int comb_columns;              // d, covers w * d scalar bits
+	EllipticCurvePoint base_comb[EC_CONTEXT_COMB_POINTS]; // [i - 1] = sum of 2^(j*d) G over set bits j of i
+	GF2LinearMaps linear_maps;              // field sqrt, trace and half-trace (halving, decompression)
+	GF2FixedOperand x_base;                 // x(G), the ladder's fixed factor for k * G
+	GF2FixedOperand sqrt_b;                 // sqrt(b), ladder doubling (all zero for b = 1)
+	EllipticCurveModN modn;                 // arithmetic modulo the order n
+	EllipticCurveTuning tuning;             // in effect with EC_CONTEXT_FLAG_TUNED
+}EllipticCurveContextData;
+
+typedef struct alignas(8){
+	unsigned int magic;
+	unsigned int version;
+	unsigned int data_bytelen;              // sizeof(EllipticCurveContextData)
+	unsigned int reserved;
+	unsigned long long fingerprint;         // elliptic_curve_fingerprint()
+}EllipticCurveContextBlobHeader;
+
+struct EllipticCurveContext;
+
+// Runs on the freshly built storage, before the context turns ready. Set by
+// elliptic_curve_tune.h, so only builds that tune link the tuner.
+typedef void (*EllipticCurveContextTuneHook)(const EllipticCurve *curve,
+		struct EllipticCurveContext *ctx);
+
+typedef struct EllipticCurveContext{
+	int state;                              // EC_CONTEXT_STATE_*
+	const EllipticCurveContextData *data;   // &storage or an attached blob
+	// Tuning while the context is built (elliptic_curve_tune.h)
+	EllipticCurveContextTuneHook tune_hook; // 0: keep the defaults
+	EllipticCurveTuneClock tune_clock;      // measure with this clock, when set
+	void *tune_clock_arg;
+	EllipticCurveTuning tune_preset;        // adopt after checking, when comb_width != 0
+	EllipticCurveContextData storage;
+}EllipticCurveContext;
+
+// Zero-initialized storage ( = { 0 } ) is a valid empty context as well.
+void elliptic_curve_context_init(EllipticCurveContext *ctx);
+void elliptic_curve_attach_context(EllipticCurve *curve, EllipticCurveContext *ctx);
+
+// Returns the ready context, building it on first use. Returns 0 when the
+// curve has no context attached; callers then take the generic path.
+const EllipticCurveContextData* elliptic_curve_context_acquire(const EllipticCurve *curve);
+
+// Computes all derived data for a curve, with the default tuning. Returns 1
+// on success.
+int elliptic_curve_context_build(const EllipticCurve *curve, EllipticCurveContextData *out);
+
+// Rebuilds the fixed-base comb of out with window width
+// (1 .. EC_CONTEXT_COMB_WIDTH).
+void elliptic_curve_context_build_comb(const EllipticCurve *curve,
+		EllipticCurveContextData *out, unsigned int width);
+
+// Hash over all curve parameters; used to reject blobs built for other curves.
+unsigned long long elliptic_curve_fingerprint(const EllipticCurve *curve);
+
+// Writes header + data, returns bytes written (0 if out_capacity is too small).
+// For a curve without a context the data is built in place, which needs an
+// 8-byte aligned out (0 otherwise).
+unsigned long elliptic_curve_context_serialize(const EllipticCurve *curve,
+		unsigned char *out, unsigned long out_capacity);
+// Points the curve's (still empty) context at a serialized blob without
+// copying it. The blob must stay valid and be 8-byte aligned. Returns 1 on
+// success, 0 if the blob is stale, malformed or the context is already in use.
+int elliptic_curve_context_attach_blob(const EllipticCurve *curve,
+		const unsigned char *blob, unsigned long bytelen);
+
+#endif /* ELLIPTIC_CURVE_CONTEXT_H_ */
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+#include "ec_test_util.h"
+
+int test_elliptic_curve_context() {
+	int failures = 0;
+	std::cout << "\n--- Testing lazy per-curve acceleration context ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurveRegistryEntry *e = elliptic_curve_registry_get(c);
+		int ok = 1;
+
+		// Private copy of the curve with its own, fresh context
+		EllipticCurve curve = *e->curve;
+		EllipticCurveContext ctx;
+		elliptic_curve_context_init(&ctx);
+		elliptic_curve_attach_context(&curve, &ctx);
+
+		// Concurrent first use: every thread must see the same, complete context
+		const EllipticCurveContextData *seen[4] = { };
+		std::thread threads[4];
+		for (int t = 0; t < 4; ++t)
+			threads[t] = std::thread([&curve, &seen, t]() {
+				seen[t] = elliptic_curve_context_acquire(&curve);
+			});
+		for (int t = 0; t < 4; ++t)
+			threads[t].join();
+		for (int t = 0; t < 4; ++t)
+			ok &= seen[t] == &ctx.storage;
+		ok &= ctx.state == EC_CONTEXT_STATE_READY;
+		ok &= (ctx.storage.flags & EC_CONTEXT_FLAG_SPARSE_REDUCTION) != 0;
+		ok &= ctx.storage.reduction.degree == e->reduction.degree;
+
+		// Same results with and without the context
+		EllipticCurve bare = *e->curve;
+		bare.context = 0;
+		EllipticCurvePoint G = { }, R1 = { }, R2 = { };
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		for (unsigned long i = 0; i < 8; ++i)
+			k[i] = (unsigned char) (0x3C + 17 * i);
+		for (unsigned long i = 0; i < curve.field_size_bytes; ++i) {
+			elliptic_curve_point_get_coord_x(&curve, &G)[i] = curve.xG[i];
+			elliptic_curve_point_get_coord_y(&curve, &G)[i] = curve.yG[i];
+		}
+		elliptic_curve_binary_point_multiply(&curve, &R1, &G, k, curve.field_size_bytes);
+		elliptic_curve_binary_point_multiply(&bare, &R2, &G, k, curve.field_size_bytes);
+		ok &= ec_test_points_equal(&curve, &R1, &R2);
+
+		// Serialize, then attach the blob zero-copy to yet another fresh context
+		alignas(8) static unsigned char blob[sizeof(EllipticCurveContextBlobHeader)
+				+ sizeof(EllipticCurveContextData)];
+		unsigned long blob_len = elliptic_curve_context_serialize(&curve, blob, sizeof(blob));
+		ok &= blob_len == sizeof(blob);
+		ok &= elliptic_curve_context_serialize(&curve, blob, sizeof(blob) - 1) == 0;
+
+		EllipticCurve cold = *e->curve;
+		EllipticCurveContext cold_ctx = { };
+		cold.context = &cold_ctx;
+		ok &= elliptic_curve_context_attach_blob(&cold, blob, blob_len);
+		ok &= (const unsigned char*) elliptic_curve_context_acquire(&cold)
+				== blob + sizeof(EllipticCurveContextBlobHeader);
+		ok &= !elliptic_curve_context_attach_blob(&cold, blob, blob_len); // already in use
+
+		// Stale blob: different curve parameters
+		EllipticCurve other = *e->curve;
+		EllipticCurveContext other_ctx = { };
+		other.context = &other_ctx;
+		other.yG[0] ^= 1;
+		ok &= !elliptic_curve_context_attach_blob(&other, blob, blob_len);
+		other.yG[0] ^= 1;
+		blob[0] ^= 0xFF; // broken magic
+		ok &= !elliptic_curve_context_attach_blob(&other, blob, blob_len);
+		blob[0] ^= 0xFF;
+		ok &= elliptic_curve_context_attach_blob(&other, blob, blob_len);
+
+		std::cout << std::left << std::setw(12) << e->sec_name << std::right
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
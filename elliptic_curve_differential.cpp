@@ -0,0 +1,451 @@
+#include "elliptic_curve_differential.h"
+#include "ecdh_peer.h"
+#include "elliptic_curve_batch.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_msm.h"
+#include "elliptic_curve_registry.h"
+
+#define DIFF_MSM_SCRATCH_BYTELEN (32UL * 1024UL)
+
+alignas(8) static unsigned char diff_msm_scratch[DIFF_MSM_SCRATCH_BYTELEN];
+
+#if !EC_REGISTRY_CONTEXTS
+// The registry curves carry no context: the accelerated paths run on copies
+// with one of these attached
+static EllipticCurve diff_curves[EC_REGISTRY_MAX_CURVES];
+static EllipticCurveContext diff_contexts[EC_REGISTRY_MAX_CURVES];
+#endif
+
+typedef struct {
+	const EllipticCurveRegistryEntry *entry;
+	const EllipticCurve *curve;
+	EllipticCurve bare;                     // no context: reference paths
+	unsigned long len;
+	unsigned long y_offset;
+	const unsigned char *data;
+	unsigned long size;
+	unsigned long pos;
+	unsigned long long prng;
+	unsigned int run;
+	unsigned int failed;
+}DiffCase;
+
+static const char *const diff_check_names[EC_DIFF_CHECK_COUNT] = {
+	"field multiply", "field multiply ct", "field reduce", "field fused",
+	"field inverse", "field maps", "point multiply", "point base",
+	"point linearity", "point order", "point msm", "point halving", "ecdh"
+};
+
+const char* elliptic_curve_differential_check_name(unsigned int check) {
+	return (check < EC_DIFF_CHECK_COUNT) ? diff_check_names[check] : "unknown";
+}
+
+static void diff_note(DiffCase *c, unsigned int check, int ok) {
+	c->run |= 1U << check;
+	if (!ok)
+		c->failed |= 1U << check;
+}
+
+// Input bytes first, then xorshift64 output
+static unsigned char diff_byte(DiffCase *c) {
+	if (c->pos < c->size)
+		return c->data[c->pos++];
+	c->prng ^= c->prng << 13;
+	c->prng ^= c->prng >> 7;
+	c->prng ^= c->prng << 17;
+	return (unsigned char) (c->prng >> 24);
+}
+
+static int diff_equal(const unsigned char *a, const unsigned char *b, unsigned long bytelen) {
+	unsigned char diff = 0;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		diff |= a[i] ^ b[i];
+	return diff == 0;
+}
+
+static int diff_is_zero(const unsigned char *a, unsigned long bytelen) {
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		acc |= a[i];
+	return acc == 0;
+}
+
+static void diff_clear_from_bit(unsigned char *a, unsigned long bytelen, long bit) {
+	for (unsigned long i = (unsigned long) bit; i < 8 * bytelen; ++i)
+		a[i >> 3] &= (unsigned char) ~(1U << (i & 7));
+}
+
+// A reduced field element
+static void diff_element(DiffCase *c, unsigned char *out) {
+	for (unsigned long i = 0; i < c->len; ++i)
+		out[i] = diff_byte(c);
+	diff_clear_from_bit(out, c->len, gf2_degree_lsb(c->curve->modulus, c->len));
+}
+
+// Compares LSB-first integers of equal length
+static int diff_int_less(const unsigned char *a, const unsigned char *b, unsigned long bytelen) {
+	for (unsigned long i = bytelen; i-- > 0;) {
+		if (a[i] != b[i])
+			return a[i] < b[i];
+	}
+	return 0;
+}
+
+static void diff_int_sub(unsigned char *a, const unsigned char *b, unsigned long bytelen) {
+	unsigned int borrow = 0;
+	for (unsigned long i = 0; i < bytelen; ++i) {
+		unsigned int d = (unsigned int) a[i] - b[i] - borrow;
+		a[i] = (unsigned char) d;
+		borrow = (d >> 8) & 1U;
+	}
+}
+
+static void diff_int_add(unsigned char *out, const unsigned char *a, const unsigned char *b,
+		unsigned long bytelen) {
+	unsigned int carry = 0;
+	for (unsigned long i = 0; i < bytelen; ++i) {
+		carry += (unsigned int) a[i] + b[i];
+		out[i] = (unsigned char) carry;
+		carry >>= 8;
+	}
+}
+
+// A scalar in [1, n - 1]: the ladder and the identities below want k != 0 mod n
+static void diff_scalar(DiffCase *c, unsigned char *out) {
+	for (unsigned long i = 0; i < c->len; ++i)
+		out[i] = diff_byte(c);
+	diff_clear_from_bit(out, c->len, gf2_degree_lsb(c->curve->order, c->len) + 1);
+	if (!diff_int_less(out, c->curve->order, c->len))
+		diff_int_sub(out, c->curve->order, c->len);
+	if (diff_is_zero(out, c->len))
+		out[0] = 1;
+}
+
+// Bit-serial product, the oracle for every multiplication kernel
+static void diff_reference_multiply(const unsigned char *a, const unsigned char *b,
+		unsigned char *out, unsigned long bytelen) {
+	for (unsigned long i = 0; i < 2 * bytelen; ++i)
+		out[i] = 0;
+	for (unsigned long bit = 0; bit < 8 * bytelen; ++bit) {
+		if (!((a[bit >> 3] >> (bit & 7)) & 1))
+			continue;
+		unsigned long byte_shift = bit >> 3;
+		unsigned int s = bit & 7;
+		for (unsigned long i = 0; i < bytelen; ++i) {
+			out[i + byte_shift] ^= (unsigned char) (b[i] << s);
+			if (s)
+				out[i + byte_shift + 1] ^= (unsigned char) (b[i] >> (8 - s));
+		}
+	}
+}
+
+// (a * b + c * d) mod f with the reference routines
+static void diff_reference_mac(const DiffCase *c, const unsigned char *a, const unsigned char *b,
+		const unsigned char *x, const unsigned char *y, unsigned char *out) {
+	alignas(8) unsigned char p1[2 * GF2_VECTOR_MAX_BYTELEN + 1];
+	alignas(8) unsigned char p2[2 * GF2_VECTOR_MAX_BYTELEN + 1];
+	diff_reference_multiply(a, b, p1, c->len);
+	diff_reference_multiply(x, y, p2, c->len);
+	for (unsigned long i = 0; i < 2 * c->len; ++i)
+		p1[i] ^= p2[i];
+	gf2_reduce_lsb(p1, 2 * c->len, c->curve->modulus, c->len);
+	for (unsigned long i = 0; i < c->len; ++i)
+		out[i] = p1[i];
+}
+
+static void diff_check_field(DiffCase *c) {
+	unsigned long len = c->len;
+	const unsigned char *modulus = c->curve->modulus;
+	const GF2ReductionDescriptor *desc = c->entry->reduction.degree ? &c->entry->reduction : 0;
+	alignas(8) unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char x[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char y[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char zero[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char one[GF2_VECTOR_MAX_BYTELEN] = { 1 };
+	alignas(8) unsigned char r[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char expected[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char ref[2 * GF2_VECTOR_MAX_BYTELEN + 1];
+	alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char wide2[2 * GF2_VECTOR_MAX_BYTELEN];
+	int ok;
+
+	diff_element(c, a);
+	diff_element(c, b);
+	diff_element(c, x);
+	diff_element(c, y);
+	diff_reference_multiply(a, b, ref, len);
+
+	// Default plan and every split / kernel combination
+	gf2_multiply_lsb(a, b, wide, len);
+	ok = diff_equal(wide, ref, 2 * len);
+	for (int kernel = GF2_MULTIPLY_KERNEL_PORTABLE; kernel <= GF2_MULTIPLY_KERNEL_LIMB32; ++kernel) {
+		if (!gf2_multiply_kernel_available(kernel))
+			continue;
+		for (int split = 0; split < 3; ++split) {
+			GF2MultiplyPlan plan;
+			plan.kernel = (unsigned short) kernel;
+			plan.karatsuba_threshold_words = (split == 1) ? 2 : 0xFFFF;
+			plan.toom3_threshold_words = (split == 2) ? 3 : 0xFFFF;
+			gf2_multiply_planned_lsb(a, b, wide, len, &plan);
+			ok &= diff_equal(wide, ref, 2 * len);
+		}
+	}
+	diff_note(c, EC_DIFF_CHECK_FIELD_MULTIPLY, ok);
+
+	gf2_multiply_ct_lsb(a, b, wide, len);
+	ok = diff_equal(wide, ref, 2 * len);
+	diff_reference_multiply(a, a, wide2, len);
+	gf2_square_ct_lsb(a, wide, len);
+	ok &= diff_equal(wide, wide2, 2 * len);
+	diff_note(c, EC_DIFF_CHECK_FIELD_MULTIPLY_CT, ok);
+
+	for (unsigned long i = 0; i < 2 * len; ++i)
+		wide[i] = wide2[i] = ref[i];
+	gf2_reduce_lsb(ref, 2 * len, modulus, len);
+	gf2_reduce_ct_lsb(wide, 2 * len, modulus, len);
+	ok = diff_equal(wide, ref, 2 * len);
+	if (desc) {
+		gf2_reduce_sparse_lsb(wide2, 2 * len, desc);
+		ok &= diff_equal(wide2, ref, 2 * len);
+	}
+	diff_note(c, EC_DIFF_CHECK_FIELD_REDUCE, ok);
+
+	ok = 1;
+	for (int with_desc = 0; with_desc < 2; ++with_desc) {
+		const GF2ReductionDescriptor *d = with_desc ? desc : 0;
+		diff_reference_mac(c, a, b, zero, zero, expected);
+		gf2_field_multiply_lsb(a, b, r, len, modulus, d);
+		ok &= diff_equal(r, expected, len);
+		diff_reference_mac(c, x, x, zero, zero, expected);
+		gf2_field_square_lsb(x, r, len, modulus, d);
+		ok &= diff_equal(r, expected, len);
+		diff_reference_mac(c, a, b, x, one, expected);
+		gf2_field_multiply_add_lsb(a, b, x, r, len, modulus, d);
+		ok &= diff_equal(r, expected, len);
+		diff_reference_mac(c, a, b, x, y, expected);
+		gf2_field_multiply2_add_lsb(a, b, x, y, r, len, modulus, d);
+		ok &= diff_equal(r, expected, len);
+	}
+	diff_note(c, EC_DIFF_CHECK_FIELD_FUSED, ok);
+
+	if (diff_is_zero(a, len))
+		a[0] = 1;
+	gf2_binary_inverse_lsb(a, r, len, modulus);
+	diff_reference_mac(c, a, r, zero, zero, expected);
+	ok = diff_equal(expected, one, len);
+	gf2_inverse_ct_lsb(a, expected, len, modulus, desc);
+	ok &= diff_equal(expected, r, len);
+	gf2_inverse_ct_lsb(a, expected, len, modulus, 0);
+	ok &= diff_equal(expected, r, len);
+	gf2_inverse_ct_lsb(zero, expected, len, modulus, desc);
+	ok &= diff_is_zero(expected, len);
+	diff_note(c, EC_DIFF_CHECK_FIELD_INVERSE, ok);
+
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(c->curve);
+	if (ctx && (ctx->flags & EC_CONTEXT_FLAG_LINEAR_MAPS)) {
+		gf2_sqrt_lsb(x, expected, len, modulus);
+		gf2_sqrt(x, r, &ctx->linear_maps);
+		ok = diff_equal(r, expected, len);
+		diff_reference_mac(c, r, r, zero, zero, expected);
+		ok &= diff_equal(expected, x, len);
+		int tr = gf2_trace_lsb(x, len, modulus);
+		ok &= gf2_trace(x, &ctx->linear_maps) == tr;
+		if (ctx->linear_maps.has_half_trace) {
+			x[0] ^= (unsigned char) tr;     // Tr(1) = 1 for odd degree
+			gf2_half_trace_lsb(x, expected, len, modulus);
+			gf2_half_trace(x, r, &ctx->linear_maps);
+			ok &= diff_equal(r, expected, len);
+			diff_reference_mac(c, r, r, r, one, expected);    // H^2 + H = x
+			ok &= diff_equal(expected, x, len);
+		}
+		diff_note(c, EC_DIFF_CHECK_FIELD_MAPS, ok);
+	}
+}
+
+static int diff_point_equal(const DiffCase *c, const EllipticCurvePoint *p,
+		const EllipticCurvePoint *q) {
+	return diff_equal(p->point_mem, q->point_mem, c->len)
+			&& diff_equal(&p->point_mem[c->y_offset], &q->point_mem[c->y_offset], c->len);
+}
+
+static int diff_point_is_infinity(const DiffCase *c, const EllipticCurvePoint *p) {
+	return diff_is_zero(p->point_mem, c->len) && diff_is_zero(&p->point_mem[c->y_offset], c->len);
+}
+
+static void diff_check_point(DiffCase *c) {
+	const EllipticCurve *curve = c->curve;
+	const EllipticCurve *bare = &c->bare;
+	unsigned long len = c->len;
+	alignas(8) unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char s[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) EllipticCurvePoint G = { }, P = { }, aP = { }, bP = { }, R = { }, S = { };
+	int ok;
+
+	for (unsigned long i = 0; i < len; ++i) {
+		G.point_mem[i] = curve->xG[i];
+		G.point_mem[i + c->y_offset] = curve->yG[i];
+	}
+	diff_scalar(c, k);
+	diff_scalar(c, a);
+	diff_scalar(c, b);
+	elliptic_curve_binary_point_multiply(bare, &P, &G, k, len);
+
+	// Context paths (comb, halving), the ladder and the stepped state machine
+	// against plain double-and-add
+	elliptic_curve_binary_point_multiply(bare, &aP, &P, a, len);
+	ok = elliptic_curve_binary_point_on_curve(curve, &aP);
+	elliptic_curve_binary_point_multiply(curve, &R, &P, a, len);
+	ok &= diff_point_equal(c, &R, &aP);
+	elliptic_curve_binary_point_multiply_ct(curve, &R, &P, a, len);
+	ok &= diff_point_equal(c, &R, &aP);
+	EllipticCurveMultiplyState state;
+	elliptic_curve_binary_point_multiply_init(&state, curve, &P, a, len);
+	while (!elliptic_curve_binary_point_multiply_step(&state, 7))
+		;
+	elliptic_curve_binary_point_multiply_finish(&state, &R);
+	ok &= diff_point_equal(c, &R, &aP);
+	diff_note(c, EC_DIFF_CHECK_POINT_MULTIPLY, ok);
+
+	elliptic_curve_binary_point_multiply(bare, &S, &G, a, len);
+	elliptic_curve_binary_point_multiply_base(curve, &R, a, len);
+	ok = diff_point_equal(c, &R, &S);
+	elliptic_curve_binary_point_multiply_base_ct(curve, &R, a, len);
+	ok &= diff_point_equal(c, &R, &S);
+	diff_note(c, EC_DIFF_CHECK_POINT_BASE, ok);
+
+	// (a + b) P = aP + bP, 2 (aP) = aP + aP
+	elliptic_curve_binary_point_multiply(bare, &bP, &P, b, len);
+	diff_int_add(s, a, b, len);
+	elliptic_curve_binary_point_multiply(bare, &R, &P, s, len);
+	elliptic_curve_binary_point_add(curve, &S, &aP, &bP);
+	ok = diff_point_equal(c, &R, &S);
+	elliptic_curve_binary_point_double(curve, &R, &aP);
+	elliptic_curve_binary_point_add(curve, &S, &aP, &aP);
+	ok &= diff_point_equal(c, &R, &S);
+	diff_int_add(s, a, a, len);
+	elliptic_curve_binary_point_multiply(bare, &S, &P, s, len);
+	ok &= diff_point_equal(c, &R, &S);
+	diff_note(c, EC_DIFF_CHECK_POINT_LINEARITY, ok);
+
+	// n G = n P = O, (n - 1) P = -P = (x, x + y)
+	elliptic_curve_binary_point_multiply(curve, &R, &G, curve->order, len);
+	ok = diff_point_is_infinity(c, &R);
+	elliptic_curve_binary_point_multiply(bare, &R, &P, curve->order, len);
+	ok &= diff_point_is_infinity(c, &R);
+	for (unsigned long i = 0; i < len; ++i)
+		s[i] = curve->order[i];
+	s[0] ^= 1;                              // n is odd
+	elliptic_curve_binary_point_multiply(curve, &R, &P, s, len);
+	for (unsigned long i = 0; i < len; ++i)
+		ok &= R.point_mem[i] == P.point_mem[i]
+				&& R.point_mem[i + c->y_offset] == (P.point_mem[i] ^ P.point_mem[i + c->y_offset]);
+	diff_note(c, EC_DIFF_CHECK_POINT_ORDER, ok);
+
+	// aP + bG by every multi-scalar method, and a batch of two
+	elliptic_curve_binary_point_multiply(bare, &S, &G, b, len);
+	elliptic_curve_binary_point_add(curve, &S, &aP, &S);
+	elliptic_curve_msm2(curve, &R, &P, a, &G, b, len);
+	ok = diff_point_equal(c, &R, &S);
+	const EllipticCurvePoint *points[2] = { &P, &G };
+	const unsigned char *scalars[2] = { a, b };
+	for (int method = EC_MSM_METHOD_AUTO; method <= EC_MSM_METHOD_JSF; ++method) {
+		unsigned long need = elliptic_curve_msm_scratch_bytelen(curve, 2, len, method);
+		if (need > DIFF_MSM_SCRATCH_BYTELEN)
+			continue;
+		ok &= elliptic_curve_msm(curve, &R, points, scalars, 2, len, method,
+				diff_msm_scratch, DIFF_MSM_SCRATCH_BYTELEN);
+		ok &= diff_point_equal(c, &R, &S);
+	}
+	EllipticCurvePoint *outs[2] = { &R, &S };
+	const EllipticCurvePoint *ins[2] = { &P, &P };
+	unsigned long need = elliptic_curve_batch_scratch_bytelen(2);
+	if (need <= DIFF_MSM_SCRATCH_BYTELEN) {
+		ok &= elliptic_curve_binary_point_multiply_batch(curve, outs, ins, scalars, 2, len,
+				diff_msm_scratch, DIFF_MSM_SCRATCH_BYTELEN);
+		ok &= diff_point_equal(c, &R, &aP) && diff_point_equal(c, &S, &bP);
+	}
+	diff_note(c, EC_DIFF_CHECK_POINT_MSM, ok);
+
+	if (elliptic_curve_binary_supports_halving(curve)) {
+		elliptic_curve_binary_point_double(curve, &S, &aP);
+		ok = elliptic_curve_binary_point_halve(curve, &R, &S) && diff_point_equal(c, &R, &aP);
+		ok &= elliptic_curve_binary_point_halve(bare, &R, &S) && diff_point_equal(c, &R, &aP);
+		diff_note(c, EC_DIFF_CHECK_POINT_HALVING, ok);
+	}
+}
+
+static void diff_check_ecdh(DiffCase *c) {
+	const EllipticCurve *curve = c->curve;
+	unsigned long len = c->len;
+	static EcdhPreparedPeer peer;
+	alignas(8) unsigned char d1[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char d2[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char pub1[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char pub2[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char s1[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char s2[GF2_VECTOR_MAX_BYTELEN] = { };
+
+	diff_scalar(c, d1);
+	diff_scalar(c, d2);
+	ecdh_generate_public_key(curve, d1, pub1);
+	ecdh_generate_public_key_ct(curve, d2, pub2);
+	int ok = ecdh_public_key_verify(curve, pub1) && ecdh_public_key_verify(curve, pub2);
+	ecdh_generate_shared_secret(curve, d1, pub2, s1);
+	ecdh_generate_shared_secret(curve, d2, pub1, s2);
+	ok &= diff_equal(s1, s2, len);
+	ecdh_generate_shared_secret_ct(curve, d2, pub1, s2);
+	ok &= diff_equal(s1, s2, len);
+	ok &= ecdh_peer_prepare(curve, &peer, pub2);
+	ecdh_generate_shared_secret_prepared(&peer, d1, s2);
+	ok &= diff_equal(s1, s2, len);
+	diff_note(c, EC_DIFF_CHECK_ECDH, ok);
+}
+
+int elliptic_curve_differential_run(const unsigned char *data, unsigned long size,
+		EcDifferentialReport *report) {
+	static DiffCase c;
+	unsigned long long h = 0xCBF29CE484222325ULL;
+	unsigned int groups = (size > 1) ? (data[1] & EC_DIFF_GROUP_ALL) : 0;
+
+	for (unsigned long i = 0; i < size; ++i)
+		h = (h ^ data[i]) * 0x100000001B3ULL;
+	unsigned long index = (size ? data[0] : 0) % elliptic_curve_registry_count();
+	c.entry = elliptic_curve_registry_get(index);
+	c.curve = c.entry->curve;
+#if !EC_REGISTRY_CONTEXTS
+	if (!diff_curves[index].context) {
+		diff_curves[index] = *c.curve;
+		elliptic_curve_attach_context(&diff_curves[index], &diff_contexts[index]);
+	}
+	c.curve = &diff_curves[index];
+#endif
+	c.bare = *c.curve;
+	c.bare.context = 0;
+	c.len = c.curve->field_size_bytes;
+	c.y_offset = (c.len + 7UL) & (~7UL);
+	c.data = data;
+	c.size = size;
+	c.pos = (size < 2) ? size : 2;
+	c.prng = h | 1;
+	c.run = 0;
+	c.failed = 0;
+	if (!groups)
+		groups = EC_DIFF_GROUP_ALL;
+
+	if (groups & EC_DIFF_GROUP_FIELD)
+		diff_check_field(&c);
+	if (groups & EC_DIFF_GROUP_POINT)
+		diff_check_point(&c);
+	if (groups & EC_DIFF_GROUP_ECDH)
+		diff_check_ecdh(&c);
+
+	if (report) {
+		report->curve = c.curve;
+		report->checks_run = c.run;
+		report->checks_failed = c.failed;
+	}
+	return c.failed == 0;
+}
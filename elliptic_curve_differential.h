@@ -0,0 +1,58 @@
+#ifndef ELLIPTIC_CURVE_DIFFERENTIAL_H_
+#define ELLIPTIC_CURVE_DIFFERENTIAL_H_
+
+#include "elliptic_curve.h"
+
+// Differential and algebraic self-checks, driven by arbitrary input bytes.
+//
+// One input is one test case on one registered curve. Every backend is
+// cross-checked against the reference routines (a bit-serial product,
+// gf2_reduce_lsb, gf2_binary_inverse_lsb, the context-less
+// elliptic_curve_binary_point_multiply) and against algebraic identities:
+// (a + b) P = aP + bP, n G = O, (n - 1) P = -P, a (b G) = b (a G), ...
+//
+// The same entry point serves the libFuzzer target (tools/ec_fuzz.cpp), the
+// offline randomized tester (tools/ec_difftest.cpp) and the regression test.
+// Input layout:
+//   byte 0    curve, index into the registry (mod count)
+//   byte 1    check groups (EC_DIFF_GROUP_*, 0 = all)
+//   byte 2..  operand material; when short, it is stretched with a PRNG
+//             seeded from the whole input, so every input is a valid case
+// Inputs of any length (including empty) are accepted. Not reentrant: the
+// multi-scalar checks use a static scratch area, and without
+// EC_REGISTRY_CONTEXTS the accelerated paths run on static context-backed
+// copies of the registry curves (EC_REGISTRY_MAX_CURVES contexts).
+
+#define EC_DIFF_GROUP_FIELD (1U << 0)
+#define EC_DIFF_GROUP_POINT (1U << 1)
+#define EC_DIFF_GROUP_ECDH  (1U << 2)
+#define EC_DIFF_GROUP_ALL   (EC_DIFF_GROUP_FIELD | EC_DIFF_GROUP_POINT | EC_DIFF_GROUP_ECDH)
+
+#define EC_DIFF_CHECK_FIELD_MULTIPLY    (0)     // word kernels and plans vs. bit-serial
+#define EC_DIFF_CHECK_FIELD_MULTIPLY_CT (1)
+#define EC_DIFF_CHECK_FIELD_REDUCE      (2)     // sparse / ct vs. gf2_reduce_lsb
+#define EC_DIFF_CHECK_FIELD_FUSED       (3)
+#define EC_DIFF_CHECK_FIELD_INVERSE     (4)
+#define EC_DIFF_CHECK_FIELD_MAPS        (5)     // sqrt / trace / half-trace
+#define EC_DIFF_CHECK_POINT_MULTIPLY    (6)     // context, no context, ladder, stepped
+#define EC_DIFF_CHECK_POINT_BASE        (7)
+#define EC_DIFF_CHECK_POINT_LINEARITY   (8)
+#define EC_DIFF_CHECK_POINT_ORDER       (9)
+#define EC_DIFF_CHECK_POINT_MSM         (10)
+#define EC_DIFF_CHECK_POINT_HALVING     (11)
+#define EC_DIFF_CHECK_ECDH              (12)
+#define EC_DIFF_CHECK_COUNT             (13)
+
+typedef struct {
+	const EllipticCurve *curve;
+	unsigned int checks_run;                // bit per EC_DIFF_CHECK_*
+	unsigned int checks_failed;
+}EcDifferentialReport;
+
+// Returns 1 if every check that ran passed. report may be 0.
+int elliptic_curve_differential_run(const unsigned char *data, unsigned long size,
+		EcDifferentialReport *report);
+
+const char* elliptic_curve_differential_check_name(unsigned int check);
+
+#endif /* ELLIPTIC_CURVE_DIFFERENTIAL_H_ */
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <iomanip>
+#include "elliptic_curve_differential.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0xD1FFE12EUL)
+#include "ec_test_util.h"
+
+// A fixed set of differential inputs per curve: a few with every check,
+// more field-only ones (cheap), and degenerate inputs (empty, all ones,
+// all zeros) that the PRNG stretching and scalar clamping must turn into
+// valid cases
+int test_elliptic_curve_differential() {
+	int failures = 0;
+	std::cout << "\n--- Differential self-checks (elliptic_curve_differential.h) ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned int covered = 0, failed = 0;
+
+		for (int iter = 0; iter < 40; ++iter) {
+			unsigned char data[2 + 8 * GF2_VECTOR_MAX_BYTELEN];
+			unsigned long size = sizeof(data);
+			for (unsigned long i = 0; i < size; ++i)
+				data[i] = ec_test_random_byte();
+			data[0] = (unsigned char) c;
+			data[1] = (iter < 2) ? EC_DIFF_GROUP_ALL : EC_DIFF_GROUP_FIELD;
+			if (iter == 2 || iter == 3)
+				for (unsigned long i = 2; i < size; ++i)
+					data[i] = (iter == 2) ? 0xFF : 0x00;
+			if (iter == 4)
+				size = 2;
+			EcDifferentialReport report;
+			elliptic_curve_differential_run(data, size, &report);
+			covered |= report.checks_run;
+			failed |= report.checks_failed;
+		}
+
+		int ok = !failed && (covered & (1U << EC_DIFF_CHECK_ECDH));
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL");
+		for (unsigned int check = 0; check < EC_DIFF_CHECK_COUNT; ++check) {
+			if (failed & (1U << check))
+				std::cout << " [" << elliptic_curve_differential_check_name(check) << "]";
+		}
+		std::cout << "\n";
+		failures += !ok;
+	}
+
+	// Empty input: curve 0, every group
+	EcDifferentialReport report;
+	int ok = elliptic_curve_differential_run(0, 0, &report)
+			&& report.checks_run == (1U << EC_DIFF_CHECK_COUNT) - 1U - (elliptic_curve_binary_supports_halving(
+					elliptic_curve_registry_get(0)->curve) ? 0 : (1U << EC_DIFF_CHECK_POINT_HALVING));
+	std::cout << std::left << std::setw(12) << "empty input" << (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+	return failures;
+}
@@ -0,0 +1,172 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x5EED1234UL)
+#include "ec_test_util.h"
+
+// The context's field maps against the reference definitions, and the
+// reference ones against their defining equations: sqrt(c)^2 = c and
+// H(c)^2 + H(c) = c for Tr(c) = 0
+static int halving_test_field(const EllipticCurve *curve) {
+	unsigned long len = curve->field_size_bytes;
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	int ok = 1;
+
+	for (int iter = 0; iter < 16; ++iter) {
+		alignas(8) unsigned char c[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char r[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		for (unsigned long i = 0; i < len; ++i)
+			c[i] = ec_test_random_byte();
+		elliptic_curve_field_reduce(curve, c, len);
+
+		int tr = gf2_trace_lsb(c, len, curve->modulus);
+		ok &= gf2_trace(c, &ctx->linear_maps) == tr;
+
+		gf2_sqrt_lsb(c, r, len, curve->modulus);
+		gf2_multiply_lsb(r, r, wide, len);
+		elliptic_curve_field_reduce(curve, wide, 2 * len);
+		for (unsigned long i = 0; i < len; ++i)
+			ok &= wide[i] == c[i];
+
+		c[0] ^= (unsigned char) tr;    // Tr(1) = 1 for odd m
+		gf2_half_trace_lsb(c, r, len, curve->modulus);
+		gf2_multiply_lsb(r, r, wide, len);
+		elliptic_curve_field_reduce(curve, wide, 2 * len);
+		for (unsigned long i = 0; i < len; ++i)
+			ok &= (wide[i] ^ r[i]) == c[i];
+	}
+	return ok;
+}
+
+int test_elliptic_curve_halving() {
+	int failures = 0;
+	std::cout << "\n--- Testing point halving and halve-and-add ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = ec_test_registry_curve(c);
+		unsigned long len = curve->field_size_bytes;
+		unsigned long y_offset = (len + 7UL) & (~7UL);
+		const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+		EllipticCurvePoint G = { }, P = { }, Q = { }, R1 = { }, R2 = { };
+		ec_test_load_base(curve, &G);
+
+		if (!elliptic_curve_binary_supports_halving(curve)) {
+			int ok = !(ctx->flags & EC_CONTEXT_FLAG_HALVING)
+					&& !elliptic_curve_binary_point_halve(curve, &Q, &G);
+			std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+					<< (ok ? "PASS (not eligible)" : "FAIL") << "\n";
+			failures += !ok;
+			continue;
+		}
+
+		// The context-less copy runs plain double-and-add and reference field ops
+		EllipticCurve bare = *curve;
+		bare.context = 0;
+		int ok = (ctx->flags & EC_CONTEXT_FLAG_HALVING) != 0;
+		ok &= halving_test_field(curve);
+
+		// halve(2P) = P, 2 halve(P) = P, with and without the context
+		for (int iter = 0; iter < 8; ++iter) {
+			unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+			for (unsigned long i = 0; i + 1 < len; ++i)
+				k[i] = ec_test_random_byte();
+			elliptic_curve_binary_point_multiply(&bare, &P, &G, k, len);
+			elliptic_curve_binary_point_double(curve, &Q, &P);
+			ok &= elliptic_curve_binary_point_halve(curve, &R1, &Q)
+					&& ec_test_points_equal(curve, &R1, &P);
+			ok &= elliptic_curve_binary_point_halve(&bare, &R2, &Q)
+					&& ec_test_points_equal(curve, &R2, &P);
+			ok &= elliptic_curve_binary_point_halve(curve, &R1, &P);
+			elliptic_curve_binary_point_double(curve, &R2, &R1);
+			ok &= ec_test_points_equal(curve, &R2, &P);
+		}
+
+		// Halve-and-add against double-and-add: random, k = 0, 1, n - 1, n, > n
+		for (int iter = 0; iter < 14; ++iter) {
+			unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+			for (unsigned long i = 0; i < len; ++i) {
+				if (iter < 8)
+					k[i] = ec_test_random_byte();
+				else if (iter < 10)
+					k[i] = i ? 0 : (unsigned char) (iter - 8);
+				else
+					k[i] = curve->order[i];
+			}
+			if (iter == 10)
+				k[0] -= 1;
+			else if (iter == 12)
+				k[0] ^= 0x10;
+			else if (iter == 13)
+				k[len - 1] = 0xFF;
+			elliptic_curve_binary_point_multiply(curve, &R1, &G, k, len);
+			elliptic_curve_binary_point_multiply(&bare, &R2, &G, k, len);
+			ok &= ec_test_points_equal(curve, &R1, &R2);
+		}
+
+		// G + T with T = (0, sqrt(b)) of order 2 is not halvable: rejected by
+		// halve(), multiplied by double-and-add
+		EllipticCurvePoint T = { }, GT = { };
+		gf2_sqrt_lsb(curve->b, &T.point_mem[y_offset], len, curve->modulus);
+		elliptic_curve_binary_point_add(curve, &GT, &G, &T);
+		ok &= !elliptic_curve_binary_point_halve(curve, &Q, &GT);
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		for (unsigned long i = 0; i < len; ++i)
+			k[i] = ec_test_random_byte();
+		elliptic_curve_binary_point_multiply(curve, &R1, &GT, k, len);
+		elliptic_curve_binary_point_multiply(&bare, &R2, &GT, k, len);
+		ok &= ec_test_points_equal(curve, &R1, &R2);
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Doubling vs. halving and double-and-add vs. halve-and-add, eligible curves only
+void benchmark_elliptic_curve_halving() {
+	const int runs = 20;
+	std::cout << "\n--- Benchmark: point halving vs. doubling (us/op) ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right
+			<< std::setw(10) << "double" << std::setw(10) << "halve"
+			<< std::setw(14) << "d&a, no ctx" << std::setw(14) << "halve-and-add" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = ec_test_registry_curve(c);
+		unsigned long len = curve->field_size_bytes;
+		if (!elliptic_curve_binary_supports_halving(curve))
+			continue;
+		EllipticCurve bare = *curve;
+		bare.context = 0;
+		EllipticCurvePoint G = { }, R = { };
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		ec_test_load_base(curve, &G);
+		for (unsigned long i = 0; i + 1 < len; ++i)
+			k[i] = (unsigned char) (0x6B * (i + 3));
+		elliptic_curve_binary_point_halve(curve, &R, &G); // warm context
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (int r = 0; r < 50 * runs; ++r)
+			elliptic_curve_binary_point_double(curve, &R, &G);
+		auto t1 = std::chrono::steady_clock::now();
+		for (int r = 0; r < 50 * runs; ++r)
+			elliptic_curve_binary_point_halve(curve, &R, &G);
+		auto t2 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			elliptic_curve_binary_point_multiply(&bare, &R, &G, k, len);
+		auto t3 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+			elliptic_curve_binary_point_multiply(curve, &R, &G, k, len);
+		auto t4 = std::chrono::steady_clock::now();
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::right << std::fixed << std::setprecision(1)
+				<< std::setw(10) << ec_test_microseconds(t0, t1, 50 * runs)
+				<< std::setw(10) << ec_test_microseconds(t1, t2, 50 * runs)
+				<< std::setw(14) << ec_test_microseconds(t2, t3, runs)
+				<< std::setw(14) << ec_test_microseconds(t3, t4, runs) << "\n";
+	}
+}
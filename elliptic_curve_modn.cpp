@@ -0,0 +1,429 @@
+#include "elliptic_curve_modn.h"
+#include "elliptic_curve_context.h"
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 modn_u128;
+#endif
+
+// lo + 2^64 hi = a b + c + d; cannot overflow, (2^64 - 1)^2 + 2 (2^64 - 1)
+// is 2^128 - 1
+static inline unsigned long long modn_mac(unsigned long long a, unsigned long long b,
+		unsigned long long c, unsigned long long d, unsigned long long *hi) {
+#if defined(__SIZEOF_INT128__)
+	modn_u128 p = (modn_u128) a * b + c + d;
+	*hi = (unsigned long long) (p >> 64);
+	return (unsigned long long) p;
+#else
+	unsigned long long a0 = a & 0xFFFFFFFFULL, a1 = a >> 32;
+	unsigned long long b0 = b & 0xFFFFFFFFULL, b1 = b >> 32;
+	unsigned long long p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+	unsigned long long mid = (p00 >> 32) + (p01 & 0xFFFFFFFFULL) + (p10 & 0xFFFFFFFFULL);
+	unsigned long long lo = (p00 & 0xFFFFFFFFULL) | (mid << 32);
+	unsigned long long h = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+	lo += c;
+	h += lo < c;
+	lo += d;
+	h += lo < d;
+	*hi = h;
+	return lo;
+#endif
+}
+
+// out = a + b over k limbs, returns the carry
+static unsigned long long modn_add_limbs(unsigned long long *out, const unsigned long long *a,
+		const unsigned long long *b, unsigned long k) {
+	unsigned long long carry = 0;
+	for (unsigned long i = 0; i < k; ++i) {
+		unsigned long long s = a[i] + carry;
+		carry = s < carry;
+		out[i] = s + b[i];
+		carry += out[i] < s;
+	}
+	return carry;
+}
+
+// out = a - b over k limbs, returns the borrow
+static unsigned long long modn_sub_limbs(unsigned long long *out, const unsigned long long *a,
+		const unsigned long long *b, unsigned long k) {
+	unsigned long long borrow = 0;
+	for (unsigned long i = 0; i < k; ++i) {
+		unsigned long long d = a[i] - b[i];
+		unsigned long long next = a[i] < b[i];
+		next |= d < borrow;
+		out[i] = d - borrow;
+		borrow = next;
+	}
+	return borrow;
+}
+
+// out = mask ? a : b, mask all ones or zero
+static void modn_select(unsigned long long *out, unsigned long long mask,
+		const unsigned long long *a, const unsigned long long *b, unsigned long k) {
+	for (unsigned long i = 0; i < k; ++i)
+		out[i] = (a[i] & mask) | (b[i] & ~mask);
+}
+
+// out = carry 2^(64 k) + in, minus n if that is at least n; the value must
+// be below 2 n
+static void modn_reduce_once(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *in, unsigned long long carry) {
+	unsigned long k = m->limbs;
+	unsigned long long t[EC_MODN_LIMBS];
+	unsigned long long borrow = modn_sub_limbs(t, in, m->n, k);
+	modn_select(out, 0 - (carry | (borrow ^ 1)), t, in, k);
+	for (unsigned long i = k; i < EC_MODN_LIMBS; ++i)
+		out[i] = 0;
+}
+
+static void modn_wipe(unsigned long long *p, unsigned long limbs) {
+	volatile unsigned long long *raw = p;
+	for (unsigned long i = 0; i < limbs; ++i)
+		raw[i] = 0;
+}
+
+// Barrett (HAC 14.42) with b = 2^64: x < b^(2k), 2k limbs. q estimates
+// x / n from the top k + 1 limbs of x and mu, at most 2 below the true
+// quotient, so r = x - q n < 3 n takes two conditional subtractions.
+static void modn_barrett(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *x) {
+	unsigned long k = m->limbs;
+	unsigned long long q[2 * EC_MODN_LIMBS + 2];
+	unsigned long long r[EC_MODN_LIMBS + 1], t[EC_MODN_LIMBS + 1];
+	unsigned long long n_ext[EC_MODN_LIMBS + 1];
+	const unsigned long long *q1 = x + k - 1;
+
+	for (unsigned long i = 0; i < 2 * k + 2; ++i)
+		q[i] = 0;
+	for (unsigned long i = 0; i <= k; ++i) {
+		unsigned long long carry = 0;
+		for (unsigned long j = 0; j <= k; ++j)
+			q[i + j] = modn_mac(q1[i], m->mu[j], q[i + j], carry, &carry);
+		q[i + k + 1] = carry;
+	}
+	const unsigned long long *q3 = q + k + 1;
+
+	// r = (x - q3 n) mod b^(k + 1)
+	for (unsigned long i = 0; i <= k; ++i)
+		r[i] = 0;
+	for (unsigned long i = 0; i <= k; ++i) {
+		unsigned long long carry = 0;
+		for (unsigned long j = 0; j < k && i + j <= k; ++j)
+			r[i + j] = modn_mac(q3[i], m->n[j], r[i + j], carry, &carry);
+		if (i == 0)
+			r[k] = carry;
+	}
+	modn_sub_limbs(r, x, r, k + 1);
+
+	for (unsigned long i = 0; i < k; ++i)
+		n_ext[i] = m->n[i];
+	n_ext[k] = 0;
+	for (int pass = 0; pass < 2; ++pass) {
+		unsigned long long borrow = modn_sub_limbs(t, r, n_ext, k + 1);
+		modn_select(r, 0 - borrow, r, t, k + 1);
+	}
+	for (unsigned long i = 0; i < EC_MODN_LIMBS; ++i)
+		out[i] = (i < k) ? r[i] : 0;
+	modn_wipe(q, 2 * EC_MODN_LIMBS + 2);
+	modn_wipe(t, EC_MODN_LIMBS + 1);
+}
+
+// Limb i of a byte string, zero beyond its end
+static unsigned long long modn_load_limb(const unsigned char *in, unsigned long bytelen,
+		unsigned long i) {
+	unsigned long long v = 0;
+	for (unsigned long b = 0; b < 8 && 8 * i + b < bytelen; ++b)
+		v |= (unsigned long long) in[8 * i + b] << (8 * b);
+	return v;
+}
+
+int elliptic_curve_modn_init(EllipticCurveModN *m, const unsigned char *modulus,
+		unsigned long bytelen) {
+	unsigned char *raw = (unsigned char*) m;
+	for (unsigned long i = 0; i < sizeof(EllipticCurveModN); ++i)
+		raw[i] = 0;
+	if (bytelen > GF2_VECTOR_MAX_BYTELEN)
+		return 0;
+
+	unsigned long k = 0;
+	for (unsigned long i = 0; i < EC_MODN_LIMBS; ++i) {
+		m->n[i] = modn_load_limb(modulus, bytelen, i);
+		if (m->n[i])
+			k = i + 1;
+	}
+	if (!k || !(m->n[0] & 1) || (k == 1 && m->n[0] == 1)) {
+		for (unsigned long i = 0; i < EC_MODN_LIMBS; ++i)
+			m->n[i] = 0;
+		return 0;
+	}
+	unsigned long bits = 64 * (k - 1);
+	for (unsigned long long v = m->n[k - 1]; v; v >>= 1)
+		++bits;
+	m->limbs = (unsigned int) k;
+	m->bits = (unsigned int) bits;
+	m->bytelen = (unsigned int) ((bits + 7) / 8);
+
+	// Newton's iteration doubles the correct low bits, n^-1 = n mod 2^3
+	unsigned long long inv = m->n[0];
+	for (int i = 0; i < 5; ++i)
+		inv *= 2 - m->n[0] * inv;
+	m->n0_inv = 0 - inv;
+
+	// R^2 mod n by 128 k doublings of 1; mu = floor(2^(128 k) / n) by
+	// long division, one quotient bit per doubling of the remainder
+	unsigned long long r[EC_MODN_LIMBS + 1] = { 1 };
+	unsigned long long n_ext[EC_MODN_LIMBS + 1] = { };
+	unsigned long long t[EC_MODN_LIMBS + 1];
+	for (unsigned long i = 0; i < k; ++i)
+		n_ext[i] = m->n[i];
+	for (unsigned long step = 0; step < 128 * k; ++step) {
+		modn_add_limbs(r, r, r, k + 1);
+		if (!modn_sub_limbs(t, r, n_ext, k + 1)) {
+			for (unsigned long i = 0; i <= k; ++i)
+				r[i] = t[i];
+		}
+	}
+	for (unsigned long i = 0; i < k; ++i)
+		m->r2[i] = r[i];
+
+	for (unsigned long i = 0; i <= k; ++i)
+		r[i] = 0;
+	for (long bit = 128 * (long) k; bit >= 0; --bit) {
+		modn_add_limbs(r, r, r, k + 1);
+		r[0] |= (bit == 128 * (long) k);
+		if (!modn_sub_limbs(t, r, n_ext, k + 1)) {
+			for (unsigned long i = 0; i <= k; ++i)
+				r[i] = t[i];
+			if (bit < 64 * (long) (k + 1))
+				m->mu[bit / 64] |= 1ULL << (bit % 64);
+		}
+	}
+	return 1;
+}
+
+const EllipticCurveModN* elliptic_curve_modn_get(const EllipticCurve *curve,
+		EllipticCurveModN *scratch) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	if (ctx && (ctx->flags & EC_CONTEXT_FLAG_MODN))
+		return &ctx->modn;
+	if (!elliptic_curve_modn_init(scratch, curve->order, curve->field_size_bytes))
+		return 0;
+	return scratch;
+}
+
+// Horner over k-limb chunks from the top: r = (r b^k + chunk) mod n, where
+// r b^k + chunk < b^(2k) is always in Barrett's range
+void elliptic_curve_modn_from_bytes(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned char *in, unsigned long bytelen) {
+	unsigned long k = m->limbs;
+	unsigned long limbs = (bytelen + 7) / 8;
+	unsigned long chunks = (limbs + k - 1) / k;
+	unsigned long long x[2 * EC_MODN_LIMBS] = { };
+	long c = (long) chunks - 1;
+
+	if (chunks < 2)
+		c = 1;
+	for (unsigned long i = 0; i < 2 * k; ++i)
+		x[i] = modn_load_limb(in, bytelen, (c - 1) * k + i);
+	modn_barrett(m, out, x);
+	for (c -= 2; c >= 0; --c) {
+		for (unsigned long i = 0; i < k; ++i) {
+			x[i] = modn_load_limb(in, bytelen, c * k + i);
+			x[k + i] = out[i];
+		}
+		modn_barrett(m, out, x);
+	}
+	modn_wipe(x, 2 * EC_MODN_LIMBS);
+}
+
+void elliptic_curve_modn_to_bytes(const EllipticCurveModN *m, unsigned char *out,
+		const unsigned long long *in) {
+	for (unsigned long i = 0; i < m->bytelen; ++i)
+		out[i] = (unsigned char) (in[i >> 3] >> (8 * (i & 7)));
+}
+
+void elliptic_curve_modn_add(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a, const unsigned long long *b) {
+	unsigned long long s[EC_MODN_LIMBS];
+	unsigned long long carry = modn_add_limbs(s, a, b, m->limbs);
+	modn_reduce_once(m, out, s, carry);
+}
+
+void elliptic_curve_modn_sub(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a, const unsigned long long *b) {
+	unsigned long k = m->limbs;
+	unsigned long long d[EC_MODN_LIMBS], n_masked[EC_MODN_LIMBS] = { };
+	unsigned long long mask = 0 - modn_sub_limbs(d, a, b, k);
+	for (unsigned long i = 0; i < k; ++i)
+		n_masked[i] = m->n[i] & mask;
+	modn_add_limbs(out, d, n_masked, k);
+	for (unsigned long i = k; i < EC_MODN_LIMBS; ++i)
+		out[i] = 0;
+}
+
+void elliptic_curve_modn_neg(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a) {
+	const unsigned long long zero[EC_MODN_LIMBS] = { };
+	elliptic_curve_modn_sub(m, out, zero, a);
+}
+
+void elliptic_curve_modn_mul(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a, const unsigned long long *b) {
+	unsigned long k = m->limbs;
+	unsigned long long x[2 * EC_MODN_LIMBS];
+	for (unsigned long i = 0; i < 2 * k; ++i)
+		x[i] = 0;
+	for (unsigned long i = 0; i < k; ++i) {
+		unsigned long long carry = 0;
+		for (unsigned long j = 0; j < k; ++j)
+			x[i + j] = modn_mac(a[i], b[j], x[i + j], carry, &carry);
+		x[i + k] = carry;
+	}
+	modn_barrett(m, out, x);
+	modn_wipe(x, 2 * EC_MODN_LIMBS);
+}
+
+// CIOS (Koc, Acar, Kaliski): one multiply row, then one reduction row that
+// clears the lowest limb, per limb of b; t stays below 2 n
+void elliptic_curve_modn_mont_mul(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a, const unsigned long long *b) {
+	unsigned long k = m->limbs;
+	const unsigned long long *n = m->n;
+	unsigned long long t[EC_MODN_LIMBS + 2];
+	for (unsigned long i = 0; i < k + 2; ++i)
+		t[i] = 0;
+
+	for (unsigned long i = 0; i < k; ++i) {
+		unsigned long long carry = 0;
+		for (unsigned long j = 0; j < k; ++j)
+			t[j] = modn_mac(a[j], b[i], t[j], carry, &carry);
+		unsigned long long s = t[k] + carry;
+		t[k + 1] = s < carry;
+		t[k] = s;
+
+		unsigned long long q = t[0] * m->n0_inv;
+		modn_mac(q, n[0], t[0], 0, &carry);
+		for (unsigned long j = 1; j < k; ++j)
+			t[j - 1] = modn_mac(q, n[j], t[j], carry, &carry);
+		s = t[k] + carry;
+		t[k - 1] = s;
+		t[k] = t[k + 1] + (s < carry);
+	}
+	modn_reduce_once(m, out, t, t[k]);
+	modn_wipe(t, EC_MODN_LIMBS + 2);
+}
+
+void elliptic_curve_modn_to_mont(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a) {
+	elliptic_curve_modn_mont_mul(m, out, a, m->r2);
+}
+
+void elliptic_curve_modn_from_mont(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a) {
+	const unsigned long long one[EC_MODN_LIMBS] = { 1 };
+	elliptic_curve_modn_mont_mul(m, out, a, one);
+}
+
+// a^(n - 2) in Montgomery form, fixed 4-bit windows. The exponent is public;
+// every window multiplies, by R (one) for a zero digit, and the table index
+// only depends on n.
+void elliptic_curve_modn_inv(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a) {
+	unsigned long k = m->limbs;
+	unsigned long long table[16][EC_MODN_LIMBS];
+	unsigned long long acc[EC_MODN_LIMBS], e[EC_MODN_LIMBS];
+	const unsigned long long one[EC_MODN_LIMBS] = { 1 }, two[EC_MODN_LIMBS] = { 2 };
+
+	modn_sub_limbs(e, m->n, two, k);
+	elliptic_curve_modn_to_mont(m, table[0], one);
+	elliptic_curve_modn_to_mont(m, table[1], a);
+	for (int i = 2; i < 16; ++i)
+		elliptic_curve_modn_mont_mul(m, table[i], table[i - 1], table[1]);
+
+	for (unsigned long i = 0; i < EC_MODN_LIMBS; ++i)
+		acc[i] = table[0][i];
+	for (long w = (long) (m->bits + 3) / 4 - 1; w >= 0; --w) {
+		for (int s = 0; s < 4; ++s)
+			elliptic_curve_modn_mont_mul(m, acc, acc, acc);
+		unsigned long digit = (unsigned long) (e[w / 16] >> (4 * (w % 16))) & 15;
+		elliptic_curve_modn_mont_mul(m, acc, acc, table[digit]);
+	}
+	elliptic_curve_modn_from_mont(m, out, acc);
+	modn_wipe(&table[0][0], 16 * EC_MODN_LIMBS);
+	modn_wipe(acc, EC_MODN_LIMBS);
+}
+
+// Zeros are replaced by one under a mask on the way in and masked back to
+// zero on the way out, so the sequence of operations is the same for any
+// input.
+unsigned long elliptic_curve_modn_batch_inv(const EllipticCurveModN *m,
+		unsigned long long (*out)[EC_MODN_LIMBS],
+		const unsigned long long (*in)[EC_MODN_LIMBS], unsigned long count) {
+	const unsigned long long one[EC_MODN_LIMBS] = { 1 }, zero[EC_MODN_LIMBS] = { };
+	unsigned long long acc[EC_MODN_LIMBS] = { 1 }, x[EC_MODN_LIMBS], r[EC_MODN_LIMBS];
+	unsigned long nonzero = 0;
+	if (!count)
+		return 0;
+
+	for (unsigned long i = 0; i < count; ++i) {
+		unsigned long long z = (unsigned long long) elliptic_curve_modn_is_zero(m, in[i]);
+		nonzero += (unsigned long) (z ^ 1);
+		modn_select(x, 0 - z, one, in[i], EC_MODN_LIMBS);
+		elliptic_curve_modn_mul(m, acc, acc, x);
+		for (unsigned long l = 0; l < EC_MODN_LIMBS; ++l)
+			out[i][l] = acc[l];
+	}
+	elliptic_curve_modn_inv(m, acc, acc);
+	for (unsigned long i = count; i-- > 0;) {
+		unsigned long long z = (unsigned long long) elliptic_curve_modn_is_zero(m, in[i]);
+		modn_select(x, 0 - z, one, in[i], EC_MODN_LIMBS);
+		if (i)
+			elliptic_curve_modn_mul(m, r, acc, out[i - 1]);
+		else
+			modn_select(r, 0 - 1ULL, acc, zero, EC_MODN_LIMBS);
+		elliptic_curve_modn_mul(m, acc, acc, x);
+		modn_select(out[i], 0 - z, zero, r, EC_MODN_LIMBS);
+	}
+	modn_wipe(acc, EC_MODN_LIMBS);
+	modn_wipe(x, EC_MODN_LIMBS);
+	modn_wipe(r, EC_MODN_LIMBS);
+	return nonzero;
+}
+
+int elliptic_curve_modn_equal(const EllipticCurveModN *m, const unsigned long long *a,
+		const unsigned long long *b) {
+	unsigned long long diff = 0;
+	for (unsigned long i = 0; i < m->limbs; ++i)
+		diff |= a[i] ^ b[i];
+	return (int) (((diff | (0 - diff)) >> 63) ^ 1);
+}
+
+int elliptic_curve_modn_is_zero(const EllipticCurveModN *m, const unsigned long long *a) {
+	const unsigned long long zero[EC_MODN_LIMBS] = { };
+	return elliptic_curve_modn_equal(m, a, zero);
+}
+
+int elliptic_curve_modn_random(const EllipticCurveModN *m, unsigned long long *out,
+		int (*random)(void *arg, unsigned char *out, unsigned long bytelen), void *random_arg) {
+	unsigned long len = m->bytelen;
+	unsigned char buf[GF2_VECTOR_MAX_BYTELEN];
+	unsigned long long t[EC_MODN_LIMBS];
+	unsigned char top_mask = (unsigned char) (0xFF >> (8 * len - m->bits));
+	int ok = 0;
+
+	for (int draw = 0; draw < EC_MODN_MAX_DRAWS && !ok; ++draw) {
+		if (!random(random_arg, buf, len))
+			break;
+		buf[len - 1] &= top_mask;
+		for (unsigned long i = 0; i < EC_MODN_LIMBS; ++i)
+			out[i] = modn_load_limb(buf, len, i);
+		ok = (int) modn_sub_limbs(t, out, m->n, m->limbs)
+				& !elliptic_curve_modn_is_zero(m, out);
+	}
+	volatile unsigned char *raw = buf;
+	for (unsigned long i = 0; i < sizeof(buf); ++i)
+		raw[i] = 0;
+	modn_wipe(t, EC_MODN_LIMBS);
+	if (!ok)
+		modn_wipe(out, EC_MODN_LIMBS);
+	return ok;
+}
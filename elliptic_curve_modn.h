@@ -0,0 +1,106 @@
+#ifndef ELLIPTIC_CURVE_MODN_H_
+#define ELLIPTIC_CURVE_MODN_H_
+
+#include "elliptic_curve.h"
+
+// Integer arithmetic modulo the base point order n (or any odd modulus up to
+// GF2_VECTOR_MAX_BYTELEN bytes): the scalar field of signatures, blinding and
+// key reduction.
+//
+// Elements are EC_MODN_LIMBS 64-bit limbs, least significant first, fully
+// reduced (below n), limbs above EllipticCurveModN::limbs zero. Two
+// reductions, both with per-modulus constants from
+// elliptic_curve_modn_init() (kept in the curve context, see
+// elliptic_curve_modn_get()):
+//  - Barrett: elliptic_curve_modn_mul() and elliptic_curve_modn_from_bytes()
+//    work on ordinary values, no conversion needed;
+//  - Montgomery: elliptic_curve_modn_mont_mul() on values in Montgomery form
+//    (a R mod n, R = 2^(64 limbs)), cheaper per product, for chains such as
+//    exponentiations; convert in and out with to_mont / from_mont.
+//
+// Everything except elliptic_curve_modn_random() runs in time independent of
+// the element values (n itself is public). Inversion is Fermat's a^(n-2),
+// so n must be prime, as the order of every registry curve is.
+//
+// elliptic_curve_scalar.h keeps the bitwise reduction the multiplications
+// use on byte strings; this module is the fast path for arithmetic on
+// scalars.
+
+#define EC_MODN_LIMBS ((GF2_VECTOR_MAX_BYTELEN + 7) / 8)
+
+// Redraws per elliptic_curve_modn_random() call before giving up; a draw
+// is rejected less than half of the time.
+#ifndef EC_MODN_MAX_DRAWS
+#define EC_MODN_MAX_DRAWS (64)
+#endif
+
+typedef struct alignas(8){
+	unsigned long long n[EC_MODN_LIMBS];
+	unsigned long long mu[EC_MODN_LIMBS + 1];       // Barrett: floor(2^(128 limbs) / n)
+	unsigned long long r2[EC_MODN_LIMBS];           // Montgomery: R^2 mod n
+	unsigned long long n0_inv;                      // Montgomery: -n^-1 mod 2^64
+	unsigned int limbs;                             // k, the limbs n occupies
+	unsigned int bits;                              // bits(n)
+	unsigned int bytelen;                           // bytes of n
+	unsigned int reserved;
+}EllipticCurveModN;
+
+// modulus LSB first, bytelen <= GF2_VECTOR_MAX_BYTELEN. Returns 0 (and
+// leaves m zeroed) unless the modulus is odd and above 1.
+int elliptic_curve_modn_init(EllipticCurveModN *m, const unsigned char *modulus,
+		unsigned long bytelen);
+
+// Constants for the curve's order n: from the curve context when one is
+// attached, otherwise computed into scratch. Returns 0 if n is unusable.
+const EllipticCurveModN* elliptic_curve_modn_get(const EllipticCurve *curve,
+		EllipticCurveModN *scratch);
+
+// out = in mod n, in an integer of any length, bytes LSB first.
+void elliptic_curve_modn_from_bytes(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned char *in, unsigned long bytelen);
+// m->bytelen bytes, LSB first.
+void elliptic_curve_modn_to_bytes(const EllipticCurveModN *m, unsigned char *out,
+		const unsigned long long *in);
+
+// out may alias either input in all of these.
+void elliptic_curve_modn_add(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a, const unsigned long long *b);
+void elliptic_curve_modn_sub(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a, const unsigned long long *b);
+void elliptic_curve_modn_neg(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a);
+// Barrett
+void elliptic_curve_modn_mul(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a, const unsigned long long *b);
+
+// Montgomery: out = a b R^-1 mod n
+void elliptic_curve_modn_mont_mul(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a, const unsigned long long *b);
+void elliptic_curve_modn_to_mont(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a);
+void elliptic_curve_modn_from_mont(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a);
+
+// out = a^-1 mod n, 0 for a = 0.
+void elliptic_curve_modn_inv(const EllipticCurveModN *m, unsigned long long *out,
+		const unsigned long long *a);
+// Montgomery's trick: count inverses for one inversion and 3 (count - 1)
+// multiplications. Zero inputs give zero outputs without spoiling the
+// others. out must not overlap in. Returns how many inputs were non-zero.
+unsigned long elliptic_curve_modn_batch_inv(const EllipticCurveModN *m,
+		unsigned long long (*out)[EC_MODN_LIMBS],
+		const unsigned long long (*in)[EC_MODN_LIMBS], unsigned long count);
+
+// 1 if a == b, else 0.
+int elliptic_curve_modn_equal(const EllipticCurveModN *m, const unsigned long long *a,
+		const unsigned long long *b);
+int elliptic_curve_modn_is_zero(const EllipticCurveModN *m, const unsigned long long *a);
+
+// Uniform out in [1, n - 1] by rejection: bits(n) random bits per draw,
+// redrawn while out is 0 or not below n. random fills out with bytelen
+// bytes and returns 1 on success. Returns 0 if it fails or after
+// EC_MODN_MAX_DRAWS rejected draws.
+int elliptic_curve_modn_random(const EllipticCurveModN *m, unsigned long long *out,
+		int (*random)(void *arg, unsigned char *out, unsigned long bytelen), void *random_arg);
+
+#endif /* ELLIPTIC_CURVE_MODN_H_ */
@@ -0,0 +1,285 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "elliptic_curve_modn.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+#include "elliptic_curve_scalar.h"
+#define EC_TEST_RNG_SEED (0x4D4F0047UL)
+#include "ec_test_util.h"
+
+static int modn_test_random_source(void *arg, unsigned char *out, unsigned long bytelen) {
+	int *mode = (int*) arg;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		out[i] = (*mode == 1) ? 0xFF : (*mode == 2) ? 0 : ec_test_random_byte();
+	return *mode != 3;
+}
+
+static void modn_test_load(const EllipticCurveModN *m, unsigned long long *out, const char *hex) {
+	unsigned char bytes[128];
+	unsigned long len = ec_test_hex_lsb(hex, bytes, 0);
+	elliptic_curve_modn_from_bytes(m, out, bytes, len);
+}
+
+static void modn_test_random(const EllipticCurveModN *m, unsigned long long *out) {
+	int mode = 0;
+	elliptic_curve_modn_random(m, out, modn_test_random_source, &mode);
+}
+
+typedef struct {
+	const char *name;
+	const char *n, *a, *b, *ab, *a_plus_b, *a_minus_b, *a_inv, *wide, *wide_mod_n;
+}ModNTestVector;
+
+// Python's integers, a and b from SHA-256 of the curve name, wide a 96-byte
+// value (several Horner chunks at every modulus size)
+static const ModNTestVector modn_test_vectors[] = {
+	{ "sect163k1",
+		"04000000000000000000020108a2e0cc0d99f8a5ef",
+		"03c7c0c2186e3d0763221d55e10163cf1b14e3b9f5",
+		"01a531438e2e73cf11680c0545b03e44b5f7b4c761",
+		"0225594ba09ad4c25396528a2598c61a89a6656d15",
+		"016cf205a69cb0d6748a275a1e0ec147c3729fdb67",
+		"02228f7e8a3fc93851ba11509b51258a651d2ef294",
+		"00d19e89a5398d6a4973af2c06ceb8dbb767a1f51e",
+		"e17a6f3df4ae16545dda49dc3ea12de4f93af9d66b2e5b76d9e57d389004357058cca472c63c9fb1"
+		"475cc45cdec4853d463cb401314116d448f58339950f0cbf354816db7b3b2000f8b361ab6c44a3f3"
+		"4dfa1bf8e38d363f8e669cd04e0f8d2a",
+		"01a5830803bb5c26beb666b88de157a3eb89cc3b51" },
+	{ "sect233r1",
+		"01000000000000000000000000000013e974e72f8a6922031d2603cfe0d7",
+		"001055c4cf702b28294a0f6a109c7fcca5c3b01aa7a8ec54361fda3f2961",
+		"00f0d4fd83d6683c61fb16371fac80d85d6e7778f4da471f64d92245f4b9",
+		"0051dc3955bb44ae5eb53140c031beeb21065a960a54e42fe4ce6cd6ae05",
+		"00012ac2534693648b4525a13049009119bd4064121a11707dd2f8b53d43",
+		"001f80c74b99c2ebc74ef932f0efff0831ca1fd13d37c737ee6cbbc9157f",
+		"00465acd15af7c37e81cc0648f96d51aa69154af461c9e24ddcd65c8defb",
+		"b8246dd34017a2bc15cafd3f82ee7814a229cb184e3074b8b3fbe8699df24582ca5419307d90742b"
+		"df87f62c5567a450816ec859466fd64bc73c433f3c5cf1ee5abde01f6c515cba817b62a3f838b55f"
+		"8a820a665c8680ac3f6b5007d8087964",
+		"00ccad648cf0a44625d481bd190e8abd575d9d616d20f17813d1a8584f64" },
+	{ "p256 order",                 // four full limbs
+		"ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551",
+		"0d9aefc92d24a429629621eebb51844cd136d501fa4c3f4bd0fb4e81db5fc024",
+		"773f96efc88b1e523a4d7c029cd8187d90495671f5ee7a9907e3877bb0b8cca2",
+		"609f3804d7701d3248a6b458ec1a8618316545a525b2f3fd98308da676527d07",
+		"84da86b8f5afc27b9ce39df158299cca61802b73f03ab9e4d8ded5fd8c188cc6",
+		"965b58d8649985d82848a5ec1e796bcefdd4793dab756337bcd191c9270a18d3",
+		"2800bf74437d5447955d5bb332179409b2981272eb0f6fbf19db8fb1009208c5",
+		"1d4f92ba1140f5077a9c1c9fd3476a1507bbb7619ce1d34d49ec8c481e7e297e83899564c2c0740d"
+		"2d170b4b0fae4b2c22d4493b2c7369dc6a24cd83205f94ff7985ebd3da40d5187d6d3ef3d626abf3"
+		"c2b81c285ffb4e73104a472066c443b9",
+		"b172bac5aa51f3d407bb1089aa08118173b664e3c86904a5d909ffa658c2185d" },
+};
+
+// Known vectors for every operation, then on every registry curve: the
+// context's constants, reduction of byte strings of every length against
+// the bitwise elliptic_curve_scalar_reduce, inverses, batch inversion with
+// zeros mixed in and rejection sampling
+int test_elliptic_curve_modn() {
+	int failures = 0;
+	std::cout << "\n--- Testing arithmetic modulo n (Barrett / Montgomery) ---\n";
+
+	for (unsigned long v = 0; v < sizeof(modn_test_vectors) / sizeof(modn_test_vectors[0]); ++v) {
+		const ModNTestVector *tv = &modn_test_vectors[v];
+		unsigned char n_bytes[GF2_VECTOR_MAX_BYTELEN];
+		unsigned long n_len = ec_test_hex_lsb(tv->n, n_bytes, 0);
+		EllipticCurveModN m;
+		int ok = elliptic_curve_modn_init(&m, n_bytes, n_len);
+		unsigned long long a[EC_MODN_LIMBS], b[EC_MODN_LIMBS], r[EC_MODN_LIMBS],
+				expected[EC_MODN_LIMBS], am[EC_MODN_LIMBS], bm[EC_MODN_LIMBS];
+		modn_test_load(&m, a, tv->a);
+		modn_test_load(&m, b, tv->b);
+
+		elliptic_curve_modn_mul(&m, r, a, b);
+		modn_test_load(&m, expected, tv->ab);
+		ok &= elliptic_curve_modn_equal(&m, r, expected);
+		elliptic_curve_modn_to_mont(&m, am, a);
+		elliptic_curve_modn_to_mont(&m, bm, b);
+		elliptic_curve_modn_mont_mul(&m, r, am, bm);
+		elliptic_curve_modn_from_mont(&m, r, r);
+		ok &= elliptic_curve_modn_equal(&m, r, expected);
+		elliptic_curve_modn_add(&m, r, a, b);
+		modn_test_load(&m, expected, tv->a_plus_b);
+		ok &= elliptic_curve_modn_equal(&m, r, expected);
+		elliptic_curve_modn_sub(&m, r, a, b);
+		modn_test_load(&m, expected, tv->a_minus_b);
+		ok &= elliptic_curve_modn_equal(&m, r, expected);
+		elliptic_curve_modn_inv(&m, r, a);
+		modn_test_load(&m, expected, tv->a_inv);
+		ok &= elliptic_curve_modn_equal(&m, r, expected);
+		modn_test_load(&m, r, tv->wide);
+		modn_test_load(&m, expected, tv->wide_mod_n);
+		ok &= elliptic_curve_modn_equal(&m, r, expected);
+
+		// n itself, n - 1 + 1 and -a + a all land on 0; 0 has no inverse
+		elliptic_curve_modn_from_bytes(&m, r, n_bytes, n_len);
+		ok &= elliptic_curve_modn_is_zero(&m, r);
+		elliptic_curve_modn_neg(&m, r, a);
+		elliptic_curve_modn_add(&m, r, r, a);
+		ok &= elliptic_curve_modn_is_zero(&m, r);
+		elliptic_curve_modn_inv(&m, r, r);
+		ok &= elliptic_curve_modn_is_zero(&m, r);
+
+		std::cout << std::left << std::setw(24) << tv->name << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	{
+		EllipticCurveModN m;
+		const unsigned char even[] = { 0x10, 0x01 }, one[] = { 0x01, 0x00 }, zero[] = { 0, 0 };
+		int ok = !elliptic_curve_modn_init(&m, even, 2) && !elliptic_curve_modn_init(&m, one, 2)
+				&& !elliptic_curve_modn_init(&m, zero, 2);
+		std::cout << std::left << std::setw(24) << "bad moduli" << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = ec_test_registry_curve(c);
+		unsigned long len = curve->field_size_bytes;
+		EllipticCurveModN scratch, fresh;
+		const EllipticCurveModN *m = elliptic_curve_modn_get(curve, &scratch);
+		int ok = m != 0 && m != &scratch;
+		ok &= elliptic_curve_modn_init(&fresh, curve->order, len);
+		const unsigned char *x = (const unsigned char*) m, *y = (const unsigned char*) &fresh;
+		for (unsigned long i = 0; ok && i < sizeof(EllipticCurveModN); ++i)
+			ok &= x[i] == y[i];
+
+		// Reduction of every length up to 3 len + 2 bytes, and of products
+		unsigned char bytes[3 * GF2_VECTOR_MAX_BYTELEN + 2], reduced[GF2_VECTOR_MAX_BYTELEN];
+		unsigned char expected[GF2_VECTOR_MAX_BYTELEN];
+		unsigned long long r[EC_MODN_LIMBS], a[EC_MODN_LIMBS], b[EC_MODN_LIMBS];
+		for (unsigned long l = 0; l <= 3 * len + 2; ++l) {
+			for (unsigned long i = 0; i < l; ++i)
+				bytes[i] = ec_test_random_byte();
+			elliptic_curve_modn_from_bytes(m, r, bytes, l);
+			elliptic_curve_modn_to_bytes(m, reduced, r);
+			elliptic_curve_scalar_reduce(curve->order, len, expected, bytes, l, 0);
+			for (unsigned long i = 0; i < m->bytelen; ++i)
+				ok &= reduced[i] == expected[i];
+		}
+		for (int t = 0; t < 32; ++t) {
+			unsigned long long ai[EC_MODN_LIMBS], q[EC_MODN_LIMBS], am[EC_MODN_LIMBS];
+			modn_test_random(m, a);
+			modn_test_random(m, b);
+			elliptic_curve_modn_inv(m, ai, a);
+			elliptic_curve_modn_mul(m, q, a, b);
+			elliptic_curve_modn_mul(m, r, q, ai);
+			ok &= elliptic_curve_modn_equal(m, r, b);
+			elliptic_curve_modn_to_mont(m, am, a);
+			elliptic_curve_modn_mont_mul(m, am, am, am);
+			elliptic_curve_modn_from_mont(m, am, am);
+			elliptic_curve_modn_mul(m, r, a, a);
+			ok &= elliptic_curve_modn_equal(m, r, am);
+		}
+
+		// Batch inversion with zeros at both ends and inside
+		const unsigned long count = 37;
+		std::vector<unsigned long long> in(count * EC_MODN_LIMBS), out(count * EC_MODN_LIMBS);
+		unsigned long long (*in_rows)[EC_MODN_LIMBS] = (unsigned long long (*)[EC_MODN_LIMBS]) in.data();
+		unsigned long long (*out_rows)[EC_MODN_LIMBS] = (unsigned long long (*)[EC_MODN_LIMBS]) out.data();
+		for (unsigned long i = 0; i < count; ++i) {
+			if (i == 0 || i == 17 || i == count - 1)
+				continue;
+			modn_test_random(m, in_rows[i]);
+		}
+		ok &= elliptic_curve_modn_batch_inv(m, out_rows,
+				(const unsigned long long (*)[EC_MODN_LIMBS]) in_rows, count) == count - 3;
+		for (unsigned long i = 0; i < count; ++i) {
+			elliptic_curve_modn_inv(m, r, in_rows[i]);
+			ok &= elliptic_curve_modn_equal(m, r, out_rows[i]);
+		}
+
+		// Sampling: in range; a failing source, one that only offers values
+		// above n and one that only offers zero all give up with out zeroed
+		for (int t = 0; t < 64; ++t) {
+			int mode = 0;
+			ok &= elliptic_curve_modn_random(m, r, modn_test_random_source, &mode);
+			elliptic_curve_modn_to_bytes(m, reduced, r);
+			elliptic_curve_scalar_reduce(curve->order, len, expected, reduced, m->bytelen, 0);
+			for (unsigned long i = 0; i < m->bytelen; ++i)
+				ok &= reduced[i] == expected[i];
+			ok &= !elliptic_curve_modn_is_zero(m, r);
+		}
+		for (int mode = 1; mode <= 3; ++mode) {
+			r[0] = 5;
+			ok &= !elliptic_curve_modn_random(m, r, modn_test_random_source, &mode);
+			ok &= elliptic_curve_modn_is_zero(m, r);
+		}
+
+		std::cout << std::left << std::setw(24) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Nanoseconds per operation modulo n: product and reduction by Barrett, by
+// Montgomery and by the bitwise elliptic_curve_scalar_reduce, one inversion
+// and the per-element cost of a 64-element batch inversion
+void benchmark_elliptic_curve_modn() {
+	const int iterations = 20000;
+	const unsigned long count = 64;
+	std::cout << "\n--- Benchmark: arithmetic modulo n, ns per operation ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right << std::setw(10) << "barrett"
+			<< std::setw(10) << "mont" << std::setw(10) << "bitwise" << std::setw(10) << "inv"
+			<< std::setw(10) << "batch" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = ec_test_registry_curve(c);
+		unsigned long len = curve->field_size_bytes;
+		EllipticCurveModN scratch;
+		const EllipticCurveModN *m = elliptic_curve_modn_get(curve, &scratch);
+		unsigned long long a[EC_MODN_LIMBS], b[EC_MODN_LIMBS];
+		modn_test_random(m, a);
+		modn_test_random(m, b);
+		unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN], out[GF2_VECTOR_MAX_BYTELEN];
+		for (unsigned long i = 0; i < 2 * len; ++i)
+			wide[i] = ec_test_random_byte();
+		double ns[5];
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; ++i)
+			elliptic_curve_modn_mul(m, a, a, b);
+		auto t1 = std::chrono::steady_clock::now();
+		ns[0] = std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+
+		t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; ++i)
+			elliptic_curve_modn_mont_mul(m, a, a, b);
+		t1 = std::chrono::steady_clock::now();
+		ns[1] = std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+
+		t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations / 100; ++i) {
+			elliptic_curve_scalar_reduce(curve->order, len, out, wide, 2 * len, 0);
+			wide[0] ^= out[0];
+		}
+		t1 = std::chrono::steady_clock::now();
+		ns[2] = std::chrono::duration<double, std::nano>(t1 - t0).count() / (iterations / 100);
+
+		t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations / 100; ++i)
+			elliptic_curve_modn_inv(m, a, a);
+		t1 = std::chrono::steady_clock::now();
+		ns[3] = std::chrono::duration<double, std::nano>(t1 - t0).count() / (iterations / 100);
+
+		std::vector<unsigned long long> in(count * EC_MODN_LIMBS), inv(count * EC_MODN_LIMBS);
+		unsigned long long (*in_rows)[EC_MODN_LIMBS] = (unsigned long long (*)[EC_MODN_LIMBS]) in.data();
+		for (unsigned long i = 0; i < count; ++i)
+			modn_test_random(m, in_rows[i]);
+		t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < 10; ++i)
+			elliptic_curve_modn_batch_inv(m, (unsigned long long (*)[EC_MODN_LIMBS]) inv.data(),
+					(const unsigned long long (*)[EC_MODN_LIMBS]) in_rows, count);
+		t1 = std::chrono::steady_clock::now();
+		ns[4] = std::chrono::duration<double, std::nano>(t1 - t0).count() / (10 * count);
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::right << std::fixed << std::setprecision(0);
+		for (int i = 0; i < 5; ++i)
+			std::cout << std::setw(10) << ns[i];
+		std::cout << "\n";
+	}
+}
@@ -0,0 +1,283 @@
+#include "elliptic_curve_msm.h"
+#include "elliptic_curve_scalar.h"
+
+static void msm_point_set_infinity(EllipticCurvePoint *out) {
+	for (unsigned long i = 0; i < 2 * GF2_VECTOR_MAX_BYTELEN; ++i)
+		out->point_mem[i] = 0x00;
+}
+
+static void msm_point_copy(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const EllipticCurvePoint *in) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	for (unsigned long i = 0; i < len; ++i) {
+		out->point_mem[i] = in->point_mem[i];
+		out->point_mem[i + y_offset] = in->point_mem[i + y_offset];
+	}
+}
+
+// acc += sign * in, where -(x, y) = (x, x + y)
+static void msm_point_accumulate(const EllipticCurve *curve,
+		EllipticCurvePoint *acc, const EllipticCurvePoint *in, int sign) {
+	if (sign > 0) {
+		elliptic_curve_binary_point_add(curve, acc, acc, in);
+		return;
+	}
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	alignas(8) EllipticCurvePoint neg = { };
+	for (unsigned long i = 0; i < len; ++i) {
+		neg.point_mem[i] = in->point_mem[i];
+		neg.point_mem[i + y_offset] = in->point_mem[i] ^ in->point_mem[i + y_offset];
+	}
+	elliptic_curve_binary_point_add(curve, acc, acc, &neg);
+}
+
+static unsigned long msm_align8(unsigned long n) {
+	return (n + 7UL) & (~7UL);
+}
+
+// Estimated point operations (additions and doublings cost about the same in
+// affine coordinates: one inversion each)
+static unsigned long msm_straus_cost(unsigned long count, unsigned long bits,
+		unsigned long w) {
+	return bits + count * ((1UL << (w - 2)) + bits / (w + 1));
+}
+
+static unsigned long msm_pippenger_windows(unsigned long bits, unsigned long c) {
+	return bits / c + 2;
+}
+
+// The first point dropped into an empty bucket is a copy, not an addition.
+static unsigned long msm_pippenger_cost(unsigned long count, unsigned long bits,
+		unsigned long c) {
+	unsigned long buckets = 1UL << (c - 1);
+	unsigned long filled = (count < buckets) ? count : buckets;
+	return bits + msm_pippenger_windows(bits, c) * (count - filled + 2 * buckets);
+}
+
+static unsigned long msm_straus_width(unsigned long count, unsigned long bits) {
+	unsigned long best = 2;
+	for (unsigned long w = 3; w <= EC_MSM_STRAUS_MAX_WIDTH; ++w) {
+		if (msm_straus_cost(count, bits, w) < msm_straus_cost(count, bits, best))
+			best = w;
+	}
+	return best;
+}
+
+static unsigned long msm_pippenger_window(unsigned long count, unsigned long bits) {
+	unsigned long best = 2;
+	for (unsigned long c = 3; c <= EC_MSM_PIPPENGER_MAX_WINDOW; ++c) {
+		if (msm_pippenger_cost(count, bits, c) < msm_pippenger_cost(count, bits, best))
+			best = c;
+	}
+	return best;
+}
+
+int elliptic_curve_msm_select_method(unsigned long count, unsigned long bytelen) {
+	unsigned long bits = 8 * bytelen;
+	unsigned long straus = msm_straus_cost(count, bits, msm_straus_width(count, bits));
+	unsigned long pippenger = msm_pippenger_cost(count, bits, msm_pippenger_window(count, bits));
+	return (pippenger < straus) ? EC_MSM_METHOD_PIPPENGER : EC_MSM_METHOD_STRAUS;
+}
+
+unsigned long elliptic_curve_msm_scratch_bytelen(const EllipticCurve *curve,
+		unsigned long count, unsigned long bytelen, int method) {
+	unsigned long bits = 8 * bytelen;
+	(void) curve;
+
+	if (method == EC_MSM_METHOD_AUTO)
+		method = elliptic_curve_msm_select_method(count, bytelen);
+	if (method == EC_MSM_METHOD_STRAUS) {
+		unsigned long w = msm_straus_width(count, bits);
+		return msm_align8(count * (1UL << (w - 2)) * sizeof(EllipticCurvePoint))
+				+ msm_align8(count * EC_SCALAR_DIGIT_COUNT(bytelen));
+	}
+	if (method == EC_MSM_METHOD_PIPPENGER) {
+		unsigned long c = msm_pippenger_window(count, bits);
+		return msm_align8((1UL << (c - 1)) * sizeof(EllipticCurvePoint))
+				+ msm_align8(count * msm_pippenger_windows(bits, c) * sizeof(short));
+	}
+	return 0;
+}
+
+static void msm_straus(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const EllipticCurvePoint *const *points,
+		const unsigned char *const *scalars, unsigned long count,
+		unsigned long bytelen, unsigned char *scratch) {
+	unsigned long w = msm_straus_width(count, 8 * bytelen);
+	unsigned long table_size = 1UL << (w - 2);
+	unsigned long digit_count = EC_SCALAR_DIGIT_COUNT(bytelen);
+	EllipticCurvePoint *tables = (EllipticCurvePoint*) scratch;
+	signed char *digits = (signed char*) (scratch
+			+ msm_align8(count * table_size * sizeof(EllipticCurvePoint)));
+	alignas(8) EllipticCurvePoint acc = { };
+	long top = -1;
+
+	// tables[t * table_size + j] = (2j + 1) * points[t]
+	for (unsigned long t = 0; t < count; ++t) {
+		EllipticCurvePoint *table = &tables[t * table_size];
+		alignas(8) EllipticCurvePoint twice = { };
+		msm_point_copy(curve, &table[0], points[t]);
+		elliptic_curve_binary_point_double(curve, &twice, points[t]);
+		for (unsigned long j = 1; j < table_size; ++j)
+			elliptic_curve_binary_point_add(curve, &table[j], &table[j - 1], &twice);
+
+		elliptic_curve_scalar_recode_wnaf(scalars[t], bytelen, w, &digits[t * digit_count]);
+		for (long d = (long) digit_count - 1; d > top; --d) {
+			if (digits[t * digit_count + d]) {
+				top = d;
+				break;
+			}
+		}
+	}
+
+	for (long d = top; d >= 0; --d) {
+		elliptic_curve_binary_point_double(curve, &acc, &acc);
+		for (unsigned long t = 0; t < count; ++t) {
+			int digit = digits[t * digit_count + d];
+			if (digit > 0)
+				msm_point_accumulate(curve, &acc, &tables[t * table_size + (digit >> 1)], 1);
+			else if (digit < 0)
+				msm_point_accumulate(curve, &acc, &tables[t * table_size + ((-digit) >> 1)], -1);
+		}
+	}
+	msm_point_set_infinity(out);
+	msm_point_copy(curve, out, &acc);
+}
+
+// Bits [pos, pos + width) of exp, zero beyond the end
+static unsigned int msm_scalar_bits(const unsigned char *exp,
+		unsigned long bytelen, unsigned long pos, unsigned long width) {
+	unsigned int value = 0;
+	for (unsigned long i = 0; i < width; ++i) {
+		unsigned long bit = pos + i;
+		if ((bit >> 3) < bytelen)
+			value |= (unsigned int) ((exp[bit >> 3] >> (bit & 7)) & 1) << i;
+	}
+	return value;
+}
+
+static void msm_pippenger(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const EllipticCurvePoint *const *points,
+		const unsigned char *const *scalars, unsigned long count,
+		unsigned long bytelen, unsigned char *scratch) {
+	unsigned long c = msm_pippenger_window(count, 8 * bytelen);
+	unsigned long windows = msm_pippenger_windows(8 * bytelen, c);
+	unsigned long bucket_count = 1UL << (c - 1);
+	EllipticCurvePoint *buckets = (EllipticCurvePoint*) scratch;
+	short *digits = (short*) (scratch
+			+ msm_align8(bucket_count * sizeof(EllipticCurvePoint)));
+	alignas(8) EllipticCurvePoint acc = { };
+	alignas(8) EllipticCurvePoint running = { };
+	alignas(8) EllipticCurvePoint window_sum = { };
+
+	// Signed c-bit digits in [-2^(c-1), 2^(c-1)), so a bucket serves +P and -P
+	for (unsigned long t = 0; t < count; ++t) {
+		unsigned int carry = 0;
+		for (unsigned long j = 0; j < windows; ++j) {
+			int digit = (int) (msm_scalar_bits(scalars[t], bytelen, j * c, c) + carry);
+			carry = 0;
+			if (digit >= (int) bucket_count) {
+				digit -= (int) (1UL << c);
+				carry = 1;
+			}
+			digits[t * windows + j] = (short) digit;
+		}
+	}
+
+	for (long j = (long) windows - 1; j >= 0; --j) {
+		for (unsigned long i = 0; i < c; ++i)
+			elliptic_curve_binary_point_double(curve, &acc, &acc);
+
+		for (unsigned long b = 0; b < bucket_count; ++b)
+			msm_point_set_infinity(&buckets[b]);
+		for (unsigned long t = 0; t < count; ++t) {
+			int digit = digits[t * windows + (unsigned long) j];
+			if (digit > 0)
+				msm_point_accumulate(curve, &buckets[digit - 1], points[t], 1);
+			else if (digit < 0)
+				msm_point_accumulate(curve, &buckets[-digit - 1], points[t], -1);
+		}
+
+		// sum of (b + 1) * buckets[b] by running sums from the top bucket
+		msm_point_set_infinity(&running);
+		msm_point_set_infinity(&window_sum);
+		for (long b = (long) bucket_count - 1; b >= 0; --b) {
+			elliptic_curve_binary_point_add(curve, &running, &running, &buckets[b]);
+			elliptic_curve_binary_point_add(curve, &window_sum, &window_sum, &running);
+		}
+		elliptic_curve_binary_point_add(curve, &acc, &acc, &window_sum);
+	}
+	msm_point_set_infinity(out);
+	msm_point_copy(curve, out, &acc);
+}
+
+void elliptic_curve_msm2(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const EllipticCurvePoint *in1, const unsigned char *exp1,
+		const EllipticCurvePoint *in2, const unsigned char *exp2,
+		unsigned long bytelen) {
+	signed char u1[EC_SCALAR_DIGIT_COUNT(GF2_VECTOR_MAX_BYTELEN)];
+	signed char u2[EC_SCALAR_DIGIT_COUNT(GF2_VECTOR_MAX_BYTELEN)];
+	alignas(8) EllipticCurvePoint sum = { };       // in1 + in2
+	alignas(8) EllipticCurvePoint difference = { }; // in1 - in2
+	alignas(8) EllipticCurvePoint acc = { };
+
+	if (bytelen > GF2_VECTOR_MAX_BYTELEN) {
+		msm_point_set_infinity(out);
+		return;
+	}
+	elliptic_curve_scalar_recode_jsf(exp1, exp2, bytelen, u1, u2);
+	elliptic_curve_binary_point_add(curve, &sum, in1, in2);
+	msm_point_copy(curve, &difference, in1);
+	msm_point_accumulate(curve, &difference, in2, -1);
+
+	long top = (long) EC_SCALAR_DIGIT_COUNT(bytelen) - 1;
+	while (top >= 0 && !u1[top] && !u2[top])
+		--top;
+	for (long j = top; j >= 0; --j) {
+		elliptic_curve_binary_point_double(curve, &acc, &acc);
+		if (u1[j] && u2[j])
+			msm_point_accumulate(curve, &acc, (u1[j] == u2[j]) ? &sum : &difference, u1[j]);
+		else if (u1[j])
+			msm_point_accumulate(curve, &acc, in1, u1[j]);
+		else if (u2[j])
+			msm_point_accumulate(curve, &acc, in2, u2[j]);
+	}
+	msm_point_set_infinity(out);
+	msm_point_copy(curve, out, &acc);
+}
+
+int elliptic_curve_msm(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const EllipticCurvePoint *const *points,
+		const unsigned char *const *scalars, unsigned long count,
+		unsigned long bytelen, int method,
+		void *scratch, unsigned long scratch_bytelen) {
+	if (!curve || !out || (count && (!points || !scalars))
+			|| bytelen > GF2_VECTOR_MAX_BYTELEN)
+		return 0;
+	if (method == EC_MSM_METHOD_AUTO)
+		method = elliptic_curve_msm_select_method(count, bytelen);
+	if (method == EC_MSM_METHOD_JSF) {
+		if (count != 2)
+			return 0;
+		elliptic_curve_msm2(curve, out, points[0], scalars[0], points[1],
+				scalars[1], bytelen);
+		return 1;
+	}
+	if (method != EC_MSM_METHOD_STRAUS && method != EC_MSM_METHOD_PIPPENGER)
+		return 0;
+	if (!count) {
+		msm_point_set_infinity(out);
+		return 1;
+	}
+	if (!scratch || ((unsigned long) scratch & 7UL)
+			|| scratch_bytelen < elliptic_curve_msm_scratch_bytelen(curve, count, bytelen, method))
+		return 0;
+
+	if (method == EC_MSM_METHOD_STRAUS)
+		msm_straus(curve, out, points, scalars, count, bytelen, (unsigned char*) scratch);
+	else
+		msm_pippenger(curve, out, points, scalars, count, bytelen, (unsigned char*) scratch);
+	return 1;
+}
@@ -0,0 +1,58 @@
+#ifndef ELLIPTIC_CURVE_MSM_H_
+#define ELLIPTIC_CURVE_MSM_H_
+
+#include "elliptic_curve.h"
+
+// Multi-scalar multiplication: out = sum of scalars[i] * points[i].
+//
+// All terms share one chain of doublings instead of one per term.
+//  - Straus (interleaved wNAF): per-term tables of odd multiples, cheapest
+//    for a handful of terms.
+//  - Pippenger (signed buckets): no per-term tables, per-window bucket sums;
+//    wins once the number of terms gets large.
+//  - Joint sparse form: two terms only, 4 precomputed points and the lowest
+//    joint weight of any signed binary representation.
+// EC_MSM_METHOD_AUTO picks by an operation-count estimate.
+//
+// These are variable-time routines meant for public scalars (signature
+// verification, batch checks); use elliptic_curve_binary_point_multiply_ct
+// for secrets.
+//
+// Nothing is allocated: the caller supplies an 8-byte aligned scratch area
+// of elliptic_curve_msm_scratch_bytelen() bytes.
+
+#define EC_MSM_METHOD_AUTO      (0)
+#define EC_MSM_METHOD_STRAUS    (1)
+#define EC_MSM_METHOD_PIPPENGER (2)
+#define EC_MSM_METHOD_JSF       (3)     // count == 2 only, needs no scratch
+
+#ifndef EC_MSM_STRAUS_MAX_WIDTH
+#define EC_MSM_STRAUS_MAX_WIDTH (6)     // table of 2^(w-2) points per term
+#endif
+#ifndef EC_MSM_PIPPENGER_MAX_WINDOW
+#define EC_MSM_PIPPENGER_MAX_WINDOW (12) // 2^(c-1) buckets
+#endif
+
+// Method EC_MSM_METHOD_AUTO would choose for these sizes.
+int elliptic_curve_msm_select_method(unsigned long count, unsigned long bytelen);
+
+// Scratch bytes needed by elliptic_curve_msm() for this method and size.
+unsigned long elliptic_curve_msm_scratch_bytelen(const EllipticCurve *curve,
+		unsigned long count, unsigned long bytelen, int method);
+
+// scalars[i] are bytelen bytes, LSB first. Returns 1 on success, 0 on bad
+// arguments or a scratch area that is too small (out is then untouched).
+int elliptic_curve_msm(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const EllipticCurvePoint *const *points,
+		const unsigned char *const *scalars, unsigned long count,
+		unsigned long bytelen, int method,
+		void *scratch, unsigned long scratch_bytelen);
+
+// out = exp1 * in1 + exp2 * in2 via the joint sparse form, stack only.
+// bytelen above GF2_VECTOR_MAX_BYTELEN gives the point at infinity.
+void elliptic_curve_msm2(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const EllipticCurvePoint *in1, const unsigned char *exp1,
+		const EllipticCurvePoint *in2, const unsigned char *exp2,
+		unsigned long bytelen);
+
+#endif /* ELLIPTIC_CURVE_MSM_H_ */
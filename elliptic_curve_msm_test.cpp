@@ -0,0 +1,170 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "elliptic_curve_msm.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x1D872B41UL)
+#include "ec_test_util.h"
+
+// count random multiples of G and random scalars (a few of them degenerate)
+static void msm_test_make_terms(const EllipticCurve *curve, unsigned long count,
+		std::vector<EllipticCurvePoint> &points,
+		std::vector<std::vector<unsigned char> > &scalars) {
+	unsigned long len = curve->field_size_bytes;
+	points.assign(count, EllipticCurvePoint());
+	scalars.assign(count, std::vector<unsigned char>(len, 0));
+	for (unsigned long t = 0; t < count; ++t) {
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		k[0] = (unsigned char) (t + 2);
+		k[1] = ec_test_random_byte();
+		elliptic_curve_binary_point_multiply_base(curve, &points[t], k, len);
+		for (unsigned long i = 0; i + 1 < len; ++i)
+			scalars[t][i] = ec_test_random_byte();
+	}
+	if (count > 2) {
+		scalars[1].assign(len, 0);      // zero scalar
+		points[2] = points[0];          // repeated point
+	}
+}
+
+static void msm_test_reference(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const std::vector<EllipticCurvePoint> &points,
+		const std::vector<std::vector<unsigned char> > &scalars) {
+	EllipticCurvePoint acc = { }, term = { };
+	for (unsigned long t = 0; t < points.size(); ++t) {
+		elliptic_curve_binary_point_multiply(curve, &term, &points[t],
+				scalars[t].data(), curve->field_size_bytes);
+		elliptic_curve_binary_point_add(curve, &acc, &acc, &term);
+	}
+	*out = acc;
+}
+
+static int msm_test_run(const EllipticCurve *curve, EllipticCurvePoint *out,
+		const std::vector<EllipticCurvePoint> &points,
+		const std::vector<std::vector<unsigned char> > &scalars, int method) {
+	unsigned long count = points.size();
+	unsigned long len = curve->field_size_bytes;
+	std::vector<const EllipticCurvePoint*> point_ptrs(count);
+	std::vector<const unsigned char*> scalar_ptrs(count);
+	for (unsigned long t = 0; t < count; ++t) {
+		point_ptrs[t] = &points[t];
+		scalar_ptrs[t] = scalars[t].data();
+	}
+	unsigned long bytes = elliptic_curve_msm_scratch_bytelen(curve, count, len, method);
+	std::vector<unsigned long long> scratch(bytes / 8 + 1);
+	return elliptic_curve_msm(curve, out, point_ptrs.data(), scalar_ptrs.data(),
+			count, len, method, scratch.data(), bytes);
+}
+
+int test_elliptic_curve_msm() {
+	int failures = 0;
+	std::cout << "\n--- Testing multi-scalar multiplication against separate multiplies ---\n";
+	const unsigned long counts[] = { 1, 2, 3, 7, 24 };
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); c += 3) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		int ok = 1;
+		for (unsigned long n = 0; n < sizeof(counts) / sizeof(counts[0]); ++n) {
+			std::vector<EllipticCurvePoint> points;
+			std::vector<std::vector<unsigned char> > scalars;
+			EllipticCurvePoint expected = { };
+			msm_test_make_terms(curve, counts[n], points, scalars);
+			msm_test_reference(curve, &expected, points, scalars);
+
+			const int methods[] = { EC_MSM_METHOD_AUTO, EC_MSM_METHOD_STRAUS,
+					EC_MSM_METHOD_PIPPENGER, EC_MSM_METHOD_JSF };
+			for (int m = 0; m < 4; ++m) {
+				EllipticCurvePoint result = { };
+				int accepted = msm_test_run(curve, &result, points, scalars, methods[m]);
+				if (methods[m] == EC_MSM_METHOD_JSF && counts[n] != 2) {
+					ok &= !accepted;
+					continue;
+				}
+				ok &= accepted && ec_test_points_equal(curve, &result, &expected);
+			}
+		}
+
+		// a G + b G with b = n - a must give O through every method
+		std::vector<EllipticCurvePoint> points(2);
+		std::vector<std::vector<unsigned char> > scalars(2,
+				std::vector<unsigned char>(curve->field_size_bytes, 0));
+		unsigned int borrow = 0;
+		for (unsigned long i = 0; i < curve->field_size_bytes; ++i) {
+			scalars[0][i] = (i + 2 < curve->field_size_bytes) ? ec_test_random_byte() : 0;
+			unsigned int diff = curve->order[i] - scalars[0][i] - borrow;
+			scalars[1][i] = (unsigned char) diff;
+			borrow = (diff >> 8) & 1;
+		}
+		for (unsigned long i = 0; i < curve->field_size_bytes; ++i) {
+			elliptic_curve_point_get_coord_x(curve, &points[0])[i] = curve->xG[i];
+			elliptic_curve_point_get_coord_y(curve, &points[0])[i] = curve->yG[i];
+		}
+		points[1] = points[0];
+		for (int m = EC_MSM_METHOD_STRAUS; m <= EC_MSM_METHOD_JSF; ++m) {
+			EllipticCurvePoint result = { }, infinity = { };
+			result.point_mem[0] = 0x5A;
+			ok &= msm_test_run(curve, &result, points, scalars, m)
+					&& ec_test_points_equal(curve, &result, &infinity);
+		}
+		// Oversized scalars are refused by the direct JSF entry point too
+		EllipticCurvePoint result = { }, infinity = { };
+		result.point_mem[0] = 0x5A;
+		elliptic_curve_msm2(curve, &result, &points[0], scalars[0].data(), &points[1],
+				scalars[1].data(), GF2_VECTOR_MAX_BYTELEN + 1);
+		ok &= ec_test_points_equal(curve, &result, &infinity);
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+void benchmark_elliptic_curve_msm() {
+	const unsigned long counts[] = { 2, 4, 16, 64, 256 };
+	std::cout << "\n--- Benchmark: multi-scalar multiplication (ms per linear combination) ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		if (c && curve->field_size_bytes == elliptic_curve_registry_get(c - 1)->curve->field_size_bytes)
+			continue;   // one curve per field size
+		std::cout << (const char*) curve->curve_name_ascii << "\n" << std::right
+				<< std::setw(6) << "terms" << std::setw(12) << "separate"
+				<< std::setw(12) << "Straus" << std::setw(12) << "Pippenger"
+				<< std::setw(12) << "JSF" << "   auto\n";
+		for (unsigned long n = 0; n < sizeof(counts) / sizeof(counts[0]); ++n) {
+			std::vector<EllipticCurvePoint> points;
+			std::vector<std::vector<unsigned char> > scalars;
+			EllipticCurvePoint result = { };
+			msm_test_make_terms(curve, counts[n], points, scalars);
+
+			double ms[4] = { 0, 0, 0, 0 };
+			auto t0 = std::chrono::steady_clock::now();
+			auto t1 = t0;
+			if (counts[n] <= 16) {
+				msm_test_reference(curve, &result, points, scalars);
+				t1 = std::chrono::steady_clock::now();
+				ms[0] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+			}
+			for (int m = EC_MSM_METHOD_STRAUS; m <= EC_MSM_METHOD_JSF; ++m) {
+				if (m == EC_MSM_METHOD_JSF && counts[n] != 2)
+					continue;
+				t0 = std::chrono::steady_clock::now();
+				msm_test_run(curve, &result, points, scalars, m);
+				t1 = std::chrono::steady_clock::now();
+				ms[m] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+			}
+			std::cout << std::setw(6) << counts[n] << std::fixed << std::setprecision(2);
+			for (int m = 0; m < 4; ++m) {
+				if (ms[m] > 0)
+					std::cout << std::setw(12) << ms[m];
+				else
+					std::cout << std::setw(12) << "-";
+			}
+			std::cout << "   " << ((elliptic_curve_msm_select_method(counts[n],
+					curve->field_size_bytes) == EC_MSM_METHOD_STRAUS) ? "Straus" : "Pippenger")
+					<< "\n";
+		}
+	}
+}
@@ -0,0 +1,157 @@
+#include "elliptic_curve_normal.h"
+#include "elliptic_curve_scalar.h"
+
+// Affine points in the normal basis; (0, 0) is the point at infinity, as in
+// the polynomial basis (0 is 0 in both).
+typedef struct alignas(8){
+	unsigned char x[GF2_VECTOR_MAX_BYTELEN];
+	unsigned char y[GF2_VECTOR_MAX_BYTELEN];
+}NormalPoint;
+
+typedef struct {
+	const GF2NormalBasis *basis;
+	unsigned long len;
+	unsigned char a[GF2_VECTOR_MAX_BYTELEN];    // a, normal basis
+	unsigned char one[GF2_VECTOR_MAX_BYTELEN];  // 1, normal basis
+}NormalCurve;
+
+static int normal_is_zero(const unsigned char *in, unsigned long len) {
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < len; ++i)
+		acc |= in[i];
+	return acc == 0;
+}
+
+static int normal_equal(const unsigned char *a, const unsigned char *b, unsigned long len) {
+	unsigned char acc = 0;
+	for (unsigned long i = 0; i < len; ++i)
+		acc |= a[i] ^ b[i];
+	return acc == 0;
+}
+
+// lambda = x1 + y1 / x1, x3 = lambda^2 + lambda + a, y3 = x1^2 + (lambda + 1) x3
+static void normal_point_double(const NormalCurve *nc, NormalPoint *out,
+		const NormalPoint *in) {
+	unsigned long len = nc->len;
+	alignas(8) unsigned char lambda[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char x3[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char t[GF2_VECTOR_MAX_BYTELEN];
+
+	if (normal_is_zero(in->x, len)) {
+		for (unsigned long i = 0; i < len; ++i)
+			out->x[i] = out->y[i] = 0;
+		return;
+	}
+	gf2_normal_inverse(in->x, t, nc->basis);
+	gf2_normal_multiply(in->y, t, lambda, nc->basis);
+	for (unsigned long i = 0; i < len; ++i)
+		lambda[i] ^= in->x[i];
+	gf2_normal_square(lambda, x3, nc->basis);
+	for (unsigned long i = 0; i < len; ++i) {
+		x3[i] ^= lambda[i] ^ nc->a[i];
+		lambda[i] ^= nc->one[i];
+	}
+	gf2_normal_multiply(lambda, x3, t, nc->basis);
+	gf2_normal_square(in->x, lambda, nc->basis);
+	for (unsigned long i = 0; i < len; ++i) {
+		out->x[i] = x3[i];
+		out->y[i] = t[i] ^ lambda[i];
+	}
+}
+
+// lambda = (y1 + y2) / (x1 + x2), x3 = lambda^2 + lambda + x1 + x2 + a,
+// y3 = lambda (x1 + x3) + x3 + y1
+static void normal_point_add(const NormalCurve *nc, NormalPoint *out,
+		const NormalPoint *p, const NormalPoint *q) {
+	unsigned long len = nc->len;
+	alignas(8) unsigned char lambda[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char x3[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char dx[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char t[GF2_VECTOR_MAX_BYTELEN];
+
+	if (normal_is_zero(p->x, len) && normal_is_zero(p->y, len)) {
+		*out = *q;
+		return;
+	}
+	if (normal_is_zero(q->x, len) && normal_is_zero(q->y, len)) {
+		*out = *p;
+		return;
+	}
+	if (normal_equal(p->x, q->x, len)) {
+		if (normal_equal(p->y, q->y, len)) {
+			normal_point_double(nc, out, p);
+		} else {                            // q = -p
+			for (unsigned long i = 0; i < len; ++i)
+				out->x[i] = out->y[i] = 0;
+		}
+		return;
+	}
+	for (unsigned long i = 0; i < len; ++i) {
+		dx[i] = p->x[i] ^ q->x[i];
+		t[i] = p->y[i] ^ q->y[i];
+	}
+	gf2_normal_inverse(dx, x3, nc->basis);
+	gf2_normal_multiply(t, x3, lambda, nc->basis);
+	gf2_normal_square(lambda, x3, nc->basis);
+	for (unsigned long i = 0; i < len; ++i) {
+		x3[i] ^= lambda[i] ^ dx[i] ^ nc->a[i];
+		t[i] = p->x[i] ^ x3[i];
+	}
+	gf2_normal_multiply(lambda, t, t, nc->basis);
+	for (unsigned long i = 0; i < len; ++i) {
+		out->y[i] = t[i] ^ x3[i] ^ p->y[i];
+		out->x[i] = x3[i];
+	}
+}
+
+int elliptic_curve_normal_basis_init(const EllipticCurve *curve,
+		GF2NormalBasis *basis) {
+	return gf2_normal_basis_init(basis, curve->modulus, curve->field_size_bytes);
+}
+
+void elliptic_curve_binary_point_multiply_normal(const EllipticCurve *curve,
+		const GF2NormalBasis *basis, EllipticCurvePoint *out,
+		const EllipticCurvePoint *in, const unsigned char *exp,
+		unsigned long bytelen) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	NormalCurve nc;
+	NormalPoint p, acc = { };
+
+	nc.basis = basis;
+	nc.len = len;
+	gf2_normal_from_polynomial(curve->a, nc.a, basis);
+	gf2_normal_one(nc.one, basis);
+	gf2_normal_from_polynomial(in->point_mem, p.x, basis);
+	gf2_normal_from_polynomial(in->point_mem + y_offset, p.y, basis);
+
+	if (elliptic_curve_binary_is_koblitz(curve)) {
+		// k P = sum of digits[i] tau^i P, tau(x, y) = (x^2, y^2)
+		signed char digits[EC_MULTIPLY_MAX_DIGITS];
+		long count = elliptic_curve_scalar_recode_tnaf(curve, exp, bytelen, digits);
+		NormalPoint neg;
+		for (unsigned long i = 0; i < len; ++i) {
+			neg.x[i] = p.x[i];
+			neg.y[i] = p.x[i] ^ p.y[i];
+		}
+		for (long i = count - 1; i >= 0; --i) {
+			gf2_normal_square(acc.x, acc.x, basis);
+			gf2_normal_square(acc.y, acc.y, basis);
+			if (digits[i] > 0)
+				normal_point_add(&nc, &acc, &acc, &p);
+			else if (digits[i] < 0)
+				normal_point_add(&nc, &acc, &acc, &neg);
+		}
+		for (long i = 0; i < count; ++i)
+			digits[i] = 0;
+	} else {
+		for (long bit = 8 * (long) bytelen - 1; bit >= 0; --bit) {
+			normal_point_double(&nc, &acc, &acc);
+			if ((exp[bit >> 3] >> (bit & 7)) & 1)
+				normal_point_add(&nc, &acc, &acc, &p);
+		}
+	}
+
+	gf2_normal_to_polynomial(acc.x, out->point_mem, basis);
+	gf2_normal_to_polynomial(acc.y, out->point_mem + y_offset, basis);
+}
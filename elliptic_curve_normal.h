@@ -0,0 +1,34 @@
+#ifndef ELLIPTIC_CURVE_NORMAL_H_
+#define ELLIPTIC_CURVE_NORMAL_H_
+
+#include "elliptic_curve.h"
+#include "galois_field2_normal.h"
+
+// Point multiplication with the field in a Gaussian normal basis
+// (galois_field2_normal.h).
+//
+// Points keep the library's polynomial-basis layout: the input point and the
+// curve coefficient a are converted on the way in, the result on the way
+// out, so public keys and shared secrets are byte for byte the same as with
+// elliptic_curve_binary_point_multiply.
+//
+// Inside, the formulas are affine: every addition and doubling pays one
+// Itoh-Tsujii inversion, whose squarings are rotations. Koblitz curves use
+// tau-and-add on the tau-adic NAF, the Frobenius map being two rotations;
+// other curves double-and-add. Variable time, like
+// elliptic_curve_binary_point_multiply.
+//
+// The basis is caller storage (sizeof(GF2NormalBasis), about 21 KB at
+// 32-byte vectors), built once per curve.
+
+// Returns 1 if the curve's field has a supported normal basis.
+int elliptic_curve_normal_basis_init(const EllipticCurve *curve,
+		GF2NormalBasis *basis);
+
+// out = exp * in, exp bytelen bytes LSB first; out may alias in.
+void elliptic_curve_binary_point_multiply_normal(const EllipticCurve *curve,
+		const GF2NormalBasis *basis, EllipticCurvePoint *out,
+		const EllipticCurvePoint *in, const unsigned char *exp,
+		unsigned long bytelen);
+
+#endif /* ELLIPTIC_CURVE_NORMAL_H_ */
@@ -0,0 +1,188 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "elliptic_curve_normal.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x6E6F0043UL)
+#include "ec_test_util.h"
+
+static GF2NormalBasis normal_test_basis;
+
+// Field operations in the normal basis against the polynomial basis (through
+// the conversions), then point multiplication against
+// elliptic_curve_binary_point_multiply on every registry curve.
+int test_elliptic_curve_normal() {
+	int failures = 0;
+	std::cout << "\n--- Testing the Gaussian normal basis against the polynomial basis ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		const GF2NormalBasis *basis = &normal_test_basis;
+		unsigned long len = curve->field_size_bytes;
+		const unsigned char *mod = curve->modulus;
+		int ok = elliptic_curve_normal_basis_init(curve, &normal_test_basis);
+
+		// 1 is all ones, and converts back to 1
+		alignas(8) unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char an[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char bn[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char r1[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char r2[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char rn[GF2_VECTOR_MAX_BYTELEN] = { };
+		if (ok) {
+			a[0] = 1;
+			gf2_normal_from_polynomial(a, an, basis);
+			gf2_normal_one(rn, basis);
+			ok &= ec_test_bytes_equal(an, rn, len);
+			gf2_normal_to_polynomial(rn, r1, basis);
+			ok &= ec_test_bytes_equal(a, r1, len);
+		}
+
+		for (int iter = 0; ok && iter < 16; ++iter) {
+			ec_test_random_element(a, curve->field_size_bytes, (long) curve->binary_degree);
+			ec_test_random_element(b, curve->field_size_bytes, (long) curve->binary_degree);
+			gf2_normal_from_polynomial(a, an, basis);
+			gf2_normal_from_polynomial(b, bn, basis);
+			gf2_normal_to_polynomial(an, r1, basis);
+			ok &= ec_test_bytes_equal(a, r1, len);
+
+			gf2_field_multiply_lsb(a, b, r1, len, mod, 0);
+			gf2_normal_multiply(an, bn, rn, basis);
+			gf2_normal_to_polynomial(rn, r2, basis);
+			ok &= ec_test_bytes_equal(r1, r2, len);
+
+			gf2_field_square_lsb(a, r1, len, mod, 0);
+			gf2_normal_square(an, rn, basis);
+			gf2_normal_to_polynomial(rn, r2, basis);
+			ok &= ec_test_bytes_equal(r1, r2, len);
+
+			gf2_sqrt_lsb(a, r1, len, mod);
+			gf2_normal_sqrt(an, rn, basis);
+			gf2_normal_to_polynomial(rn, r2, basis);
+			ok &= ec_test_bytes_equal(r1, r2, len);
+
+			// a^8 both ways; a^(2^m) = a
+			gf2_field_square_lsb(a, r1, len, mod, 0);
+			gf2_field_square_lsb(r1, r1, len, mod, 0);
+			gf2_field_square_lsb(r1, r1, len, mod, 0);
+			gf2_normal_frobenius(an, rn, 3, basis);
+			gf2_normal_to_polynomial(rn, r2, basis);
+			ok &= ec_test_bytes_equal(r1, r2, len);
+			gf2_normal_frobenius(an, rn, basis->degree, basis);
+			ok &= ec_test_bytes_equal(an, rn, len);
+
+			gf2_binary_inverse_lsb(a, r1, len, mod);
+			gf2_normal_inverse(an, rn, basis);
+			gf2_normal_to_polynomial(rn, r2, basis);
+			ok &= ec_test_bytes_equal(r1, r2, len);
+
+			ok &= gf2_trace_lsb(a, len, mod) == gf2_normal_trace(an, basis);
+		}
+
+		EllipticCurvePoint G = { }, R1 = { }, R2 = { };
+		ec_test_load_base(curve, &G);
+		for (int iter = 0; ok && iter < 4; ++iter) {
+			unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+			for (unsigned long i = 0; i + 1 < len; ++i)
+				k[i] = ec_test_random_byte();
+			if (iter == 0)
+				for (unsigned long i = 0; i < len; ++i)
+					k[i] = (unsigned char) (i == 0);
+			elliptic_curve_binary_point_multiply(curve, &R1, &G, k, len);
+			elliptic_curve_binary_point_multiply_normal(curve, basis, &R2, &G, k, len);
+			ok &= ec_test_bytes_equal(R1.point_mem, R2.point_mem,
+					elliptic_curve_point_get_coord_full_bytelen(curve));
+		}
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Per curve: field operations and point multiplication, polynomial basis vs.
+// normal basis, plus the basis construction time. The polynomial-basis
+// inverse is the binary extended Euclid; the normal-basis one Itoh-Tsujii.
+void benchmark_elliptic_curve_normal() {
+	const int field_runs = 2000;
+	const int point_runs = 5;
+	std::cout << "\n--- Benchmark: polynomial basis / normal basis ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::setw(6) << "type"
+			<< std::right << std::setw(10) << "init us" << std::setw(16) << "mul ns"
+			<< std::setw(16) << "sqr ns" << std::setw(16) << "sqrt ns"
+			<< std::setw(18) << "inv ns" << std::setw(18) << "k*P us" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+		const GF2ReductionDescriptor *desc = (ctx->flags & EC_CONTEXT_FLAG_SPARSE_REDUCTION)
+				? &ctx->reduction : 0;
+		const GF2NormalBasis *basis = &normal_test_basis;
+		unsigned long len = curve->field_size_bytes;
+		const unsigned char *mod = curve->modulus;
+
+		auto t0 = std::chrono::steady_clock::now();
+		int ok = elliptic_curve_normal_basis_init(curve, &normal_test_basis);
+		auto t1 = std::chrono::steady_clock::now();
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii;
+		if (!ok) {
+			std::cout << "no basis\n";
+			continue;
+		}
+		std::cout << std::setw(6) << basis->type << std::right << std::fixed
+				<< std::setprecision(0) << std::setw(10)
+				<< std::chrono::duration<double, std::micro>(t1 - t0).count();
+
+		alignas(8) unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char an[GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char bn[GF2_VECTOR_MAX_BYTELEN] = { };
+		ec_test_random_element(a, curve->field_size_bytes, (long) curve->binary_degree);
+		ec_test_random_element(b, curve->field_size_bytes, (long) curve->binary_degree);
+		gf2_normal_from_polynomial(a, an, basis);
+		gf2_normal_from_polynomial(b, bn, basis);
+
+		double ns[8];
+		for (int op = 0; op < 8; ++op) {
+			auto s0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < field_runs; ++r) {
+				switch (op) {
+				case 0: gf2_field_multiply_lsb(a, b, a, len, mod, desc); break;
+				case 1: gf2_normal_multiply(an, bn, an, basis); break;
+				case 2: gf2_field_square_lsb(a, a, len, mod, desc); break;
+				case 3: gf2_normal_square(an, an, basis); break;
+				case 4: gf2_sqrt_lsb(a, a, len, mod); break;
+				case 5: gf2_normal_sqrt(an, an, basis); break;
+				case 6: gf2_binary_inverse_lsb(b, a, len, mod); b[0] ^= a[0]; break;
+				default: gf2_normal_inverse(bn, an, basis); bn[0] ^= an[0]; break;
+				}
+			}
+			auto s1 = std::chrono::steady_clock::now();
+			ns[op] = std::chrono::duration<double, std::nano>(s1 - s0).count() / field_runs;
+		}
+		for (int op = 0; op < 8; op += 2)
+			std::cout << std::setw(op < 6 ? 9 : 11) << ns[op] << " /" << std::setw(5) << ns[op + 1];
+
+		EllipticCurvePoint G = { }, R = { };
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		ec_test_load_base(curve, &G);
+		for (unsigned long i = 0; i + 1 < len; ++i)
+			k[i] = (unsigned char) (0x6B * (i + 3));
+		double micros[2];
+		for (int v = 0; v < 2; ++v) {
+			auto s0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < point_runs; ++r) {
+				if (v == 0)
+					elliptic_curve_binary_point_multiply(curve, &R, &G, k, len);
+				else
+					elliptic_curve_binary_point_multiply_normal(curve, basis, &R, &G, k, len);
+			}
+			auto s1 = std::chrono::steady_clock::now();
+			micros[v] = std::chrono::duration<double, std::micro>(s1 - s0).count() / point_runs;
+		}
+		std::cout << std::setw(10) << micros[0] << " /" << std::setw(6) << micros[1] << "\n";
+	}
+}
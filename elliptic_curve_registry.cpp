@@ -0,0 +1,467 @@
+#include "elliptic_curve_registry.h"
+#include "elliptic_curve_context.h"
+
+// Parameters from SEC 2 v2 / FIPS 186-4 D.1.3, stored LSB-first like every
+// other GF(2) vector in this library. With EC_REGISTRY_CONTEXTS every curve
+// owns a zero-initialized acceleration context, built on first use.
+
+#if EC_REGISTRY_CONTEXTS
+#define REGISTRY_CONTEXT(name) static EllipticCurveContext registry_context_##name;
+#define REGISTRY_CONTEXT_PTR(name) (&registry_context_##name)
+#else
+#define REGISTRY_CONTEXT(name)
+#define REGISTRY_CONTEXT_PTR(name) (0)
+#endif
+
+#if GF2_VECTOR_MAX_BYTELEN > 21
+REGISTRY_CONTEXT(sect163k1)
+static const EllipticCurve registry_curve_sect163k1 = {
+		{ 0x01 }, // a
+		{ 0x01 }, // b
+		{ // xG
+			0xE8, 0xEE, 0x94, 0x5C, 0x5E, 0x6D, 0x4E, 0xDE, 0x93, 0xD7, 0x07, 0xAA,
+			0xAC, 0x11, 0xBC, 0x7B, 0x53, 0xC0, 0x13, 0xFE, 0x02
+		},
+		{ // yG
+			0xD9, 0xA3, 0xDA, 0xCC, 0x38, 0xD5, 0x36, 0x05, 0x80, 0x2E, 0x1F, 0x32,
+			0x58, 0xFF, 0x38, 0x5D, 0xB0, 0x0F, 0x07, 0x89, 0x02
+		},
+		{ // modulus
+			0xC9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08
+		},
+		{ // order
+			0xEF, 0xA5, 0xF8, 0x99, 0x0D, 0xCC, 0xE0, 0xA2, 0x08, 0x01, 0x02, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04
+		},
+		{ 0x02 }, // cofactor
+		"sect163k1", 21UL, 163UL, REGISTRY_CONTEXT_PTR(sect163k1) };
+REGISTRY_CONTEXT(sect163r1)
+static const EllipticCurve registry_curve_sect163r1 = {
+		{ // a
+			0xE2, 0x2A, 0x78, 0xD2, 0x46, 0xE2, 0x88, 0xBD, 0x28, 0x84, 0xFF, 0x54,
+			0x95, 0x4F, 0xA8, 0xEF, 0xAA, 0x2C, 0x88, 0xB6, 0x07
+		},
+		{ // b
+			0xD9, 0xAF, 0x58, 0xF9, 0x3A, 0xF7, 0x91, 0xCA, 0x29, 0xDA, 0x6B, 0x94,
+			0xAB, 0x0A, 0xB4, 0xDC, 0xCD, 0x2D, 0x61, 0x13, 0x07
+		},
+		{ // xG
+			0x54, 0xA6, 0x76, 0x78, 0x7A, 0x78, 0x7F, 0x56, 0x89, 0x67, 0x56, 0x89,
+			0x77, 0x89, 0x43, 0xAB, 0x97, 0x96, 0x97, 0x69, 0x03
+		},
+		{ // yG
+			0x83, 0xF8, 0x1F, 0xF4, 0x88, 0x09, 0xC8, 0xE3, 0xFC, 0xFE, 0x51, 0x9D,
+			0x98, 0xB2, 0xAF, 0xEF, 0x42, 0xDB, 0x5E, 0x43, 0x00
+		},
+		{ // modulus
+			0xC9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08
+		},
+		{ // order
+			0x9B, 0x27, 0x10, 0xA7, 0x9C, 0xC2, 0x89, 0xB6, 0xAA, 0x48, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x03
+		},
+		{ 0x02 }, // cofactor
+		"sect163r1", 21UL, 163UL, REGISTRY_CONTEXT_PTR(sect163r1) };
+REGISTRY_CONTEXT(sect163r2)
+static const EllipticCurve registry_curve_sect163r2 = {
+		{ 0x01 }, // a
+		{ // b
+			0xFD, 0x05, 0x32, 0x4A, 0x74, 0x78, 0x2F, 0x51, 0x10, 0xEB, 0x81, 0x14,
+			0xCA, 0x53, 0xC9, 0xB8, 0x07, 0x19, 0x60, 0x0A, 0x02
+		},
+		{ // xG
+			0x36, 0x3E, 0x34, 0xE8, 0x37, 0x46, 0x99, 0xD4, 0x68, 0x11, 0x99, 0xA0,
+			0x7E, 0xD5, 0xA2, 0x86, 0x62, 0xA1, 0xEB, 0xF0, 0x03
+		},
+		{ // yG
+			0xF1, 0x24, 0x73, 0x79, 0x0C, 0x5C, 0x1C, 0xB1, 0x45, 0xD5, 0xCD, 0xA2,
+			0x4F, 0x09, 0xA0, 0x71, 0x6C, 0xBC, 0x1F, 0xD5, 0x00
+		},
+		{ // modulus
+			0xC9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08
+		},
+		{ // order
+			0x33, 0x4C, 0x23, 0xA4, 0x12, 0x0C, 0xE7, 0x77, 0xFE, 0x92, 0x02, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04
+		},
+		{ 0x02 }, // cofactor
+		"sect163r2", 21UL, 163UL, REGISTRY_CONTEXT_PTR(sect163r2) };
+#endif
+
+#if GF2_VECTOR_MAX_BYTELEN > 30
+REGISTRY_CONTEXT(sect233k1)
+static const EllipticCurve registry_curve_sect233k1 = {
+		{ 0x00 }, // a
+		{ 0x01 }, // b
+		{ // xG
+			0x26, 0x61, 0xAD, 0xEF, 0x6E, 0x9D, 0x4C, 0x0A, 0xF5, 0x6B, 0xC2, 0x19,
+			0xA4, 0x63, 0x95, 0x14, 0xF4, 0x2F, 0xF2, 0x29, 0xF1, 0x1A, 0x73, 0x7E,
+			0x3A, 0x85, 0xBA, 0x32, 0x72, 0x01
+		},
+		{ // yG
+			0xA3, 0xE6, 0xFA, 0x56, 0x10, 0xC1, 0xE0, 0x56, 0x9B, 0xEB, 0x8A, 0xF1,
+			0x9B, 0xCD, 0xA8, 0x27, 0xC4, 0x67, 0x5A, 0x55, 0x0F, 0xF7, 0xB7, 0x19,
+			0xE8, 0xEC, 0x7D, 0x53, 0xDB, 0x01
+		},
+		{ // modulus
+			0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x02
+		},
+		{ // order
+			0xDF, 0xAB, 0x73, 0xF1, 0xD5, 0x1A, 0xFB, 0x6E, 0xD4, 0xBC, 0x15, 0xB9,
+			0x5B, 0x9D, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x80, 0x00
+		},
+		{ 0x04 }, // cofactor
+		"sect233k1", 30UL, 233UL, REGISTRY_CONTEXT_PTR(sect233k1) };
+REGISTRY_CONTEXT(sect233r1)
+static const EllipticCurve registry_curve_sect233r1 = {
+		{ 0x01 }, // a
+		{ // b
+			0xAD, 0x90, 0x8F, 0x7D, 0x5F, 0x11, 0xFE, 0x81, 0x42, 0xCE, 0xE9, 0x20,
+			0x3B, 0x33, 0x3B, 0x21, 0x58, 0xBB, 0x23, 0x09, 0x8C, 0x7F, 0x2C, 0x33,
+			0x6C, 0xDE, 0x7E, 0x64, 0x66, 0x00
+		},
+		{ // xG
+			0x8B, 0x55, 0xFD, 0x71, 0x73, 0xEB, 0xF8, 0xF8, 0x36, 0x8B, 0x1F, 0x39,
+			0xBC, 0x65, 0xEF, 0x5F, 0x75, 0xBB, 0xF1, 0x39, 0x21, 0xBB, 0x13, 0x83,
+			0xAC, 0xCB, 0xDF, 0xC9, 0xFA, 0x00
+		},
+		{ // yG
+			0x52, 0x10, 0xF8, 0x01, 0x7E, 0x6F, 0x71, 0x36, 0xCA, 0xA7, 0x67, 0xF8,
+			0xEF, 0x0B, 0x8A, 0xBF, 0xBE, 0x28, 0x85, 0xE5, 0x78, 0x06, 0x35, 0x03,
+			0x19, 0xA4, 0x08, 0x6A, 0x00, 0x01
+		},
+		{ // modulus
+			0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x02
+		},
+		{ // order
+			0xD7, 0xE0, 0xCF, 0x03, 0x26, 0x1D, 0x03, 0x22, 0x69, 0x8A, 0x2F, 0xE7,
+			0x74, 0xE9, 0x13, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x01
+		},
+		{ 0x02 }, // cofactor
+		"sect233r1", 30UL, 233UL, REGISTRY_CONTEXT_PTR(sect233r1) };
+#endif
+
+#if GF2_VECTOR_MAX_BYTELEN > 36
+REGISTRY_CONTEXT(sect283k1)
+static const EllipticCurve registry_curve_sect283k1 = {
+		{ 0x00 }, // a
+		{ 0x01 }, // b
+		{ // xG
+			0x36, 0x28, 0x49, 0x58, 0x24, 0xAC, 0xC2, 0xB0, 0x13, 0x69, 0x87, 0x16,
+			0x7A, 0x56, 0xC1, 0x23, 0x5F, 0x26, 0xCD, 0x53, 0xE5, 0x88, 0xF1, 0x62,
+			0x81, 0x3B, 0x1A, 0x3F, 0x88, 0x44, 0xCA, 0x78, 0x3F, 0x21, 0x03, 0x05
+		},
+		{ // yG
+			0x59, 0x22, 0xDD, 0x77, 0x61, 0x11, 0x34, 0x4E, 0x36, 0x62, 0x59, 0xE4,
+			0x98, 0x46, 0x18, 0xE8, 0xC0, 0x45, 0x7E, 0xE8, 0x6F, 0x42, 0xE5, 0x07,
+			0x5D, 0xF9, 0x90, 0x8D, 0x31, 0x9E, 0x1C, 0x0F, 0x38, 0xDA, 0xCC, 0x01
+		},
+		{ // modulus
+			0xA1, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08
+		},
+		{ // order
+			0x61, 0x3C, 0x16, 0x1E, 0x06, 0x1E, 0x45, 0x94, 0x7F, 0xFF, 0x5D, 0x26,
+			0x77, 0x75, 0xD0, 0x2E, 0xAE, 0xE9, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01
+		},
+		{ 0x04 }, // cofactor
+		"sect283k1", 36UL, 283UL, REGISTRY_CONTEXT_PTR(sect283k1) };
+REGISTRY_CONTEXT(sect283r1)
+static const EllipticCurve registry_curve_sect283r1 = {
+		{ 0x01 }, // a
+		{ // b
+			0xF5, 0xA2, 0x79, 0x3B, 0x31, 0x3E, 0x26, 0xF6, 0x5A, 0x48, 0x81, 0xA5,
+			0xA2, 0x9F, 0x30, 0x45, 0x76, 0xFD, 0x97, 0xCA, 0x3F, 0x30, 0xA0, 0x19,
+			0x8A, 0xAF, 0xA4, 0xA5, 0x6D, 0x59, 0xB8, 0xC8, 0x0A, 0x68, 0x7B, 0x02
+		},
+		{ // xG
+			0x53, 0x20, 0xB1, 0x86, 0xCD, 0xBE, 0xCD, 0xF8, 0x98, 0xE1, 0xE2, 0x80,
+			0x9C, 0xAC, 0x7E, 0x55, 0xB8, 0x25, 0xED, 0x2E, 0xEC, 0xDF, 0xB0, 0x70,
+			0x8C, 0x4F, 0x93, 0xE1, 0x90, 0xDD, 0xB7, 0x8D, 0x25, 0x39, 0xF9, 0x05
+		},
+		{ // yG
+			0xF4, 0x12, 0x81, 0xBE, 0x45, 0xDF, 0xF0, 0x13, 0xC8, 0x79, 0x67, 0x82,
+			0xB0, 0xDD, 0x0E, 0x35, 0x02, 0xF7, 0x6F, 0x51, 0xB4, 0x02, 0x0D, 0xB2,
+			0xD4, 0xE6, 0x8F, 0xB9, 0x1C, 0x14, 0x24, 0xFE, 0x54, 0x68, 0x67, 0x03
+		},
+		{ // modulus
+			0xA1, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08
+		},
+		{ // order
+			0x07, 0xB3, 0xAD, 0xEF, 0x7C, 0x2A, 0x04, 0x5B, 0x16, 0x90, 0x8A, 0x93,
+			0xFC, 0x60, 0x96, 0x39, 0x90, 0xEF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x03
+		},
+		{ 0x02 }, // cofactor
+		"sect283r1", 36UL, 283UL, REGISTRY_CONTEXT_PTR(sect283r1) };
+#endif
+
+#if GF2_VECTOR_MAX_BYTELEN > 52
+REGISTRY_CONTEXT(sect409k1)
+static const EllipticCurve registry_curve_sect409k1 = {
+		{ 0x00 }, // a
+		{ 0x01 }, // b
+		{ // xG
+			0x46, 0x37, 0x02, 0xE9, 0xCF, 0x40, 0x55, 0xB3, 0xB1, 0x2E, 0x22, 0xEE,
+			0x62, 0xAA, 0xAA, 0xB5, 0x9E, 0x18, 0x60, 0xC4, 0xC2, 0x7C, 0xF6, 0xF9,
+			0xB8, 0xCF, 0xAC, 0x27, 0x4C, 0xC8, 0x07, 0xE3, 0x87, 0x09, 0xFD, 0x0E,
+			0x21, 0x84, 0x71, 0x0F, 0x89, 0xB1, 0x3A, 0xAD, 0xC1, 0x49, 0x8F, 0x65,
+			0x5F, 0xF0, 0x60, 0x00
+		},
+		{ // yG
+			0x6B, 0x28, 0xE0, 0xD8, 0x48, 0xEC, 0x63, 0x58, 0x7A, 0xA2, 0x9C, 0xAA,
+			0x15, 0x52, 0xC5, 0xE9, 0x42, 0x6C, 0x5F, 0xDA, 0xE3, 0x10, 0xEA, 0xE9,
+			0x65, 0x51, 0x32, 0xE6, 0x27, 0xA4, 0x8E, 0x91, 0x2F, 0x78, 0x60, 0x34,
+			0x9C, 0x29, 0x04, 0xBF, 0xAC, 0x1D, 0xBA, 0xAC, 0x42, 0x4E, 0x7C, 0x0B,
+			0x05, 0x69, 0xE3, 0x01
+		},
+		{ // modulus
+			0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x02
+		},
+		{ // order
+			0xCF, 0x5F, 0x1E, 0xE0, 0xB8, 0x83, 0x5C, 0x4B, 0x5B, 0xCA, 0xE7, 0xE3,
+			0xD3, 0x5E, 0x7D, 0x55, 0xC4, 0x0E, 0x40, 0x20, 0xEA, 0xD4, 0xB2, 0x83,
+			0x5F, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			0xFF, 0xFF, 0x7F, 0x00
+		},
+		{ 0x04 }, // cofactor
+		"sect409k1", 52UL, 409UL, REGISTRY_CONTEXT_PTR(sect409k1) };
+REGISTRY_CONTEXT(sect409r1)
+static const EllipticCurve registry_curve_sect409r1 = {
+		{ 0x01 }, // a
+		{ // b
+			0x5F, 0x54, 0x13, 0x7B, 0x31, 0xAE, 0x50, 0x4F, 0xAA, 0x55, 0x7A, 0xD5,
+			0x6C, 0x2F, 0x82, 0x72, 0xB2, 0x97, 0xA1, 0xA9, 0xC8, 0x27, 0xAC, 0xD6,
+			0x99, 0xFA, 0x61, 0x47, 0x67, 0xDD, 0xF3, 0xF1, 0x2E, 0x42, 0xD6, 0x7F,
+			0x6B, 0x47, 0x7B, 0x3B, 0x75, 0x9A, 0x4B, 0x5C, 0xEB, 0x9F, 0xEE, 0xC8,
+			0xC2, 0xA5, 0x21, 0x00
+		},
+		{ // xG
+			0xA7, 0x96, 0x79, 0xBB, 0x54, 0x4E, 0x79, 0x60, 0xAB, 0xAE, 0x03, 0x56,
+			0x51, 0x80, 0x11, 0x8A, 0x86, 0x5A, 0x25, 0xDC, 0x03, 0x97, 0xE5, 0x34,
+			0x5B, 0xFE, 0x1F, 0xB0, 0x4D, 0x1D, 0x77, 0xF1, 0x4A, 0xDE, 0x1C, 0x44,
+			0x60, 0x62, 0x75, 0x64, 0x60, 0x0C, 0x6B, 0x49, 0xB3, 0xDD, 0x88, 0xD0,
+			0x60, 0x48, 0x5D, 0x01
+		},
+		{ // yG
+			0x06, 0xC7, 0x73, 0x02, 0xBA, 0x64, 0xC3, 0x81, 0x36, 0x1B, 0x18, 0xD2,
+			0x40, 0x4F, 0x4B, 0xDF, 0x1F, 0x4F, 0x51, 0x38, 0x8F, 0xD0, 0x88, 0x54,
+			0x4F, 0xAA, 0x58, 0x01, 0x8D, 0x19, 0xBD, 0xA7, 0xC5, 0xB9, 0x36, 0x76,
+			0x6A, 0x10, 0xED, 0x24, 0x83, 0xA7, 0xBF, 0x2B, 0xF3, 0xE5, 0x6B, 0xAB,
+			0xCF, 0xB1, 0x61, 0x00
+		},
+		{ // modulus
+			0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x02
+		},
+		{ // order
+			0x73, 0x11, 0xA2, 0xD9, 0x37, 0xCD, 0x64, 0x81, 0x83, 0x2F, 0x05, 0x9E,
+			0x3C, 0x7C, 0xA4, 0x5F, 0xBE, 0x07, 0x33, 0xF3, 0x12, 0xA6, 0xD6, 0xAA,
+			0xE2, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x01
+		},
+		{ 0x02 }, // cofactor
+		"sect409r1", 52UL, 409UL, REGISTRY_CONTEXT_PTR(sect409r1) };
+#endif
+
+#if GF2_VECTOR_MAX_BYTELEN > 72
+REGISTRY_CONTEXT(sect571k1)
+static const EllipticCurve registry_curve_sect571k1 = {
+		{ 0x00 }, // a
+		{ 0x01 }, // b
+		{ // xG
+			0x72, 0x89, 0x1C, 0xA0, 0x83, 0x52, 0x94, 0xE2, 0xC7, 0x88, 0xCA, 0x4D,
+			0x17, 0x47, 0x8B, 0x98, 0xFB, 0x76, 0x47, 0x49, 0x39, 0xBA, 0xD1, 0xBB,
+			0x8C, 0xB0, 0xCE, 0xB4, 0x4D, 0x30, 0xDA, 0x47, 0xE6, 0x05, 0xB2, 0x93,
+			0x84, 0x95, 0x70, 0x43, 0xA4, 0x1C, 0x84, 0x01, 0x48, 0x80, 0x24, 0x60,
+			0xD4, 0xD5, 0x12, 0x00, 0x97, 0xA2, 0x9C, 0xAC, 0xE4, 0x3F, 0x10, 0xF8,
+			0x31, 0x96, 0x18, 0x82, 0xBC, 0x3F, 0x92, 0x59, 0xA8, 0xB7, 0x6E, 0x02
+		},
+		{ // yG
+			0xA3, 0xC7, 0xF1, 0x3E, 0x14, 0x4C, 0xCD, 0x01, 0xF6, 0x84, 0x19, 0x59,
+			0xC8, 0x30, 0x04, 0x32, 0x1B, 0xAF, 0xA7, 0x7B, 0x1A, 0xB0, 0x20, 0xB6,
+			0xDC, 0xAE, 0x72, 0xF7, 0xB9, 0xBB, 0xBE, 0x4F, 0xA7, 0xAE, 0x44, 0xAC,
+			0xC0, 0x79, 0x49, 0x9D, 0x2C, 0x8A, 0x6D, 0x00, 0xFC, 0x1E, 0xC6, 0xFF,
+			0x54, 0x7A, 0x30, 0x9F, 0xEC, 0x8C, 0xD5, 0x4D, 0x31, 0x95, 0xCA, 0x3B,
+			0xDE, 0xEA, 0x4A, 0x4F, 0x37, 0xBF, 0x4F, 0x7F, 0x80, 0xDC, 0x49, 0x03
+		},
+		{ // modulus
+			0x25, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08
+		},
+		{ // order
+			0x01, 0x10, 0x7C, 0x63, 0x8F, 0x77, 0xFE, 0x5C, 0xB4, 0xDE, 0x91, 0x1E,
+			0x38, 0x39, 0xD6, 0xE5, 0x4B, 0xD8, 0x30, 0xB6, 0x38, 0x41, 0x7F, 0x91,
+			0xDB, 0xA8, 0x91, 0xB3, 0xE4, 0x63, 0x9A, 0xF1, 0xE1, 0x50, 0x18, 0x13,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02
+		},
+		{ 0x04 }, // cofactor
+		"sect571k1", 72UL, 571UL, REGISTRY_CONTEXT_PTR(sect571k1) };
+REGISTRY_CONTEXT(sect571r1)
+static const EllipticCurve registry_curve_sect571r1 = {
+		{ 0x01 }, // a
+		{ // b
+			0x7A, 0x72, 0x55, 0x29, 0x7F, 0xFF, 0xFE, 0x7F, 0x0C, 0xCA, 0xBA, 0x39,
+			0xE7, 0x4D, 0x0E, 0x52, 0xAA, 0x12, 0xFF, 0x78, 0x5A, 0x18, 0xFD, 0x4A,
+			0x29, 0x6E, 0xA6, 0x56, 0x67, 0xAD, 0xE7, 0x2B, 0x33, 0x59, 0xFA, 0x8E,
+			0xBD, 0xAB, 0xFF, 0x84, 0xAD, 0x18, 0x9A, 0x4A, 0xCE, 0xA8, 0x6B, 0xCD,
+			0xF1, 0xEF, 0x8C, 0xCB, 0xFF, 0x97, 0x6A, 0x5C, 0x2F, 0xD6, 0xF3, 0xB7,
+			0x17, 0x71, 0x29, 0xDE, 0x95, 0xF2, 0x21, 0x22, 0x7E, 0x0E, 0xF4, 0x02
+		},
+		{ // xG
+			0x19, 0x2D, 0xEC, 0x8E, 0x9C, 0x76, 0xE7, 0xE1, 0x27, 0xD9, 0x50, 0xC8,
+			0xB4, 0xA3, 0xBF, 0x4A, 0x39, 0xF1, 0x14, 0x86, 0x03, 0x60, 0xAE, 0x99,
+			0x14, 0xFB, 0x67, 0x5B, 0xA3, 0x11, 0xD7, 0xCD, 0x93, 0xD2, 0xC0, 0xF4,
+			0x50, 0x39, 0xE5, 0xBD, 0xBD, 0x2A, 0x7B, 0xDB, 0xC8, 0x0F, 0xF4, 0xA5,
+			0x0A, 0xA8, 0x5F, 0x95, 0xD2, 0xD1, 0x93, 0x0A, 0x75, 0xD7, 0x3C, 0x0D,
+			0xD4, 0xC0, 0x16, 0x6C, 0x29, 0x56, 0xB8, 0x34, 0x1D, 0x00, 0x03, 0x03
+		},
+		{ // yG
+			0x5B, 0xC1, 0x8A, 0x1B, 0xAF, 0x27, 0x48, 0x1A, 0x3C, 0xDD, 0x23, 0x6E,
+			0x51, 0xF1, 0xE2, 0x16, 0x9B, 0xC1, 0x85, 0x04, 0x2F, 0x1D, 0x53, 0xB3,
+			0xA8, 0xB2, 0x1B, 0x46, 0x8F, 0xAF, 0x91, 0x62, 0x57, 0x8A, 0xB0, 0xBA,
+			0x43, 0x3E, 0x42, 0x84, 0xA6, 0xE8, 0x21, 0x39, 0x53, 0xF8, 0x80, 0x19,
+			0xCA, 0xBB, 0x9C, 0x00, 0xA6, 0x27, 0x6C, 0x8C, 0xD7, 0x69, 0x3D, 0xB7,
+			0xFE, 0xFF, 0xCC, 0x6D, 0x9B, 0x63, 0xDA, 0x42, 0x73, 0xF2, 0x7B, 0x03
+		},
+		{ // modulus
+			0x25, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08
+		},
+		{ // order
+			0x47, 0x4E, 0xE8, 0x2F, 0xBB, 0xE9, 0x82, 0x83, 0x6E, 0xD6, 0x74, 0x51,
+			0x3D, 0xE9, 0x1D, 0x16, 0xA1, 0x9C, 0xDD, 0xC7, 0x1E, 0x85, 0x23, 0x68,
+			0x18, 0x9B, 0x05, 0x08, 0x73, 0x98, 0x55, 0xFF, 0x18, 0xCE, 0x61, 0xE6,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x03
+		},
+		{ 0x02 }, // cofactor
+		"sect571r1", 72UL, 571UL, REGISTRY_CONTEXT_PTR(sect571r1) };
+#endif
+
+static const EllipticCurveRegistryEntry registry_entries[] = {
+#if GF2_VECTOR_MAX_BYTELEN > 21
+		{ "sect163k1", "K-163", "1.3.132.0.1", { 0x2B, 0x81, 0x04, 0x00, 0x01 }, 1,
+				&registry_curve_sect163k1, { 163, 3, { 7, 6, 3 } } },
+		{ "sect163r1", 0, "1.3.132.0.2", { 0x2B, 0x81, 0x04, 0x00, 0x02 }, 0,
+				&registry_curve_sect163r1, { 163, 3, { 7, 6, 3 } } },
+		{ "sect163r2", "B-163", "1.3.132.0.15", { 0x2B, 0x81, 0x04, 0x00, 0x0F }, 0,
+				&registry_curve_sect163r2, { 163, 3, { 7, 6, 3 } } },
+#endif
+#if GF2_VECTOR_MAX_BYTELEN > 30
+		{ "sect233k1", "K-233", "1.3.132.0.26", { 0x2B, 0x81, 0x04, 0x00, 0x1A }, 1,
+				&registry_curve_sect233k1, { 233, 1, { 74 } } },
+		{ "sect233r1", "B-233", "1.3.132.0.27", { 0x2B, 0x81, 0x04, 0x00, 0x1B }, 0,
+				&registry_curve_sect233r1, { 233, 1, { 74 } } },
+#endif
+#if GF2_VECTOR_MAX_BYTELEN > 36
+		{ "sect283k1", "K-283", "1.3.132.0.16", { 0x2B, 0x81, 0x04, 0x00, 0x10 }, 1,
+				&registry_curve_sect283k1, { 283, 3, { 12, 7, 5 } } },
+		{ "sect283r1", "B-283", "1.3.132.0.17", { 0x2B, 0x81, 0x04, 0x00, 0x11 }, 0,
+				&registry_curve_sect283r1, { 283, 3, { 12, 7, 5 } } },
+#endif
+#if GF2_VECTOR_MAX_BYTELEN > 52
+		{ "sect409k1", "K-409", "1.3.132.0.36", { 0x2B, 0x81, 0x04, 0x00, 0x24 }, 1,
+				&registry_curve_sect409k1, { 409, 1, { 87 } } },
+		{ "sect409r1", "B-409", "1.3.132.0.37", { 0x2B, 0x81, 0x04, 0x00, 0x25 }, 0,
+				&registry_curve_sect409r1, { 409, 1, { 87 } } },
+#endif
+#if GF2_VECTOR_MAX_BYTELEN > 72
+		{ "sect571k1", "K-571", "1.3.132.0.38", { 0x2B, 0x81, 0x04, 0x00, 0x26 }, 1,
+				&registry_curve_sect571k1, { 571, 3, { 10, 5, 2 } } },
+		{ "sect571r1", "B-571", "1.3.132.0.39", { 0x2B, 0x81, 0x04, 0x00, 0x27 }, 0,
+				&registry_curve_sect571r1, { 571, 3, { 10, 5, 2 } } },
+#endif
+		{ 0, 0, 0, { 0 }, 0, 0, { 0, 0, { 0 } } } // terminator, keeps the array non-empty
+};
+
+static_assert(sizeof(registry_entries) / sizeof(registry_entries[0]) - 1 <= EC_REGISTRY_MAX_CURVES,
+		"EC_REGISTRY_MAX_CURVES too small");
+
+static int registry_string_equal(const char *s1, const char *s2) {
+	if (!s1 || !s2)
+		return 0;
+	while (*s1 && *s1 == *s2) {
+		++s1;
+		++s2;
+	}
+	return *s1 == *s2;
+}
+
+unsigned long elliptic_curve_registry_count() {
+	return sizeof(registry_entries) / sizeof(registry_entries[0]) - 1;
+}
+
+const EllipticCurveRegistryEntry* elliptic_curve_registry_get(unsigned long index) {
+	if (index >= elliptic_curve_registry_count())
+		return 0;
+	return &registry_entries[index];
+}
+
+const EllipticCurveRegistryEntry* elliptic_curve_registry_find(const char *name_or_oid) {
+	for (unsigned long i = 0; i < elliptic_curve_registry_count(); ++i) {
+		const EllipticCurveRegistryEntry *e = &registry_entries[i];
+		if (registry_string_equal(name_or_oid, e->sec_name)
+				|| registry_string_equal(name_or_oid, e->nist_name)
+				|| registry_string_equal(name_or_oid, e->oid))
+			return e;
+	}
+	return 0;
+}
+
+const EllipticCurveRegistryEntry* elliptic_curve_registry_find_oid_der(
+		const unsigned char *der, unsigned long der_bytelen) {
+	const unsigned long oid_bytelen = sizeof(registry_entries[0].oid_der);
+	if (der_bytelen == oid_bytelen + 2 && der[0] == 0x06 && der[1] == oid_bytelen) {
+		der += 2;
+		der_bytelen -= 2;
+	}
+	if (der_bytelen != oid_bytelen)
+		return 0;
+	for (unsigned long i = 0; i < elliptic_curve_registry_count(); ++i) {
+		unsigned char diff = 0;
+		for (unsigned long j = 0; j < oid_bytelen; ++j)
+			diff |= der[j] ^ registry_entries[i].oid_der[j];
+		if (diff == 0)
+			return &registry_entries[i];
+	}
+	return 0;
+}
+
+const EllipticCurve* elliptic_curve_registry_find_curve(const char *name_or_oid) {
+	const EllipticCurveRegistryEntry *e = elliptic_curve_registry_find(name_or_oid);
+	return e ? e->curve : 0;
+}
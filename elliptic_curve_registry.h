@@ -0,0 +1,45 @@
+#ifndef ELLIPTIC_CURVE_REGISTRY_H_
+#define ELLIPTIC_CURVE_REGISTRY_H_
+
+#include "elliptic_curve.h"
+
+// Built-in SEC 2 / FIPS 186 binary curves. All entries are constant data,
+// usable directly without any runtime setup. Curves that don't fit into
+// GF2_VECTOR_MAX_BYTELEN are compiled out (the registry then simply doesn't
+// know them).
+
+// Per-curve acceleration contexts (elliptic_curve_context.h) for the
+// registry curves, built on first use. Each one is sizeof(EllipticCurveContext)
+// of RAM, mostly the half-trace table (16 * GF2_VECTOR_MAX_BYTELEN^2 bytes):
+// about 19 KB per curve at 32-byte vectors, 106 KB at 80. Off by default, so
+// the registry curves take the generic path; to accelerate one curve, attach
+// a context of your own to a copy of it (elliptic_curve_attach_context()).
+#ifndef EC_REGISTRY_CONTEXTS
+#define EC_REGISTRY_CONTEXTS (0)
+#endif
+
+// Upper bound of elliptic_curve_registry_count(), for per-curve arrays
+#define EC_REGISTRY_MAX_CURVES (11UL)
+
+typedef struct {
+	const char *sec_name;                 // e.g. "sect233k1"
+	const char *nist_name;                // e.g. "K-233", 0 if none
+	const char *oid;                      // dotted form, e.g. "1.3.132.0.26"
+	unsigned char oid_der[5];             // DER contents octets of the OID
+	unsigned char is_koblitz;             // a in {0,1}, b = 1
+	const EllipticCurve *curve;
+	GF2ReductionDescriptor reduction;     // sparse form of curve->modulus
+} EllipticCurveRegistryEntry;
+
+unsigned long elliptic_curve_registry_count();
+const EllipticCurveRegistryEntry* elliptic_curve_registry_get(unsigned long index);
+
+// Accepts the SEC name, the NIST name or the dotted OID.
+const EllipticCurveRegistryEntry* elliptic_curve_registry_find(const char *name_or_oid);
+// Accepts either the bare contents octets or a full DER TLV (tag 0x06).
+const EllipticCurveRegistryEntry* elliptic_curve_registry_find_oid_der(
+		const unsigned char *der, unsigned long der_bytelen);
+
+const EllipticCurve* elliptic_curve_registry_find_curve(const char *name_or_oid);
+
+#endif /* ELLIPTIC_CURVE_REGISTRY_H_ */
@@ -0,0 +1,65 @@
+#include <iostream>
+#include <iomanip>
+#include "elliptic_curve_registry.h"
+
+int test_elliptic_curve_registry() {
+	int failures = 0;
+
+	std::cout << "\n--- Testing built-in curve registry ("
+			<< elliptic_curve_registry_count() << " curves fit GF2_VECTOR_MAX_BYTELEN = "
+			<< GF2_VECTOR_MAX_BYTELEN << ") ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurveRegistryEntry *e = elliptic_curve_registry_get(c);
+		const EllipticCurve *curve = e->curve;
+		unsigned long len = curve->field_size_bytes;
+		EllipticCurvePoint G = { };
+		EllipticCurvePoint R = { };
+		GF2ReductionDescriptor desc;
+		int ok = 1;
+
+		unsigned char *gx = elliptic_curve_point_get_coord_x(curve, &G);
+		unsigned char *gy = elliptic_curve_point_get_coord_y(curve, &G);
+		for (unsigned long i = 0; i < len; ++i) {
+			gx[i] = curve->xG[i];
+			gy[i] = curve->yG[i];
+		}
+
+		// Precomputed descriptor must match the modulus it was taken from
+		ok &= gf2_reduction_descriptor_init(&desc, curve->modulus, len);
+		ok &= desc.degree == e->reduction.degree
+				&& desc.degree == curve->binary_degree
+				&& desc.term_count == e->reduction.term_count;
+		for (unsigned long k = 0; k < desc.term_count; ++k)
+			ok &= desc.terms[k] == e->reduction.terms[k];
+
+		// Lookup by every key must lead back to the same entry
+		ok &= elliptic_curve_registry_find(e->sec_name) == e;
+		ok &= elliptic_curve_registry_find(e->oid) == e;
+		ok &= !e->nist_name || elliptic_curve_registry_find(e->nist_name) == e;
+		ok &= elliptic_curve_registry_find_oid_der(e->oid_der, sizeof(e->oid_der)) == e;
+		unsigned char tlv[2 + sizeof(e->oid_der)] = { 0x06, sizeof(e->oid_der) };
+		for (unsigned long i = 0; i < sizeof(e->oid_der); ++i)
+			tlv[2 + i] = e->oid_der[i];
+		ok &= elliptic_curve_registry_find_oid_der(tlv, sizeof(tlv)) == e;
+
+		ok &= elliptic_curve_binary_point_on_curve(curve, &G);
+		elliptic_curve_binary_point_multiply(curve, &R, &G, curve->order, len);
+		unsigned char nz = 0;
+		for (unsigned long i = 0; i < elliptic_curve_point_get_coord_full_bytelen(curve); ++i)
+			nz |= R.point_mem[i];
+		ok &= nz == 0;
+
+		std::cout << std::left << std::setw(10) << e->sec_name << std::setw(7)
+				<< (e->nist_name ? e->nist_name : "-") << std::setw(14) << e->oid
+				<< std::right << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	int ok = elliptic_curve_registry_find("sect239k1") == 0
+			&& elliptic_curve_registry_find("") == 0
+			&& elliptic_curve_registry_find_curve("1.3.132.0.99") == 0;
+	std::cout << "Unknown names rejected: " << (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+	return failures;
+}
@@ -0,0 +1,292 @@
+#include "elliptic_curve_scalar.h"
+
+// Multi-precision integers as 32-bit limbs, least significant first; the
+// tau-adic code uses them as two's complement numbers. Wide enough for #E
+// plus the headroom of 2 r during reduction and of the tau-adic remainders.
+#define SCALAR_LIMBS ((GF2_VECTOR_MAX_BYTELEN + 8) / 4)
+
+static void scalar_load(unsigned int *out, const unsigned char *in, unsigned long bytelen) {
+	for (unsigned long i = 0; i < SCALAR_LIMBS; ++i)
+		out[i] = 0;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		out[i >> 2] |= (unsigned int) in[i] << (8 * (i & 3));
+}
+
+static void scalar_store(unsigned char *out, unsigned long bytelen, const unsigned int *in) {
+	for (unsigned long i = 0; i < bytelen; ++i)
+		out[i] = (unsigned char) (in[i >> 2] >> (8 * (i & 3)));
+}
+
+static unsigned long scalar_bit_length(const unsigned int *in) {
+	for (long i = SCALAR_LIMBS - 1; i >= 0; --i) {
+		if (in[i]) {
+			unsigned long bits = 32 * (unsigned long) i;
+			for (unsigned int v = in[i]; v; v >>= 1)
+				++bits;
+			return bits;
+		}
+	}
+	return 0;
+}
+
+// out = in1 + in2, returns the carry
+static unsigned int scalar_add(unsigned int *out, const unsigned int *in1,
+		const unsigned int *in2, unsigned long limbs) {
+	unsigned long long carry = 0;
+	for (unsigned long i = 0; i < limbs; ++i) {
+		carry += (unsigned long long) in1[i] + in2[i];
+		out[i] = (unsigned int) carry;
+		carry >>= 32;
+	}
+	return (unsigned int) carry;
+}
+
+// out = in1 - in2, returns the borrow
+static unsigned int scalar_sub(unsigned int *out, const unsigned int *in1,
+		const unsigned int *in2, unsigned long limbs) {
+	unsigned long long borrow = 0;
+	for (unsigned long i = 0; i < limbs; ++i) {
+		unsigned long long v = (unsigned long long) in1[i] - in2[i] - borrow;
+		out[i] = (unsigned int) v;
+		borrow = (v >> 32) & 1;
+	}
+	return (unsigned int) borrow;
+}
+
+// out = mask ? in1 : in2, mask all ones or zero
+static void scalar_select(unsigned int *out, unsigned int mask, const unsigned int *in1,
+		const unsigned int *in2, unsigned long limbs) {
+	for (unsigned long i = 0; i < limbs; ++i)
+		out[i] = (in1[i] & mask) | (in2[i] & ~mask);
+}
+
+static void scalar_wipe(unsigned int *p, unsigned long limbs) {
+	volatile unsigned int *raw = p;
+	for (unsigned long i = 0; i < limbs; ++i)
+		raw[i] = 0;
+}
+
+unsigned long elliptic_curve_scalar_group_order(const EllipticCurve *curve,
+		unsigned char *out) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned int n[SCALAR_LIMBS], h[SCALAR_LIMBS], r[SCALAR_LIMBS] = { };
+
+	scalar_load(n, curve->order, len);
+	scalar_load(h, curve->cofactor, len);
+	for (unsigned long i = 0; i < SCALAR_LIMBS; ++i) {
+		unsigned long long carry = 0;
+		for (unsigned long j = 0; i + j < SCALAR_LIMBS; ++j) {
+			carry += (unsigned long long) n[i] * h[j] + r[i + j];
+			r[i + j] = (unsigned int) carry;
+			carry >>= 32;
+		}
+	}
+	scalar_store(out, len + 1, r);
+	return scalar_bit_length(r);
+}
+
+// Bit-serial: r = 2 r + bit, minus the modulus whenever it reaches it. The
+// subtraction is always done and the result selected by the borrow.
+void elliptic_curve_scalar_reduce(const unsigned char *modulus, unsigned long modlen,
+		unsigned char *out, const unsigned char *exp, unsigned long bytelen,
+		unsigned long shift) {
+	unsigned long limbs = modlen / 4 + 1;   // room for 2 r
+	unsigned int m[SCALAR_LIMBS], r[SCALAR_LIMBS] = { }, t[SCALAR_LIMBS];
+
+	scalar_load(m, modulus, modlen);
+	for (long bit = (long) (8 * bytelen + shift) - 1; bit >= 0; --bit) {
+		unsigned int carry = 0;
+		if (bit >= (long) shift) {
+			unsigned long e = (unsigned long) bit - shift;
+			carry = (exp[e >> 3] >> (e & 7)) & 1;
+		}
+		for (unsigned long i = 0; i < limbs; ++i) {
+			unsigned int v = r[i];
+			r[i] = (v << 1) | carry;
+			carry = v >> 31;
+		}
+		unsigned int borrow = scalar_sub(t, r, m, limbs);
+		scalar_select(r, borrow - 1U, t, r, limbs);
+	}
+	scalar_store(out, modlen, r);
+	scalar_wipe(r, SCALAR_LIMBS);
+	scalar_wipe(t, SCALAR_LIMBS);
+}
+
+unsigned long elliptic_curve_scalar_fix_length(const unsigned char *modulus,
+		unsigned long modlen, unsigned char *out, const unsigned char *k) {
+	unsigned long limbs = modlen / 4 + 1;
+	unsigned int m[SCALAR_LIMBS], once[SCALAR_LIMBS], twice[SCALAR_LIMBS];
+
+	scalar_load(m, modulus, modlen);
+	scalar_load(once, k, modlen);
+	unsigned long t = scalar_bit_length(m);
+	scalar_add(once, once, m, limbs);
+	scalar_add(twice, once, m, limbs);
+	unsigned int top = (once[t >> 5] >> (t & 31)) & 1;
+	scalar_select(once, 0U - top, once, twice, limbs);
+	scalar_store(out, modlen + 1, once);
+	scalar_wipe(once, SCALAR_LIMBS);
+	scalar_wipe(twice, SCALAR_LIMBS);
+	return t;
+}
+
+void elliptic_curve_scalar_recode_wnaf(const unsigned char *exp, unsigned long bytelen,
+		unsigned long w, signed char *digits) {
+	alignas(8) unsigned char k[EC_SCALAR_MAX_BYTELEN + 1] = { };
+	unsigned int mask = (1U << w) - 1;
+
+	for (unsigned long i = 0; i < bytelen; ++i)
+		k[i] = exp[i];
+
+	for (unsigned long d = 0; d < EC_SCALAR_DIGIT_COUNT(bytelen); ++d) {
+		int digit = 0;
+		if (k[0] & 1) {
+			digit = (int) (k[0] & mask);
+			if (digit >= (1 << (w - 1)))
+				digit -= (1 << w);
+			k[0] &= (unsigned char) ~mask;      // k -= digit for digit > 0
+			if (digit < 0) {                    // k -= digit = k + |digit|
+				unsigned int carry = 1U << w;
+				for (unsigned long i = 0; i <= bytelen && carry; ++i) {
+					carry += k[i];
+					k[i] = (unsigned char) carry;
+					carry >>= 8;
+				}
+			}
+		}
+		digits[d] = (signed char) digit;
+		for (unsigned long i = 0; i < bytelen; ++i)
+			k[i] = (unsigned char) ((k[i] >> 1) | (k[i + 1] << 7));
+		k[bytelen] >>= 1;
+	}
+}
+
+void elliptic_curve_scalar_recode_jsf(const unsigned char *exp1, const unsigned char *exp2,
+		unsigned long bytelen, signed char *u1, signed char *u2) {
+	alignas(8) unsigned char k1[EC_SCALAR_MAX_BYTELEN] = { };
+	alignas(8) unsigned char k2[EC_SCALAR_MAX_BYTELEN] = { };
+	unsigned int d1 = 0, d2 = 0;
+
+	for (unsigned long i = 0; i < bytelen; ++i) {
+		k1[i] = exp1[i];
+		k2[i] = exp2[i];
+	}
+	for (unsigned long j = 0; j < EC_SCALAR_DIGIT_COUNT(bytelen); ++j) {
+		// l = d + k mod 8
+		unsigned int l1 = (k1[0] + d1) & 7U;
+		unsigned int l2 = (k2[0] + d2) & 7U;
+		int v1 = 0, v2 = 0;
+		if (l1 & 1) {
+			v1 = ((l1 & 3U) == 1) ? 1 : -1;
+			if ((l1 == 3 || l1 == 5) && (l2 & 3U) == 2)
+				v1 = -v1;
+		}
+		if (l2 & 1) {
+			v2 = ((l2 & 3U) == 1) ? 1 : -1;
+			if ((l2 == 3 || l2 == 5) && (l1 & 3U) == 2)
+				v2 = -v2;
+		}
+		if ((int) (2 * d1) == 1 + v1)
+			d1 = 1 - d1;
+		if ((int) (2 * d2) == 1 + v2)
+			d2 = 1 - d2;
+		u1[j] = (signed char) v1;
+		u2[j] = (signed char) v2;
+		for (unsigned long i = 0; i < bytelen; ++i) {
+			unsigned char next1 = (i + 1 < bytelen) ? k1[i + 1] : 0;
+			unsigned char next2 = (i + 1 < bytelen) ? k2[i + 1] : 0;
+			k1[i] = (unsigned char) ((k1[i] >> 1) | (next1 << 7));
+			k2[i] = (unsigned char) ((k2[i] >> 1) | (next2 << 7));
+		}
+	}
+}
+
+// ---- Tau-adic recoding ----
+
+static int tnaf_is_zero(const unsigned int *in) {
+	unsigned int acc = 0;
+	for (unsigned long i = 0; i < SCALAR_LIMBS; ++i)
+		acc |= in[i];
+	return acc == 0;
+}
+
+// inout += v for a small signed v
+static void tnaf_add_small(unsigned int *inout, int v) {
+	unsigned int add[SCALAR_LIMBS];
+	unsigned int fill = (v < 0) ? 0xFFFFFFFFU : 0;
+	add[0] = (unsigned int) v;
+	for (unsigned long i = 1; i < SCALAR_LIMBS; ++i)
+		add[i] = fill;
+	scalar_add(inout, inout, add, SCALAR_LIMBS);
+}
+
+// Arithmetic shift right by one
+static void tnaf_half(unsigned int *out, const unsigned int *in) {
+	for (unsigned long i = 0; i + 1 < SCALAR_LIMBS; ++i)
+		out[i] = (in[i] >> 1) | (in[i + 1] << 31);
+	out[SCALAR_LIMBS - 1] = (unsigned int) ((int) in[SCALAR_LIMBS - 1] >> 1);
+}
+
+// One tau-adic NAF digit of r0 + r1 tau (HMV Alg. 3.61), then
+// r0 + r1 tau = (r0 + r1 tau - u) / tau = (r1 + mu r0 / 2) - (r0 / 2) tau
+static int tnaf_step(unsigned int *r0, unsigned int *r1, int mu) {
+	int u = 0;
+	unsigned int h[SCALAR_LIMBS];
+
+	if (r0[0] & 1) {
+		u = 2 - (int) ((r0[0] - 2 * r1[0]) & 3U);
+		tnaf_add_small(r0, -u);
+	}
+	tnaf_half(h, r0);
+	if (mu > 0)
+		scalar_add(r0, r1, h, SCALAR_LIMBS);
+	else
+		scalar_sub(r0, r1, h, SCALAR_LIMBS);
+	for (unsigned long i = 0; i < SCALAR_LIMBS; ++i)
+		r1[i] = 0;
+	scalar_sub(r1, r1, h, SCALAR_LIMBS);
+	return u;
+}
+
+long elliptic_curve_scalar_recode_tnaf(const EllipticCurve *curve,
+		const unsigned char *exp, unsigned long bytelen, signed char *digits) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long m = curve->binary_degree;
+	int mu = (curve->a[0] & 1) ? 1 : -1;
+	alignas(8) unsigned char order[EC_SCALAR_MAX_BYTELEN];
+	alignas(8) unsigned char k[EC_SCALAR_MAX_BYTELEN];
+	unsigned int r0[SCALAR_LIMBS], r1[SCALAR_LIMBS] = { }, t[SCALAR_LIMBS];
+
+	// k mod #E, its tau-adic NAF folded into c_j = sum(u_{j + i m}), |c_j| <= 3
+	elliptic_curve_scalar_group_order(curve, order);
+	elliptic_curve_scalar_reduce(order, len + 1, k, exp, bytelen, 0);
+	scalar_load(r0, k, len + 1);
+	for (unsigned long j = 0; j < m; ++j)
+		digits[j] = 0;
+	for (unsigned long i = 0; !tnaf_is_zero(r0) || !tnaf_is_zero(r1); ++i)
+		digits[i % m] = (signed char) (digits[i % m] + tnaf_step(r0, r1, mu));
+
+	// rho = sum(c_j tau^j) by Horner: (x + y tau) tau + c = (c - 2 y) + (x + mu y) tau
+	for (long j = (long) m - 1; j >= 0; --j) {
+		scalar_add(t, r1, r1, SCALAR_LIMBS);
+		if (mu > 0)
+			scalar_add(r1, r0, r1, SCALAR_LIMBS);
+		else
+			scalar_sub(r1, r0, r1, SCALAR_LIMBS);
+		for (unsigned long i = 0; i < SCALAR_LIMBS; ++i)
+			r0[i] = 0;
+		scalar_sub(r0, r0, t, SCALAR_LIMBS);
+		tnaf_add_small(r0, digits[j]);
+	}
+
+	long count = 0;
+	while ((!tnaf_is_zero(r0) || !tnaf_is_zero(r1)) && count < (long) EC_MULTIPLY_MAX_DIGITS)
+		digits[count++] = (signed char) tnaf_step(r0, r1, mu);
+	for (unsigned long i = 0; i < len + 1; ++i)
+		k[i] = 0;
+	scalar_wipe(r0, SCALAR_LIMBS);
+	scalar_wipe(r1, SCALAR_LIMBS);
+	scalar_wipe(t, SCALAR_LIMBS);
+	return count;
+}
@@ -0,0 +1,65 @@
+#ifndef ELLIPTIC_CURVE_SCALAR_H_
+#define ELLIPTIC_CURVE_SCALAR_H_
+
+#include "elliptic_curve.h"
+
+// Integer scalar handling for the point multiplications.
+//
+// Scalars are unsigned integers, bytes LSB first, not GF(2) polynomials:
+//  - reduction modulo the base point order n or the group order #E = h n
+//    (k P = (k mod #E) P for every point on the curve, k mod n is enough
+//    for points of the order-n subgroup such as G);
+//  - fixed-length scalars: k + #E or k + 2 #E, whichever has exactly
+//    bits(#E) + 1 bits, so the multiplication loop length does not depend on
+//    the key;
+//  - recodings feeding the multiplication engines: width-w NAF (halve-and-add,
+//    prepared peers, Straus MSM), joint sparse form (two-term MSM) and the
+//    Frobenius (tau-adic) NAF used on Koblitz curves.
+//
+// Reduction and fixed-length scalars are constant time (only the lengths are
+// public); the recodings are not.
+
+#define EC_SCALAR_MAX_BYTELEN (GF2_VECTOR_MAX_BYTELEN + 1)     // #E and fixed-length scalars
+#define EC_SCALAR_DIGIT_COUNT(bytelen) (8 * (bytelen) + 1)  // (w)NAF and JSF digits
+
+// out = h * n (EC_SCALAR_MAX_BYTELEN bytes, only field_size_bytes + 1 used).
+// Returns its bit length.
+unsigned long elliptic_curve_scalar_group_order(const EllipticCurve *curve,
+		unsigned char *out);
+
+// out = (exp * 2^shift) mod modulus, modlen bytes. modulus must be non-zero
+// and at most EC_SCALAR_MAX_BYTELEN bytes; out may alias exp when bytelen
+// <= modlen. Runs 8 * bytelen + shift steps whatever the values.
+void elliptic_curve_scalar_reduce(const unsigned char *modulus, unsigned long modlen,
+		unsigned char *out, const unsigned char *exp, unsigned long bytelen,
+		unsigned long shift);
+
+// For k < modulus (modlen bytes): out = k + modulus or k + 2 modulus, the one
+// with bit t set, t = bits(modulus), so out is exactly t + 1 bits long.
+// out has modlen + 1 bytes. Returns t, the index of the top bit.
+unsigned long elliptic_curve_scalar_fix_length(const unsigned char *modulus,
+		unsigned long modlen, unsigned char *out, const unsigned char *k);
+
+// Width-w NAF of exp (2 <= w <= 7, w = 2 is the plain NAF), LSB first: every
+// non-zero digit is odd, |digit| < 2^(w-1) and at least w - 1 zeros follow
+// it. Always writes EC_SCALAR_DIGIT_COUNT(bytelen) digits.
+void elliptic_curve_scalar_recode_wnaf(const unsigned char *exp, unsigned long bytelen,
+		unsigned long w, signed char *digits);
+
+// Joint sparse form (Solinas) of two scalars, LSB first: of any three
+// consecutive digit columns at least one is zero in both. Writes
+// EC_SCALAR_DIGIT_COUNT(bytelen) columns.
+void elliptic_curve_scalar_recode_jsf(const unsigned char *exp1, const unsigned char *exp2,
+		unsigned long bytelen, signed char *u1, signed char *u2);
+
+// Tau-adic NAF for Koblitz curves (elliptic_curve_binary_is_koblitz()): with
+// tau the Frobenius map (x, y) -> (x^2, y^2) and mu = 1 for a = 1, -1 for
+// a = 0, tau^2 = mu tau - 2 on every point of the curve, and tau^m is the
+// identity. exp is reduced mod #E, its tau-adic expansion is folded modulo
+// tau^m - 1 and recoded again, so k P = sum(digits[i] tau^i P) with digits
+// in { -1, 0, 1 }, no two adjacent non-zero and about m + 4 of them.
+// digits has room for EC_MULTIPLY_MAX_DIGITS. Returns the digit count.
+long elliptic_curve_scalar_recode_tnaf(const EllipticCurve *curve,
+		const unsigned char *exp, unsigned long bytelen, signed char *digits);
+
+#endif /* ELLIPTIC_CURVE_SCALAR_H_ */
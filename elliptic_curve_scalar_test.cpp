@@ -0,0 +1,258 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "elliptic_curve_scalar.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x5CA1A7UL)
+#include "ec_test_util.h"
+
+// Signed digits back to an integer: positive and negative digits are
+// collected separately and subtracted. Returns 1 if the value equals k.
+static int scalar_test_digits_value(const signed char *digits, unsigned long count,
+		const unsigned char *k, unsigned long bytelen) {
+	unsigned char pos[EC_SCALAR_MAX_BYTELEN + 2] = { };
+	unsigned char neg[EC_SCALAR_MAX_BYTELEN + 2] = { };
+	for (unsigned long i = 0; i < count; ++i) {
+		if (digits[i] == 0)
+			continue;
+		unsigned char *to = (digits[i] > 0) ? pos : neg;
+		unsigned int carry = (unsigned int) ((digits[i] > 0) ? digits[i] : -digits[i]) << (i & 7);
+		for (unsigned long j = i >> 3; j < sizeof(pos) && carry; ++j) {
+			carry += to[j];
+			to[j] = (unsigned char) carry;
+			carry >>= 8;
+		}
+	}
+	unsigned int borrow = 0;
+	unsigned char diff = 0;
+	for (unsigned long j = 0; j < sizeof(pos); ++j) {
+		unsigned int v = (unsigned int) pos[j] - neg[j] - borrow;
+		borrow = (v >> 8) & 1;
+		diff |= (unsigned char) v ^ ((j < bytelen) ? k[j] : 0);
+	}
+	return diff == 0 && borrow == 0;
+}
+
+// Known vectors: small moduli, and sect163k1's n with (2^256 - 1) and
+// (2^168 - 1) * 2^100
+static int scalar_test_reduce_vectors() {
+	int ok = 1;
+	const unsigned char m13[1] = { 13 };
+	const unsigned char ffff[2] = { 0xFF, 0xFF };
+	const unsigned char five[1] = { 5 };
+	unsigned char r[EC_SCALAR_MAX_BYTELEN] = { };
+
+	elliptic_curve_scalar_reduce(m13, 1, r, ffff, 2, 0);
+	ok &= r[0] == 2;
+	elliptic_curve_scalar_reduce(m13, 1, r, five, 1, 10);
+	ok &= r[0] == 11;
+
+	const unsigned char p32[4] = { 0x07, 0xCA, 0x9A, 0x3B };        // 10^9 + 7
+	const unsigned char ones64[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+	const unsigned char expect64[4] = { 0x47, 0xDD, 0xB5, 0x22 };   // 582344007
+	elliptic_curve_scalar_reduce(p32, 4, r, ones64, 8, 0);
+	ok &= ec_test_bytes_equal(r, expect64, 4);
+
+	const EllipticCurve *k163 = elliptic_curve_registry_find_curve("sect163k1");
+	if (!k163)
+		return ok;
+	const unsigned char expect256[21] = { 0xDE, 0xE4, 0x40, 0x4E, 0x26, 0x40, 0x6F, 0xEA,
+			0xEE, 0x25, 0x43, 0x80, 0x84, 0xD6, 0x81, 0x99, 0xFC, 0xCC, 0x47, 0xD7, 0x01 };
+	const unsigned char expect168[21] = { 0x2D, 0x1F, 0x70, 0x52, 0xBD, 0xE4, 0xC3, 0xA2,
+			0x0F, 0x52, 0x9D, 0x23, 0xF4, 0x47, 0x68, 0x1D, 0x98, 0xC9, 0xCF, 0x7C, 0x00 };
+	unsigned char ones[GF2_VECTOR_MAX_BYTELEN];
+	for (unsigned long i = 0; i < GF2_VECTOR_MAX_BYTELEN; ++i)
+		ones[i] = 0xFF;
+	if (GF2_VECTOR_MAX_BYTELEN >= 32) {
+		elliptic_curve_scalar_reduce(k163->order, 21, r, ones, 32, 0);
+		ok &= ec_test_bytes_equal(r, expect256, 21);
+	}
+	elliptic_curve_scalar_reduce(k163->order, 21, r, ones, 21, 100);
+	ok &= ec_test_bytes_equal(r, expect168, 21);
+	ok &= elliptic_curve_scalar_group_order(k163, r) == 164;
+	return ok;
+}
+
+// Fixed length: k + N or k + 2 N with top bit t, congruent to k mod N
+static int scalar_test_fix_length(const unsigned char *order, unsigned long modlen,
+		const unsigned char *k) {
+	unsigned char fixed[EC_SCALAR_MAX_BYTELEN + 1] = { };
+	unsigned char back[EC_SCALAR_MAX_BYTELEN] = { };
+	unsigned long t = elliptic_curve_scalar_fix_length(order, modlen, fixed, k);
+	int ok = (long) t == gf2_degree_lsb(order, modlen) + 1;
+	ok &= gf2_degree_lsb(fixed, modlen + 1) == (long) t;
+	elliptic_curve_scalar_reduce(order, modlen, back, fixed, modlen + 1, 0);
+	return ok && ec_test_bytes_equal(back, k, modlen);
+}
+
+// wNAF and JSF: value and sparsity
+static int scalar_test_recodings(unsigned long len) {
+	int ok = 1;
+	signed char d1[EC_SCALAR_DIGIT_COUNT(GF2_VECTOR_MAX_BYTELEN)];
+	signed char d2[EC_SCALAR_DIGIT_COUNT(GF2_VECTOR_MAX_BYTELEN)];
+	unsigned long count = EC_SCALAR_DIGIT_COUNT(len);
+
+	for (int iter = 0; iter < 8; ++iter) {
+		unsigned char k1[GF2_VECTOR_MAX_BYTELEN], k2[GF2_VECTOR_MAX_BYTELEN];
+		for (unsigned long i = 0; i < len; ++i) {
+			k1[i] = (iter == 0) ? 0xFF : ec_test_random_byte();
+			k2[i] = (iter == 1) ? 0x00 : ec_test_random_byte();
+		}
+		for (unsigned long w = 2; w <= 6; ++w) {
+			elliptic_curve_scalar_recode_wnaf(k1, len, w, d1);
+			ok &= scalar_test_digits_value(d1, count, k1, len);
+			for (unsigned long i = 0; i < count; ++i) {
+				if (!d1[i])
+					continue;
+				ok &= (d1[i] & 1) && d1[i] < (1 << (w - 1)) && -d1[i] < (1 << (w - 1));
+				for (unsigned long j = i + 1; j < i + w && j < count; ++j)
+					ok &= d1[j] == 0;
+			}
+		}
+		elliptic_curve_scalar_recode_jsf(k1, k2, len, d1, d2);
+		ok &= scalar_test_digits_value(d1, count, k1, len);
+		ok &= scalar_test_digits_value(d2, count, k2, len);
+		for (unsigned long i = 0; i + 2 < count; ++i)
+			ok &= !(d1[i] || d2[i]) || !(d1[i + 1] || d2[i + 1]) || !(d1[i + 2] || d2[i + 2]);
+	}
+	return ok;
+}
+
+int test_elliptic_curve_scalar() {
+	int failures = 0;
+	std::cout << "\n--- Testing scalar reduction and recoding (elliptic_curve_scalar.h) ---\n";
+
+	int ok = scalar_test_reduce_vectors();
+	std::cout << std::left << std::setw(12) << "vectors" << (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned long len = curve->field_size_bytes;
+		unsigned char order[EC_SCALAR_MAX_BYTELEN] = { };
+		EllipticCurvePoint G = { }, R1 = { }, R2 = { };
+		ec_test_load_base(curve, &G);
+		unsigned long t = elliptic_curve_scalar_group_order(curve, order);
+
+		ok = scalar_test_recodings(len);
+
+		// Fixed length for 0, 1, N - 1 and random k < N
+		for (int iter = 0; iter < 8; ++iter) {
+			unsigned char k[EC_SCALAR_MAX_BYTELEN] = { };
+			for (unsigned long i = 0; i < len; ++i)
+				k[i] = (iter == 2) ? order[i] : (iter < 2) ? 0 : ec_test_random_byte();
+			if (iter == 1)
+				k[0] = 1;
+			else if (iter == 2)
+				k[0] -= 1;     // N is even
+			else if (iter > 2)
+				elliptic_curve_scalar_reduce(order, len + 1, k, k, len, 0);
+			ok &= scalar_test_fix_length(order, len + 1, k);
+		}
+
+		// Every double-and-add loop is bits(#E) + 1 long; without a context
+		// only Koblitz curves take another schedule
+		EllipticCurve bare = *curve;
+		bare.context = 0;
+		if (!elliptic_curve_binary_is_koblitz(curve)) {
+			EllipticCurveMultiplyState state;
+			for (int iter = 0; iter < 3; ++iter) {
+				unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+				k[0] = 1;
+				for (unsigned long i = 0; iter && i < len; ++i)
+					k[i] = (iter == 1) ? ec_test_random_byte() : 0xFF;
+				elliptic_curve_binary_point_multiply_init(&state, &bare, &G, k, len);
+				ok &= state.mode == EC_MULTIPLY_MODE_DOUBLE_AND_ADD && state.next == (long) t;
+				elliptic_curve_binary_point_multiply_finish(&state, &R1);
+			}
+		}
+
+		// Tau-adic NAF: non-adjacent, about m digits, and tau-and-add agrees
+		// with the ladder
+		for (int iter = 0; iter < 4 && elliptic_curve_binary_is_koblitz(curve); ++iter) {
+			signed char digits[EC_MULTIPLY_MAX_DIGITS];
+			unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+			for (unsigned long i = 0; i < len; ++i)
+				k[i] = (iter == 0) ? curve->order[i] : ec_test_random_byte();
+			long count = elliptic_curve_scalar_recode_tnaf(curve, k, len, digits);
+			ok &= count <= (long) curve->binary_degree + 8;
+			for (long i = 0; i + 1 < count; ++i)
+				ok &= !(digits[i] && digits[i + 1]);
+			elliptic_curve_binary_point_multiply(curve, &R1, &G, k, len);
+			elliptic_curve_binary_point_multiply_ct(curve, &R2, &G, k, len);
+			ok &= ec_test_points_equal(curve, &R1, &R2);
+		}
+
+		// Scalars above the order: k + 2 #E (and k + n for G) give k P
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { }, big[GF2_VECTOR_MAX_BYTELEN] = { };
+		for (unsigned long i = 0; i + 1 < len; ++i)
+			k[i] = ec_test_random_byte();
+		unsigned int carry = 0;
+		for (unsigned long i = 0; i < len; ++i) {
+			carry += k[i] + 2U * order[i];
+			big[i] = (unsigned char) carry;
+			carry >>= 8;
+		}
+		for (unsigned long i = len; i < GF2_VECTOR_MAX_BYTELEN; ++i) {
+			carry += 2U * order[i];
+			big[i] = (unsigned char) carry;
+			carry >>= 8;
+		}
+		elliptic_curve_binary_point_multiply(curve, &R1, &G, k, len);
+		elliptic_curve_binary_point_multiply(curve, &R2, &G, big, GF2_VECTOR_MAX_BYTELEN);
+		ok &= ec_test_points_equal(curve, &R1, &R2);
+		elliptic_curve_binary_point_multiply_ct(curve, &R2, &G, big, GF2_VECTOR_MAX_BYTELEN);
+		ok &= ec_test_points_equal(curve, &R1, &R2);
+		elliptic_curve_binary_point_multiply_base(curve, &R2, big, GF2_VECTOR_MAX_BYTELEN);
+		ok &= ec_test_points_equal(curve, &R1, &R2);
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// Multiply latency by scalar shape: a short scalar, a random one, n - 1 and a
+// full-width one above the order. With reduction and fixed-length scalars
+// the double-and-add columns stay flat.
+void benchmark_elliptic_curve_scalar() {
+	const int runs = 5;
+	std::cout << "\n--- Benchmark: multiply latency by scalar shape (us/op) ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::setw(16) << "schedule" << std::right
+			<< std::setw(10) << "k = 3" << std::setw(10) << "random"
+			<< std::setw(10) << "n - 1" << std::setw(10) << "oversized" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = elliptic_curve_registry_get(c)->curve;
+		unsigned long len = curve->field_size_bytes;
+		EllipticCurve bare = *curve;
+		bare.context = 0;
+		EllipticCurvePoint G = { }, R = { };
+		unsigned char k[4][GF2_VECTOR_MAX_BYTELEN] = { };
+		ec_test_load_base(curve, &G);
+		k[0][0] = 3;
+		for (unsigned long i = 0; i < len; ++i) {
+			k[1][i] = (unsigned char) (0x6B * (i + 3));
+			k[2][i] = curve->order[i];
+		}
+		k[1][len - 1] = 0;
+		k[2][0] -= 1;
+		for (unsigned long i = 0; i < GF2_VECTOR_MAX_BYTELEN; ++i)
+			k[3][i] = 0xFF;
+
+		const char *schedule = elliptic_curve_binary_is_koblitz(curve) ? "tau-and-add"
+				: "double-and-add";
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::setw(16) << schedule << std::right << std::fixed << std::setprecision(0);
+		for (int shape = 0; shape < 4; ++shape) {
+			unsigned long bytelen = (shape == 3) ? GF2_VECTOR_MAX_BYTELEN : len;
+			auto t0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < runs; ++r)
+				elliptic_curve_binary_point_multiply(&bare, &R, &G, k[shape], bytelen);
+			auto t1 = std::chrono::steady_clock::now();
+			std::cout << std::setw(10) << ec_test_microseconds(t0, t1, runs);
+		}
+		std::cout << "\n";
+	}
+}
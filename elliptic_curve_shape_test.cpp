@@ -0,0 +1,161 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_scalar.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x5AFE0041UL)
+#include "ec_test_util.h"
+
+// The specialized formulas (registry curve, context with its shape flags)
+// against the general ones (context-less copy)
+int test_elliptic_curve_shape() {
+	int failures = 0;
+	std::cout << "\n--- Testing curve-shape specialized formulas against the general ones ---\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurveRegistryEntry *entry = elliptic_curve_registry_get(c);
+		const EllipticCurve *curve = ec_test_registry_curve(c);
+		const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+		unsigned long len = curve->field_size_bytes;
+		unsigned long y_offset = (len + 7UL) & (~7UL);
+		EllipticCurve bare = *curve;
+		bare.context = 0;
+
+		// Koblitz curves are exactly the a in { 0, 1 }, b = 1 ones
+		unsigned int a_flags = ctx->flags & (EC_CONTEXT_FLAG_A_ZERO | EC_CONTEXT_FLAG_A_ONE);
+		int ok = (a_flags != (EC_CONTEXT_FLAG_A_ZERO | EC_CONTEXT_FLAG_A_ONE));
+		ok &= (entry->is_koblitz != 0) == (a_flags && (ctx->flags & EC_CONTEXT_FLAG_B_ONE));
+		ok &= (entry->is_koblitz != 0) == (elliptic_curve_binary_is_koblitz(curve) != 0);
+
+		EllipticCurvePoint G = { }, P = { }, Q = { }, R1 = { }, R2 = { };
+		ec_test_load_base(curve, &G);
+		for (int iter = 0; iter < 6; ++iter) {
+			unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+			for (unsigned long i = 0; i + 1 < len; ++i)
+				k[i] = ec_test_random_byte();
+			elliptic_curve_binary_point_multiply(curve, &P, &G, k, len);
+			k[0] ^= 0x5A;
+			elliptic_curve_binary_point_multiply(curve, &Q, &G, k, len);
+
+			alignas(8) unsigned char f1[GF2_VECTOR_MAX_BYTELEN] = { };
+			alignas(8) unsigned char f2[GF2_VECTOR_MAX_BYTELEN] = { };
+			for (unsigned long i = 0; i < len; ++i)
+				f1[i] = f2[i] = P.point_mem[i];
+			elliptic_curve_field_add_a(curve, f1);
+			elliptic_curve_field_add_a(&bare, f2);
+			for (unsigned long i = 0; i < len; ++i)
+				ok &= f1[i] == f2[i];
+
+			elliptic_curve_binary_point_add(curve, &R1, &P, &Q);
+			elliptic_curve_binary_point_add(&bare, &R2, &P, &Q);
+			ok &= ec_test_points_equal(curve, &R1, &R2);
+			elliptic_curve_binary_point_double(curve, &R1, &P);
+			elliptic_curve_binary_point_double(&bare, &R2, &P);
+			ok &= ec_test_points_equal(curve, &R1, &R2);
+			ok &= elliptic_curve_binary_point_on_curve(curve, &R1)
+					&& elliptic_curve_binary_point_on_curve(&bare, &R1);
+			R1.point_mem[y_offset] ^= 1;
+			ok &= !elliptic_curve_binary_point_on_curve(curve, &R1)
+					&& !elliptic_curve_binary_point_on_curve(&bare, &R1);
+
+			elliptic_curve_binary_point_multiply_ct(curve, &R1, &P, k, len);
+			elliptic_curve_binary_point_multiply_ct(&bare, &R2, &P, k, len);
+			ok &= ec_test_points_equal(curve, &R1, &R2);
+		}
+
+		// With the counters compiled in: b = 1 saves a multiplication and a
+		// squaring per ladder step, the context's sqrt(b) table a squaring
+		if (EC_OPERATION_COUNTS) {
+			EllipticCurveOperationCounts general, special;
+			unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+			k[0] = 1;
+			elliptic_curve_operation_counts_reset();
+			elliptic_curve_binary_point_multiply_ct(&bare, &R1, &G, k, len);
+			elliptic_curve_operation_counts_get(&general);
+			elliptic_curve_operation_counts_reset();
+			elliptic_curve_binary_point_multiply_ct(curve, &R2, &G, k, len);
+			elliptic_curve_operation_counts_get(&special);
+			if (ctx->flags & EC_CONTEXT_FLAG_B_ONE)
+				ok &= special.multiply < general.multiply && special.square < general.square;
+			else
+				ok &= special.multiply == general.multiply && special.square < general.square;
+		}
+
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+static void shape_test_print_counts(const EllipticCurveOperationCounts *counts, unsigned long runs) {
+	std::cout << std::right << std::setw(6) << counts->multiply / runs << "M"
+			<< std::setw(4) << counts->square / runs << "S"
+			<< std::setw(3) << counts->inverse / runs << "I";
+}
+
+// Field operations per point operation, general formulas (no context) vs.
+// the curve-shape specialized ones. The counts need a build with
+// EC_OPERATION_COUNTS=1; the ladder times are always printed.
+void benchmark_elliptic_curve_shape() {
+	const int runs = 5;
+	std::cout << "\n--- Benchmark: field operations per point operation, general / specialized ---\n";
+	if (!EC_OPERATION_COUNTS)
+		std::cout << "(operation counts need -DEC_OPERATION_COUNTS=1)\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::setw(7) << "shape"
+			<< std::setw(28) << "on_curve" << std::setw(28) << "ladder step"
+			<< std::right << std::setw(20) << "ladder us" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurve *curve = ec_test_registry_curve(c);
+		const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+		unsigned long len = curve->field_size_bytes;
+		EllipticCurve bare = *curve;
+		bare.context = 0;
+		EllipticCurvePoint G = { }, R = { };
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		ec_test_load_base(curve, &G);
+		for (unsigned long i = 0; i + 1 < len; ++i)
+			k[i] = (unsigned char) (0x6B * (i + 3));
+
+		const char *shape = (ctx->flags & EC_CONTEXT_FLAG_A_ZERO) ? "a=0"
+				: (ctx->flags & EC_CONTEXT_FLAG_A_ONE) ? "a=1" : "a";
+		std::cout << std::left << std::setw(12) << (const char*) curve->curve_name_ascii
+				<< std::setw(3) << shape << std::setw(4)
+				<< ((ctx->flags & EC_CONTEXT_FLAG_B_ONE) ? ",b=1" : ",b");
+
+		EllipticCurveOperationCounts counts[4];
+		double micros[2];
+		const EllipticCurve *variants[2] = { &bare, curve };
+		for (int v = 0; v < 2; ++v) {
+			elliptic_curve_operation_counts_reset();
+			for (int r = 0; r < runs; ++r)
+				elliptic_curve_binary_point_on_curve(variants[v], &G);
+			elliptic_curve_operation_counts_get(&counts[v]);
+
+			// bits(#E) + 1 ladder steps, the final y recovery is spread over them
+			unsigned char order[EC_SCALAR_MAX_BYTELEN];
+			unsigned long steps = elliptic_curve_scalar_group_order(curve, order) + 1;
+			elliptic_curve_operation_counts_reset();
+			auto t0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < runs; ++r)
+				elliptic_curve_binary_point_multiply_ct(variants[v], &R, &G, k, len);
+			auto t1 = std::chrono::steady_clock::now();
+			elliptic_curve_operation_counts_get(&counts[2 + v]);
+			counts[2 + v].multiply /= steps;
+			counts[2 + v].square /= steps;
+			counts[2 + v].inverse = 0;
+			micros[v] = std::chrono::duration<double, std::micro>(t1 - t0).count() / runs;
+		}
+		shape_test_print_counts(&counts[0], runs);
+		std::cout << " /";
+		shape_test_print_counts(&counts[1], runs);
+		std::cout << "  ";
+		shape_test_print_counts(&counts[2], runs);
+		std::cout << " /";
+		shape_test_print_counts(&counts[3], runs);
+		std::cout << std::fixed << std::setprecision(0) << std::setw(10) << micros[0]
+				<< " /" << std::setw(7) << micros[1] << "\n";
+	}
+}
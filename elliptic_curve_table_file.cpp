@@ -0,0 +1,126 @@
+#include "elliptic_curve_table_file.h"
+#include "elliptic_curve_registry.h"
+#include "ec_crc32.h"
+
+#define TABLE_FILE_BLOB_BYTELEN \
+	(sizeof(EllipticCurveContextBlobHeader) + sizeof(EllipticCurveContextData))
+
+unsigned int elliptic_curve_table_file_crc32(const unsigned char *in, unsigned long bytelen) {
+	return ec_crc32(in, bytelen);
+}
+
+static unsigned long table_file_align8(unsigned long n) {
+	return (n + 7UL) & (~7UL);
+}
+
+// Covers the header (with header_crc32 taken as 0) and the entry table
+static unsigned int table_file_header_crc(const unsigned char *file) {
+	const EllipticCurveTableFileHeader *header = (const EllipticCurveTableFileHeader*) file;
+	EllipticCurveTableFileHeader copy = *header;
+	copy.header_crc32 = 0;
+
+	unsigned int crc = ec_crc32_update(0xFFFFFFFFU,
+			(const unsigned char*) &copy, sizeof(copy));
+	crc = ec_crc32_update(crc, file + sizeof(EllipticCurveTableFileHeader),
+			header->entry_count * sizeof(EllipticCurveTableFileEntry));
+	return ~crc;
+}
+
+unsigned long elliptic_curve_table_file_write(const EllipticCurve *const *curves,
+		unsigned long curve_count, unsigned char *out, unsigned long out_capacity) {
+	unsigned long blobs_offset = table_file_align8(sizeof(EllipticCurveTableFileHeader)
+			+ curve_count * sizeof(EllipticCurveTableFileEntry));
+	unsigned long blob_stride = table_file_align8(TABLE_FILE_BLOB_BYTELEN);
+	unsigned long total = blobs_offset + curve_count * blob_stride;
+
+	if (!out)
+		return total;
+	if (out_capacity < total)
+		return 0;
+	for (unsigned long i = 0; i < total; ++i)
+		out[i] = 0;
+
+	EllipticCurveTableFileHeader *header = (EllipticCurveTableFileHeader*) out;
+	EllipticCurveTableFileEntry *entries =
+			(EllipticCurveTableFileEntry*) (out + sizeof(EllipticCurveTableFileHeader));
+
+	for (unsigned long c = 0; c < curve_count; ++c) {
+		unsigned long offset = blobs_offset + c * blob_stride;
+		if (!elliptic_curve_context_serialize(curves[c], out + offset, blob_stride))
+			return 0;
+		entries[c].fingerprint = elliptic_curve_fingerprint(curves[c]);
+		entries[c].offset = (unsigned int) offset;
+		entries[c].bytelen = (unsigned int) TABLE_FILE_BLOB_BYTELEN;
+		entries[c].crc32 = elliptic_curve_table_file_crc32(out + offset, TABLE_FILE_BLOB_BYTELEN);
+		for (unsigned long i = 0; i < sizeof(entries[c].curve_name_ascii); ++i)
+			entries[c].curve_name_ascii[i] = curves[c]->curve_name_ascii[i];
+	}
+
+	header->magic = EC_TABLE_FILE_MAGIC;
+	header->version = EC_TABLE_FILE_VERSION;
+	header->entry_count = (unsigned int) curve_count;
+	header->total_bytelen = (unsigned int) total;
+	header->context_bytelen = (unsigned int) sizeof(EllipticCurveContextData);
+	header->header_crc32 = table_file_header_crc(out);
+	return total;
+}
+
+int elliptic_curve_table_file_validate(const unsigned char *file, unsigned long bytelen) {
+	const EllipticCurveTableFileHeader *header = (const EllipticCurveTableFileHeader*) file;
+
+	if (!file || ((unsigned long) file & 7UL) || bytelen < sizeof(EllipticCurveTableFileHeader))
+		return 0;
+	if (header->magic != EC_TABLE_FILE_MAGIC || header->version != EC_TABLE_FILE_VERSION
+			|| header->total_bytelen != bytelen
+			|| header->context_bytelen != sizeof(EllipticCurveContextData))
+		return 0;
+	if (header->entry_count > (bytelen - sizeof(EllipticCurveTableFileHeader))
+			/ sizeof(EllipticCurveTableFileEntry))
+		return 0;
+	if (table_file_header_crc(file) != header->header_crc32)
+		return 0;
+
+	const EllipticCurveTableFileEntry *entries =
+			(const EllipticCurveTableFileEntry*) (file + sizeof(EllipticCurveTableFileHeader));
+	for (unsigned long c = 0; c < header->entry_count; ++c) {
+		const EllipticCurveTableFileEntry *e = &entries[c];
+		if ((e->offset & 7U) || e->bytelen != TABLE_FILE_BLOB_BYTELEN
+				|| e->offset > bytelen || e->bytelen > bytelen - e->offset)
+			return 0;
+		if (elliptic_curve_table_file_crc32(file + e->offset, e->bytelen) != e->crc32)
+			return 0;
+	}
+	return 1;
+}
+
+static int table_file_attach_checked(const EllipticCurve *curve,
+		const unsigned char *file) {
+	const EllipticCurveTableFileHeader *header = (const EllipticCurveTableFileHeader*) file;
+	const EllipticCurveTableFileEntry *entries =
+			(const EllipticCurveTableFileEntry*) (file + sizeof(EllipticCurveTableFileHeader));
+	unsigned long long fingerprint = elliptic_curve_fingerprint(curve);
+
+	for (unsigned long c = 0; c < header->entry_count; ++c) {
+		if (entries[c].fingerprint == fingerprint)
+			return elliptic_curve_context_attach_blob(curve,
+					file + entries[c].offset, entries[c].bytelen);
+	}
+	return 0;
+}
+
+int elliptic_curve_table_file_attach(const EllipticCurve *curve,
+		const unsigned char *file, unsigned long bytelen) {
+	if (!elliptic_curve_table_file_validate(file, bytelen))
+		return 0;
+	return table_file_attach_checked(curve, file);
+}
+
+unsigned long elliptic_curve_table_file_attach_registry(const unsigned char *file,
+		unsigned long bytelen) {
+	unsigned long attached = 0;
+	if (!elliptic_curve_table_file_validate(file, bytelen))
+		return 0;
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c)
+		attached += table_file_attach_checked(elliptic_curve_registry_get(c)->curve, file);
+	return attached;
+}
@@ -0,0 +1,72 @@
+#ifndef ELLIPTIC_CURVE_TABLE_FILE_H_
+#define ELLIPTIC_CURVE_TABLE_FILE_H_
+
+#include "elliptic_curve_context.h"
+
+// Precomputed-table file: serialized acceleration contexts for several curves
+// in one position-independent image, meant to be mapped read-only and used in
+// place (no copy, no recomputation at process start).
+//
+// Layout (native byte order, all offsets from the start of the file):
+//   EllipticCurveTableFileHeader
+//   EllipticCurveTableFileEntry[entry_count]
+//   context blobs (EllipticCurveContextBlobHeader + data), 8-byte aligned
+//
+// The header CRC covers header and entry table, every entry has its own CRC,
+// and every blob carries the fingerprint of the curve it was built for, so a
+// corrupted file or one built for other parameters / another build
+// configuration is rejected instead of being used.
+
+#define EC_TABLE_FILE_MAGIC   (0x46544345U)   // "ECTF", little endian
+#define EC_TABLE_FILE_VERSION (1U)
+
+typedef struct alignas(8){
+	unsigned int magic;
+	unsigned int version;
+	unsigned int entry_count;
+	unsigned int total_bytelen;
+	unsigned int context_bytelen;           // sizeof(EllipticCurveContextData) of the writer
+	unsigned int header_crc32;              // computed with this field set to 0
+}EllipticCurveTableFileHeader;
+
+typedef struct alignas(8){
+	unsigned long long fingerprint;         // elliptic_curve_fingerprint()
+	unsigned int offset;
+	unsigned int bytelen;
+	unsigned int crc32;
+	unsigned int reserved;
+	unsigned char curve_name_ascii[16];     // informational only
+}EllipticCurveTableFileEntry;
+
+// ec_crc32(), the checksum of the file and its entries
+unsigned int elliptic_curve_table_file_crc32(const unsigned char *in, unsigned long bytelen);
+
+// Writes a file image with one entry per curve. Returns the image size; with
+// out == 0 only the required size is returned, 0 if out_capacity is too small.
+unsigned long elliptic_curve_table_file_write(const EllipticCurve *const *curves,
+		unsigned long curve_count, unsigned char *out, unsigned long out_capacity);
+
+// Checks header, entry table and every entry CRC. Returns 1 if the image is intact.
+int elliptic_curve_table_file_validate(const unsigned char *file, unsigned long bytelen);
+
+// Attaches the entry matching the curve's fingerprint, in place. The image
+// must be 8-byte aligned and outlive the curve's use. Returns 1 on success.
+int elliptic_curve_table_file_attach(const EllipticCurve *curve,
+		const unsigned char *file, unsigned long bytelen);
+
+// Attaches every built-in curve found in the image, returns how many. The
+// registry curves only have contexts to attach to with EC_REGISTRY_CONTEXTS
+// (elliptic_curve_registry.h); otherwise this returns 0, and copies with
+// contexts of their own go through elliptic_curve_table_file_attach().
+unsigned long elliptic_curve_table_file_attach_registry(const unsigned char *file,
+		unsigned long bytelen);
+
+// POSIX hosts only, implemented in elliptic_curve_table_file_posix.cpp:
+// maps the file read-only, validates it and attaches the registry curves.
+// Returns the mapping (to be released with elliptic_curve_table_file_unmap()
+// once no curve uses it any more) or 0 on failure.
+const unsigned char* elliptic_curve_table_file_map(const char *path,
+		unsigned long *out_bytelen, unsigned long *out_attached);
+void elliptic_curve_table_file_unmap(const unsigned char *file, unsigned long bytelen);
+
+#endif /* ELLIPTIC_CURVE_TABLE_FILE_H_ */
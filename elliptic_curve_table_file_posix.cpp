@@ -0,0 +1,42 @@
+// POSIX host glue for elliptic_curve_table_file: not part of the
+// dependency-free core, leave it out of bare-metal builds.
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "elliptic_curve_table_file.h"
+
+const unsigned char* elliptic_curve_table_file_map(const char *path,
+		unsigned long *out_bytelen, unsigned long *out_attached) {
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return 0;
+	}
+	void *map = mmap(0, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return 0;
+
+	const unsigned char *file = (const unsigned char*) map;
+	unsigned long bytelen = (unsigned long) st.st_size;
+	if (!elliptic_curve_table_file_validate(file, bytelen)) {
+		munmap(map, bytelen);
+		return 0;
+	}
+	unsigned long attached = elliptic_curve_table_file_attach_registry(file, bytelen);
+	if (out_bytelen)
+		*out_bytelen = bytelen;
+	if (out_attached)
+		*out_attached = attached;
+	return file;
+}
+
+void elliptic_curve_table_file_unmap(const unsigned char *file, unsigned long bytelen) {
+	if (file)
+		munmap((void*) file, bytelen);
+}
@@ -0,0 +1,118 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <vector>
+#include "elliptic_curve_registry.h"
+#include "elliptic_curve_table_file.h"
+
+int test_elliptic_curve_table_file() {
+	int failures = 0;
+	std::cout << "\n--- Testing precomputed-table file format ---\n";
+
+	unsigned long count = elliptic_curve_registry_count();
+	std::vector<const EllipticCurve*> curves;
+	for (unsigned long c = 0; c < count; ++c)
+		curves.push_back(elliptic_curve_registry_get(c)->curve);
+
+	unsigned long size = elliptic_curve_table_file_write(curves.data(), count, 0, 0);
+	std::vector<unsigned long long> storage((size + 7) / 8);
+	unsigned char *image = (unsigned char*) storage.data();
+	int ok = elliptic_curve_table_file_write(curves.data(), count, image, size) == size;
+	ok &= elliptic_curve_table_file_write(curves.data(), count, image, size - 1) == 0;
+	ok &= elliptic_curve_table_file_validate(image, size);
+	std::cout << "Write + validate (" << size << " bytes): " << (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+
+	// Cold copies of every curve pick up their tables from the image, in place
+	for (unsigned long c = 0; c < count; ++c) {
+		const EllipticCurve *reference = curves[c];
+		EllipticCurve cold = *reference;
+		EllipticCurveContext cold_ctx = { };
+		cold.context = &cold_ctx;
+
+		ok = elliptic_curve_table_file_attach(&cold, image, size);
+		const unsigned char *data = (const unsigned char*) elliptic_curve_context_acquire(&cold);
+		ok &= data > image && data < image + size;
+
+		// Fixed-base comb from the file must agree with the generic multiply
+		EllipticCurve bare = *reference;
+		bare.context = 0;
+		EllipticCurvePoint G = { }, R1 = { }, R2 = { };
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		for (unsigned long i = 0; i < cold.field_size_bytes; ++i) {
+			k[i] = (unsigned char) (0xA7 * (i + 1) + c);
+			elliptic_curve_point_get_coord_x(&bare, &G)[i] = bare.xG[i];
+			elliptic_curve_point_get_coord_y(&bare, &G)[i] = bare.yG[i];
+		}
+		elliptic_curve_binary_point_multiply_base(&cold, &R1, k, cold.field_size_bytes);
+		elliptic_curve_binary_point_multiply(&bare, &R2, &G, k, cold.field_size_bytes);
+		unsigned char diff = 0;
+		for (unsigned long i = 0; i < elliptic_curve_point_get_coord_full_bytelen(&bare); ++i)
+			diff |= R1.point_mem[i] ^ R2.point_mem[i];
+		ok &= diff == 0;
+
+		// Parameters the file wasn't built for are not attached
+		EllipticCurve stale = *reference;
+		EllipticCurveContext stale_ctx = { };
+		stale.context = &stale_ctx;
+		stale.order[0] ^= 2;
+		ok &= !elliptic_curve_table_file_attach(&stale, image, size);
+
+		std::cout << std::left << std::setw(12) << (const char*) reference->curve_name_ascii
+				<< std::right << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// Any flipped bit is caught by the header or entry CRC
+	ok = 1;
+	for (unsigned long pos = 0; pos < size; pos += 97) {
+		image[pos] ^= 0x10;
+		ok &= !elliptic_curve_table_file_validate(image, size);
+		image[pos] ^= 0x10;
+	}
+	ok &= !elliptic_curve_table_file_validate(image + 8, size - 8);  // misaligned / truncated
+	ok &= !elliptic_curve_table_file_validate(image, size - 8);
+	std::cout << "Corruption rejected: " << (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+
+	// Round trip through a real file and mmap, attached to the registry curves
+	const char *path = "ec_tables_test.bin";
+	std::FILE *f = std::fopen(path, "wb");
+	ok = f && std::fwrite(image, 1, size, f) == size;
+	if (f)
+		std::fclose(f);
+	unsigned long mapped_len = 0, attached = 0;
+	const unsigned char *mapped = elliptic_curve_table_file_map(path, &mapped_len, &attached);
+	ok &= mapped != 0 && mapped_len == size;
+	std::cout << "mmap: " << attached << " of " << count
+			<< " registry curves attached (curves already in use keep their context)\n";
+
+	// Cold start: building a context vs. attaching it from the mapping
+	for (unsigned long c = 0; ok && c < count; ++c) {
+		EllipticCurve built = *curves[c], mapped_curve = *curves[c];
+		EllipticCurveContext built_ctx = { }, mapped_ctx = { };
+		built.context = &built_ctx;
+		mapped_curve.context = &mapped_ctx;
+
+		auto t0 = std::chrono::steady_clock::now();
+		elliptic_curve_context_acquire(&built);
+		auto t1 = std::chrono::steady_clock::now();
+		ok &= elliptic_curve_table_file_attach(&mapped_curve, mapped, mapped_len);
+		const unsigned char *data = (const unsigned char*) elliptic_curve_context_acquire(&mapped_curve);
+		auto t2 = std::chrono::steady_clock::now();
+		ok &= data > mapped && data < mapped + mapped_len;
+
+		std::cout << std::left << std::setw(12) << (const char*) curves[c]->curve_name_ascii
+				<< std::right << "build " << std::setw(8)
+				<< std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count()
+				<< " us, attach from mapping " << std::setw(6)
+				<< std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count()
+				<< " us\n";
+	}
+	std::cout << "mmap round trip: " << (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+	// Curves may now point into the mapping; keep it for the process lifetime.
+	std::remove(path);
+	return failures;
+}
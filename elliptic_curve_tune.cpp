@@ -0,0 +1,461 @@
+#include "elliptic_curve_tune.h"
+#include "ec_crc32.h"
+#include "ec_atomic.h"
+
+#define TUNE_MAX_PLANS (16)
+#define TUNE_MAX_REPS  (1UL << 20)
+
+#define TUNE_FIELD    (0)   // elliptic_curve_field_multiply
+#define TUNE_MULTIPLY (1)   // elliptic_curve_binary_point_multiply
+#define TUNE_BASE     (2)   // elliptic_curve_binary_point_multiply_base
+
+// Inputs and reference results shared by the checks and the benchmarks.
+// probe is a copy of the curve on the tuner's own context (data), bare has
+// no context and is the reference. With
+// P = 2 G, k P and (2 k) G are the same point, so one reference
+// multiplication covers both checks of an input; for k = n both are O.
+typedef struct alignas(8){
+	const EllipticCurve *probe;
+	EllipticCurve bare;
+	EllipticCurveContextData *data;
+	EllipticCurveTuneClock clock;
+	void *clock_arg;
+	unsigned char a[EC_TUNE_CHECKS][GF2_VECTOR_MAX_BYTELEN];    // reduced field elements
+	unsigned char b[EC_TUNE_CHECKS][GF2_VECTOR_MAX_BYTELEN];
+	unsigned char k[EC_TUNE_CHECKS][GF2_VECTOR_MAX_BYTELEN];    // scalars, the last one is n
+	unsigned char k2[EC_TUNE_CHECKS][GF2_VECTOR_MAX_BYTELEN + 1]; // 2 k
+	EllipticCurvePoint point;                                   // P = 2 G
+	EllipticCurvePoint expected[EC_TUNE_CHECKS];                // k P = (2 k) G
+}TuneBench;
+
+// xorshift64, seeded with the curve fingerprint: the same inputs every run
+static unsigned char tune_byte(unsigned long long *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return (unsigned char) (*state >> 24);
+}
+
+static int tune_equal(const unsigned char *a, const unsigned char *b, unsigned long bytelen) {
+	unsigned char diff = 0;
+	for (unsigned long i = 0; i < bytelen; ++i)
+		diff |= a[i] ^ b[i];
+	return diff == 0;
+}
+
+static int tune_point_equal(const EllipticCurve *curve, const EllipticCurvePoint *p,
+		const EllipticCurvePoint *q) {
+	unsigned long len = curve->field_size_bytes;
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	return tune_equal(p->point_mem, q->point_mem, len)
+			&& tune_equal(p->point_mem + y_offset, q->point_mem + y_offset, len);
+}
+
+static void tune_bench_init(TuneBench *bench, const EllipticCurve *probe,
+		EllipticCurveContextData *data, EllipticCurveTuneClock clock, void *clock_arg) {
+	unsigned long len = probe->field_size_bytes;
+	long degree = gf2_degree_lsb(probe->modulus, len);
+	unsigned long y_offset = (len + 7UL) & (~7UL);
+	unsigned long long state = elliptic_curve_fingerprint(probe) | 1ULL;
+	alignas(8) EllipticCurvePoint G = { };
+
+	unsigned char *raw = (unsigned char*) bench;
+	for (unsigned long i = 0; i < sizeof(TuneBench); ++i)
+		raw[i] = 0;
+	bench->probe = probe;
+	bench->bare = *probe;
+	bench->bare.context = 0;
+	bench->data = data;
+	bench->clock = clock;
+	bench->clock_arg = clock_arg;
+
+	for (unsigned long c = 0; c < EC_TUNE_CHECKS; ++c) {
+		for (unsigned long i = 0; i < len; ++i) {
+			bench->a[c][i] = tune_byte(&state);
+			bench->b[c][i] = tune_byte(&state);
+			bench->k[c][i] = tune_byte(&state);
+		}
+		for (long bit = degree; bit < (long) (8 * len); ++bit) {
+			bench->a[c][bit >> 3] &= (unsigned char) ~(1U << (bit & 7));
+			bench->b[c][bit >> 3] &= (unsigned char) ~(1U << (bit & 7));
+		}
+	}
+	for (unsigned long i = 0; i < len; ++i)
+		bench->k[EC_TUNE_CHECKS - 1][i] = probe->order[i];
+	for (unsigned long c = 0; c < EC_TUNE_CHECKS; ++c) {
+		unsigned char carry = 0;
+		for (unsigned long i = 0; i < len; ++i) {
+			bench->k2[c][i] = (unsigned char) ((bench->k[c][i] << 1) | carry);
+			carry = (unsigned char) (bench->k[c][i] >> 7);
+		}
+		bench->k2[c][len] = carry;
+	}
+
+	for (unsigned long i = 0; i < len; ++i) {
+		G.point_mem[i] = probe->xG[i];
+		G.point_mem[i + y_offset] = probe->yG[i];
+	}
+	elliptic_curve_binary_point_double(&bench->bare, &bench->point, &G);
+	// expected[EC_TUNE_CHECKS - 1] = n P = O stays zero
+	for (unsigned long c = 0; c + 1 < EC_TUNE_CHECKS; ++c)
+		elliptic_curve_binary_point_multiply_base(&bench->bare, &bench->expected[c],
+				bench->k2[c], len + 1);
+}
+
+// Field products with plan (through the fused kernels the curve layer
+// uses) against the schoolbook loop with the generic reduction
+static int tune_check_plan(const TuneBench *bench, const GF2MultiplyPlan *plan) {
+	const EllipticCurve *curve = bench->probe;
+	const EllipticCurveContextData *data = bench->data;
+	const GF2ReductionDescriptor *desc =
+			(data->flags & EC_CONTEXT_FLAG_SPARSE_REDUCTION) ? &data->reduction : 0;
+	unsigned long len = curve->field_size_bytes;
+	GF2MultiplyPlan reference = { 0xFFFF, 0xFFFF, GF2_MULTIPLY_KERNEL_PORTABLE };
+	int ok = 1;
+
+	for (unsigned long c = 0; c < EC_TUNE_CHECKS; ++c) {
+		alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		alignas(8) unsigned char out[GF2_VECTOR_MAX_BYTELEN] = { };
+
+		gf2_multiply_planned_lsb(bench->a[c], bench->b[c], wide, len, &reference);
+		gf2_reduce_lsb(wide, 2 * len, curve->modulus, len);
+		gf2_field_multiply_planned_lsb(bench->a[c], bench->b[c], out, len, curve->modulus,
+				desc, plan);
+		ok &= tune_equal(out, wide, len);
+
+		// + a: the multiply-add kernel on the same product
+		gf2_field_multiply_add_planned_lsb(bench->a[c], bench->b[c], bench->a[c], out, len,
+				curve->modulus, desc, plan);
+		for (unsigned long i = 0; i < len; ++i)
+			wide[i] ^= bench->a[c][i];
+		ok &= tune_equal(out, wide, len);
+	}
+	return ok;
+}
+
+// The context's current configuration against the context-free path
+static int tune_check_points(const TuneBench *bench) {
+	const EllipticCurve *curve = bench->probe;
+	unsigned long len = curve->field_size_bytes;
+	int ok = 1;
+
+	for (unsigned long c = 0; c < EC_TUNE_CHECKS; ++c) {
+		alignas(8) EllipticCurvePoint out = { };
+		elliptic_curve_binary_point_multiply(curve, &out, &bench->point, bench->k[c], len);
+		ok &= tune_point_equal(curve, &out, &bench->expected[c]);
+		elliptic_curve_binary_point_multiply_base(curve, &out, bench->k2[c], len + 1);
+		ok &= tune_point_equal(curve, &out, &bench->expected[c]);
+	}
+	return ok;
+}
+
+static void tune_apply(const TuneBench *bench, const EllipticCurveTuning *tuning) {
+	EllipticCurveContextData *data = bench->data;
+	if (data->comb_width != tuning->comb_width)
+		elliptic_curve_context_build_comb(bench->probe, data, tuning->comb_width);
+	data->tuning = *tuning;
+	data->flags |= EC_CONTEXT_FLAG_TUNED;
+}
+
+static void tune_run(const TuneBench *bench, int what, unsigned long reps) {
+	const EllipticCurve *curve = bench->probe;
+	unsigned long len = curve->field_size_bytes;
+	alignas(8) unsigned char x[GF2_VECTOR_MAX_BYTELEN] = { };
+	alignas(8) EllipticCurvePoint out = { };
+
+	for (unsigned long i = 0; i < len; ++i)
+		x[i] = bench->a[0][i];
+	for (unsigned long r = 0; r < reps; ++r) {
+		if (what == TUNE_FIELD)
+			elliptic_curve_field_multiply(curve, x, x, bench->b[0]);
+		else if (what == TUNE_MULTIPLY)
+			elliptic_curve_binary_point_multiply(curve, &out, &bench->point, bench->k[0], len);
+		else
+			elliptic_curve_binary_point_multiply_base(curve, &out, bench->k[0], len);
+	}
+}
+
+static unsigned long long tune_sample(const TuneBench *bench, int what, unsigned long reps) {
+	unsigned long long start = bench->clock(bench->clock_arg);
+	tune_run(bench, what, reps);
+	return bench->clock(bench->clock_arg) - start;
+}
+
+// Repetitions for samples of at least EC_TUNE_SAMPLE_NS, once per stage so
+// that all candidates of the stage run the same work
+static unsigned long tune_calibrate(const TuneBench *bench, int what) {
+	unsigned long reps = 1;
+	while (reps < TUNE_MAX_REPS && tune_sample(bench, what, reps) < EC_TUNE_SAMPLE_NS)
+		reps *= 2;
+	return reps;
+}
+
+// Nanoseconds per operation, fastest of EC_TUNE_ROUNDS samples
+static unsigned long long tune_time(const TuneBench *bench, int what, unsigned long reps) {
+	unsigned long long best = ~0ULL;
+	for (int r = 0; r < EC_TUNE_ROUNDS; ++r) {
+		unsigned long long t = tune_sample(bench, what, reps);
+		if (t < best)
+			best = t;
+	}
+	return best / reps;
+}
+
+static unsigned int tune_ns(unsigned long long ns) {
+	return ns > 0xFFFFFFFFULL ? 0xFFFFFFFFU : (unsigned int) ns;
+}
+
+// Every compiled-in kernel, plain and with each split threshold that makes
+// a difference at this operand size (the 32-bit limb backend has none)
+static unsigned long tune_plan_candidates(unsigned long words, GF2MultiplyPlan *out) {
+	static const unsigned short kernels[3] = {
+		GF2_MULTIPLY_KERNEL_PORTABLE, GF2_MULTIPLY_KERNEL_CLMUL, GF2_MULTIPLY_KERNEL_LIMB32
+	};
+	unsigned long count = 0;
+
+	gf2_multiply_plan_default(&out[count++]);
+	for (int k = 0; k < 3; ++k) {
+		if (!gf2_multiply_kernel_available(kernels[k]) || count >= TUNE_MAX_PLANS)
+			continue;
+		GF2MultiplyPlan plan = { 0xFFFF, 0xFFFF, kernels[k] };
+		out[count++] = plan;
+		if (kernels[k] == GF2_MULTIPLY_KERNEL_LIMB32)
+			continue;
+		for (unsigned long t = 2; t <= words && count < TUNE_MAX_PLANS; ++t) {
+			plan.karatsuba_threshold_words = (unsigned short) t;
+			out[count++] = plan;
+		}
+		if (words >= 3 && count < TUNE_MAX_PLANS) {
+			plan.karatsuba_threshold_words = 0xFFFF;
+			plan.toom3_threshold_words = 3;
+			out[count++] = plan;
+		}
+	}
+	return count;
+}
+
+// Field backend first, then the point multiplications on top of it. Leaves
+// the winner applied. Returns 0 if no candidate passed a check.
+static int tune_measure(const TuneBench *bench, EllipticCurveTuning *out) {
+	const EllipticCurveContextData *data = bench->data;
+	unsigned long words = (bench->probe->field_size_bytes + 7) / 8;
+	EllipticCurveTuning tuning;
+	GF2MultiplyPlan plans[TUNE_MAX_PLANS];
+	unsigned long long best;
+	unsigned long reps;
+
+	elliptic_curve_tuning_default(&tuning);
+	tuning.origin = EC_TUNE_ORIGIN_MEASURED;
+
+	unsigned long plan_count = tune_plan_candidates(words, plans);
+	GF2MultiplyPlan best_plan = plans[0];
+	tune_apply(bench, &tuning);
+	reps = tune_calibrate(bench, TUNE_FIELD);
+	best = ~0ULL;
+	for (unsigned long p = 0; p < plan_count; ++p) {
+		if (!tune_check_plan(bench, &plans[p]))
+			continue;
+		tuning.plan = plans[p];
+		tune_apply(bench, &tuning);
+		unsigned long long t = tune_time(bench, TUNE_FIELD, reps);
+		if (t < best) {
+			best = t;
+			best_plan = plans[p];
+		}
+	}
+	if (best == ~0ULL)
+		return 0;
+	tuning.plan = best_plan;
+	tuning.field_multiply_ns = tune_ns(best);
+
+	// Double-and-add is a candidate of its own where the default is a shortcut
+	unsigned short methods[3] = { EC_TUNE_MULTIPLY_AUTO };
+	unsigned long method_count = 1;
+	if (elliptic_curve_binary_is_koblitz(bench->probe) || (data->flags & EC_CONTEXT_FLAG_HALVING))
+		methods[method_count++] = EC_TUNE_MULTIPLY_DOUBLE_AND_ADD;
+	methods[method_count++] = EC_TUNE_MULTIPLY_LADDER;
+	unsigned short best_method = EC_TUNE_MULTIPLY_AUTO;
+	tune_apply(bench, &tuning);
+	reps = tune_calibrate(bench, TUNE_MULTIPLY);
+	best = ~0ULL;
+	for (unsigned long m = 0; m < method_count; ++m) {
+		tuning.multiply = methods[m];
+		tune_apply(bench, &tuning);
+		if (!tune_check_points(bench))
+			continue;
+		unsigned long long t = tune_time(bench, TUNE_MULTIPLY, reps);
+		if (t < best) {
+			best = t;
+			best_method = methods[m];
+		}
+	}
+	if (best == ~0ULL)
+		return 0;
+	tuning.multiply = best_method;
+	tuning.point_multiply_ns = tune_ns(best);
+
+	unsigned short width = EC_CONTEXT_COMB_WIDTH < 2 ? EC_CONTEXT_COMB_WIDTH : 2;
+	unsigned short best_width = EC_CONTEXT_COMB_WIDTH;
+	tuning.comb_width = width;
+	tune_apply(bench, &tuning);
+	reps = tune_calibrate(bench, TUNE_BASE);
+	best = ~0ULL;
+	for (; width <= EC_CONTEXT_COMB_WIDTH; ++width) {
+		tuning.comb_width = width;
+		tune_apply(bench, &tuning);
+		if (!tune_check_points(bench))
+			continue;
+		unsigned long long t = tune_time(bench, TUNE_BASE, reps);
+		if (t < best) {
+			best = t;
+			best_width = width;
+		}
+	}
+	if (best == ~0ULL)
+		return 0;
+	tuning.comb_width = best_width;
+	tuning.base_multiply_ns = tune_ns(best);
+
+	tune_apply(bench, &tuning);
+	*out = tuning;
+	return 1;
+}
+
+// Fields a check cannot catch: a kernel this build lacks would silently
+// fall back, a comb wider than the table does not fit.
+static int tune_preset_usable(const EllipticCurveTuning *tuning) {
+	return gf2_multiply_kernel_available(tuning->plan.kernel)
+			&& tuning->comb_width >= 2 && tuning->comb_width <= EC_CONTEXT_COMB_WIDTH
+			&& tuning->multiply <= EC_TUNE_MULTIPLY_LADDER;
+}
+
+void elliptic_curve_tune_build(const EllipticCurve *curve, EllipticCurveContext *ctx) {
+	EllipticCurveContext probe_ctx;
+	EllipticCurve probe = *curve;
+	TuneBench bench;
+	EllipticCurveTuning tuning;
+	int tuned = 0;
+
+	// Candidates are applied to a ready context of our own: ctx is not
+	// ready yet and only gets the winner
+	elliptic_curve_context_init(&probe_ctx);
+	probe_ctx.storage = ctx->storage;
+	probe_ctx.data = &probe_ctx.storage;
+	probe_ctx.state = EC_CONTEXT_STATE_READY;
+	probe.context = &probe_ctx;
+	tune_bench_init(&bench, &probe, &probe_ctx.storage, ctx->tune_clock, ctx->tune_clock_arg);
+
+	if (ctx->tune_preset.comb_width && tune_preset_usable(&ctx->tune_preset)) {
+		tuning = ctx->tune_preset;
+		tuning.origin = EC_TUNE_ORIGIN_PRESET;
+		tune_apply(&bench, &tuning);
+		tuned = tune_check_plan(&bench, &tuning.plan) && tune_check_points(&bench);
+	}
+	if (!tuned && ctx->tune_clock)
+		tuned = tune_measure(&bench, &tuning);
+	// The adopted configuration as a whole, once more
+	if (tuned)
+		tuned = tune_check_plan(&bench, &tuning.plan) && tune_check_points(&bench);
+	if (tuned)
+		ctx->storage = probe_ctx.storage;
+}
+
+void elliptic_curve_tune_at_first_use(EllipticCurveContext *ctx,
+		EllipticCurveTuneClock clock, void *clock_arg) {
+	ctx->tune_clock = clock;
+	ctx->tune_clock_arg = clock_arg;
+	ctx->tune_hook = elliptic_curve_tune_build;
+}
+
+void elliptic_curve_tune_preset(EllipticCurveContext *ctx, const EllipticCurveTuning *tuning) {
+	ctx->tune_preset = *tuning;
+	ctx->tune_hook = elliptic_curve_tune_build;
+}
+
+int elliptic_curve_tune(const EllipticCurve *curve, EllipticCurveTuneClock clock,
+		void *clock_arg) {
+	EllipticCurveContext *ctx = curve->context;
+	if (!ctx || !clock)
+		return 0;
+	if (EC_ATOMIC_LOAD_ACQUIRE(&ctx->state) == EC_CONTEXT_STATE_EMPTY)
+		elliptic_curve_tune_at_first_use(ctx, clock, clock_arg);
+	return elliptic_curve_tuning_get(curve) != 0;
+}
+
+const EllipticCurveTuning* elliptic_curve_tuning_get(const EllipticCurve *curve) {
+	const EllipticCurveContextData *ctx = elliptic_curve_context_acquire(curve);
+	if (ctx && (ctx->flags & EC_CONTEXT_FLAG_TUNED))
+		return &ctx->tuning;
+	return 0;
+}
+
+// Entry count of an intact image, -1 otherwise
+static long tuning_file_entries(const unsigned char *image, unsigned long bytelen) {
+	const EllipticCurveTuningFileHeader *header = (const EllipticCurveTuningFileHeader*) image;
+
+	if (!image || ((unsigned long) image & 7UL) || bytelen < sizeof(EllipticCurveTuningFileHeader))
+		return -1;
+	if (header->magic != EC_TUNING_FILE_MAGIC || header->version != EC_TUNING_FILE_VERSION
+			|| header->entry_bytelen != sizeof(EllipticCurveTuningFileEntry)
+			|| header->entry_count > EC_TUNING_FILE_MAX_ENTRIES)
+		return -1;
+	unsigned long entries_bytelen = header->entry_count * sizeof(EllipticCurveTuningFileEntry);
+	if (bytelen < sizeof(EllipticCurveTuningFileHeader) + entries_bytelen)
+		return -1;
+	if (ec_crc32(image + sizeof(EllipticCurveTuningFileHeader),
+			entries_bytelen) != header->crc32)
+		return -1;
+	return (long) header->entry_count;
+}
+
+int elliptic_curve_tuning_file_find(const unsigned char *image, unsigned long bytelen,
+		const EllipticCurve *curve, EllipticCurveTuning *out) {
+	long count = tuning_file_entries(image, bytelen);
+	const EllipticCurveTuningFileEntry *entries =
+			(const EllipticCurveTuningFileEntry*) (image + sizeof(EllipticCurveTuningFileHeader));
+	unsigned long long fingerprint = elliptic_curve_fingerprint(curve);
+
+	for (long i = 0; i < count; ++i) {
+		if (entries[i].fingerprint == fingerprint) {
+			*out = entries[i].tuning;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+unsigned long elliptic_curve_tuning_file_update(unsigned char *image, unsigned long bytelen,
+		unsigned long capacity, const EllipticCurve *curve, const EllipticCurveTuning *tuning) {
+	long count = tuning_file_entries(image, bytelen);
+	EllipticCurveTuningFileHeader *header = (EllipticCurveTuningFileHeader*) image;
+	EllipticCurveTuningFileEntry *entries =
+			(EllipticCurveTuningFileEntry*) (image + sizeof(EllipticCurveTuningFileHeader));
+	unsigned long long fingerprint = elliptic_curve_fingerprint(curve);
+
+	if (!image || ((unsigned long) image & 7UL))
+		return 0;
+	if (count < 0)
+		count = 0;
+	long slot = count;
+	for (long i = 0; i < count; ++i)
+		if (entries[i].fingerprint == fingerprint)
+			slot = i;
+	if (slot == count)
+		++count;
+
+	unsigned long entries_bytelen = (unsigned long) count * sizeof(EllipticCurveTuningFileEntry);
+	unsigned long total = sizeof(EllipticCurveTuningFileHeader) + entries_bytelen;
+	if (count > EC_TUNING_FILE_MAX_ENTRIES || capacity < total)
+		return 0;
+
+	entries[slot].fingerprint = fingerprint;
+	entries[slot].tuning = *tuning;
+	header->magic = EC_TUNING_FILE_MAGIC;
+	header->version = EC_TUNING_FILE_VERSION;
+	header->entry_count = (unsigned int) count;
+	header->entry_bytelen = sizeof(EllipticCurveTuningFileEntry);
+	header->reserved = 0;
+	header->crc32 = ec_crc32(image + sizeof(EllipticCurveTuningFileHeader),
+			entries_bytelen);
+	return total;
+}
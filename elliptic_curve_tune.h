@@ -0,0 +1,113 @@
+#ifndef ELLIPTIC_CURVE_TUNE_H_
+#define ELLIPTIC_CURVE_TUNE_H_
+
+#include "elliptic_curve_context.h"
+
+// Per-curve auto-tuning: which field multiplication backend (portable, CLMUL
+// or 32-bit limb kernel, Karatsuba / Toom-3 thresholds), which fixed-base
+// comb width and which variable-base multiplication (affine tau-, halve- or
+// double-and-add, or the projective ladder) is fastest depends on the CPU
+// and the curve. The tuner times each candidate with a short calibrated
+// benchmark and records the winners in the curve context
+// (EllipticCurveContextData::tuning, EC_CONTEXT_FLAG_TUNED), where the curve
+// layer picks them up.
+//
+// Every candidate is first checked against the reference implementation:
+// field products against the portable schoolbook multiplication with the
+// generic reduction, point multiplications against the context-free
+// double-and-add, on a few pseudo-random inputs. A candidate that disagrees
+// is never timed, and a configuration that fails the final check is dropped
+// for the defaults.
+//
+// Tuning happens while the context is built, so it follows the context's
+// rules: set it up before the curve is shared; it then runs once, in the
+// first thread that uses the curve, while the others wait (a few tens of
+// milliseconds per curve). The core needs no clock of its own: the caller
+// hands one in (elliptic_curve_tune_clock_posix() on POSIX hosts).
+//
+// A measured tuning can be kept in a small tuning file (see below) and
+// handed to later processes as a preset, which is only checked, not timed.
+
+// Shortest timed sample: repetitions double until one sample lasts this long.
+#ifndef EC_TUNE_SAMPLE_NS
+#define EC_TUNE_SAMPLE_NS (1000000ULL)
+#endif
+// Samples per candidate; the fastest one counts.
+#ifndef EC_TUNE_ROUNDS
+#define EC_TUNE_ROUNDS (3)
+#endif
+#define EC_TUNE_CHECKS (3)          // inputs every candidate is checked on
+
+// Measure with clock when the (still empty) context is built, i.e. at the
+// curve's first use.
+void elliptic_curve_tune_at_first_use(EllipticCurveContext *ctx,
+		EllipticCurveTuneClock clock, void *clock_arg);
+// Adopt tuning when the (still empty) context is built, after checking it.
+// If it is rejected (another build, another CPU, a bad file) the context
+// measures instead when it has a clock, otherwise keeps the defaults.
+void elliptic_curve_tune_preset(EllipticCurveContext *ctx, const EllipticCurveTuning *tuning);
+
+// Explicit call: tunes the curve's context now, building it. Returns 1 if
+// the context ends up tuned; 0 without a context, or if it was already
+// built untuned (a context in use is read-only).
+int elliptic_curve_tune(const EllipticCurve *curve, EllipticCurveTuneClock clock,
+		void *clock_arg);
+
+// The tuning in effect, 0 if the curve runs on the defaults.
+const EllipticCurveTuning* elliptic_curve_tuning_get(const EllipticCurve *curve);
+
+// The context's tune hook, installed by the calls above. Checks and times
+// the candidates on a ready copy of ctx->storage that only it can reach
+// (about sizeof(EllipticCurveContext) of stack), then writes the winner to
+// ctx->storage; the defaults stay if nothing passes.
+void elliptic_curve_tune_build(const EllipticCurve *curve, EllipticCurveContext *ctx);
+
+// Tuning file: one entry per curve, keyed by elliptic_curve_fingerprint().
+// Layout (native byte order): EllipticCurveTuningFileHeader, then
+// entry_count EllipticCurveTuningFileEntry. The CRC covers the entries, the
+// header fields are checked one by one.
+#define EC_TUNING_FILE_MAGIC       (0x55544345U)   // "ECTU", little endian
+#define EC_TUNING_FILE_VERSION     (1U)
+#define EC_TUNING_FILE_MAX_ENTRIES (32)
+
+typedef struct alignas(8){
+	unsigned int magic;
+	unsigned int version;
+	unsigned int entry_count;
+	unsigned int entry_bytelen;             // sizeof(EllipticCurveTuningFileEntry) of the writer
+	unsigned int crc32;
+	unsigned int reserved;
+}EllipticCurveTuningFileHeader;
+
+typedef struct alignas(8){
+	unsigned long long fingerprint;         // elliptic_curve_fingerprint()
+	EllipticCurveTuning tuning;
+}EllipticCurveTuningFileEntry;
+
+#define EC_TUNING_FILE_MAX_BYTELEN (sizeof(EllipticCurveTuningFileHeader) \
+		+ EC_TUNING_FILE_MAX_ENTRIES * sizeof(EllipticCurveTuningFileEntry))
+
+// Finds the curve's entry in an 8-byte aligned image. Returns 1 and fills
+// out, or 0 if the image is damaged, of another version or has no entry for
+// the curve. The entry still goes through elliptic_curve_tune_preset()'s
+// checks before it is used.
+int elliptic_curve_tuning_file_find(const unsigned char *image, unsigned long bytelen,
+		const EllipticCurve *curve, EllipticCurveTuning *out);
+
+// Adds or replaces the curve's entry in the image of bytelen bytes (a
+// damaged or empty one starts over) and returns the new length, 0 if
+// capacity is too small. image must be 8-byte aligned.
+unsigned long elliptic_curve_tuning_file_update(unsigned char *image, unsigned long bytelen,
+		unsigned long capacity, const EllipticCurve *curve, const EllipticCurveTuning *tuning);
+
+// POSIX hosts only, implemented in elliptic_curve_tune_posix.cpp.
+// load: 1 if the file has an entry for the curve. save: rewrites the file
+// (through a temporary and rename) with the curve's entry added or
+// replaced, 1 on success. The clock is CLOCK_MONOTONIC, arg unused.
+int elliptic_curve_tuning_load(const char *path, const EllipticCurve *curve,
+		EllipticCurveTuning *out);
+int elliptic_curve_tuning_save(const char *path, const EllipticCurve *curve,
+		const EllipticCurveTuning *tuning);
+unsigned long long elliptic_curve_tune_clock_posix(void *arg);
+
+#endif /* ELLIPTIC_CURVE_TUNE_H_ */
@@ -0,0 +1,80 @@
+// POSIX host glue for elliptic_curve_tune: not part of the dependency-free
+// core, leave it out of bare-metal builds.
+#include <fcntl.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "elliptic_curve_tune.h"
+
+#define TUNING_PATH_MAX (1024)
+
+// Up to capacity bytes of the file, 0 if it cannot be read
+static unsigned long tuning_read(const char *path, unsigned char *out, unsigned long capacity) {
+	int fd = open(path, O_RDONLY);
+	unsigned long total = 0;
+	if (fd < 0)
+		return 0;
+	while (total < capacity) {
+		ssize_t n = read(fd, out + total, capacity - total);
+		if (n <= 0)
+			break;
+		total += (unsigned long) n;
+	}
+	close(fd);
+	return total;
+}
+
+int elliptic_curve_tuning_load(const char *path, const EllipticCurve *curve,
+		EllipticCurveTuning *out) {
+	alignas(8) unsigned char image[EC_TUNING_FILE_MAX_BYTELEN];
+	unsigned long bytelen = tuning_read(path, image, sizeof(image));
+	return elliptic_curve_tuning_file_find(image, bytelen, curve, out);
+}
+
+int elliptic_curve_tuning_save(const char *path, const EllipticCurve *curve,
+		const EllipticCurveTuning *tuning) {
+	alignas(8) unsigned char image[EC_TUNING_FILE_MAX_BYTELEN];
+	char temporary[TUNING_PATH_MAX];
+	unsigned long length = 0;
+
+	while (path[length] && length + 5 < sizeof(temporary)) {
+		temporary[length] = path[length];
+		++length;
+	}
+	if (path[length])
+		return 0;
+	temporary[length++] = '.';
+	temporary[length++] = 't';
+	temporary[length++] = 'm';
+	temporary[length++] = 'p';
+	temporary[length] = 0;
+
+	unsigned long bytelen = tuning_read(path, image, sizeof(image));
+	bytelen = elliptic_curve_tuning_file_update(image, bytelen, sizeof(image), curve, tuning);
+	if (!bytelen)
+		return 0;
+
+	int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return 0;
+	unsigned long written = 0;
+	while (written < bytelen) {
+		ssize_t n = write(fd, image + written, bytelen - written);
+		if (n <= 0)
+			break;
+		written += (unsigned long) n;
+	}
+	if (close(fd) != 0 || written != bytelen || rename(temporary, path) != 0) {
+		unlink(temporary);
+		return 0;
+	}
+	return 1;
+}
+
+unsigned long long elliptic_curve_tune_clock_posix(void *arg) {
+	struct timespec now;
+	(void) arg;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long) now.tv_sec * 1000000000ULL + (unsigned long long) now.tv_nsec;
+}
@@ -0,0 +1,327 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "elliptic_curve_registry.h"
+#include "elliptic_curve_tune.h"
+#include "ec_test_util.h"
+
+static const char *tune_method_name(unsigned int method) {
+	if (method == EC_TUNE_MULTIPLY_DOUBLE_AND_ADD)
+		return "double-and-add";
+	if (method == EC_TUNE_MULTIPLY_LADDER)
+		return "ladder";
+	return "auto";
+}
+
+// The curve layer on a tuned copy against the context-free path: multiply
+// and multiply_base on random scalars, 0, n and O, and the field product
+static int tune_test_agrees(const EllipticCurve *tuned, unsigned int seed) {
+	EllipticCurve bare = *tuned;
+	bare.context = 0;
+	unsigned long len = tuned->field_size_bytes;
+	EllipticCurvePoint G = { }, P = { }, O = { }, R1 = { }, R2 = { };
+	unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+	int ok = 1;
+
+	for (unsigned long i = 0; i < len; ++i) {
+		elliptic_curve_point_get_coord_x(&bare, &G)[i] = bare.xG[i];
+		elliptic_curve_point_get_coord_y(&bare, &G)[i] = bare.yG[i];
+		k[i] = (unsigned char) (0x3B * (i + 1) + seed);
+	}
+	elliptic_curve_binary_point_multiply(&bare, &P, &G, k, len);
+
+	for (int t = 0; t < 5; ++t) {
+		for (unsigned long i = 0; i < len; ++i) {
+			if (t < 3)
+				k[i] = (unsigned char) (0x5D * (i + 7) + 31 * t + seed);
+			else
+				k[i] = (t == 3) ? 0 : tuned->order[i];
+		}
+		elliptic_curve_binary_point_multiply(tuned, &R1, &P, k, len);
+		elliptic_curve_binary_point_multiply(&bare, &R2, &P, k, len);
+		ok &= ec_test_points_equal(tuned, &R1, &R2);
+		elliptic_curve_binary_point_multiply_base(tuned, &R1, k, len);
+		elliptic_curve_binary_point_multiply_base(&bare, &R2, k, len);
+		ok &= ec_test_points_equal(tuned, &R1, &R2);
+		elliptic_curve_binary_point_multiply(tuned, &R1, &O, k, len);
+		ok &= ec_test_points_equal(tuned, &R1, &O);
+
+		unsigned char x1[GF2_VECTOR_MAX_BYTELEN] = { }, x2[GF2_VECTOR_MAX_BYTELEN] = { };
+		elliptic_curve_field_multiply(tuned, x1, elliptic_curve_point_get_coord_x(&bare, &P),
+				elliptic_curve_point_get_coord_y(&bare, &R2));
+		elliptic_curve_field_multiply(&bare, x2, elliptic_curve_point_get_coord_x(&bare, &P),
+				elliptic_curve_point_get_coord_y(&bare, &R2));
+		for (unsigned long i = 0; i < len; ++i)
+			ok &= x1[i] == x2[i];
+	}
+	return ok;
+}
+
+int test_elliptic_curve_tune() {
+	int failures = 0;
+	std::cout << "\n--- Testing per-curve auto-tuning ---\n";
+
+	unsigned long count = elliptic_curve_registry_count();
+	std::vector<EllipticCurveTuning> measured(count);
+
+	// Explicit tuning of a cold copy of every curve
+	for (unsigned long c = 0; c < count; ++c) {
+		const EllipticCurve *reference = elliptic_curve_registry_get(c)->curve;
+		EllipticCurve cold = *reference;
+		EllipticCurveContext *ctx = new EllipticCurveContext();
+		cold.context = ctx;
+
+		int ok = elliptic_curve_tune(&cold, elliptic_curve_tune_clock_posix, 0);
+		const EllipticCurveTuning *tuning = elliptic_curve_tuning_get(&cold);
+		ok &= tuning != 0;
+		if (tuning) {
+			measured[c] = *tuning;
+			ok &= tuning->origin == EC_TUNE_ORIGIN_MEASURED;
+			ok &= gf2_multiply_kernel_available(tuning->plan.kernel);
+			ok &= tuning->comb_width >= 1 && tuning->comb_width <= EC_CONTEXT_COMB_WIDTH;
+			ok &= elliptic_curve_context_acquire(&cold)->comb_width == tuning->comb_width;
+			ok &= tuning->field_multiply_ns && tuning->point_multiply_ns
+					&& tuning->base_multiply_ns;
+		}
+		ok &= tune_test_agrees(&cold, (unsigned int) c);
+		// A built context is read-only
+		EllipticCurve late = *reference;
+		EllipticCurveContext *late_ctx = new EllipticCurveContext();
+		late.context = late_ctx;
+		elliptic_curve_context_acquire(&late);
+		ok &= !elliptic_curve_tune(&late, elliptic_curve_tune_clock_posix, 0);
+		ok &= elliptic_curve_tuning_get(&late) == 0;
+
+		std::cout << std::left << std::setw(12) << (const char*) reference->curve_name_ascii
+				<< std::right << (ok ? "PASS" : "FAIL");
+		if (tuning)
+			std::cout << "  kernel " << (tuning->plan.kernel == GF2_MULTIPLY_KERNEL_CLMUL ? "clmul"
+					: tuning->plan.kernel == GF2_MULTIPLY_KERNEL_LIMB32 ? "limb32" : "portable")
+					<< ", karatsuba " << tuning->plan.karatsuba_threshold_words
+					<< ", toom3 " << tuning->plan.toom3_threshold_words
+					<< ", comb " << tuning->comb_width
+					<< ", " << tune_method_name(tuning->multiply);
+		std::cout << "\n";
+		failures += !ok;
+		delete late_ctx;
+		delete ctx;
+	}
+
+	// Every configuration, handed in as a preset, gives the reference results
+	{
+		int ok = 1;
+		for (unsigned long c = 0; c < count; ++c) {
+			const EllipticCurve *reference = elliptic_curve_registry_get(c)->curve;
+			for (unsigned int method = 0; method <= EC_TUNE_MULTIPLY_LADDER; ++method) {
+				EllipticCurve cold = *reference;
+				EllipticCurveContext *ctx = new EllipticCurveContext();
+				cold.context = ctx;
+				EllipticCurveTuning preset;
+				elliptic_curve_tuning_default(&preset);
+				preset.multiply = (unsigned short) method;
+				preset.comb_width = (unsigned short) (method == 1 ? 2 : EC_CONTEXT_COMB_WIDTH);
+				preset.plan.karatsuba_threshold_words = (unsigned short) (method + 1);
+				elliptic_curve_tune_preset(ctx, &preset);
+				const EllipticCurveTuning *tuning = elliptic_curve_tuning_get(&cold);
+				ok &= tuning && tuning->origin == EC_TUNE_ORIGIN_PRESET
+						&& tuning->multiply == method;
+				ok &= tune_test_agrees(&cold, method);
+				delete ctx;
+			}
+		}
+		std::cout << "Presets, all methods: " << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// Presets this build cannot honour are dropped: defaults without a
+	// clock, a fresh measurement with one
+	{
+		const EllipticCurve *reference = elliptic_curve_registry_get(0)->curve;
+		EllipticCurveTuning bad;
+		int ok = 1;
+		for (int variant = 0; variant < 4; ++variant) {
+			elliptic_curve_tuning_default(&bad);
+			if (variant == 0)
+				bad.comb_width = EC_CONTEXT_COMB_WIDTH + 1;
+			else if (variant == 3)
+				bad.comb_width = 1;
+			else if (variant == 1)
+				bad.multiply = 7;
+			else if (!gf2_multiply_kernel_available(GF2_MULTIPLY_KERNEL_CLMUL))
+				bad.plan.kernel = GF2_MULTIPLY_KERNEL_CLMUL;
+			else
+				bad.plan.kernel = 5;
+			EllipticCurve cold = *reference;
+			EllipticCurveContext *ctx = new EllipticCurveContext();
+			cold.context = ctx;
+			elliptic_curve_tune_preset(ctx, &bad);
+			ok &= elliptic_curve_tuning_get(&cold) == 0;
+			ok &= elliptic_curve_context_acquire(&cold)->comb_width == EC_CONTEXT_COMB_WIDTH;
+			delete ctx;
+
+			EllipticCurve timed = *reference;
+			ctx = new EllipticCurveContext();
+			timed.context = ctx;
+			elliptic_curve_tune_preset(ctx, &bad);
+			elliptic_curve_tune_at_first_use(ctx, elliptic_curve_tune_clock_posix, 0);
+			const EllipticCurveTuning *tuning = elliptic_curve_tuning_get(&timed);
+			ok &= tuning && tuning->origin == EC_TUNE_ORIGIN_MEASURED;
+			delete ctx;
+		}
+		std::cout << "Unusable presets rejected: " << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// Tuning at first use while other threads wait for the context
+	{
+		const EllipticCurve *reference = elliptic_curve_registry_get(count - 1)->curve;
+		EllipticCurve cold = *reference;
+		EllipticCurveContext *ctx = new EllipticCurveContext();
+		cold.context = ctx;
+		elliptic_curve_tune_at_first_use(ctx, elliptic_curve_tune_clock_posix, 0);
+		int results[4] = { };
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t)
+			threads.emplace_back([&, t] { results[t] = tune_test_agrees(&cold, (unsigned int) t); });
+		for (auto &thread : threads)
+			thread.join();
+		int ok = results[0] && results[1] && results[2] && results[3];
+		ok &= elliptic_curve_tuning_get(&cold) != 0;
+		std::cout << "First use from 4 threads: " << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+		delete ctx;
+	}
+
+	// Tuning file image: add, replace, find, reject damage and other curves
+	{
+		alignas(8) unsigned char image[EC_TUNING_FILE_MAX_BYTELEN] = { };
+		unsigned long bytelen = 0;
+		int ok = 1;
+		for (unsigned long c = 0; c < count; ++c)
+			ok &= (bytelen = elliptic_curve_tuning_file_update(image, bytelen, sizeof(image),
+					elliptic_curve_registry_get(c)->curve, &measured[c])) != 0;
+		EllipticCurveTuning replaced = measured[0];
+		replaced.comb_width = 2;
+		unsigned long before = bytelen;
+		bytelen = elliptic_curve_tuning_file_update(image, bytelen, sizeof(image),
+				elliptic_curve_registry_get(0)->curve, &replaced);
+		ok &= bytelen == before;
+		for (unsigned long c = 0; c < count; ++c) {
+			EllipticCurveTuning found;
+			ok &= elliptic_curve_tuning_file_find(image, bytelen,
+					elliptic_curve_registry_get(c)->curve, &found);
+			ok &= found.comb_width == (c ? measured[c].comb_width : 2);
+		}
+		EllipticCurve stale = *elliptic_curve_registry_get(0)->curve;
+		stale.b[0] ^= 1;
+		EllipticCurveTuning found;
+		ok &= !elliptic_curve_tuning_file_find(image, bytelen, &stale, &found);
+		ok &= !elliptic_curve_tuning_file_update(image, bytelen,
+				sizeof(EllipticCurveTuningFileHeader), &stale, &replaced);
+		for (unsigned long pos = 0; pos < bytelen; pos += 13) {
+			image[pos] ^= 0x04;
+			ok &= !elliptic_curve_tuning_file_find(image, bytelen,
+					elliptic_curve_registry_get(0)->curve, &found);
+			image[pos] ^= 0x04;
+		}
+		std::cout << "File image (" << bytelen << " bytes): " << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// A later process: load the saved tuning as a preset, no measurement
+	{
+		const char *path = "ec_tuning_test.bin";
+		std::remove(path);
+		int ok = 1;
+		for (unsigned long c = 0; c < count; ++c)
+			ok &= elliptic_curve_tuning_save(path, elliptic_curve_registry_get(c)->curve,
+					&measured[c]);
+		for (unsigned long c = 0; c < count; ++c) {
+			const EllipticCurve *reference = elliptic_curve_registry_get(c)->curve;
+			EllipticCurve cold = *reference;
+			EllipticCurveContext *ctx = new EllipticCurveContext();
+			cold.context = ctx;
+			EllipticCurveTuning loaded;
+			ok &= elliptic_curve_tuning_load(path, &cold, &loaded);
+			elliptic_curve_tune_preset(ctx, &loaded);
+			auto t0 = std::chrono::steady_clock::now();
+			const EllipticCurveTuning *tuning = elliptic_curve_tuning_get(&cold);
+			auto t1 = std::chrono::steady_clock::now();
+			ok &= tuning && tuning->origin == EC_TUNE_ORIGIN_PRESET;
+			ok &= tuning && tuning->plan.kernel == measured[c].plan.kernel
+					&& tuning->comb_width == measured[c].comb_width
+					&& tuning->multiply == measured[c].multiply;
+			ok &= tune_test_agrees(&cold, (unsigned int) c);
+			std::cout << std::left << std::setw(12) << (const char*) reference->curve_name_ascii
+					<< std::right << "context with preset " << std::setw(8)
+					<< std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count()
+					<< " us\n";
+			delete ctx;
+		}
+		EllipticCurveTuning loaded;
+		ok &= !elliptic_curve_tuning_load("ec_tuning_missing.bin",
+				elliptic_curve_registry_get(0)->curve, &loaded);
+		std::cout << "File round trip: " << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+		std::remove(path);
+	}
+	return failures;
+}
+
+// Tuning cost per curve, and the tuned against the default configuration
+void benchmark_elliptic_curve_tune() {
+	std::cout << "\n--- Benchmark: per-curve auto-tuning ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right
+			<< std::setw(11) << "tune ms" << std::setw(14) << "mul default"
+			<< std::setw(12) << "mul tuned" << std::setw(14) << "base default"
+			<< std::setw(12) << "base tuned" << "  (us per multiplication)\n";
+
+	unsigned long count = elliptic_curve_registry_count();
+	for (unsigned long c = 0; c < count; ++c) {
+		const EllipticCurve *reference = elliptic_curve_registry_get(c)->curve;
+		EllipticCurve plain = *reference, tuned = *reference;
+		EllipticCurveContext *plain_ctx = new EllipticCurveContext();
+		EllipticCurveContext *tuned_ctx = new EllipticCurveContext();
+		plain.context = plain_ctx;
+		tuned.context = tuned_ctx;
+		unsigned long len = reference->field_size_bytes;
+
+		auto t0 = std::chrono::steady_clock::now();
+		elliptic_curve_tune(&tuned, elliptic_curve_tune_clock_posix, 0);
+		auto t1 = std::chrono::steady_clock::now();
+		elliptic_curve_context_acquire(&plain);
+
+		EllipticCurvePoint G = { }, R = { };
+		unsigned char k[GF2_VECTOR_MAX_BYTELEN] = { };
+		for (unsigned long i = 0; i < len; ++i) {
+			elliptic_curve_point_get_coord_x(&plain, &G)[i] = plain.xG[i];
+			elliptic_curve_point_get_coord_y(&plain, &G)[i] = plain.yG[i];
+			k[i] = (unsigned char) (0xC5 * (i + 3) + c);
+		}
+		const int iters = 100;
+		double us[4];
+		const EllipticCurve *curves[2] = { &plain, &tuned };
+		for (int v = 0; v < 4; ++v) {
+			auto s = std::chrono::steady_clock::now();
+			for (int i = 0; i < iters; ++i) {
+				if (v < 2)
+					elliptic_curve_binary_point_multiply(curves[v & 1], &R, &G, k, len);
+				else
+					elliptic_curve_binary_point_multiply_base(curves[v & 1], &R, k, len);
+			}
+			auto e = std::chrono::steady_clock::now();
+			us[v] = std::chrono::duration<double, std::micro>(e - s).count() / iters;
+		}
+		std::cout << std::left << std::setw(12) << (const char*) reference->curve_name_ascii
+				<< std::right << std::fixed << std::setprecision(1)
+				<< std::setw(11) << std::chrono::duration<double, std::milli>(t1 - t0).count()
+				<< std::setw(14) << us[0] << std::setw(12) << us[1]
+				<< std::setw(14) << us[2] << std::setw(12) << us[3] << "\n";
+		std::cout.unsetf(std::ios::fixed);
+		delete tuned_ctx;
+		delete plain_ctx;
+	}
+}
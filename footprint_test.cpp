@@ -0,0 +1,250 @@
+// Peak stack / static memory footprint harness (Linux host only).
+//
+// Every measured API call runs on its own painted stack region (ucontext),
+// the high-water mark is found by scanning for the first overwritten byte.
+// Results are compared against per-call budgets so an optimization that
+// blows the RAM budget shows up as a FAIL line.
+//
+// Numbers are host numbers (x86-64 frames, host compiler flags); they track
+// the Cortex-M figures from README.md proportionally, not exactly.
+
+#include <iostream>
+#include <iomanip>
+#include <ucontext.h>
+
+#include "ecdh.h"
+#include "ecdh_peer.h"
+#include "elliptic_curve_msm.h"
+#include "elliptic_curve_context.h"
+#include "elliptic_curve_registry.h"
+#include "galois_field2_limb32.h"
+
+#ifndef FOOTPRINT_STACK_REGION_BYTES
+#define FOOTPRINT_STACK_REGION_BYTES (256UL * 1024UL)
+#endif
+
+// Default budget: the library keeps all temporaries on the stack, sized by
+// GF2_VECTOR_MAX_BYTELEN; allow 48 vectors worth plus call overhead.
+#ifndef FOOTPRINT_STACK_BUDGET_BYTES
+#define FOOTPRINT_STACK_BUDGET_BYTES (48UL * GF2_VECTOR_MAX_BYTELEN + 1024UL)
+#endif
+
+#define FOOTPRINT_PAINT_BYTE (0xA5)
+
+typedef struct {
+	const EllipticCurve *curve;
+	alignas(8) unsigned char private_key[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char public_key[2 * GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char peer_public_key[2 * GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char shared_secret[GF2_VECTOR_MAX_BYTELEN];
+	alignas(8) unsigned char scratch[4 * GF2_VECTOR_MAX_BYTELEN];
+	EllipticCurvePoint base_point;
+	GF2ReductionDescriptor reduction;
+} footprint_env_t;
+
+typedef struct {
+	const char *name;
+	void (*run)(footprint_env_t *env);
+	unsigned long budget_bytes;
+} footprint_case_t;
+
+alignas(16) static unsigned char footprint_stack[FOOTPRINT_STACK_REGION_BYTES];
+static ucontext_t footprint_caller_ctx;
+static ucontext_t footprint_callee_ctx;
+static const footprint_case_t *footprint_current_case;
+static footprint_env_t *footprint_current_env;
+
+static void footprint_trampoline() {
+	if (footprint_current_case->run)
+		footprint_current_case->run(footprint_current_env);
+}
+
+// Runs one case on the painted region and returns the number of bytes that
+// were touched below the top of the region.
+static unsigned long footprint_measure(const footprint_case_t *c,
+		footprint_env_t *env) {
+	for (unsigned long i = 0; i < FOOTPRINT_STACK_REGION_BYTES; ++i)
+		footprint_stack[i] = FOOTPRINT_PAINT_BYTE;
+
+	footprint_current_case = c;
+	footprint_current_env = env;
+	getcontext(&footprint_callee_ctx);
+	footprint_callee_ctx.uc_stack.ss_sp = footprint_stack;
+	footprint_callee_ctx.uc_stack.ss_size = FOOTPRINT_STACK_REGION_BYTES;
+	footprint_callee_ctx.uc_link = &footprint_caller_ctx;
+	makecontext(&footprint_callee_ctx, footprint_trampoline, 0);
+	swapcontext(&footprint_caller_ctx, &footprint_callee_ctx);
+
+	unsigned long low = 0;
+	while (low < FOOTPRINT_STACK_REGION_BYTES
+			&& footprint_stack[low] == FOOTPRINT_PAINT_BYTE)
+		++low;
+	return FOOTPRINT_STACK_REGION_BYTES - low;
+}
+
+static void footprint_load_base_point(footprint_env_t *env) {
+	const EllipticCurve *curve = env->curve;
+	unsigned char *x = elliptic_curve_point_get_coord_x(curve, &env->base_point);
+	unsigned char *y = elliptic_curve_point_get_coord_y(curve, &env->base_point);
+	for (unsigned long i = 0; i < curve->field_size_bytes; ++i) {
+		x[i] = curve->xG[i];
+		y[i] = curve->yG[i];
+	}
+}
+
+static void footprint_run_point_double(footprint_env_t *env) {
+	elliptic_curve_binary_point_double(env->curve,
+			(EllipticCurvePoint*) env->scratch, &env->base_point);
+}
+static void footprint_run_point_add(footprint_env_t *env) {
+	elliptic_curve_binary_point_add(env->curve,
+			(EllipticCurvePoint*) env->scratch, &env->base_point,
+			(EllipticCurvePoint*) env->public_key);
+}
+static void footprint_run_point_on_curve(footprint_env_t *env) {
+	elliptic_curve_binary_point_on_curve(env->curve, &env->base_point);
+}
+static void footprint_run_point_multiply(footprint_env_t *env) {
+	elliptic_curve_binary_point_multiply(env->curve,
+			(EllipticCurvePoint*) env->scratch, &env->base_point,
+			env->private_key, env->curve->field_size_bytes);
+}
+static void footprint_run_point_multiply_ct(footprint_env_t *env) {
+	elliptic_curve_binary_point_multiply_ct(env->curve,
+			(EllipticCurvePoint*) env->scratch, &env->base_point,
+			env->private_key, env->curve->field_size_bytes);
+}
+static void footprint_run_field_inverse_ct(footprint_env_t *env) {
+	gf2_inverse_ct_lsb(env->curve->xG, env->scratch,
+			env->curve->field_size_bytes, env->curve->modulus, 0);
+}
+static void footprint_run_msm2(footprint_env_t *env) {
+	elliptic_curve_msm2(env->curve, (EllipticCurvePoint*) env->scratch,
+			&env->base_point, env->private_key,
+			(EllipticCurvePoint*) env->public_key, env->private_key,
+			env->curve->field_size_bytes);
+}
+static void footprint_run_field_inverse(footprint_env_t *env) {
+	gf2_binary_inverse_lsb(env->curve->xG, env->scratch,
+			env->curve->field_size_bytes, env->curve->modulus);
+}
+#if GF2_HAVE_LIMB32
+static void footprint_run_limb32_multiply(footprint_env_t *env) {
+	gf2_limb32_field_multiply_lsb(env->curve->xG, env->curve->yG, env->scratch,
+			env->curve->field_size_bytes, env->curve->modulus, &env->reduction);
+}
+static void footprint_run_limb32_multiply2_add(footprint_env_t *env) {
+	gf2_limb32_field_multiply2_add_lsb(env->curve->xG, env->curve->yG, env->curve->b,
+			env->curve->xG, env->scratch, env->curve->field_size_bytes,
+			env->curve->modulus, &env->reduction);
+}
+static void footprint_run_limb32_square(footprint_env_t *env) {
+	gf2_limb32_field_square_lsb(env->curve->xG, env->scratch,
+			env->curve->field_size_bytes, env->curve->modulus, &env->reduction);
+}
+#endif
+static void footprint_run_context_build(footprint_env_t *env) {
+	static EllipticCurveContextData data;
+	elliptic_curve_context_build(env->curve, &data);
+}
+static void footprint_run_ecdh_generate_public_key(footprint_env_t *env) {
+	ecdh_generate_public_key(env->curve, env->private_key, env->public_key);
+}
+static void footprint_run_ecdh_generate_shared_secret_ct(footprint_env_t *env) {
+	ecdh_generate_shared_secret_ct(env->curve, env->private_key,
+			env->peer_public_key, env->shared_secret);
+}
+static void footprint_run_ecdh_public_key_verify(footprint_env_t *env) {
+	ecdh_public_key_verify(env->curve, env->peer_public_key);
+}
+static void footprint_run_ecdh_generate_shared_secret(footprint_env_t *env) {
+	ecdh_generate_shared_secret(env->curve, env->private_key,
+			env->peer_public_key, env->shared_secret);
+}
+
+// Prepared by the case before, used by the case after
+static EcdhPreparedPeer footprint_peer;
+static void footprint_run_ecdh_peer_prepare(footprint_env_t *env) {
+	ecdh_peer_prepare(env->curve, &footprint_peer, env->peer_public_key);
+}
+static void footprint_run_ecdh_generate_shared_secret_prepared(footprint_env_t *env) {
+	ecdh_generate_shared_secret_prepared(&footprint_peer, env->private_key,
+			env->shared_secret);
+}
+
+static const footprint_case_t footprint_cases[] = {
+	{ "gf2_binary_inverse_lsb", footprint_run_field_inverse, FOOTPRINT_STACK_BUDGET_BYTES },
+#if GF2_HAVE_LIMB32
+	// The 32-bit limb backend answers to its own configured limit
+	{ "gf2_limb32_field_multiply_lsb", footprint_run_limb32_multiply, GF2_LIMB32_RAM_LIMIT_BYTES },
+	{ "gf2_limb32_field_multiply2_add_lsb", footprint_run_limb32_multiply2_add, GF2_LIMB32_RAM_LIMIT_BYTES },
+	{ "gf2_limb32_field_square_lsb", footprint_run_limb32_square, GF2_LIMB32_RAM_LIMIT_BYTES },
+#endif
+	{ "elliptic_curve_binary_point_double", footprint_run_point_double, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "elliptic_curve_binary_point_add", footprint_run_point_add, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "elliptic_curve_binary_point_on_curve", footprint_run_point_on_curve, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "elliptic_curve_binary_point_multiply", footprint_run_point_multiply, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "gf2_inverse_ct_lsb", footprint_run_field_inverse_ct, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "elliptic_curve_binary_point_multiply_ct", footprint_run_point_multiply_ct, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "elliptic_curve_msm2", footprint_run_msm2, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "elliptic_curve_context_build", footprint_run_context_build, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "ecdh_generate_public_key", footprint_run_ecdh_generate_public_key, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "ecdh_public_key_verify", footprint_run_ecdh_public_key_verify, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "ecdh_generate_shared_secret", footprint_run_ecdh_generate_shared_secret, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "ecdh_generate_shared_secret_ct", footprint_run_ecdh_generate_shared_secret_ct, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "ecdh_peer_prepare", footprint_run_ecdh_peer_prepare, FOOTPRINT_STACK_BUDGET_BYTES },
+	{ "ecdh_generate_shared_secret_prepared", footprint_run_ecdh_generate_shared_secret_prepared, FOOTPRINT_STACK_BUDGET_BYTES },
+};
+
+int test_footprint() {
+	static footprint_env_t env;
+	int failures = 0;
+
+	std::cout << "\n--- Footprint: static object sizes (bytes) ---\n";
+	std::cout << "GF2_VECTOR_MAX_BYTELEN:  " << GF2_VECTOR_MAX_BYTELEN << "\n";
+	std::cout << "EllipticCurve:           " << sizeof(EllipticCurve) << "\n";
+	std::cout << "EllipticCurvePoint:      " << sizeof(EllipticCurvePoint) << "\n";
+	std::cout << "ecdh_keygroup_t:         " << sizeof(ecdh_keygroup_t) << "\n";
+	std::cout << "EllipticCurveContext:    " << sizeof(EllipticCurveContext) << "\n";
+#if GF2_HAVE_LIMB32
+	std::cout << "limb32 square table:     " << GF2_LIMB32_SQUARE_TABLE_BYTES << " / "
+			<< GF2_LIMB32_ROM_LIMIT_BYTES << "\n";
+#endif
+
+	// Cost of the trampoline itself, subtracted from every measurement.
+	const footprint_case_t empty_case = { "empty", 0, 0 };
+	unsigned long overhead = footprint_measure(&empty_case, &env);
+	std::cout << "Harness overhead:        " << overhead << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurveRegistryEntry *entry = elliptic_curve_registry_get(c);
+		const EllipticCurve *curve = entry->curve;
+
+		env.curve = curve;
+		for (unsigned long i = 0; i < GF2_VECTOR_MAX_BYTELEN; ++i)
+			env.private_key[i] = 0;
+		// Full-length scalar so the multiply walks every bit of the field.
+		for (unsigned long i = 0; i + 1 < curve->field_size_bytes; ++i)
+			env.private_key[i] = (unsigned char) (0x5A ^ (i * 0x1D));
+		footprint_load_base_point(&env);
+		gf2_reduction_descriptor_init(&env.reduction, curve->modulus, curve->field_size_bytes);
+		ecdh_generate_public_key(curve, env.private_key, env.public_key);
+		ecdh_generate_public_key(curve, env.private_key, env.peer_public_key);
+
+		std::cout << "\n--- Footprint: peak stack per call, " << entry->sec_name
+				<< " ---\n";
+		for (unsigned long i = 0; i < sizeof(footprint_cases) / sizeof(footprint_cases[0]); ++i) {
+			const footprint_case_t *fc = &footprint_cases[i];
+			unsigned long used = footprint_measure(fc, &env);
+			used = (used > overhead) ? used - overhead : 0;
+			int ok = used <= fc->budget_bytes;
+			failures += !ok;
+			std::cout << std::left << std::setw(44) << fc->name << std::right
+					<< std::setw(8) << used << " / " << std::setw(6)
+					<< fc->budget_bytes << (ok ? "  ok" : "  FAIL: over budget")
+					<< "\n";
+		}
+	}
+	std::cout << (failures ? "Footprint test FAILED\n" : "Footprint test passed\n");
+	return failures;
+}
@@ -1,4 +1,7 @@
 #include "galois_field2.h"
+#if GF2_HAVE_LIMB32
+#include "galois_field2_limb32.h"
+#endif
 
 long gf2_degree_lsb(const unsigned char* in, unsigned long bytelen) {
     long i;
@@ -14,26 +17,402 @@ long gf2_degree_lsb(const unsigned char* in, unsigned long bytelen) {
     return -1;
 }
 
-void gf2_multiply_lsb(const unsigned char* in1, const unsigned char* in2, unsigned char* out, unsigned long bytelen) {
-    unsigned long total_bits = bytelen * 8;
-    unsigned long out_bytelen = bytelen * 2;
+// ---- Polynomial multiplication over 64-bit words ----
+//
+// Operands are loaded into little-endian 64-bit words and multiplied by a
+// 64x64 carry-less base kernel, a schoolbook loop over words, and Karatsuba
+// and Toom-3 splits above the plan's thresholds. All scratch lives on the
+// caller's stack; its size is checked against GF2_MULTIPLY_SCRATCH_WORDS.
+
+#define GF2_WORDS(bytelen)          (((bytelen) + 7UL) >> 3)
+#define GF2_MAX_WORDS               GF2_WORDS(GF2_VECTOR_MAX_BYTELEN)
+#define GF2_MULTIPLY_SCRATCH_WORDS  (6 * GF2_MAX_WORDS + 16)
+
+// Keeps the window table of the base kernel and the split scratch out of
+// the frames that recurse or stay on the plain schoolbook path.
+#if defined(__GNUC__) || defined(__clang__)
+#define GF2_NOINLINE __attribute__((noinline))
+#else
+#define GF2_NOINLINE
+#endif
+
+typedef unsigned long long gf2_word_t;
+
+// 64x64 -> 128 carry-less product, 4-bit window over a, with the three top
+// bits of b that the window table shifts out added back afterwards.
+static void gf2_mul1_portable(gf2_word_t a, gf2_word_t b,
+                              gf2_word_t* lo, gf2_word_t* hi)
+{
+    gf2_word_t table[16];
+    gf2_word_t l, h, g, m;
+    unsigned int i;
+
+    table[0] = 0;
+    table[1] = b;
+    for (i = 2; i < 16; i += 2) {
+        table[i] = table[i >> 1] << 1;
+        table[i + 1] = table[i] ^ b;
+    }
+    l = table[a & 15];
+    h = 0;
+    for (i = 4; i < 64; i += 4) {
+        g = table[(a >> i) & 15];
+        l ^= g << i;
+        h ^= g >> (64 - i);
+    }
+    m = (0ULL - (b >> 63)) & 0xEEEEEEEEEEEEEEEEULL;
+    h ^= (a & m) >> 1;
+    m = (0ULL - ((b >> 62) & 1)) & 0xCCCCCCCCCCCCCCCCULL;
+    h ^= (a & m) >> 2;
+    m = (0ULL - ((b >> 61) & 1)) & 0x8888888888888888ULL;
+    h ^= (a & m) >> 3;
+    *lo = l;
+    *hi = h;
+}
+
+#if GF2_HAVE_CLMUL
+typedef long long gf2_v2di __attribute__((vector_size(16)));
+
+static void gf2_mul1_clmul(gf2_word_t a, gf2_word_t b,
+                           gf2_word_t* lo, gf2_word_t* hi)
+{
+    gf2_v2di va = { (long long)a, 0 };
+    gf2_v2di vb = { (long long)b, 0 };
+    gf2_v2di r = __builtin_ia32_pclmulqdq128(va, vb, 0x00);
+    *lo = (gf2_word_t)r[0];
+    *hi = (gf2_word_t)r[1];
+}
+#endif
+
+// out[0 .. 2n) = a * b
+static GF2_NOINLINE void gf2_mul_words_base(const gf2_word_t* a, const gf2_word_t* b,
+                               gf2_word_t* out, unsigned long n, int kernel)
+{
     unsigned long i, j;
+    gf2_word_t lo, hi;
 
-    for (i = 0; i < out_bytelen; ++i)
+    for (i = 0; i < 2 * n; ++i)
         out[i] = 0;
+    for (i = 0; i < n; ++i) {
+        if (!a[i])
+            continue;
+        for (j = 0; j < n; ++j) {
+#if GF2_HAVE_CLMUL
+            if (kernel == GF2_MULTIPLY_KERNEL_CLMUL)
+                gf2_mul1_clmul(a[i], b[j], &lo, &hi);
+            else
+#endif
+                gf2_mul1_portable(a[i], b[j], &lo, &hi);
+            out[i + j] ^= lo;
+            out[i + j + 1] ^= hi;
+        }
+    }
+    (void)kernel;
+}
 
-    for (i = 0; i < total_bits; ++i) {
-        unsigned char bit1 = (in1[i >> 3] >> (i & 7)) & 1;
-        if (!bit1) continue;
+static void gf2_mul_words(const gf2_word_t* a, const gf2_word_t* b,
+                          gf2_word_t* out, unsigned long n,
+                          const GF2MultiplyPlan* plan, gf2_word_t* scratch);
 
-        for (j = 0; j < total_bits; ++j) {
-            unsigned char bit2 = (in2[j >> 3] >> (j & 7)) & 1;
-            if (!bit2) continue;
+// Karatsuba, h = ceil(n / 2):
+// a*b = p0 + y (pm + p0 + p2) + y^2 p2, y = x^(64 h), pm = (a0 + a1)(b0 + b1)
+// Scratch: 6h words + the sub-products' scratch.
+static void gf2_mul_words_karatsuba(const gf2_word_t* a, const gf2_word_t* b,
+                                    gf2_word_t* out, unsigned long n,
+                                    const GF2MultiplyPlan* plan,
+                                    gf2_word_t* scratch)
+{
+    unsigned long h = (n + 1) >> 1;
+    unsigned long l = n - h;                    // high half length, l <= h
+    gf2_word_t* sa = scratch;
+    gf2_word_t* sb = scratch + h;
+    gf2_word_t* pm = scratch + 2 * h;
+    gf2_word_t* rest = scratch + 4 * h;
+    unsigned long i;
 
-            unsigned long k = i + j;
-            out[k >> 3] ^= (1U << (k & 7));
+    for (i = 0; i < h; ++i) {
+        sa[i] = a[i] ^ (i < l ? a[h + i] : 0);
+        sb[i] = b[i] ^ (i < l ? b[h + i] : 0);
+    }
+    // p0 -> out[0 .. 2h), p2 -> out[2h .. 2n); the halves do not overlap
+    gf2_mul_words(a, b, out, h, plan, rest);
+    if (l == h) {
+        gf2_mul_words(a + h, b + h, out + 2 * h, l, plan, rest);
+    } else {
+        // odd n: pad the high halves to h words, the product still fits 2l + 1
+        gf2_word_t* ha = pm;
+        gf2_word_t* hb = pm + h;
+        gf2_word_t* hp = rest;
+        for (i = 0; i < h; ++i) {
+            ha[i] = i < l ? a[h + i] : 0;
+            hb[i] = i < l ? b[h + i] : 0;
+        }
+        gf2_mul_words(ha, hb, hp, h, plan, rest + 2 * h);
+        for (i = 0; i < 2 * l; ++i)
+            out[2 * h + i] = hp[i];
+    }
+    gf2_mul_words(sa, sb, pm, h, plan, rest);
+    for (i = 0; i < 2 * h; ++i)
+        pm[i] ^= out[i] ^ (i < 2 * l ? out[2 * h + i] : 0);
+    for (i = 0; i < 2 * h && h + i < 2 * n; ++i)
+        out[h + i] ^= pm[i];
+}
+
+// In-place exact division by (x + 1): q_i = r_i + q_(i-1), a prefix XOR
+static void gf2_words_divide_x_plus_1(gf2_word_t* inout, unsigned long n)
+{
+    gf2_word_t carry = 0;
+    unsigned long i;
+    for (i = 0; i < n; ++i) {
+        gf2_word_t w = inout[i];
+        w ^= w << 1;
+        w ^= w << 2;
+        w ^= w << 4;
+        w ^= w << 8;
+        w ^= w << 16;
+        w ^= w << 32;
+        w ^= carry;
+        carry = 0ULL - (w >> 63);
+        inout[i] = w;
+    }
+}
+
+// In-place exact division by x
+static void gf2_words_divide_x(gf2_word_t* inout, unsigned long n)
+{
+    unsigned long i;
+    for (i = 0; i + 1 < n; ++i)
+        inout[i] = (inout[i] >> 1) | (inout[i + 1] << 63);
+    inout[n - 1] >>= 1;
+}
+
+// Toom-3 over GF(2)[x] (Bodrato), k = ceil(n / 3), y = x^(64 k), evaluated at
+// y in { 0, 1, x, x + 1, inf }. With c0..c4 the product's coefficients:
+//   s1 = r(1) + c0 + c4                      = c1 + c2 + c3
+//   A  = (r(x) + c0 + x^4 c4) / x            = c1 + c2 x + c3 x^2
+//   B  = (r(x+1) + c0 + (x+1)^4 c4) / (x+1)  = s1 + c2 x + c3 x^2
+//   c3 = ((A + s1) / (x+1) + A + B) / x,  c2 = A + B + c3,  c1 = s1 + c2 + c3
+// Scratch: 12k + 8 words + the sub-products' scratch.
+static void gf2_mul_words_toom3(const gf2_word_t* a, const gf2_word_t* b,
+                                gf2_word_t* out, unsigned long n,
+                                const GF2MultiplyPlan* plan,
+                                gf2_word_t* scratch)
+{
+    unsigned long k = (n + 2) / 3;
+    unsigned long l = n - 2 * k;                // top part length, 1 <= l <= k
+    unsigned long e = k + 1;                    // evaluations at x, x+1 grow by 2 bits
+    gf2_word_t* a1 = scratch;                   // U(1), V(1): k words each
+    gf2_word_t* b1 = a1 + k;
+    gf2_word_t* ax = b1 + k;                    // U(x), V(x): e words each
+    gf2_word_t* bx = ax + e;
+    gf2_word_t* ax1 = bx + e;                   // U(x+1), V(x+1)
+    gf2_word_t* bx1 = ax1 + e;
+    gf2_word_t* r1 = bx1 + e;                   // 2k words
+    gf2_word_t* rx = r1 + 2 * k;                // 2e words
+    gf2_word_t* rx1 = rx + 2 * e;               // 2e words
+    gf2_word_t* rest = rx1 + 2 * e;
+    unsigned long i;
+
+    for (i = 0; i < e; ++i) {
+        // u0 + u1 x + u2 x^2 and u0 + u1 (x+1) + u2 (x^2+1), word by word
+        gf2_word_t u0 = i < k ? a[i] : 0, v0 = i < k ? b[i] : 0;
+        gf2_word_t u1 = i < k ? a[k + i] : 0, v1 = i < k ? b[k + i] : 0;
+        gf2_word_t u2 = i < l ? a[2 * k + i] : 0, v2 = i < l ? b[2 * k + i] : 0;
+        gf2_word_t u1p = (i && i - 1 < k) ? a[k + i - 1] : 0;
+        gf2_word_t v1p = (i && i - 1 < k) ? b[k + i - 1] : 0;
+        gf2_word_t u2p = (i && i - 1 < l) ? a[2 * k + i - 1] : 0;
+        gf2_word_t v2p = (i && i - 1 < l) ? b[2 * k + i - 1] : 0;
+        gf2_word_t xu1 = (u1 << 1) | (u1p >> 63), xv1 = (v1 << 1) | (v1p >> 63);
+        gf2_word_t xxu2 = (u2 << 2) | (u2p >> 62), xxv2 = (v2 << 2) | (v2p >> 62);
+        if (i < k) {
+            a1[i] = u0 ^ u1 ^ u2;
+            b1[i] = v0 ^ v1 ^ v2;
         }
+        ax[i] = u0 ^ xu1 ^ xxu2;
+        bx[i] = v0 ^ xv1 ^ xxv2;
+        ax1[i] = ax[i] ^ u1 ^ u2;
+        bx1[i] = bx[i] ^ v1 ^ v2;
+    }
+
+    // c0 -> out[0 .. 2k), c4 -> out[4k .. 2n), zeros in between
+    for (i = 0; i < 2 * n; ++i)
+        out[i] = 0;
+    gf2_mul_words(a, b, out, k, plan, rest);
+    {
+        gf2_word_t* ta = rx;                    // pad u2, v2 to k words
+        gf2_word_t* tb = rx + k;
+        gf2_word_t* tp = rx1;
+        for (i = 0; i < k; ++i) {
+            ta[i] = i < l ? a[2 * k + i] : 0;
+            tb[i] = i < l ? b[2 * k + i] : 0;
+        }
+        gf2_mul_words(ta, tb, tp, k, plan, rest);
+        for (i = 0; i < 2 * l; ++i)
+            out[4 * k + i] = tp[i];
+    }
+    gf2_mul_words(a1, b1, r1, k, plan, rest);
+    gf2_mul_words(ax, bx, rx, e, plan, rest);
+    gf2_mul_words(ax1, bx1, rx1, e, plan, rest);
+
+    // c0 and c4 are 2k words at most, shifts by 4 bits need one word more
+    const gf2_word_t* c0 = out;
+    const gf2_word_t* c4 = out + 4 * k;
+    unsigned long c4_len = 2 * l;
+    for (i = 0; i < 2 * e; ++i) {
+        gf2_word_t w0 = i < 2 * k ? c0[i] : 0;
+        gf2_word_t w4 = i < c4_len ? c4[i] : 0;
+        gf2_word_t w4p = (i && i - 1 < c4_len) ? c4[i - 1] : 0;
+        gf2_word_t x4c4 = (w4 << 4) | (w4p >> 60);
+        if (i < 2 * k)
+            r1[i] ^= w0 ^ w4;                   // s1
+        rx[i] ^= w0 ^ x4c4;
+        rx1[i] ^= w0 ^ x4c4 ^ w4;               // (x+1)^4 = x^4 + 1
+    }
+    gf2_words_divide_x(rx, 2 * e);              // A
+    gf2_words_divide_x_plus_1(rx1, 2 * e);      // B
+    for (i = 0; i < 2 * e; ++i) {
+        gf2_word_t s1 = i < 2 * k ? r1[i] : 0;
+        gf2_word_t sum = rx[i] ^ rx1[i];        // A + B = c2 + c3
+        rx1[i] = rx[i] ^ s1;                    // A + s1
+        rx[i] = sum;
+    }
+    gf2_words_divide_x_plus_1(rx1, 2 * e);
+    for (i = 0; i < 2 * e; ++i)
+        rx1[i] ^= rx[i];
+    gf2_words_divide_x(rx1, 2 * e);             // c3
+    for (i = 0; i < 2 * e; ++i) {
+        rx[i] ^= rx1[i];                        // c2
+        if (i < 2 * k)
+            r1[i] ^= rx[i] ^ rx1[i];            // c1
+    }
+
+    for (i = 0; i < 2 * k && k + i < 2 * n; ++i)
+        out[k + i] ^= r1[i];
+    for (i = 0; i < 2 * e && 2 * k + i < 2 * n; ++i)
+        out[2 * k + i] ^= rx[i];
+    for (i = 0; i < 2 * e && 3 * k + i < 2 * n; ++i)
+        out[3 * k + i] ^= rx1[i];
+}
+
+static int gf2_mul_use_toom3(unsigned long n, const GF2MultiplyPlan* plan)
+{
+    return n >= 3 && n >= plan->toom3_threshold_words;
+}
+
+static int gf2_mul_use_karatsuba(unsigned long n, const GF2MultiplyPlan* plan)
+{
+    return n >= 2 && n >= plan->karatsuba_threshold_words;
+}
+
+static unsigned long gf2_mul_scratch_words(unsigned long n,
+                                           const GF2MultiplyPlan* plan)
+{
+    if (gf2_mul_use_toom3(n, plan)) {
+        unsigned long k = (n + 2) / 3;
+        return 12 * k + 8 + gf2_mul_scratch_words(k + 1, plan);
+    }
+    if (gf2_mul_use_karatsuba(n, plan)) {
+        unsigned long h = (n + 1) >> 1;
+        return 6 * h + gf2_mul_scratch_words(h, plan);
+    }
+    return 0;
+}
+
+static void gf2_mul_words(const gf2_word_t* a, const gf2_word_t* b,
+                          gf2_word_t* out, unsigned long n,
+                          const GF2MultiplyPlan* plan, gf2_word_t* scratch)
+{
+    if (gf2_mul_use_toom3(n, plan))
+        gf2_mul_words_toom3(a, b, out, n, plan, scratch);
+    else if (gf2_mul_use_karatsuba(n, plan))
+        gf2_mul_words_karatsuba(a, b, out, n, plan, scratch);
+    else
+        gf2_mul_words_base(a, b, out, n, plan->kernel);
+}
+
+void gf2_multiply_plan_default(GF2MultiplyPlan* plan) {
+    plan->karatsuba_threshold_words = GF2_KARATSUBA_THRESHOLD_WORDS;
+    plan->toom3_threshold_words = GF2_TOOM3_THRESHOLD_WORDS;
+    plan->kernel = GF2_HAVE_CLMUL ? GF2_MULTIPLY_KERNEL_CLMUL
+                 : GF2_PREFER_LIMB32 ? GF2_MULTIPLY_KERNEL_LIMB32
+                 : GF2_MULTIPLY_KERNEL_PORTABLE;
+}
+
+int gf2_multiply_kernel_available(int kernel) {
+    return kernel == GF2_MULTIPLY_KERNEL_PORTABLE
+        || (kernel == GF2_MULTIPLY_KERNEL_LIMB32 && GF2_HAVE_LIMB32)
+        || (kernel == GF2_MULTIPLY_KERNEL_CLMUL && GF2_HAVE_CLMUL);
+}
+
+static GF2_NOINLINE void gf2_mul_words_split(const gf2_word_t* a,
+                                             const gf2_word_t* b,
+                                             gf2_word_t* out, unsigned long n,
+                                             const GF2MultiplyPlan* plan)
+{
+    gf2_word_t scratch[GF2_MULTIPLY_SCRATCH_WORDS];
+    gf2_mul_words(a, b, out, n, plan, scratch);
+}
+
+// out[0 .. 2n) = a * b following plan, falling back as documented in the header
+static void gf2_mul_words_planned(const gf2_word_t* a, const gf2_word_t* b,
+                                  gf2_word_t* out, unsigned long n,
+                                  const GF2MultiplyPlan* plan)
+{
+    int kernel = gf2_multiply_kernel_available(plan->kernel)
+        ? plan->kernel : GF2_MULTIPLY_KERNEL_PORTABLE;
+
+    if (kernel == plan->kernel
+            && (gf2_mul_use_toom3(n, plan) || gf2_mul_use_karatsuba(n, plan))
+            && gf2_mul_scratch_words(n, plan) <= GF2_MULTIPLY_SCRATCH_WORDS)
+        gf2_mul_words_split(a, b, out, n, plan);
+    else
+        gf2_mul_words_base(a, b, out, n, kernel);
+}
+
+static void gf2_words_load(const unsigned char* in, gf2_word_t* out,
+                           unsigned long bytelen)
+{
+    unsigned long i;
+    for (i = 0; i < GF2_WORDS(bytelen); ++i)
+        out[i] = 0;
+    for (i = 0; i < bytelen; ++i)
+        out[i >> 3] |= (gf2_word_t)in[i] << (8 * (i & 7));
+}
+
+static void gf2_words_store(const gf2_word_t* in, unsigned char* out,
+                            unsigned long bytelen)
+{
+    unsigned long i;
+    for (i = 0; i < bytelen; ++i)
+        out[i] = (unsigned char)(in[i >> 3] >> (8 * (i & 7)));
+}
+
+void gf2_multiply_planned_lsb(const unsigned char* in1,
+                              const unsigned char* in2,
+                              unsigned char* out,
+                              unsigned long bytelen,
+                              const GF2MultiplyPlan* plan)
+{
+    gf2_word_t a[GF2_MAX_WORDS];
+    gf2_word_t b[GF2_MAX_WORDS];
+    gf2_word_t product[2 * GF2_MAX_WORDS];
+
+#if GF2_HAVE_LIMB32
+    if (plan->kernel == GF2_MULTIPLY_KERNEL_LIMB32) {
+        gf2_limb32_multiply_lsb(in1, in2, out, bytelen);
+        return;
     }
+#endif
+    gf2_words_load(in1, a, bytelen);
+    gf2_words_load(in2, b, bytelen);
+    gf2_mul_words_planned(a, b, product, GF2_WORDS(bytelen), plan);
+    gf2_words_store(product, out, 2 * bytelen);
+}
+
+void gf2_multiply_lsb(const unsigned char* in1, const unsigned char* in2, unsigned char* out, unsigned long bytelen) {
+    GF2MultiplyPlan plan;
+    gf2_multiply_plan_default(&plan);
+    gf2_multiply_planned_lsb(in1, in2, out, bytelen, &plan);
 }
 
 void gf2_reduce_lsb(unsigned char* inout_reducible, unsigned long reducible_bytelen, const unsigned char* in_reducer, unsigned long reducer_bytelen) {
@@ -64,6 +443,442 @@ void gf2_reduce_lsb(unsigned char* inout_reducible, unsigned long reducible_byte
     }
 }
 
+int gf2_reduction_descriptor_init(GF2ReductionDescriptor* out,
+                                  const unsigned char* modulus,
+                                  unsigned long bytelen)
+{
+    long degree = gf2_degree_lsb(modulus, bytelen);
+    long bit;
+    unsigned short count = 0;
+
+    out->degree = 0;
+    out->term_count = 0;
+    for (bit = 0; bit < GF2_REDUCTION_MAX_TERMS; ++bit)
+        out->terms[bit] = 0;
+
+    if (degree < 16 || !(modulus[0] & 1))
+        return 0;
+
+    for (bit = degree - 1; bit > 0; --bit) {
+        if (!((modulus[bit >> 3] >> (bit & 7)) & 1))
+            continue;
+        // Folding one byte must never land back on bits that are still
+        // waiting to be folded, so middle terms have to stay well below m.
+        if (count == GF2_REDUCTION_MAX_TERMS || bit + 16 > degree)
+            return 0;
+        out->terms[count++] = (unsigned short)bit;
+    }
+    if (count == 0)
+        return 0;
+
+    out->degree = (unsigned short)degree;
+    out->term_count = count;
+    return 1;
+}
+
+static void gf2_xor_byte_at_bit(unsigned char* dst, unsigned long dst_bytelen,
+                                unsigned char value, unsigned long bit_pos)
+{
+    unsigned long byte_pos = bit_pos >> 3;
+    unsigned int  shift    = bit_pos & 7;
+
+    dst[byte_pos] ^= (unsigned char)(value << shift);
+    if (shift && byte_pos + 1 < dst_bytelen)
+        dst[byte_pos + 1] ^= (unsigned char)(value >> (8 - shift));
+}
+
+// x^(8i) = x^(8i-m) * x^m = x^(8i-m) * (x^k1 + ... + 1) mod f(x): every byte
+// above the degree is folded down once, top to bottom, in O(bytelen).
+void gf2_reduce_sparse_lsb(unsigned char* inout_reducible,
+                           unsigned long reducible_bytelen,
+                           const GF2ReductionDescriptor* desc)
+{
+    unsigned long m        = desc->degree;
+    unsigned long top_byte = m >> 3;
+    unsigned int  top_bit  = m & 7;
+    unsigned long i, k;
+    unsigned char t;
+
+    if (reducible_bytelen <= top_byte)
+        return;
+
+    for (i = reducible_bytelen - 1; i > top_byte; --i) {
+        unsigned long pos = i * 8 - m;
+        t = inout_reducible[i];
+        inout_reducible[i] = 0;
+        gf2_xor_byte_at_bit(inout_reducible, reducible_bytelen, t, pos);
+        for (k = 0; k < desc->term_count; ++k)
+            gf2_xor_byte_at_bit(inout_reducible, reducible_bytelen, t, pos + desc->terms[k]);
+    }
+
+    t = (unsigned char)(inout_reducible[top_byte] >> top_bit);
+    inout_reducible[top_byte] &= (unsigned char)((1U << top_bit) - 1U);
+    gf2_xor_byte_at_bit(inout_reducible, reducible_bytelen, t, 0);
+    for (k = 0; k < desc->term_count; ++k)
+        gf2_xor_byte_at_bit(inout_reducible, reducible_bytelen, t, desc->terms[k]);
+}
+
+// ---- Fused field kernels ----
+//
+// Product (or square) and reduction stay in 64-bit words: no double-width
+// byte buffer is written, re-read by the reduction and copied out. Sums are
+// added to the unreduced words, so a*b + c and a*b + c*d cost one reduction.
+
+#if !GF2_PREFER_LIMB32     // squarings go to the limb32 table otherwise
+// A 32-bit half spread to the even bits of a word
+static gf2_word_t gf2_word_spread32(gf2_word_t x)
+{
+    x &= 0xFFFFFFFFULL;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8))  & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2))  & 0x3333333333333333ULL;
+    x = (x | (x << 1))  & 0x5555555555555555ULL;
+    return x;
+}
+
+static void gf2_words_square(const gf2_word_t* a, gf2_word_t* out, unsigned long n)
+{
+    unsigned long i;
+    for (i = 0; i < n; ++i) {
+        out[2 * i] = gf2_word_spread32(a[i]);
+        out[2 * i + 1] = gf2_word_spread32(a[i] >> 32);
+    }
+}
+#endif
+
+static void gf2_words_xor_at_bit(gf2_word_t* dst, gf2_word_t value,
+                                 unsigned long bit_pos)
+{
+    unsigned long w = bit_pos >> 6;
+    unsigned int  s = bit_pos & 63;
+
+    dst[w] ^= value << s;
+    if (s)
+        dst[w + 1] ^= value >> (64 - s);
+}
+
+// Word folding needs every middle term at least a word below the degree
+// (one folded word must not reach back into the words still to be folded);
+// that holds for all the standard trinomials and pentanomials.
+static int gf2_words_fold_supported(const GF2ReductionDescriptor* desc)
+{
+    return desc && desc->degree && desc->terms[0] + 64U <= desc->degree;
+}
+
+// The word analogue of gf2_reduce_sparse_lsb on a 2n-word product
+static void gf2_words_reduce_sparse(gf2_word_t* c, unsigned long words,
+                                    const GF2ReductionDescriptor* desc)
+{
+    unsigned long m  = desc->degree;
+    unsigned long mw = m >> 6;
+    unsigned int  mb = m & 63;
+    unsigned long i, k;
+    gf2_word_t t;
+
+    for (i = words - 1; i > mw; --i) {
+        t = c[i];
+        if (!t)
+            continue;
+        c[i] = 0;
+        gf2_words_xor_at_bit(c, t, 64 * i - m);
+        for (k = 0; k < desc->term_count; ++k)
+            gf2_words_xor_at_bit(c, t, 64 * i - m + desc->terms[k]);
+    }
+
+    t = c[mw] >> mb;
+    c[mw] &= mb ? ((gf2_word_t)1 << mb) - 1 : 0;
+    gf2_words_xor_at_bit(c, t, 0);
+    for (k = 0; k < desc->term_count; ++k)
+        gf2_words_xor_at_bit(c, t, desc->terms[k]);
+}
+
+// Byte-level reduction for moduli the word fold does not cover
+static GF2_NOINLINE void gf2_words_reduce_bytes(const gf2_word_t* c, unsigned char* out,
+                                                unsigned long bytelen,
+                                                const unsigned char* modulus,
+                                                const GF2ReductionDescriptor* desc)
+{
+    alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN];
+    unsigned long i;
+
+    gf2_words_store(c, wide, 2 * bytelen);
+    if (desc && desc->degree)
+        gf2_reduce_sparse_lsb(wide, 2 * bytelen, desc);
+    else
+        gf2_reduce_lsb(wide, 2 * bytelen, modulus, bytelen);
+    for (i = 0; i < bytelen; ++i)
+        out[i] = wide[i];
+}
+
+static void gf2_words_reduce_store(gf2_word_t* c, unsigned char* out,
+                                   unsigned long bytelen,
+                                   const unsigned char* modulus,
+                                   const GF2ReductionDescriptor* desc)
+{
+    if (gf2_words_fold_supported(desc)) {
+        gf2_words_reduce_sparse(c, 2 * GF2_WORDS(bytelen), desc);
+        gf2_words_store(c, out, bytelen);
+    } else {
+        gf2_words_reduce_bytes(c, out, bytelen, modulus, desc);
+    }
+}
+
+void gf2_field_multiply_lsb(const unsigned char* in1,
+                            const unsigned char* in2,
+                            unsigned char* out,
+                            unsigned long bytelen,
+                            const unsigned char* modulus,
+                            const GF2ReductionDescriptor* desc)
+{
+    gf2_field_multiply_planned_lsb(in1, in2, out, bytelen, modulus, desc, 0);
+}
+
+void gf2_field_multiply_planned_lsb(const unsigned char* in1,
+                                    const unsigned char* in2,
+                                    unsigned char* out,
+                                    unsigned long bytelen,
+                                    const unsigned char* modulus,
+                                    const GF2ReductionDescriptor* desc,
+                                    const GF2MultiplyPlan* plan)
+{
+    gf2_word_t a[GF2_MAX_WORDS];
+    gf2_word_t b[GF2_MAX_WORDS];
+    gf2_word_t product[2 * GF2_MAX_WORDS];
+    GF2MultiplyPlan default_plan;
+
+    if (!plan) {
+        gf2_multiply_plan_default(&default_plan);
+        plan = &default_plan;
+    }
+#if GF2_HAVE_LIMB32
+    if (plan->kernel == GF2_MULTIPLY_KERNEL_LIMB32) {
+        gf2_limb32_field_multiply_lsb(in1, in2, out, bytelen, modulus, desc);
+        return;
+    }
+#endif
+    gf2_words_load(in1, a, bytelen);
+    gf2_words_load(in2, b, bytelen);
+    gf2_mul_words_planned(a, b, product, GF2_WORDS(bytelen), plan);
+    gf2_words_reduce_store(product, out, bytelen, modulus, desc);
+}
+
+void gf2_field_square_lsb(const unsigned char* in,
+                          unsigned char* out,
+                          unsigned long bytelen,
+                          const unsigned char* modulus,
+                          const GF2ReductionDescriptor* desc)
+{
+#if GF2_PREFER_LIMB32
+    gf2_limb32_field_square_lsb(in, out, bytelen, modulus, desc);
+#else
+    gf2_word_t a[GF2_MAX_WORDS];
+    gf2_word_t product[2 * GF2_MAX_WORDS];
+
+    gf2_words_load(in, a, bytelen);
+    gf2_words_square(a, product, GF2_WORDS(bytelen));
+    gf2_words_reduce_store(product, out, bytelen, modulus, desc);
+#endif
+}
+
+void gf2_field_multiply_add_lsb(const unsigned char* in1,
+                                const unsigned char* in2,
+                                const unsigned char* add,
+                                unsigned char* out,
+                                unsigned long bytelen,
+                                const unsigned char* modulus,
+                                const GF2ReductionDescriptor* desc)
+{
+    gf2_field_multiply_add_planned_lsb(in1, in2, add, out, bytelen, modulus, desc, 0);
+}
+
+void gf2_field_multiply_add_planned_lsb(const unsigned char* in1,
+                                        const unsigned char* in2,
+                                        const unsigned char* add,
+                                        unsigned char* out,
+                                        unsigned long bytelen,
+                                        const unsigned char* modulus,
+                                        const GF2ReductionDescriptor* desc,
+                                        const GF2MultiplyPlan* plan)
+{
+    gf2_word_t a[GF2_MAX_WORDS];
+    gf2_word_t b[GF2_MAX_WORDS];
+    gf2_word_t product[2 * GF2_MAX_WORDS];
+    GF2MultiplyPlan default_plan;
+    unsigned long i;
+
+    if (!plan) {
+        gf2_multiply_plan_default(&default_plan);
+        plan = &default_plan;
+    }
+#if GF2_HAVE_LIMB32
+    if (plan->kernel == GF2_MULTIPLY_KERNEL_LIMB32) {
+        gf2_limb32_field_multiply_add_lsb(in1, in2, add, out, bytelen, modulus, desc);
+        return;
+    }
+#endif
+    gf2_words_load(in1, a, bytelen);
+    gf2_words_load(in2, b, bytelen);
+    gf2_mul_words_planned(a, b, product, GF2_WORDS(bytelen), plan);
+    gf2_words_load(add, a, bytelen);
+    for (i = 0; i < GF2_WORDS(bytelen); ++i)
+        product[i] ^= a[i];
+    gf2_words_reduce_store(product, out, bytelen, modulus, desc);
+}
+
+void gf2_field_multiply2_add_lsb(const unsigned char* in1,
+                                 const unsigned char* in2,
+                                 const unsigned char* in3,
+                                 const unsigned char* in4,
+                                 unsigned char* out,
+                                 unsigned long bytelen,
+                                 const unsigned char* modulus,
+                                 const GF2ReductionDescriptor* desc)
+{
+    gf2_field_multiply2_add_planned_lsb(in1, in2, in3, in4, out, bytelen, modulus, desc, 0);
+}
+
+void gf2_field_multiply2_add_planned_lsb(const unsigned char* in1,
+                                         const unsigned char* in2,
+                                         const unsigned char* in3,
+                                         const unsigned char* in4,
+                                         unsigned char* out,
+                                         unsigned long bytelen,
+                                         const unsigned char* modulus,
+                                         const GF2ReductionDescriptor* desc,
+                                         const GF2MultiplyPlan* plan)
+{
+    gf2_word_t a[GF2_MAX_WORDS];
+    gf2_word_t b[GF2_MAX_WORDS];
+    gf2_word_t product[2 * GF2_MAX_WORDS];
+    gf2_word_t product2[2 * GF2_MAX_WORDS];
+    GF2MultiplyPlan default_plan;
+    unsigned long n = GF2_WORDS(bytelen);
+    unsigned long i;
+
+    if (!plan) {
+        gf2_multiply_plan_default(&default_plan);
+        plan = &default_plan;
+    }
+#if GF2_HAVE_LIMB32
+    if (plan->kernel == GF2_MULTIPLY_KERNEL_LIMB32) {
+        gf2_limb32_field_multiply2_add_lsb(in1, in2, in3, in4, out, bytelen, modulus, desc);
+        return;
+    }
+#endif
+    gf2_words_load(in1, a, bytelen);
+    gf2_words_load(in2, b, bytelen);
+    gf2_mul_words_planned(a, b, product, n, plan);
+    gf2_words_load(in3, a, bytelen);
+    gf2_words_load(in4, b, bytelen);
+    gf2_mul_words_planned(a, b, product2, n, plan);
+    for (i = 0; i < 2 * n; ++i)
+        product[i] ^= product2[i];
+    gf2_words_reduce_store(product, out, bytelen, modulus, desc);
+}
+
+#define GF2_FIXED_ROWS (1UL << GF2_MUL_FIXED_WINDOW_BITS)
+#define GF2_FIXED_MASK (GF2_FIXED_ROWS - 1)
+
+void gf2_mul_fixed_init(GF2FixedOperand* out,
+                        const unsigned char* operand,
+                        unsigned long bytelen)
+{
+    unsigned long n = GF2_WORDS(bytelen);
+    unsigned long u, k;
+
+    for (u = 0; u < GF2_FIXED_ROWS; ++u)
+        for (k = 0; k <= GF2_MAX_WORDS; ++k)
+            out->window[u][k] = 0;
+    out->bytelen = (unsigned short)bytelen;
+    out->words = (unsigned short)n;
+    gf2_words_load(operand, out->window[1], bytelen);
+
+    // 2u b = (u b) x, (2u + 1) b = 2u b + b
+    for (u = 2; u < GF2_FIXED_ROWS; u += 2) {
+        for (k = 0; k <= n; ++k) {
+            out->window[u][k] = (out->window[u >> 1][k] << 1)
+                    | (k ? out->window[u >> 1][k - 1] >> 63 : 0);
+            out->window[u + 1][k] = out->window[u][k] ^ out->window[1][k];
+        }
+    }
+}
+
+// Left-to-right comb: window column j of every word of a, top column first,
+// the 2n-word accumulator shifted by one window between columns
+static void gf2_mul_fixed_words(const GF2FixedOperand* fixed, const gf2_word_t* a,
+                                gf2_word_t* c)
+{
+    const unsigned int w = GF2_MUL_FIXED_WINDOW_BITS;
+    unsigned long n = fixed->words;
+    unsigned long i, k;
+    long j;
+
+    for (i = 0; i < 2 * n; ++i)
+        c[i] = 0;
+    for (j = 64 / w - 1; j >= 0; --j) {
+        for (i = 0; i < n; ++i) {
+            const gf2_word_t* row = fixed->window[(a[i] >> (w * j)) & GF2_FIXED_MASK];
+            for (k = 0; k <= n; ++k)
+                c[i + k] ^= row[k];
+        }
+        if (j) {
+            for (i = 2 * n - 1; i > 0; --i)
+                c[i] = (c[i] << w) | (c[i - 1] >> (64 - w));
+            c[0] <<= w;
+        }
+    }
+}
+
+void gf2_mul_fixed(const GF2FixedOperand* fixed,
+                   const unsigned char* in,
+                   unsigned char* out,
+                   const unsigned char* modulus,
+                   const GF2ReductionDescriptor* desc)
+{
+    gf2_word_t a[GF2_MAX_WORDS];
+    gf2_word_t product[2 * GF2_MAX_WORDS];
+
+    gf2_words_load(in, a, fixed->bytelen);
+    gf2_mul_fixed_words(fixed, a, product);
+    gf2_words_reduce_store(product, out, fixed->bytelen, modulus, desc);
+}
+
+// Same comb, but every window is split into its bits and each bit adds
+// row 2^t under a mask: no table index or branch depends on in.
+void gf2_mul_fixed_ct_lsb(const GF2FixedOperand* fixed,
+                          const unsigned char* in,
+                          unsigned char* out)
+{
+    const unsigned int w = GF2_MUL_FIXED_WINDOW_BITS;
+    unsigned long n = fixed->words;
+    gf2_word_t a[GF2_MAX_WORDS];
+    gf2_word_t c[2 * GF2_MAX_WORDS];
+    unsigned long i, k;
+    unsigned int t;
+    long j;
+
+    gf2_words_load(in, a, fixed->bytelen);
+    for (i = 0; i < 2 * n; ++i)
+        c[i] = 0;
+    for (j = 64 / w - 1; j >= 0; --j) {
+        for (i = 0; i < n; ++i) {
+            for (t = 0; t < w; ++t) {
+                const gf2_word_t* row = fixed->window[1UL << t];
+                gf2_word_t mask = 0 - ((a[i] >> (w * j + t)) & 1);
+                for (k = 0; k <= n; ++k)
+                    c[i + k] ^= row[k] & mask;
+            }
+        }
+        if (j) {
+            for (i = 2 * n - 1; i > 0; --i)
+                c[i] = (c[i] << w) | (c[i - 1] >> (64 - w));
+            c[0] <<= w;
+        }
+    }
+    gf2_words_store(c, out, 2 * (unsigned long)fixed->bytelen);
+}
+
 void gf2_lshift_lsb(unsigned char*       dst,
                        const unsigned char* src,
                        unsigned long        bytelen,
@@ -144,3 +959,388 @@ void gf2_binary_inverse_lsb(
         gf2_reduce_lsb(out, bytelen, modulus, bytelen);
     }
 }
+
+// in^2 mod modulus, in place; desc->degree == 0 selects the generic reduction
+static void gf2_square_mod(unsigned char* inout, unsigned long bytelen,
+                           const unsigned char* modulus,
+                           const GF2ReductionDescriptor* desc)
+{
+    alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN];
+    unsigned long i;
+    gf2_square_ct_lsb(inout, wide, bytelen);
+    if (desc->degree)
+        gf2_reduce_sparse_lsb(wide, 2 * bytelen, desc);
+    else
+        gf2_reduce_lsb(wide, 2 * bytelen, modulus, bytelen);
+    for (i = 0; i < bytelen; ++i)
+        inout[i] = wide[i];
+}
+
+void gf2_sqrt_lsb(const unsigned char* in,
+                  unsigned char* out,
+                  unsigned long bytelen,
+                  const unsigned char* modulus)
+{
+    GF2ReductionDescriptor desc;
+    long m = gf2_degree_lsb(modulus, bytelen);
+    unsigned long i;
+    long k;
+
+    gf2_reduction_descriptor_init(&desc, modulus, bytelen);
+    for (i = 0; i < bytelen; ++i)
+        out[i] = in[i];
+    for (k = 1; k < m; ++k)
+        gf2_square_mod(out, bytelen, modulus, &desc);
+}
+
+int gf2_trace_lsb(const unsigned char* in,
+                  unsigned long bytelen,
+                  const unsigned char* modulus)
+{
+    alignas(8) unsigned char power[GF2_VECTOR_MAX_BYTELEN];
+    alignas(8) unsigned char sum[GF2_VECTOR_MAX_BYTELEN];
+    GF2ReductionDescriptor desc;
+    long m = gf2_degree_lsb(modulus, bytelen);
+    unsigned long i;
+    long k;
+
+    gf2_reduction_descriptor_init(&desc, modulus, bytelen);
+    for (i = 0; i < bytelen; ++i) {
+        power[i] = in[i];
+        sum[i] = in[i];
+    }
+    for (k = 1; k < m; ++k) {
+        gf2_square_mod(power, bytelen, modulus, &desc);
+        for (i = 0; i < bytelen; ++i)
+            sum[i] ^= power[i];
+    }
+    return sum[0] & 1;
+}
+
+void gf2_half_trace_lsb(const unsigned char* in,
+                        unsigned char* out,
+                        unsigned long bytelen,
+                        const unsigned char* modulus)
+{
+    alignas(8) unsigned char power[GF2_VECTOR_MAX_BYTELEN];
+    GF2ReductionDescriptor desc;
+    long m = gf2_degree_lsb(modulus, bytelen);
+    unsigned long i;
+    long k;
+
+    gf2_reduction_descriptor_init(&desc, modulus, bytelen);
+    for (i = 0; i < bytelen; ++i) {
+        power[i] = in[i];
+        out[i] = in[i];
+    }
+    for (k = 1; k <= (m - 1) / 2; ++k) {
+        gf2_square_mod(power, bytelen, modulus, &desc);
+        gf2_square_mod(power, bytelen, modulus, &desc);
+        for (i = 0; i < bytelen; ++i)
+            out[i] ^= power[i];
+    }
+}
+
+static void gf2_linear_maps_reduce(unsigned char* wide, const GF2LinearMaps* maps)
+{
+    if (maps->reduction.degree)
+        gf2_reduce_sparse_lsb(wide, 2UL * maps->bytelen, &maps->reduction);
+    else
+        gf2_reduce_lsb(wide, 2UL * maps->bytelen, maps->modulus, maps->bytelen);
+}
+
+// Tr(z^k) are the power sums of the roots of the modulus, so Newton's
+// identities give all of them at once: s_0 = m mod 2 and, over GF(2),
+// s_k = k c_k + sum(c_j s_(k-j), 0 < j < k), with c_j the coefficient of z^(m-j).
+static void gf2_linear_maps_trace_mask(GF2LinearMaps* maps)
+{
+    unsigned long m = maps->degree;
+    const unsigned char* f = maps->modulus;
+    unsigned long k, j;
+
+    for (k = 0; k < m; ++k) {
+        unsigned int s = 0;
+        if (k == 0) {
+            s = m & 1;
+        } else {
+            unsigned long ck = m - k;
+            if (k & 1)
+                s = (f[ck >> 3] >> (ck & 7)) & 1;
+            for (j = 1; j < k; ++j) {
+                unsigned long cj = m - j;
+                unsigned long r = k - j;
+                if ((f[cj >> 3] >> (cj & 7)) & 1)
+                    s ^= (maps->trace_mask[r >> 3] >> (r & 7)) & 1;
+            }
+        }
+        maps->trace_mask[k >> 3] |= (unsigned char)(s << (k & 7));
+    }
+}
+
+int gf2_linear_maps_init(GF2LinearMaps* out,
+                         const unsigned char* modulus,
+                         unsigned long bytelen)
+{
+    alignas(8) unsigned char z[GF2_VECTOR_MAX_BYTELEN] = { };
+    unsigned char* raw = (unsigned char*) out;
+    unsigned long m = (unsigned long) gf2_degree_lsb(modulus, bytelen);
+    unsigned long i, k, v;
+
+    for (i = 0; i < sizeof(GF2LinearMaps); ++i)
+        raw[i] = 0;
+    out->bytelen = (unsigned short) bytelen;
+    out->degree = (unsigned short) m;
+    gf2_reduction_descriptor_init(&out->reduction, modulus, bytelen);
+    for (i = 0; i < bytelen; ++i)
+        out->modulus[i] = modulus[i];
+
+    z[0] = 0x02;
+    gf2_sqrt_lsb(z, out->sqrt_z, bytelen, modulus);
+    gf2_linear_maps_trace_mask(out);
+    if (!(m & 1))
+        return 0;
+
+    // Single rows H(z^(8k+2b+1)) at index 1 << b, then every other entry
+    // as the XOR of its lowest row and the entry without it
+    for (k = 0; k < bytelen; ++k) {
+        for (v = 0; v < GF2_HALF_TRACE_WINDOW_BITS; ++v) {
+            unsigned long bit = 8 * k + 2 * v + 1;
+            if (bit + 2 > m)
+                break;
+            for (i = 0; i < bytelen; ++i)
+                z[i] = 0;
+            z[bit >> 3] = (unsigned char)(1U << (bit & 7));
+            gf2_half_trace_lsb(z, out->half_trace[k][1UL << v], bytelen, modulus);
+        }
+        for (v = 3; v < (1UL << GF2_HALF_TRACE_WINDOW_BITS); ++v) {
+            unsigned long low = v & (0UL - v);
+            if (low == v)
+                continue;
+            for (i = 0; i < bytelen; ++i)
+                out->half_trace[k][v][i] = out->half_trace[k][low][i]
+                                         ^ out->half_trace[k][v ^ low][i];
+        }
+    }
+    out->has_half_trace = 1;
+    return 1;
+}
+
+void gf2_sqrt(const unsigned char* in,
+              unsigned char* out,
+              const GF2LinearMaps* maps)
+{
+    alignas(8) unsigned char even[GF2_VECTOR_MAX_BYTELEN] = { };
+    alignas(8) unsigned char odd[GF2_VECTOR_MAX_BYTELEN] = { };
+    alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN];
+    unsigned long len = maps->bytelen;
+    unsigned long i;
+
+    // Byte i holds bits 8i..8i+7: its even bits become nibble (i & 1) of
+    // byte i / 2 of E, its odd bits the same nibble of O
+    for (i = 0; i < len; ++i) {
+        unsigned int e = in[i] & 0x55U;
+        unsigned int o = (in[i] >> 1) & 0x55U;
+        e = (e | (e >> 1)) & 0x33U;
+        e = (e | (e >> 2)) & 0x0FU;
+        o = (o | (o >> 1)) & 0x33U;
+        o = (o | (o >> 2)) & 0x0FU;
+        even[i >> 1] |= (unsigned char)(e << (4 * (i & 1)));
+        odd[i >> 1] |= (unsigned char)(o << (4 * (i & 1)));
+    }
+    gf2_multiply_lsb(odd, maps->sqrt_z, wide, len);
+    gf2_linear_maps_reduce(wide, maps);
+    for (i = 0; i < len; ++i)
+        out[i] = wide[i] ^ even[i];
+}
+
+int gf2_trace(const unsigned char* in,
+              const GF2LinearMaps* maps)
+{
+    unsigned char acc = 0;
+    unsigned long i;
+
+    for (i = 0; i < maps->bytelen; ++i)
+        acc ^= in[i] & maps->trace_mask[i];
+    acc ^= acc >> 4;
+    acc ^= acc >> 2;
+    acc ^= acc >> 1;
+    return acc & 1;
+}
+
+void gf2_half_trace(const unsigned char* in,
+                    unsigned char* out,
+                    const GF2LinearMaps* maps)
+{
+    alignas(8) unsigned char c[GF2_VECTOR_MAX_BYTELEN];
+    unsigned long len = maps->bytelen;
+    unsigned long m = maps->degree;
+    unsigned int constant;
+    unsigned long i, k;
+
+    // H(1) = (m + 1) / 2 mod 2
+    constant = (in[0] & 1) & (unsigned int)(((m + 1) >> 1) & 1);
+    for (i = 0; i < len; ++i) {
+        c[i] = in[i];
+        out[i] = 0;
+    }
+    for (i = (m - 1) / 2; i >= 1; --i) {
+        unsigned long even = 2 * i;
+        if ((c[even >> 3] >> (even & 7)) & 1) {
+            c[i >> 3] ^= (unsigned char)(1U << (i & 7));
+            out[i >> 3] ^= (unsigned char)(1U << (i & 7));
+            constant ^= (maps->trace_mask[i >> 3] >> (i & 7)) & 1;
+        }
+    }
+    for (k = 0; k < len; ++k) {
+        unsigned int b = c[k];
+        unsigned int v = ((b >> 1) & 1U) | ((b >> 2) & 2U) | ((b >> 3) & 4U) | ((b >> 4) & 8U);
+        const unsigned char* row = maps->half_trace[k][v];
+        for (i = 0; i < len; ++i)
+            out[i] ^= row[i];
+    }
+    out[0] ^= (unsigned char) constant;
+}
+
+void gf2_multiply_ct_lsb(const unsigned char* in1,
+                         const unsigned char* in2,
+                         unsigned char* out,
+                         unsigned long bytelen)
+{
+    alignas(8) unsigned char shifted[GF2_VECTOR_MAX_BYTELEN + 1];
+    unsigned long i, j;
+    unsigned int s;
+
+    for (i = 0; i < 2 * bytelen; ++i)
+        out[i] = 0;
+
+    // For every bit offset s, add (in2 << s) at each byte whose bit s is set,
+    // selected by a mask instead of a branch.
+    for (s = 0; s < 8; ++s) {
+        shifted[0] = (unsigned char)(in2[0] << s);
+        for (j = 1; j < bytelen; ++j)
+            shifted[j] = (unsigned char)((in2[j] << s) | (s ? in2[j - 1] >> (8 - s) : 0));
+        shifted[bytelen] = (unsigned char)(s ? in2[bytelen - 1] >> (8 - s) : 0);
+
+        for (i = 0; i < bytelen; ++i) {
+            unsigned char mask = (unsigned char)(0U - ((in1[i] >> s) & 1U));
+            for (j = 0; j <= bytelen; ++j)
+                out[i + j] ^= shifted[j] & mask;
+        }
+    }
+}
+
+void gf2_square_ct_lsb(const unsigned char* in,
+                       unsigned char* out,
+                       unsigned long bytelen)
+{
+    unsigned long i;
+    // Squaring interleaves zero bits: spread every byte to 16 bits
+    for (i = 0; i < bytelen; ++i) {
+        unsigned int x = in[i];
+        x = (x | (x << 4)) & 0x0F0FU;
+        x = (x | (x << 2)) & 0x3333U;
+        x = (x | (x << 1)) & 0x5555U;
+        out[2 * i] = (unsigned char)x;
+        out[2 * i + 1] = (unsigned char)(x >> 8);
+    }
+}
+
+void gf2_reduce_ct_lsb(unsigned char* inout_reducible,
+                       unsigned long reducible_bytelen,
+                       const unsigned char* modulus,
+                       unsigned long modulus_bytelen)
+{
+    long m = gf2_degree_lsb(modulus, modulus_bytelen);
+    long bit;
+    unsigned long j;
+
+    if (m <= 0)
+        return;
+    for (bit = (long)(reducible_bytelen * 8) - 1; bit >= m; --bit) {
+        unsigned long shift = (unsigned long)(bit - m);
+        unsigned long byte_shift = shift >> 3;
+        unsigned int bit_shift = shift & 7;
+        unsigned char mask = (unsigned char)(0U - ((inout_reducible[bit >> 3] >> (bit & 7)) & 1U));
+
+        for (j = 0; j < modulus_bytelen && j + byte_shift < reducible_bytelen; ++j) {
+            inout_reducible[j + byte_shift] ^= (unsigned char)(modulus[j] << bit_shift) & mask;
+            if (bit_shift && j + byte_shift + 1 < reducible_bytelen)
+                inout_reducible[j + byte_shift + 1] ^=
+                    (unsigned char)(modulus[j] >> (8 - bit_shift)) & mask;
+        }
+    }
+}
+
+static void gf2_reduce_ct_any(unsigned char* inout, unsigned long bytelen,
+                              const unsigned char* modulus,
+                              const GF2ReductionDescriptor* desc)
+{
+    if (desc && desc->degree)
+        gf2_reduce_sparse_lsb(inout, 2 * bytelen, desc);
+    else
+        gf2_reduce_ct_lsb(inout, 2 * bytelen, modulus, bytelen);
+}
+
+// out = in^(2^k) * mul (mul may alias out)
+static void gf2_itoh_tsujii_step(const unsigned char* in, unsigned long k,
+                                 const unsigned char* mul, unsigned char* out,
+                                 unsigned long bytelen,
+                                 const unsigned char* modulus,
+                                 const GF2ReductionDescriptor* desc)
+{
+    alignas(8) unsigned char acc[GF2_VECTOR_MAX_BYTELEN] = { };
+    alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN];
+    unsigned long i, j;
+
+    for (i = 0; i < bytelen; ++i)
+        acc[i] = in[i];
+    for (j = 0; j < k; ++j) {
+        gf2_square_ct_lsb(acc, wide, bytelen);
+        gf2_reduce_ct_any(wide, bytelen, modulus, desc);
+        for (i = 0; i < bytelen; ++i)
+            acc[i] = wide[i];
+    }
+    gf2_multiply_ct_lsb(acc, mul, wide, bytelen);
+    gf2_reduce_ct_any(wide, bytelen, modulus, desc);
+    for (i = 0; i < bytelen; ++i)
+        out[i] = wide[i];
+}
+
+void gf2_inverse_ct_lsb(const unsigned char* in,
+                        unsigned char* out,
+                        unsigned long bytelen,
+                        const unsigned char* modulus,
+                        const GF2ReductionDescriptor* desc)
+{
+    alignas(8) unsigned char beta[GF2_VECTOR_MAX_BYTELEN] = { };
+    alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN];
+    long m = gf2_degree_lsb(modulus, bytelen);
+    unsigned long e, k, i;
+    int bit;
+
+    if (m < 2)
+        return;
+
+    // beta_k = in^(2^k - 1); beta_2k = beta_k^(2^k) * beta_k,
+    // beta_(k+1) = beta_k^2 * in. Walk the bits of m - 1 from the top.
+    e = (unsigned long)m - 1;
+    for (bit = 0; (e >> (bit + 1)) != 0; ++bit)
+        ;
+    for (i = 0; i < bytelen; ++i)
+        beta[i] = in[i];
+    k = 1;
+    for (--bit; bit >= 0; --bit) {
+        gf2_itoh_tsujii_step(beta, k, beta, beta, bytelen, modulus, desc);
+        k *= 2;
+        if ((e >> bit) & 1) {
+            gf2_itoh_tsujii_step(beta, 1, in, beta, bytelen, modulus, desc);
+            k += 1;
+        }
+    }
+
+    // in^(2^m - 2) = (in^(2^(m-1) - 1))^2
+    gf2_square_ct_lsb(beta, wide, bytelen);
+    gf2_reduce_ct_any(wide, bytelen, modulus, desc);
+    for (i = 0; i < bytelen; ++i)
+        out[i] = wide[i];
+}
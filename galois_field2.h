@@ -3,8 +3,93 @@
 
 #define GF2_VECTOR_MAX_BYTELEN (32UL)
 
+#define GF2_REDUCTION_MAX_TERMS (3)
+
+// Sparse reduction polynomial f(x) = x^degree + x^terms[0] + ... + 1
+// (trinomial or pentanomial), used for fast folding reduction.
+// degree == 0 marks a modulus that has no sparse form.
+typedef struct {
+    unsigned short degree;
+    unsigned short term_count;
+    unsigned short terms[GF2_REDUCTION_MAX_TERMS]; // middle exponents, descending
+} GF2ReductionDescriptor;
+
 long gf2_degree_lsb(const unsigned char* in, unsigned long bytelen);
 
+// Carry-less 64x64 base kernel used below the split thresholds. The CLMUL
+// kernel (x86 PCLMULQDQ) is compiled in when the target has it (-mpclmul);
+// GF2_HAVE_CLMUL can be forced to 0 for the portable kernel only.
+// GF2_MULTIPLY_KERNEL_LIMB32 is not a 64x64 kernel but the whole 32-bit limb
+// backend of galois_field2_limb32.h (comb product, table squaring); the split
+// thresholds do not apply to it. It is compiled in with GF2_HAVE_LIMB32
+// (builds with it add galois_field2_limb32.cpp), by default on targets with
+// 32-bit pointers and no CLMUL. There it is also the default
+// (GF2_PREFER_LIMB32) and does the squarings of gf2_field_square_lsb.
+#define GF2_MULTIPLY_KERNEL_PORTABLE (0)
+#define GF2_MULTIPLY_KERNEL_CLMUL    (1)
+#define GF2_MULTIPLY_KERNEL_LIMB32   (2)
+#ifndef GF2_HAVE_CLMUL
+#if defined(__PCLMUL__) && (defined(__GNUC__) || defined(__clang__))
+#define GF2_HAVE_CLMUL (1)
+#else
+#define GF2_HAVE_CLMUL (0)
+#endif
+#endif
+#ifndef GF2_HAVE_LIMB32
+#if defined(__SIZEOF_POINTER__) && __SIZEOF_POINTER__ == 4 && !GF2_HAVE_CLMUL
+#define GF2_HAVE_LIMB32 (1)
+#elif defined(GF2_PREFER_LIMB32)
+#define GF2_HAVE_LIMB32 (GF2_PREFER_LIMB32)
+#else
+#define GF2_HAVE_LIMB32 (0)
+#endif
+#endif
+#ifndef GF2_PREFER_LIMB32
+#if GF2_HAVE_LIMB32 && defined(__SIZEOF_POINTER__) && __SIZEOF_POINTER__ == 4 && !GF2_HAVE_CLMUL
+#define GF2_PREFER_LIMB32 (1)
+#else
+#define GF2_PREFER_LIMB32 (0)
+#endif
+#endif
+#if GF2_PREFER_LIMB32 && !GF2_HAVE_LIMB32
+#error "GF2_PREFER_LIMB32 needs GF2_HAVE_LIMB32"
+#endif
+
+// Operand sizes, in 64-bit words, from which gf2_multiply_lsb splits with
+// Karatsuba / Toom-3 instead of the schoolbook loop over words. Defaults come
+// from benchmark_gf2_multiply() (galois_field2_test.cpp): with the portable
+// kernel Karatsuba pays off from 4 words (233 bits); with CLMUL, and for
+// Toom-3 in general, the schoolbook loop wins up to 571 bits.
+#ifndef GF2_KARATSUBA_THRESHOLD_WORDS
+#if GF2_HAVE_CLMUL
+#define GF2_KARATSUBA_THRESHOLD_WORDS (0xFFFF)
+#else
+#define GF2_KARATSUBA_THRESHOLD_WORDS (4)
+#endif
+#endif
+#ifndef GF2_TOOM3_THRESHOLD_WORDS
+#define GF2_TOOM3_THRESHOLD_WORDS (0xFFFF)
+#endif
+
+typedef struct {
+    unsigned short karatsuba_threshold_words;
+    unsigned short toom3_threshold_words;
+    unsigned short kernel;                  // GF2_MULTIPLY_KERNEL_*
+} GF2MultiplyPlan;
+
+void gf2_multiply_plan_default(GF2MultiplyPlan* plan);
+int gf2_multiply_kernel_available(int kernel);
+
+// out = in1 * in2 (2 * bytelen bytes, unreduced) following plan. A plan that
+// names a kernel not compiled in, or splits deeper than the stack scratch
+// allows (6 words per operand word + 16), falls back to the schoolbook loop.
+void gf2_multiply_planned_lsb(const unsigned char* in1,
+                              const unsigned char* in2,
+                              unsigned char* out,
+                              unsigned long bytelen,
+                              const GF2MultiplyPlan* plan);
+
+// gf2_multiply_planned_lsb with gf2_multiply_plan_default()
 void gf2_multiply_lsb(const unsigned char* in1,
                       const unsigned char* in2,
                       unsigned char* out,
@@ -15,6 +100,121 @@ void gf2_reduce_lsb(unsigned char* inout_reducible,
                     const unsigned char* in_reducer,
                     unsigned long reducer_bytelen);
 
+int gf2_reduction_descriptor_init(GF2ReductionDescriptor* out,
+                                  const unsigned char* modulus,
+                                  unsigned long bytelen);
+
+void gf2_reduce_sparse_lsb(unsigned char* inout_reducible,
+                           unsigned long reducible_bytelen,
+                           const GF2ReductionDescriptor* desc);
+
+// Fused field kernels: product or square and reduction on 64-bit words, with
+// no double-width intermediate in memory. Results are reduced, bytelen bytes,
+// and may alias the inputs. desc may be 0; the word-level fold is used when
+// the descriptor's middle terms lie at least 64 bits below the degree (all
+// NIST moduli), otherwise the byte-level sparse or generic reduction.
+//   gf2_field_multiply_lsb:      out = in1 * in2
+//   gf2_field_square_lsb:        out = in^2
+//   gf2_field_multiply_add_lsb:  out = in1 * in2 + add     (add reduced)
+//   gf2_field_multiply2_add_lsb: out = in1 * in2 + in3 * in4, one reduction
+void gf2_field_multiply_lsb(const unsigned char* in1,
+                            const unsigned char* in2,
+                            unsigned char* out,
+                            unsigned long bytelen,
+                            const unsigned char* modulus,
+                            const GF2ReductionDescriptor* desc);
+
+void gf2_field_square_lsb(const unsigned char* in,
+                          unsigned char* out,
+                          unsigned long bytelen,
+                          const unsigned char* modulus,
+                          const GF2ReductionDescriptor* desc);
+
+void gf2_field_multiply_add_lsb(const unsigned char* in1,
+                                const unsigned char* in2,
+                                const unsigned char* add,
+                                unsigned char* out,
+                                unsigned long bytelen,
+                                const unsigned char* modulus,
+                                const GF2ReductionDescriptor* desc);
+
+void gf2_field_multiply2_add_lsb(const unsigned char* in1,
+                                 const unsigned char* in2,
+                                 const unsigned char* in3,
+                                 const unsigned char* in4,
+                                 unsigned char* out,
+                                 unsigned long bytelen,
+                                 const unsigned char* modulus,
+                                 const GF2ReductionDescriptor* desc);
+
+// The same with an explicit multiplication plan (0: the default one), for
+// callers that tuned it per field (elliptic_curve_tune.h).
+void gf2_field_multiply_planned_lsb(const unsigned char* in1,
+                                    const unsigned char* in2,
+                                    unsigned char* out,
+                                    unsigned long bytelen,
+                                    const unsigned char* modulus,
+                                    const GF2ReductionDescriptor* desc,
+                                    const GF2MultiplyPlan* plan);
+
+void gf2_field_multiply_add_planned_lsb(const unsigned char* in1,
+                                        const unsigned char* in2,
+                                        const unsigned char* add,
+                                        unsigned char* out,
+                                        unsigned long bytelen,
+                                        const unsigned char* modulus,
+                                        const GF2ReductionDescriptor* desc,
+                                        const GF2MultiplyPlan* plan);
+
+void gf2_field_multiply2_add_planned_lsb(const unsigned char* in1,
+                                         const unsigned char* in2,
+                                         const unsigned char* in3,
+                                         const unsigned char* in4,
+                                         unsigned char* out,
+                                         unsigned long bytelen,
+                                         const unsigned char* modulus,
+                                         const GF2ReductionDescriptor* desc,
+                                         const GF2MultiplyPlan* plan);
+
+// Fixed-operand multiplication, for many products with one loop-invariant
+// factor (x(P) in the ladder, sqrt(b), x(G)). gf2_mul_fixed_init() stores
+// operand * u for every u < 2^GF2_MUL_FIXED_WINDOW_BITS once; a product is
+// then a comb over the other factor, one table row XORed in per window and
+// one shift per window column, with no 64x64 kernel calls. The window is 4
+// (640 bytes per table at 32-byte vectors) or 8 bits (10 KB, half the
+// shifts). The structure is plain data (no pointers).
+//   gf2_mul_fixed:        out = fixed * in, reduced, like gf2_field_multiply_lsb;
+//                         rows are picked by the bits of in (variable time).
+//   gf2_mul_fixed_ct_lsb: out = fixed * in, 2 * bytelen bytes, like
+//                         gf2_multiply_ct_lsb; reads only the rows 2^t under
+//                         masks, so it is constant time in both factors.
+// in must be reduced (below 2^(8 * bytelen)); out may alias it.
+#ifndef GF2_MUL_FIXED_WINDOW_BITS
+#define GF2_MUL_FIXED_WINDOW_BITS (4)
+#endif
+
+typedef struct {
+    unsigned short bytelen;
+    unsigned short words;                   // 64-bit words of the operand
+    // [u] = operand * u, one word longer than the operand
+    unsigned long long window[1 << GF2_MUL_FIXED_WINDOW_BITS]
+                             [(GF2_VECTOR_MAX_BYTELEN + 7) / 8 + 1];
+} GF2FixedOperand;
+
+void gf2_mul_fixed_init(GF2FixedOperand* out,
+                        const unsigned char* operand,
+                        unsigned long bytelen);
+
+void gf2_mul_fixed(const GF2FixedOperand* fixed,
+                   const unsigned char* in,
+                   unsigned char* out,
+                   const unsigned char* modulus,
+                   const GF2ReductionDescriptor* desc);
+
+void gf2_mul_fixed_ct_lsb(const GF2FixedOperand* fixed,
+                          const unsigned char* in,
+                          unsigned char* out);
+
 void gf2_lshift_lsb(unsigned char*       dst,
                        const unsigned char* src,
                        unsigned long        bytelen,
@@ -26,4 +226,96 @@ void gf2_binary_inverse_lsb(
     unsigned long        bytelen,
     const unsigned char* modulus);
 
+// Reference (table-free) quadratic-equation helpers for odd-degree fields,
+// m = degree of modulus. Each costs about m modular squarings; see
+// GF2LinearMaps below for the precomputed forms.
+// Square root: in^(2^(m-1)).
+void gf2_sqrt_lsb(const unsigned char* in,
+                  unsigned char* out,
+                  unsigned long bytelen,
+                  const unsigned char* modulus);
+
+// Absolute trace Tr(in) = sum of in^(2^i), i < m; returns 0 or 1.
+int gf2_trace_lsb(const unsigned char* in,
+                  unsigned long bytelen,
+                  const unsigned char* modulus);
+
+// Half-trace H(in) = sum of in^(4^i), i <= (m-1)/2. For Tr(in) = 0 it is a
+// solution of l^2 + l = in (the other one is H(in) + 1).
+void gf2_half_trace_lsb(const unsigned char* in,
+                        unsigned char* out,
+                        unsigned long bytelen,
+                        const unsigned char* modulus);
+
+// Precomputed linear maps of one modulus: square root, trace and half-trace
+// are GF(2)-linear, so after gf2_linear_maps_init() each costs at most one
+// multiplication instead of about m squarings.
+//  - sqrt: in = E(z^2) + z O(z^2) gives sqrt(in) = E(z) + sqrt(z) O(z).
+//  - trace: parity of in & mask, mask bit i = Tr(z^i).
+//  - half-trace: even powers fold onto lower ones with
+//    H(z^2i) = H(z^i) + z^i + Tr(z^i), the remaining odd bits are looked up
+//    four at a time (the odd bits of one byte) in a table of XORed rows.
+// The structure is plain data (no pointers) and can be copied or serialized.
+#define GF2_HALF_TRACE_WINDOW_BITS (4)
+
+typedef struct {
+    unsigned short bytelen;
+    unsigned short degree;
+    unsigned short has_half_trace;          // odd degree only
+    GF2ReductionDescriptor reduction;       // degree 0: reduce with modulus
+    unsigned char modulus[GF2_VECTOR_MAX_BYTELEN];
+    unsigned char sqrt_z[GF2_VECTOR_MAX_BYTELEN];
+    unsigned char trace_mask[GF2_VECTOR_MAX_BYTELEN];
+    // [byte k][odd bits 1, 3, 5, 7 of byte k] = sum of the selected H(z^(8k+2b+1))
+    unsigned char half_trace[GF2_VECTOR_MAX_BYTELEN][1 << GF2_HALF_TRACE_WINDOW_BITS]
+                            [GF2_VECTOR_MAX_BYTELEN];
+} GF2LinearMaps;
+
+// Returns 1 if all three maps are available, 0 for an even-degree modulus
+// (no half-trace; sqrt and trace still work).
+int gf2_linear_maps_init(GF2LinearMaps* out,
+                         const unsigned char* modulus,
+                         unsigned long bytelen);
+
+// Same results as gf2_sqrt_lsb / gf2_trace_lsb / gf2_half_trace_lsb;
+// in must be reduced.
+void gf2_sqrt(const unsigned char* in,
+              unsigned char* out,
+              const GF2LinearMaps* maps);
+
+int gf2_trace(const unsigned char* in,
+              const GF2LinearMaps* maps);
+
+void gf2_half_trace(const unsigned char* in,
+                    unsigned char* out,
+                    const GF2LinearMaps* maps);
+
+// Constant-time variants: control flow and memory access pattern depend only
+// on lengths and on the (public) modulus, never on operand values.
+// Products and squares are 2 * bytelen long, like gf2_multiply_lsb.
+void gf2_multiply_ct_lsb(const unsigned char* in1,
+                         const unsigned char* in2,
+                         unsigned char* out,
+                         unsigned long bytelen);
+
+void gf2_square_ct_lsb(const unsigned char* in,
+                       unsigned char* out,
+                       unsigned long bytelen);
+
+// Bit-serial masked reduction for any modulus; prefer gf2_reduce_sparse_lsb
+// (also constant time) when the modulus has a sparse form.
+void gf2_reduce_ct_lsb(unsigned char* inout_reducible,
+                       unsigned long reducible_bytelen,
+                       const unsigned char* modulus,
+                       unsigned long modulus_bytelen);
+
+// Fermat inversion a^(2^m - 2) with an Itoh-Tsujii chain: a fixed number of
+// squarings and multiplications for a given modulus. desc may be 0.
+// Maps 0 to 0.
+void gf2_inverse_ct_lsb(const unsigned char* in,
+                        unsigned char* out,
+                        unsigned long bytelen,
+                        const unsigned char* modulus,
+                        const GF2ReductionDescriptor* desc);
+
 #endif // GALOIS_FIELD2_H
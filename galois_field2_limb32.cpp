@@ -0,0 +1,309 @@
+#include "galois_field2_limb32.h"
+
+// Everything works on 32-bit limbs, LSB first, up to GF2_LIMB32_MAX_LIMBS
+// per operand. The comb table is the only sizeable scratch and lives in the
+// comb's own frame.
+
+#define GF2_LIMB32_LIMBS(bytelen)  (((bytelen) + 3UL) >> 2)
+#define GF2_LIMB32_COMB_ROWS       (1UL << GF2_LIMB32_COMB_WINDOW_BITS)
+#define GF2_LIMB32_COMB_MASK       (GF2_LIMB32_COMB_ROWS - 1)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define GF2_LIMB32_NOINLINE __attribute__((noinline))
+#else
+#define GF2_LIMB32_NOINLINE
+#endif
+
+typedef unsigned int gf2_limb_t;
+
+static_assert(sizeof(gf2_limb_t) == 4, "gf2_limb_t must be 32 bits");
+static_assert(32 % GF2_LIMB32_COMB_WINDOW_BITS == 0 && GF2_LIMB32_COMB_WINDOW_BITS <= 8,
+              "GF2_LIMB32_COMB_WINDOW_BITS must be 1, 2, 4 or 8");
+static_assert(GF2_LIMB32_SQUARE_TABLE_BITS == 4 || GF2_LIMB32_SQUARE_TABLE_BITS == 8,
+              "GF2_LIMB32_SQUARE_TABLE_BITS must be 4 or 8");
+static_assert(GF2_LIMB32_SQUARE_TABLE_BYTES <= GF2_LIMB32_ROM_LIMIT_BYTES,
+              "square table over GF2_LIMB32_ROM_LIMIT_BYTES");
+static_assert(GF2_LIMB32_STACK_BYTES <= GF2_LIMB32_RAM_LIMIT_BYTES,
+              "comb window over GF2_LIMB32_RAM_LIMIT_BYTES");
+
+static void gf2_limbs_load(const unsigned char* in, gf2_limb_t* out,
+                           unsigned long bytelen)
+{
+    unsigned long i;
+    for (i = 0; i < GF2_LIMB32_LIMBS(bytelen); ++i)
+        out[i] = 0;
+    for (i = 0; i < bytelen; ++i)
+        out[i >> 2] |= (gf2_limb_t)in[i] << (8 * (i & 3));
+}
+
+static void gf2_limbs_store(const gf2_limb_t* in, unsigned char* out,
+                            unsigned long bytelen)
+{
+    unsigned long i;
+    for (i = 0; i < bytelen; ++i)
+        out[i] = (unsigned char)(in[i >> 2] >> (8 * (i & 3)));
+}
+
+// c[0 .. 2n) = a * b, left-to-right comb over the windows of a
+static GF2_LIMB32_NOINLINE void gf2_limbs_multiply(const gf2_limb_t* a,
+                                                   const gf2_limb_t* b,
+                                                   gf2_limb_t* c, unsigned long n)
+{
+    gf2_limb_t table[GF2_LIMB32_COMB_ROWS][GF2_LIMB32_MAX_LIMBS + 1];
+    unsigned long i, j, u;
+    int shift;
+
+    // table[u] = u(x) * b, n + 1 limbs
+    for (i = 0; i <= n; ++i)
+        table[0][i] = 0;
+    for (u = 1; u < GF2_LIMB32_COMB_ROWS; ++u) {
+        if (u & 1) {
+            for (i = 0; i < n; ++i)
+                table[u][i] = table[u - 1][i] ^ b[i];
+            table[u][n] = table[u - 1][n];
+        } else {
+            gf2_limb_t carry = 0;
+            for (i = 0; i <= n; ++i) {
+                gf2_limb_t v = table[u >> 1][i];
+                table[u][i] = (v << 1) | carry;
+                carry = v >> 31;
+            }
+        }
+    }
+
+    for (i = 0; i < 2 * n; ++i)
+        c[i] = 0;
+    for (shift = 32 - GF2_LIMB32_COMB_WINDOW_BITS; shift >= 0;
+            shift -= GF2_LIMB32_COMB_WINDOW_BITS) {
+        for (j = 0; j < n; ++j) {
+            const gf2_limb_t* row = table[(a[j] >> shift) & GF2_LIMB32_COMB_MASK];
+            for (i = 0; i <= n; ++i)
+                c[j + i] ^= row[i];
+        }
+        if (shift) {
+            for (i = 2 * n - 1; i > 0; --i)
+                c[i] = (c[i] << GF2_LIMB32_COMB_WINDOW_BITS)
+                     | (c[i - 1] >> (32 - GF2_LIMB32_COMB_WINDOW_BITS));
+            c[0] <<= GF2_LIMB32_COMB_WINDOW_BITS;
+        }
+    }
+}
+
+// x^2 spreads bit i to bit 2i; the table spreads one index at a time
+#if GF2_LIMB32_SQUARE_TABLE_BITS == 8
+static const unsigned short gf2_limb32_square_table[256] = {
+#define GF2_SQ2(n)  (unsigned short)(((n) & 1) | (((n) & 2) << 1))
+#define GF2_SQ4(n)  (unsigned short)(GF2_SQ2(n) | (GF2_SQ2((n) >> 2) << 4))
+#define GF2_SQ8(n)  (unsigned short)(GF2_SQ4(n) | (GF2_SQ4((n) >> 4) << 8))
+#define GF2_SQ8_ROW(n) GF2_SQ8(n), GF2_SQ8(n + 1), GF2_SQ8(n + 2), GF2_SQ8(n + 3), \
+                       GF2_SQ8(n + 4), GF2_SQ8(n + 5), GF2_SQ8(n + 6), GF2_SQ8(n + 7)
+    GF2_SQ8_ROW(0),   GF2_SQ8_ROW(8),   GF2_SQ8_ROW(16),  GF2_SQ8_ROW(24),
+    GF2_SQ8_ROW(32),  GF2_SQ8_ROW(40),  GF2_SQ8_ROW(48),  GF2_SQ8_ROW(56),
+    GF2_SQ8_ROW(64),  GF2_SQ8_ROW(72),  GF2_SQ8_ROW(80),  GF2_SQ8_ROW(88),
+    GF2_SQ8_ROW(96),  GF2_SQ8_ROW(104), GF2_SQ8_ROW(112), GF2_SQ8_ROW(120),
+    GF2_SQ8_ROW(128), GF2_SQ8_ROW(136), GF2_SQ8_ROW(144), GF2_SQ8_ROW(152),
+    GF2_SQ8_ROW(160), GF2_SQ8_ROW(168), GF2_SQ8_ROW(176), GF2_SQ8_ROW(184),
+    GF2_SQ8_ROW(192), GF2_SQ8_ROW(200), GF2_SQ8_ROW(208), GF2_SQ8_ROW(216),
+    GF2_SQ8_ROW(224), GF2_SQ8_ROW(232), GF2_SQ8_ROW(240), GF2_SQ8_ROW(248)
+#undef GF2_SQ8_ROW
+#undef GF2_SQ8
+#undef GF2_SQ4
+#undef GF2_SQ2
+};
+#else
+static const unsigned char gf2_limb32_square_table[16] = {
+    0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+    0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55
+};
+#endif
+
+// A 16-bit half spread to the even bits of a limb
+static gf2_limb_t gf2_limb_spread16(gf2_limb_t x)
+{
+#if GF2_LIMB32_SQUARE_TABLE_BITS == 8
+    return (gf2_limb_t)gf2_limb32_square_table[x & 0xFF]
+         | ((gf2_limb_t)gf2_limb32_square_table[(x >> 8) & 0xFF] << 16);
+#else
+    return (gf2_limb_t)gf2_limb32_square_table[x & 0xF]
+         | ((gf2_limb_t)gf2_limb32_square_table[(x >> 4) & 0xF] << 8)
+         | ((gf2_limb_t)gf2_limb32_square_table[(x >> 8) & 0xF] << 16)
+         | ((gf2_limb_t)gf2_limb32_square_table[(x >> 12) & 0xF] << 24);
+#endif
+}
+
+static void gf2_limbs_square(const gf2_limb_t* a, gf2_limb_t* out, unsigned long n)
+{
+    unsigned long i;
+    for (i = 0; i < n; ++i) {
+        out[2 * i] = gf2_limb_spread16(a[i]);
+        out[2 * i + 1] = gf2_limb_spread16(a[i] >> 16);
+    }
+}
+
+static void gf2_limbs_xor_at_bit(gf2_limb_t* dst, gf2_limb_t value,
+                                 unsigned long bit_pos)
+{
+    unsigned long w = bit_pos >> 5;
+    unsigned int  s = bit_pos & 31;
+
+    dst[w] ^= value << s;
+    if (s)
+        dst[w + 1] ^= value >> (32 - s);
+}
+
+// Same condition as the 64-bit fold, one limb instead of one word
+static int gf2_limbs_fold_supported(const GF2ReductionDescriptor* desc)
+{
+    return desc && desc->degree && desc->terms[0] + 32U <= desc->degree;
+}
+
+static void gf2_limbs_reduce_sparse(gf2_limb_t* c, unsigned long limbs,
+                                    const GF2ReductionDescriptor* desc)
+{
+    unsigned long m  = desc->degree;
+    unsigned long mw = m >> 5;
+    unsigned int  mb = m & 31;
+    unsigned long i, k;
+    gf2_limb_t t;
+
+    for (i = limbs - 1; i > mw; --i) {
+        t = c[i];
+        if (!t)
+            continue;
+        c[i] = 0;
+        gf2_limbs_xor_at_bit(c, t, 32 * i - m);
+        for (k = 0; k < desc->term_count; ++k)
+            gf2_limbs_xor_at_bit(c, t, 32 * i - m + desc->terms[k]);
+    }
+
+    t = c[mw] >> mb;
+    c[mw] &= mb ? ((gf2_limb_t)1 << mb) - 1 : 0;
+    gf2_limbs_xor_at_bit(c, t, 0);
+    for (k = 0; k < desc->term_count; ++k)
+        gf2_limbs_xor_at_bit(c, t, desc->terms[k]);
+}
+
+static GF2_LIMB32_NOINLINE void gf2_limbs_reduce_bytes(const gf2_limb_t* c, unsigned char* out,
+                                                       unsigned long bytelen,
+                                                       const unsigned char* modulus,
+                                                       const GF2ReductionDescriptor* desc)
+{
+    alignas(8) unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN];
+    unsigned long i;
+
+    gf2_limbs_store(c, wide, 2 * bytelen);
+    if (desc && desc->degree)
+        gf2_reduce_sparse_lsb(wide, 2 * bytelen, desc);
+    else
+        gf2_reduce_lsb(wide, 2 * bytelen, modulus, bytelen);
+    for (i = 0; i < bytelen; ++i)
+        out[i] = wide[i];
+}
+
+static void gf2_limbs_reduce_store(gf2_limb_t* c, unsigned char* out,
+                                   unsigned long bytelen,
+                                   const unsigned char* modulus,
+                                   const GF2ReductionDescriptor* desc)
+{
+    if (gf2_limbs_fold_supported(desc)) {
+        gf2_limbs_reduce_sparse(c, 2 * GF2_LIMB32_LIMBS(bytelen), desc);
+        gf2_limbs_store(c, out, bytelen);
+    } else {
+        gf2_limbs_reduce_bytes(c, out, bytelen, modulus, desc);
+    }
+}
+
+void gf2_limb32_multiply_lsb(const unsigned char* in1,
+                             const unsigned char* in2,
+                             unsigned char* out,
+                             unsigned long bytelen)
+{
+    gf2_limb_t a[GF2_LIMB32_MAX_LIMBS];
+    gf2_limb_t b[GF2_LIMB32_MAX_LIMBS];
+    gf2_limb_t product[2 * GF2_LIMB32_MAX_LIMBS];
+
+    gf2_limbs_load(in1, a, bytelen);
+    gf2_limbs_load(in2, b, bytelen);
+    gf2_limbs_multiply(a, b, product, GF2_LIMB32_LIMBS(bytelen));
+    gf2_limbs_store(product, out, 2 * bytelen);
+}
+
+void gf2_limb32_field_multiply_lsb(const unsigned char* in1,
+                                   const unsigned char* in2,
+                                   unsigned char* out,
+                                   unsigned long bytelen,
+                                   const unsigned char* modulus,
+                                   const GF2ReductionDescriptor* desc)
+{
+    gf2_limb_t a[GF2_LIMB32_MAX_LIMBS];
+    gf2_limb_t b[GF2_LIMB32_MAX_LIMBS];
+    gf2_limb_t product[2 * GF2_LIMB32_MAX_LIMBS];
+
+    gf2_limbs_load(in1, a, bytelen);
+    gf2_limbs_load(in2, b, bytelen);
+    gf2_limbs_multiply(a, b, product, GF2_LIMB32_LIMBS(bytelen));
+    gf2_limbs_reduce_store(product, out, bytelen, modulus, desc);
+}
+
+void gf2_limb32_field_square_lsb(const unsigned char* in,
+                                 unsigned char* out,
+                                 unsigned long bytelen,
+                                 const unsigned char* modulus,
+                                 const GF2ReductionDescriptor* desc)
+{
+    gf2_limb_t a[GF2_LIMB32_MAX_LIMBS];
+    gf2_limb_t product[2 * GF2_LIMB32_MAX_LIMBS];
+
+    gf2_limbs_load(in, a, bytelen);
+    gf2_limbs_square(a, product, GF2_LIMB32_LIMBS(bytelen));
+    gf2_limbs_reduce_store(product, out, bytelen, modulus, desc);
+}
+
+void gf2_limb32_field_multiply_add_lsb(const unsigned char* in1,
+                                       const unsigned char* in2,
+                                       const unsigned char* add,
+                                       unsigned char* out,
+                                       unsigned long bytelen,
+                                       const unsigned char* modulus,
+                                       const GF2ReductionDescriptor* desc)
+{
+    gf2_limb_t a[GF2_LIMB32_MAX_LIMBS];
+    gf2_limb_t b[GF2_LIMB32_MAX_LIMBS];
+    gf2_limb_t product[2 * GF2_LIMB32_MAX_LIMBS];
+    unsigned long i;
+
+    gf2_limbs_load(in1, a, bytelen);
+    gf2_limbs_load(in2, b, bytelen);
+    gf2_limbs_multiply(a, b, product, GF2_LIMB32_LIMBS(bytelen));
+    gf2_limbs_load(add, a, bytelen);
+    for (i = 0; i < GF2_LIMB32_LIMBS(bytelen); ++i)
+        product[i] ^= a[i];
+    gf2_limbs_reduce_store(product, out, bytelen, modulus, desc);
+}
+
+void gf2_limb32_field_multiply2_add_lsb(const unsigned char* in1,
+                                        const unsigned char* in2,
+                                        const unsigned char* in3,
+                                        const unsigned char* in4,
+                                        unsigned char* out,
+                                        unsigned long bytelen,
+                                        const unsigned char* modulus,
+                                        const GF2ReductionDescriptor* desc)
+{
+    gf2_limb_t a[GF2_LIMB32_MAX_LIMBS];
+    gf2_limb_t b[GF2_LIMB32_MAX_LIMBS];
+    gf2_limb_t product[2 * GF2_LIMB32_MAX_LIMBS];
+    gf2_limb_t product2[2 * GF2_LIMB32_MAX_LIMBS];
+    unsigned long n = GF2_LIMB32_LIMBS(bytelen);
+    unsigned long i;
+
+    gf2_limbs_load(in1, a, bytelen);
+    gf2_limbs_load(in2, b, bytelen);
+    gf2_limbs_multiply(a, b, product, n);
+    gf2_limbs_load(in3, a, bytelen);
+    gf2_limbs_load(in4, b, bytelen);
+    gf2_limbs_multiply(a, b, product2, n);
+    for (i = 0; i < 2 * n; ++i)
+        product[i] ^= product2[i];
+    gf2_limbs_reduce_store(product, out, bytelen, modulus, desc);
+}
@@ -0,0 +1,102 @@
+#ifndef GALOIS_FIELD2_LIMB32_H
+#define GALOIS_FIELD2_LIMB32_H
+
+#include "galois_field2.h"
+
+// Field backend on 32-bit limbs, for cores without a 64-bit multiplier or
+// 64-bit registers (Cortex-M, RISC-V RV32). The 64-bit word kernels of
+// galois_field2.cpp compile there too, but every word operation becomes a
+// register pair and the 64x64 window kernel spills; these kernels keep to
+// one register per limb.
+//
+// - Multiplication: left-to-right comb (Lopez-Dahab). b * u is tabulated
+//   for every u < 2^GF2_LIMB32_COMB_WINDOW_BITS on the stack, then each
+//   window column of a XORs one table row per limb into the product,
+//   followed by one shift of the product by the window width. No
+//   single-limb multiplications at all.
+// - Squaring: bit spreading through a constant table of
+//   2^GF2_LIMB32_SQUARE_TABLE_BITS entries (16 bytes at 4 bits, 512 bytes
+//   at 8 bits, which halves the lookups).
+// - Reduction: the sparse fold of galois_field2.cpp on limbs, when the
+//   descriptor's middle terms lie at least 32 bits below the degree (every
+//   registry curve); otherwise the byte-level sparse or generic reduction.
+//
+// The functions mirror the fused gf2_field_* kernels (same arguments and
+// aliasing rules, results reduced to bytelen bytes) and can be called
+// directly. In builds with GF2_HAVE_LIMB32 they are also reached through
+// GF2_MULTIPLY_KERNEL_LIMB32 in a multiplication plan, and are the default
+// wherever GF2_PREFER_LIMB32 is set (32-bit targets).
+//
+// Footprint limits: the constant tables must fit GF2_LIMB32_ROM_LIMIT_BYTES
+// and the stack data of the deepest kernel (multiply2_add: comb table, two
+// operands, two products) GF2_LIMB32_RAM_LIMIT_BYTES; both are checked at
+// compile time, so a window that does not fit the budget fails the build.
+// footprint_test.cpp measures the real peak stack against the RAM limit.
+
+// Comb window, 1, 2, 4 or 8 bits. The table takes 2^bits * (limbs + 1) limbs
+// of stack: 576 bytes at 4 bits and 32-byte vectors; 2 bits halves the
+// table and doubles the shifts.
+#ifndef GF2_LIMB32_COMB_WINDOW_BITS
+#define GF2_LIMB32_COMB_WINDOW_BITS (4)
+#endif
+// Square table index width, 4 or 8 bits.
+#ifndef GF2_LIMB32_SQUARE_TABLE_BITS
+#define GF2_LIMB32_SQUARE_TABLE_BITS (4)
+#endif
+
+#define GF2_LIMB32_MAX_LIMBS ((GF2_VECTOR_MAX_BYTELEN + 3UL) >> 2)
+
+// The default RAM limit scales with the vector size: 128 bytes per limb
+// plus 64 (1088 at 32-byte vectors, 2624 at 80), which fits the 4-bit
+// window's 88 bytes per limb plus 64 at every size and rules out 8 bits.
+#ifndef GF2_LIMB32_RAM_LIMIT_BYTES
+#define GF2_LIMB32_RAM_LIMIT_BYTES (128UL * GF2_LIMB32_MAX_LIMBS + 64UL)
+#endif
+#ifndef GF2_LIMB32_ROM_LIMIT_BYTES
+#define GF2_LIMB32_ROM_LIMIT_BYTES (512UL)
+#endif
+#define GF2_LIMB32_COMB_TABLE_BYTES \
+    ((1UL << GF2_LIMB32_COMB_WINDOW_BITS) * (GF2_LIMB32_MAX_LIMBS + 1) * 4UL)
+#define GF2_LIMB32_SQUARE_TABLE_BYTES \
+    ((1UL << GF2_LIMB32_SQUARE_TABLE_BITS) * GF2_LIMB32_SQUARE_TABLE_BITS / 4UL)
+// Stack data of the deepest kernel, without call frames
+#define GF2_LIMB32_STACK_BYTES \
+    (GF2_LIMB32_COMB_TABLE_BYTES + 6UL * GF2_LIMB32_MAX_LIMBS * 4UL)
+
+// out = in1 * in2, 2 * bytelen bytes, unreduced
+void gf2_limb32_multiply_lsb(const unsigned char* in1,
+                             const unsigned char* in2,
+                             unsigned char* out,
+                             unsigned long bytelen);
+
+void gf2_limb32_field_multiply_lsb(const unsigned char* in1,
+                                   const unsigned char* in2,
+                                   unsigned char* out,
+                                   unsigned long bytelen,
+                                   const unsigned char* modulus,
+                                   const GF2ReductionDescriptor* desc);
+
+void gf2_limb32_field_square_lsb(const unsigned char* in,
+                                 unsigned char* out,
+                                 unsigned long bytelen,
+                                 const unsigned char* modulus,
+                                 const GF2ReductionDescriptor* desc);
+
+void gf2_limb32_field_multiply_add_lsb(const unsigned char* in1,
+                                       const unsigned char* in2,
+                                       const unsigned char* add,
+                                       unsigned char* out,
+                                       unsigned long bytelen,
+                                       const unsigned char* modulus,
+                                       const GF2ReductionDescriptor* desc);
+
+void gf2_limb32_field_multiply2_add_lsb(const unsigned char* in1,
+                                        const unsigned char* in2,
+                                        const unsigned char* in3,
+                                        const unsigned char* in4,
+                                        unsigned char* out,
+                                        unsigned long bytelen,
+                                        const unsigned char* modulus,
+                                        const GF2ReductionDescriptor* desc);
+
+#endif // GALOIS_FIELD2_LIMB32_H
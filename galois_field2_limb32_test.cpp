@@ -0,0 +1,172 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "galois_field2_limb32.h"
+#include "elliptic_curve_registry.h"
+#define EC_TEST_RNG_SEED (0x3C6EF372UL)
+#include "ec_test_util.h"
+
+// Every limb32 kernel against the 64-bit portable kernels, which the rest of
+// the suite checks against the bitwise reference. desc selects the limb
+// fold, the byte-level sparse reduction or (0) the generic one.
+static int limb32_test_field(const unsigned char *modulus, unsigned long len,
+		long degree, const GF2ReductionDescriptor *desc) {
+	const GF2MultiplyPlan portable = { 0xFFFF, 0xFFFF, GF2_MULTIPLY_KERNEL_PORTABLE };
+	const GF2MultiplyPlan limb32 = { 0xFFFF, 0xFFFF, GF2_MULTIPLY_KERNEL_LIMB32 };
+	int ok = 1;
+
+	for (int iter = 0; iter < 100; ++iter) {
+		unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char c[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char d[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char expected[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char r[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		ec_test_random_element(a, len, degree);
+		ec_test_random_element(b, len, degree);
+		ec_test_random_element(c, len, degree);
+		ec_test_random_element(d, len, degree);
+		if (iter == 0)      // all ones: longest carries through the comb and the fold
+			for (unsigned long i = 0; i < len; ++i)
+				a[i] = b[i] = (unsigned char) ((8 * i + 8 <= (unsigned long) degree) ? 0xFF
+						: (1U << (degree & 7)) - 1U);
+
+		gf2_field_multiply_planned_lsb(a, b, expected, len, modulus, desc, &portable);
+		gf2_limb32_field_multiply_lsb(a, b, r, len, modulus, desc);
+		ok &= ec_test_bytes_equal(r, expected, len);
+		gf2_field_multiply_planned_lsb(a, b, r, len, modulus, desc, &limb32);
+		ok &= ec_test_bytes_equal(r, expected, len);
+
+		gf2_multiply_planned_lsb(a, a, wide, len, &portable);
+		gf2_reduce_lsb(wide, 2 * len, modulus, len);
+		gf2_limb32_field_square_lsb(a, r, len, modulus, desc);
+		ok &= ec_test_bytes_equal(r, wide, len);
+
+		gf2_field_multiply_add_planned_lsb(a, b, c, expected, len, modulus, desc, &portable);
+		gf2_limb32_field_multiply_add_lsb(a, b, c, r, len, modulus, desc);
+		ok &= ec_test_bytes_equal(r, expected, len);
+
+		gf2_field_multiply2_add_planned_lsb(a, b, c, d, expected, len, modulus, desc, &portable);
+		gf2_limb32_field_multiply2_add_lsb(a, b, c, d, a, len, modulus, desc);   // out aliases in1
+		ok &= ec_test_bytes_equal(a, expected, len);
+	}
+	return ok;
+}
+
+int test_gf2_limb32() {
+	int failures = 0;
+	std::cout << "\n--- Testing the 32-bit limb backend against the 64-bit kernels ---\n";
+	std::cout << "comb window " << GF2_LIMB32_COMB_WINDOW_BITS << " bits ("
+			<< GF2_LIMB32_COMB_TABLE_BYTES << " bytes), square table "
+			<< GF2_LIMB32_SQUARE_TABLE_BYTES << " bytes, stack data "
+			<< GF2_LIMB32_STACK_BYTES << " / " << GF2_LIMB32_RAM_LIMIT_BYTES << " bytes\n";
+
+	// Unreduced products at every length, odd limb counts included
+	const GF2MultiplyPlan limb32 = { 0xFFFF, 0xFFFF, GF2_MULTIPLY_KERNEL_LIMB32 };
+	int ok = gf2_multiply_kernel_available(GF2_MULTIPLY_KERNEL_LIMB32) == GF2_HAVE_LIMB32;
+	for (unsigned long len = 1; len <= GF2_VECTOR_MAX_BYTELEN; ++len) {
+		for (int iter = 0; iter < 8; ++iter) {
+			unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char p1[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char p2[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+			ec_test_random_element(a, len, (long) (8 * len));
+			ec_test_random_element(b, len, (long) (8 * len));
+			if (iter == 0)
+				for (unsigned long i = 0; i < len; ++i)
+					a[i] = b[i] = 0xFF;
+			gf2_multiply_ct_lsb(a, b, p2, len);
+			gf2_limb32_multiply_lsb(a, b, p1, len);
+			ok &= ec_test_bytes_equal(p1, p2, 2 * len);
+			gf2_multiply_planned_lsb(a, b, p1, len, &limb32);
+			ok &= ec_test_bytes_equal(p1, p2, 2 * len);
+		}
+	}
+	std::cout << std::left << std::setw(12) << "multiply" << std::right
+			<< (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurveRegistryEntry *entry = elliptic_curve_registry_get(c);
+		const EllipticCurve *curve = entry->curve;
+		unsigned long len = curve->field_size_bytes;
+		GF2ReductionDescriptor desc;
+		ok = gf2_reduction_descriptor_init(&desc, curve->modulus, len);
+		ok &= desc.terms[0] + 32U <= desc.degree;     // every registry curve takes the limb fold
+		ok &= limb32_test_field(curve->modulus, len, desc.degree, &desc);
+		ok &= limb32_test_field(curve->modulus, len, desc.degree, 0);
+		std::cout << std::left << std::setw(12) << entry->sec_name << std::right
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// x^163 + x^120 + 1: too high for the 64-bit fold, not for the limb fold;
+	// x^163 + x^140 + 1: too high for both, byte-level sparse reduction
+	const unsigned short middle[2] = { 120, 140 };
+	for (int m = 0; m < 2; ++m) {
+		unsigned char modulus[GF2_VECTOR_MAX_BYTELEN] = { };
+		GF2ReductionDescriptor desc;
+		modulus[0] = 1;
+		modulus[middle[m] >> 3] |= (unsigned char) (1U << (middle[m] & 7));
+		modulus[163 >> 3] |= 1U << (163 & 7);
+		ok = gf2_reduction_descriptor_init(&desc, modulus, 21);
+		ok &= limb32_test_field(modulus, 21, 163, &desc);
+		std::cout << std::left << std::setw(12) << (m ? "x^163+x^140" : "x^163+x^120")
+				<< std::right << (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// ns per field product (64-bit portable kernel vs. limb32) and square
+// (gf2_field_square_lsb vs. limb32), per registry curve. On a 64-bit host
+// the 64-bit words win; the limb backend is for 32-bit cores, build this
+// with -m32 (or on the target) to compare.
+void benchmark_gf2_limb32() {
+	const int runs = 2000;
+	const GF2MultiplyPlan portable = { 0xFFFF, 0xFFFF, GF2_MULTIPLY_KERNEL_PORTABLE };
+	std::cout << "\n--- Benchmark: 64-bit portable vs. 32-bit limb field kernels (ns, "
+			<< 8 * sizeof(void*) << "-bit build) ---\n";
+	std::cout << std::left << std::setw(12) << "curve" << std::right
+			<< std::setw(10) << "mul 64" << std::setw(10) << "mul 32"
+			<< std::setw(10) << "sqr dflt" << std::setw(10) << "sqr 32" << "\n";
+
+	for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c) {
+		const EllipticCurveRegistryEntry *entry = elliptic_curve_registry_get(c);
+		const EllipticCurve *curve = entry->curve;
+		unsigned long len = curve->field_size_bytes;
+		unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		GF2ReductionDescriptor desc;
+		gf2_reduction_descriptor_init(&desc, curve->modulus, len);
+		ec_test_random_element(a, len, desc.degree);
+		ec_test_random_element(b, len, desc.degree);
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_field_multiply_planned_lsb(a, b, a, len, curve->modulus, &desc, &portable);
+		auto t1 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_limb32_field_multiply_lsb(a, b, a, len, curve->modulus, &desc);
+		auto t2 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i) {
+			gf2_field_square_lsb(a, wide, len, curve->modulus, &desc);
+			a[0] ^= wide[0] ^ b[0];
+		}
+		auto t3 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i) {
+			gf2_limb32_field_square_lsb(a, wide, len, curve->modulus, &desc);
+			a[0] ^= wide[0] ^ b[0];
+		}
+		auto t4 = std::chrono::steady_clock::now();
+
+		std::cout << std::left << std::setw(12) << entry->sec_name << std::right
+				<< std::fixed << std::setprecision(0)
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t1 - t0).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t2 - t1).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t3 - t2).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t4 - t3).count() / runs << "\n";
+	}
+}
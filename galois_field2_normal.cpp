@@ -0,0 +1,589 @@
+#include "galois_field2_normal.h"
+
+// Normal-basis elements are worked on as 64-bit words. A rotation reads m
+// bits out of a doubled copy v + v x^m, so every rotation is a funnel shift
+// over the words, whatever its distance.
+
+#define NORMAL_WORDS(bytelen)  (((bytelen) + 7UL) >> 3)
+#define NORMAL_MAX_WORDS       NORMAL_WORDS(GF2_VECTOR_MAX_BYTELEN)
+
+typedef unsigned long long normal_word_t;
+
+// init keeps the discrete-log table F (p shorts) in to_normal until the
+// matrices are built
+static_assert(sizeof(((GF2NormalBasis*)0)->to_normal)
+              >= 2 * (GF2_NORMAL_MAX_TYPE * GF2_NORMAL_MAX_DEGREE + 1),
+              "to_normal too small for the init scratch");
+
+static void normal_load(const unsigned char* in, normal_word_t* out,
+                        unsigned long bytelen)
+{
+    unsigned long i;
+    for (i = 0; i < NORMAL_WORDS(bytelen); ++i)
+        out[i] = 0;
+    for (i = 0; i < bytelen; ++i)
+        out[i >> 3] |= (normal_word_t)in[i] << (8 * (i & 7));
+}
+
+static void normal_store(const normal_word_t* in, unsigned char* out,
+                         unsigned long bytelen)
+{
+    unsigned long i;
+    for (i = 0; i < bytelen; ++i)
+        out[i] = (unsigned char)(in[i >> 3] >> (8 * (i & 7)));
+}
+
+// d = v + v x^m, 2n words
+static void normal_double(const normal_word_t* v, normal_word_t* d,
+                          unsigned long m, unsigned long n)
+{
+    unsigned long q = m >> 6;
+    unsigned int  sh = m & 63;
+    unsigned long i;
+
+    for (i = 0; i < 2 * n; ++i)
+        d[i] = i < n ? v[i] : 0;
+    for (i = 0; i < n; ++i) {
+        d[i + q] ^= v[i] << sh;
+        if (sh)
+            d[i + q + 1] ^= v[i] >> (64 - sh);
+    }
+}
+
+// out = v rotated down by s < m (bit i = v_((i + s) mod m)), from d = v + v x^m
+static void normal_rotate(const normal_word_t* d, unsigned long s,
+                          normal_word_t* out, unsigned long n,
+                          normal_word_t top_mask)
+{
+    unsigned long q = s >> 6;
+    unsigned int  sh = s & 63;
+    unsigned long w;
+
+    for (w = 0; w < n; ++w)
+        out[w] = sh ? (d[q + w] >> sh) | (d[q + w + 1] << (64 - sh)) : d[q + w];
+    out[n - 1] &= top_mask;
+}
+
+static normal_word_t normal_top_mask(unsigned long m, unsigned long n)
+{
+    unsigned long bits = m - 64 * (n - 1);
+    return bits == 64 ? ~(normal_word_t)0 : ((normal_word_t)1 << bits) - 1;
+}
+
+// Rotation by s down, the common part of square, sqrt and frobenius
+static void normal_rotate_bytes(const unsigned char* in, unsigned char* out,
+                                unsigned long s, const GF2NormalBasis* basis)
+{
+    unsigned long m = basis->degree;
+    unsigned long n = NORMAL_WORDS(basis->bytelen);
+    normal_word_t v[NORMAL_MAX_WORDS];
+    normal_word_t d[2 * NORMAL_MAX_WORDS];
+
+    normal_load(in, v, basis->bytelen);
+    normal_double(v, d, m, n);
+    normal_rotate(d, s, v, n, normal_top_mask(m, n));
+    normal_store(v, out, basis->bytelen);
+}
+
+void gf2_normal_square(const unsigned char* in,
+                       unsigned char* out,
+                       const GF2NormalBasis* basis)
+{
+    normal_rotate_bytes(in, out, basis->degree - 1UL, basis);
+}
+
+void gf2_normal_sqrt(const unsigned char* in,
+                     unsigned char* out,
+                     const GF2NormalBasis* basis)
+{
+    normal_rotate_bytes(in, out, 1, basis);
+}
+
+void gf2_normal_frobenius(const unsigned char* in,
+                          unsigned char* out,
+                          unsigned long k,
+                          const GF2NormalBasis* basis)
+{
+    unsigned long m = basis->degree;
+    normal_rotate_bytes(in, out, (m - k % m) % m, basis);
+}
+
+// c = sum over s of (a rotated by s) & (sum of b rotated by the terms' t):
+// the X9.62 formula for every output bit at once
+void gf2_normal_multiply(const unsigned char* in1,
+                         const unsigned char* in2,
+                         unsigned char* out,
+                         const GF2NormalBasis* basis)
+{
+    unsigned long m = basis->degree;
+    unsigned long n = NORMAL_WORDS(basis->bytelen);
+    unsigned long type = basis->type;
+    normal_word_t top_mask = normal_top_mask(m, n);
+    normal_word_t v[NORMAL_MAX_WORDS];
+    normal_word_t da[2 * NORMAL_MAX_WORDS];
+    normal_word_t db[2 * NORMAL_MAX_WORDS];
+    normal_word_t ra[NORMAL_MAX_WORDS];
+    normal_word_t rb[NORMAL_MAX_WORDS];
+    normal_word_t sum[NORMAL_MAX_WORDS];
+    normal_word_t c[NORMAL_MAX_WORDS];
+    unsigned long s, j, w;
+
+    normal_load(in1, v, basis->bytelen);
+    normal_double(v, da, m, n);
+    normal_load(in2, v, basis->bytelen);
+    normal_double(v, db, m, n);
+    for (w = 0; w < n; ++w)
+        c[w] = 0;
+
+    for (s = 0; s < m; ++s) {
+        const unsigned short* t = &basis->terms[s * type];
+        for (w = 0; w < n; ++w)
+            sum[w] = 0;
+        for (j = 0; j < type; ++j) {
+            if (t[j] == GF2_NORMAL_TERM_NONE)
+                continue;
+            normal_rotate(db, t[j], rb, n, top_mask);
+            for (w = 0; w < n; ++w)
+                sum[w] ^= rb[w];
+        }
+        normal_rotate(da, s, ra, n, top_mask);
+        for (w = 0; w < n; ++w)
+            c[w] ^= ra[w] & sum[w];
+    }
+    normal_store(c, out, basis->bytelen);
+}
+
+void gf2_normal_inverse(const unsigned char* in,
+                        unsigned char* out,
+                        const GF2NormalBasis* basis)
+{
+    unsigned long e = basis->degree - 1UL;
+    unsigned long k = 1;
+    alignas(8) unsigned char r[GF2_VECTOR_MAX_BYTELEN];
+    alignas(8) unsigned char t[GF2_VECTOR_MAX_BYTELEN];
+    unsigned long i;
+    long bit = 0;
+
+    while ((e >> (bit + 1)) != 0)
+        ++bit;
+    for (i = 0; i < basis->bytelen; ++i)
+        r[i] = in[i];
+
+    // r = in^(2^k - 1): k -> 2k with r^(2^k) r, k -> k + 1 with r^2 in
+    for (--bit; bit >= 0; --bit) {
+        gf2_normal_frobenius(r, t, k, basis);
+        gf2_normal_multiply(t, r, r, basis);
+        k *= 2;
+        if ((e >> bit) & 1UL) {
+            gf2_normal_square(r, r, basis);
+            gf2_normal_multiply(r, in, r, basis);
+            k += 1;
+        }
+    }
+    gf2_normal_square(r, out, basis);
+}
+
+void gf2_normal_one(unsigned char* out,
+                    const GF2NormalBasis* basis)
+{
+    unsigned long i;
+    for (i = 0; i < basis->bytelen; ++i)
+        out[i] = (8 * i + 8 <= basis->degree) ? 0xFF
+                : (8 * i < basis->degree) ? (unsigned char)((1U << (basis->degree & 7)) - 1U) : 0;
+}
+
+int gf2_normal_trace(const unsigned char* in,
+                     const GF2NormalBasis* basis)
+{
+    unsigned char acc = 0;
+    unsigned long i;
+    for (i = 0; i < basis->bytelen; ++i)
+        acc ^= in[i];
+    acc ^= acc >> 4;
+    acc ^= acc >> 2;
+    acc ^= acc >> 1;
+    return acc & 1;
+}
+
+// out = sum of rows[j] over the set bits j < m of in, selected by masks
+static void normal_convert(const unsigned char* in, unsigned char* out,
+                           const unsigned char (*rows)[GF2_VECTOR_MAX_BYTELEN],
+                           const GF2NormalBasis* basis)
+{
+    unsigned long len = basis->bytelen;
+    unsigned long i, j;
+
+    for (i = 0; i < len; ++i)
+        out[i] = 0;
+    for (j = 0; j < basis->degree; ++j) {
+        unsigned char mask = (unsigned char)(0U - ((in[j >> 3] >> (j & 7)) & 1U));
+        for (i = 0; i < len; ++i)
+            out[i] ^= rows[j][i] & mask;
+    }
+}
+
+void gf2_normal_from_polynomial(const unsigned char* in,
+                                unsigned char* out,
+                                const GF2NormalBasis* basis)
+{
+    normal_convert(in, out, basis->to_normal, basis);
+}
+
+void gf2_normal_to_polynomial(const unsigned char* in,
+                              unsigned char* out,
+                              const GF2NormalBasis* basis)
+{
+    normal_convert(in, out, basis->to_polynomial, basis);
+}
+
+// ---------------------------------------------------------------------------
+// Construction
+
+static unsigned long normal_pow_mod(unsigned long b, unsigned long e,
+                                    unsigned long p)
+{
+    unsigned long r = 1;
+    b %= p;
+    while (e) {
+        if (e & 1)
+            r = r * b % p;
+        b = b * b % p;
+        e >>= 1;
+    }
+    return r;
+}
+
+static int normal_is_prime(unsigned long p)
+{
+    unsigned long d;
+    if (p < 2)
+        return 0;
+    for (d = 2; d * d <= p; ++d)
+        if (p % d == 0)
+            return 0;
+    return 1;
+}
+
+static unsigned long normal_gcd(unsigned long a, unsigned long b)
+{
+    while (b) {
+        unsigned long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Type-T GNB exists iff p = T m + 1 is prime and gcd(T m / k, m) = 1 with k
+// the order of 2 mod p
+static int normal_type_exists(unsigned long m, unsigned long type)
+{
+    unsigned long p = type * m + 1;
+    unsigned long k = 1, r = 2;
+    if (!normal_is_prime(p))
+        return 0;
+    while (r != 1) {
+        r = 2 * r % p;
+        ++k;
+    }
+    return normal_gcd(type * m / k, m) == 1;
+}
+
+// An element of order exactly type mod p
+static unsigned long normal_order_element(unsigned long type, unsigned long p)
+{
+    unsigned long u, d;
+    for (u = 2; u < p; ++u) {
+        if (normal_pow_mod(u, type, p) != 1)
+            continue;
+        for (d = 1; d < type; ++d)
+            if (type % d == 0 && normal_pow_mod(u, d, p) == 1)
+                break;
+        if (d == type)
+            return u;
+    }
+    return 0;
+}
+
+// Smallest binary irreducible polynomial of degree deg (bit i = z^i)
+static unsigned int normal_irreducible(unsigned int deg)
+{
+    unsigned int q, d, r;
+    for (q = (1U << deg) | 1U; q < (2U << deg); q += 2) {
+        int irreducible = 1;
+        for (d = 2; d < (1U << (deg / 2 + 1)) && irreducible; ++d) {
+            // r = q mod d
+            unsigned int dd = 0;
+            while ((d >> (dd + 1)) != 0)
+                ++dd;
+            r = q;
+            for (int b = (int)deg; b >= (int)dd; --b)
+                if ((r >> b) & 1U)
+                    r ^= d << (b - dd);
+            irreducible = r != 0;
+        }
+        if (irreducible)
+            return q;
+    }
+    return 0;
+}
+
+// GF(2^(T m)) = GF(2^m)[z] / q(z): elements are T polynomial-basis elements
+typedef unsigned char NormalExtElement[GF2_NORMAL_MAX_TYPE][GF2_VECTOR_MAX_BYTELEN];
+
+typedef struct {
+    unsigned long type;
+    unsigned int q;
+    unsigned long bytelen;
+    const unsigned char* modulus;
+    const GF2ReductionDescriptor* desc;
+} NormalExt;
+
+static void normal_ext_reduce(unsigned char (*wide)[GF2_VECTOR_MAX_BYTELEN],
+                              NormalExtElement out, const NormalExt* ext)
+{
+    unsigned long t = ext->type;
+    unsigned long d, e, i;
+    for (d = 2 * t - 2; d >= t; --d)
+        for (e = 0; e < t; ++e)
+            if ((ext->q >> e) & 1U)
+                for (i = 0; i < ext->bytelen; ++i)
+                    wide[d - t + e][i] ^= wide[d][i];
+    for (d = 0; d < t; ++d)
+        for (i = 0; i < ext->bytelen; ++i)
+            out[d][i] = wide[d][i];
+}
+
+static void normal_ext_multiply(const NormalExtElement a, const NormalExtElement b,
+                                NormalExtElement out, const NormalExt* ext)
+{
+    unsigned char wide[2 * GF2_NORMAL_MAX_TYPE - 1][GF2_VECTOR_MAX_BYTELEN] = { };
+    unsigned long i, j;
+    for (i = 0; i < ext->type; ++i)
+        for (j = 0; j < ext->type; ++j)
+            gf2_field_multiply_add_lsb(a[i], b[j], wide[i + j], wide[i + j],
+                                       ext->bytelen, ext->modulus, ext->desc);
+    normal_ext_reduce(wide, out, ext);
+}
+
+// (sum a_i z^i)^2 = sum a_i^2 z^(2i) in characteristic 2
+static void normal_ext_square(const NormalExtElement a, NormalExtElement out,
+                              const NormalExt* ext)
+{
+    unsigned char wide[2 * GF2_NORMAL_MAX_TYPE - 1][GF2_VECTOR_MAX_BYTELEN] = { };
+    unsigned long i;
+    for (i = 0; i < ext->type; ++i)
+        gf2_field_square_lsb(a[i], wide[2 * i], ext->bytelen, ext->modulus, ext->desc);
+    normal_ext_reduce(wide, out, ext);
+}
+
+static void normal_ext_set_one(NormalExtElement out, const NormalExt* ext)
+{
+    unsigned long i, j;
+    for (i = 0; i < ext->type; ++i)
+        for (j = 0; j < ext->bytelen; ++j)
+            out[i][j] = 0;
+    out[0][0] = 1;
+}
+
+static int normal_ext_is_one(const NormalExtElement a, const NormalExt* ext)
+{
+    unsigned char acc = (unsigned char)(a[0][0] ^ 1U);
+    unsigned long i, j;
+    for (i = 0; i < ext->type; ++i)
+        for (j = (i == 0); j < ext->bytelen; ++j)
+            acc |= a[i][j];
+    return acc == 0;
+}
+
+// out = base^e for a small e
+static void normal_ext_power(const NormalExtElement base, unsigned long e,
+                             NormalExtElement out, const NormalExt* ext)
+{
+    long bit;
+    normal_ext_set_one(out, ext);
+    for (bit = 8 * (long)sizeof(e) - 1; bit >= 0; --bit) {
+        normal_ext_square(out, out, ext);
+        if ((e >> bit) & 1UL)
+            normal_ext_multiply(out, base, out, ext);
+    }
+}
+
+// out = base^((2^(T m) - 1) / p): the exponent's bits come out of a long
+// division of T m one-bits by p, most significant first
+static void normal_ext_power_period(const NormalExtElement base, unsigned long bits,
+                                    unsigned long p, NormalExtElement out,
+                                    const NormalExt* ext)
+{
+    unsigned long r = 0, i;
+    normal_ext_set_one(out, ext);
+    for (i = 0; i < bits; ++i) {
+        r = 2 * r + 1;
+        normal_ext_square(out, out, ext);
+        if (r >= p) {
+            r -= p;
+            normal_ext_multiply(out, base, out, ext);
+        }
+    }
+}
+
+// beta = sum of gamma^(u^j), j < T, gamma = alpha^((2^(T m) - 1) / p) of
+// order p for some alpha = z + c. beta lies in GF(2^m): the z^1 .. z^(T-1)
+// parts must vanish.
+static int normal_gauss_period(const GF2NormalBasis* basis, unsigned long u,
+                               const unsigned char* modulus, unsigned char* beta)
+{
+    unsigned long m = basis->degree, type = basis->type, p = basis->prime;
+    unsigned long len = basis->bytelen;
+    GF2ReductionDescriptor desc;
+    NormalExt ext;
+    NormalExtElement alpha = { }, gamma, power, sum = { };
+    unsigned long c, i, j, e;
+
+    ext.type = type;
+    ext.q = normal_irreducible((unsigned int)type);
+    ext.bytelen = len;
+    ext.modulus = modulus;
+    ext.desc = gf2_reduction_descriptor_init(&desc, modulus, len) ? &desc : 0;
+    // q stays irreducible over GF(2^m) only for gcd(T, m) = 1
+    if (!ext.q || normal_gcd(type, m) != 1)
+        return 0;
+
+    for (c = 0; c < 256; ++c) {
+        alpha[0][0] = (unsigned char)c;
+        alpha[1][0] = 1;
+        normal_ext_power_period(alpha, type * m, p, gamma, &ext);
+        if (!normal_ext_is_one(gamma, &ext))
+            break;
+    }
+    if (c == 256)
+        return 0;
+
+    for (j = 0, e = 1; j < type; ++j, e = e * u % p) {
+        normal_ext_power(gamma, e, power, &ext);
+        for (i = 0; i < type; ++i)
+            for (c = 0; c < len; ++c)
+                sum[i][c] ^= power[i][c];
+    }
+
+    unsigned char rest = 0, nonzero = 0;
+    for (i = 1; i < type; ++i)
+        for (c = 0; c < len; ++c)
+            rest |= sum[i][c];
+    for (c = 0; c < len; ++c) {
+        beta[c] = sum[0][c];
+        nonzero |= sum[0][c];
+    }
+    return rest == 0 && nonzero != 0;
+}
+
+static void normal_swap_bits(unsigned char* row, unsigned long i, unsigned long j)
+{
+    unsigned char bi = (row[i >> 3] >> (i & 7)) & 1U;
+    unsigned char bj = (row[j >> 3] >> (j & 7)) & 1U;
+    if (bi != bj) {
+        row[i >> 3] ^= (unsigned char)(1U << (i & 7));
+        row[j >> 3] ^= (unsigned char)(1U << (j & 7));
+    }
+}
+
+// In-place Gauss-Jordan inversion of the m x m GF(2) matrix held in rows,
+// row pivoting undone as column swaps at the end. Returns 0 if singular.
+static int normal_invert(unsigned char (*rows)[GF2_VECTOR_MAX_BYTELEN],
+                         unsigned long m, unsigned long len)
+{
+    unsigned short pivots[GF2_NORMAL_MAX_DEGREE];
+    unsigned long k, i, r;
+
+    for (k = 0; k < m; ++k) {
+        for (r = k; r < m && !((rows[r][k >> 3] >> (k & 7)) & 1U); ++r)
+            ;
+        if (r == m)
+            return 0;
+        pivots[k] = (unsigned short)r;
+        if (r != k)
+            for (i = 0; i < len; ++i) {
+                unsigned char t = rows[r][i];
+                rows[r][i] = rows[k][i];
+                rows[k][i] = t;
+            }
+        // rows[i] -= f rows[k] off column k, column k becomes f
+        for (r = 0; r < m; ++r) {
+            if (r == k || !((rows[r][k >> 3] >> (k & 7)) & 1U))
+                continue;
+            for (i = 0; i < len; ++i)
+                rows[r][i] ^= rows[k][i];
+            rows[r][k >> 3] |= (unsigned char)(1U << (k & 7));
+        }
+    }
+    for (k = m; k-- > 0;)
+        if (pivots[k] != k)
+            for (r = 0; r < m; ++r)
+                normal_swap_bits(rows[r], k, pivots[k]);
+    return 1;
+}
+
+int gf2_normal_basis_init(GF2NormalBasis* out,
+                          const unsigned char* modulus,
+                          unsigned long bytelen)
+{
+    unsigned char* raw = (unsigned char*)out;
+    long degree = gf2_degree_lsb(modulus, bytelen);
+    unsigned long m, type, p, u, i, j, k, w, n;
+    GF2ReductionDescriptor desc;
+    const GF2ReductionDescriptor* desc_ptr;
+
+    for (i = 0; i < sizeof(GF2NormalBasis); ++i)
+        raw[i] = 0;
+    if (degree < 2 || (unsigned long)degree >= 8 * bytelen
+            || bytelen > GF2_VECTOR_MAX_BYTELEN)
+        return 0;
+    m = (unsigned long)degree;
+    for (type = 2; type <= GF2_NORMAL_MAX_TYPE; type += 2)
+        if (normal_type_exists(m, type))
+            break;
+    if (type > GF2_NORMAL_MAX_TYPE)
+        return 0;
+    p = type * m + 1;
+    u = normal_order_element(type, p);
+    out->bytelen = (unsigned short)bytelen;
+    out->degree = (unsigned short)m;
+    out->type = (unsigned short)type;
+    out->prime = (unsigned short)p;
+
+    // F(2^i u^j mod p) = i, kept in to_normal for now
+    unsigned short* log_table = (unsigned short*)out->to_normal;
+    for (i = 0; i < p; ++i)
+        log_table[i] = GF2_NORMAL_TERM_NONE;
+    for (j = 0, w = 1; j < type; ++j, w = w * u % p)
+        for (i = 0, n = w; i < m; ++i, n = 2 * n % p) {
+            if (log_table[n] != GF2_NORMAL_TERM_NONE)
+                return 0;
+            log_table[n] = (unsigned short)i;
+        }
+
+    for (i = 0; i < type * m; ++i)
+        out->terms[i] = GF2_NORMAL_TERM_NONE;
+    for (k = 1; k + 1 < p; ++k) {
+        unsigned short* slot = &out->terms[log_table[k + 1] * type];
+        for (j = 0; j < type && slot[j] != GF2_NORMAL_TERM_NONE; ++j)
+            ;
+        if (j == type)
+            return 0;
+        slot[j] = log_table[p - k];
+    }
+    for (i = 0; i < p; ++i)
+        log_table[i] = 0;
+
+    // Rows beta^(2^i) in the polynomial basis, then their inverse
+    if (!normal_gauss_period(out, u, modulus, out->to_polynomial[0]))
+        return 0;
+    desc_ptr = gf2_reduction_descriptor_init(&desc, modulus, bytelen) ? &desc : 0;
+    for (i = 1; i < m; ++i)
+        gf2_field_square_lsb(out->to_polynomial[i - 1], out->to_polynomial[i],
+                             bytelen, modulus, desc_ptr);
+    for (i = 0; i < m; ++i)
+        for (j = 0; j < bytelen; ++j)
+            out->to_normal[i][j] = out->to_polynomial[i][j];
+    return normal_invert(out->to_normal, m, bytelen);
+}
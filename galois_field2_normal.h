@@ -0,0 +1,105 @@
+#ifndef GALOIS_FIELD2_NORMAL_H
+#define GALOIS_FIELD2_NORMAL_H
+
+#include "galois_field2.h"
+
+// Gaussian normal basis (GNB) representation of GF(2^m), the alternative to
+// the polynomial basis of galois_field2.h that SEC 1 / FIPS 186 also define.
+//
+// An element is a = sum of a_i beta^(2^i), i < m, with bit i of the usual
+// LSB-first vector holding a_i. Squaring is then a cyclic rotation of the
+// bits (a_i moves to i + 1), the square root the reverse rotation, 1 is the
+// all-ones vector and the trace is the parity of the bits.
+//
+// beta is a Gauss period of type T: with p = T m + 1 prime and u of order T
+// mod p, beta = sum of gamma^(u^j), j < T, for a primitive p-th root of unity
+// gamma. Multiplication follows the ANSI X9.62 formula: with F(2^i u^j) = i,
+//   c_i = sum over k = 1 .. p - 2 of a_(F(k + 1) + i) b_(F(p - k) + i)
+// (indices mod m), evaluated for all i at once on rotated copies of the
+// operands. Only even types are supported; they cover every NIST degree
+// (163: T = 4, 233: 2, 283: 6, 409: 4, 571: 10).
+//
+// gf2_normal_basis_init() finds the type, builds the product's term table
+// and the two conversion matrices between the bases: beta is computed in the
+// polynomial basis as a Gauss period inside GF(2^(T m)) = GF(2^m)[z] / q(z),
+// q a binary irreducible of degree T (prime to m). Conversions let a
+// normal-basis computation take and return polynomial-basis bytes.
+//
+// Squarings, square roots and 2^k-th powers cost a rotation; a product
+// costs about m (T + 1) rotations, so it is slower than the polynomial
+// basis's word kernels in software. The basis pays off in square-heavy
+// work: Itoh-Tsujii inversion and the Frobenius map of Koblitz curves.
+//
+// The structure is plain data (no pointers); at 32-byte vectors it takes
+// about 21 KB and init needs about 2.5 KB of stack.
+
+#ifndef GF2_NORMAL_MAX_TYPE
+#define GF2_NORMAL_MAX_TYPE (10)
+#endif
+
+#define GF2_NORMAL_MAX_DEGREE (8 * GF2_VECTOR_MAX_BYTELEN)
+#define GF2_NORMAL_TERM_NONE  (0xFFFFU)
+
+typedef struct alignas(8) {
+    unsigned short bytelen;
+    unsigned short degree;                  // m
+    unsigned short type;                    // T
+    unsigned short prime;                   // p = T m + 1
+    // [s * T + j] = the F(p - k) of the terms with F(k + 1) = s, j < T
+    // (s = 0 has T - 1 of them, the last slot is GF2_NORMAL_TERM_NONE)
+    unsigned short terms[GF2_NORMAL_MAX_TYPE * GF2_NORMAL_MAX_DEGREE];
+    // row j: x^j in the normal basis
+    unsigned char to_normal[GF2_NORMAL_MAX_DEGREE][GF2_VECTOR_MAX_BYTELEN];
+    // row i: beta^(2^i) in the polynomial basis
+    unsigned char to_polynomial[GF2_NORMAL_MAX_DEGREE][GF2_VECTOR_MAX_BYTELEN];
+} GF2NormalBasis;
+
+// Returns 1 on success, 0 if the degree has no even-type GNB up to
+// GF2_NORMAL_MAX_TYPE (or the construction fails, which it should not).
+int gf2_normal_basis_init(GF2NormalBasis* out,
+                          const unsigned char* modulus,
+                          unsigned long bytelen);
+
+// Basis conversions; in must be reduced, out may not alias in.
+void gf2_normal_from_polynomial(const unsigned char* in,
+                                unsigned char* out,
+                                const GF2NormalBasis* basis);
+
+void gf2_normal_to_polynomial(const unsigned char* in,
+                              unsigned char* out,
+                              const GF2NormalBasis* basis);
+
+// Normal-basis arithmetic; outputs may alias the inputs.
+void gf2_normal_multiply(const unsigned char* in1,
+                         const unsigned char* in2,
+                         unsigned char* out,
+                         const GF2NormalBasis* basis);
+
+void gf2_normal_square(const unsigned char* in,
+                       unsigned char* out,
+                       const GF2NormalBasis* basis);
+
+void gf2_normal_sqrt(const unsigned char* in,
+                     unsigned char* out,
+                     const GF2NormalBasis* basis);
+
+// out = in^(2^k), any k
+void gf2_normal_frobenius(const unsigned char* in,
+                          unsigned char* out,
+                          unsigned long k,
+                          const GF2NormalBasis* basis);
+
+// Itoh-Tsujii: in^(2^m - 2) with about log2(m) + popcount(m - 1) products,
+// the squarings are rotations. Maps 0 to 0.
+void gf2_normal_inverse(const unsigned char* in,
+                        unsigned char* out,
+                        const GF2NormalBasis* basis);
+
+// 1 in the normal basis (all ones)
+void gf2_normal_one(unsigned char* out,
+                    const GF2NormalBasis* basis);
+
+int gf2_normal_trace(const unsigned char* in,
+                     const GF2NormalBasis* basis);
+
+#endif // GALOIS_FIELD2_NORMAL_H
@@ -0,0 +1,640 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "galois_field2.h"
+#define EC_TEST_RNG_SEED (0x2545F491UL)
+#include "ec_test_util.h"
+
+// Moduli used by the built-in curves, LSB-first
+static const struct {
+	const char *name;
+	unsigned long bytelen;
+	unsigned short terms[4];
+	unsigned short degree;
+} gf2_test_moduli[] = {
+	{ "x^163+x^7+x^6+x^3+1", 21, { 7, 6, 3, 0 }, 163 },
+	{ "x^233+x^74+1", 30, { 74, 0, 0, 0 }, 233 },
+	{ "x^283+x^12+x^7+x^5+1", 36, { 12, 7, 5, 0 }, 283 },
+	{ "x^409+x^87+1", 52, { 87, 0, 0, 0 }, 409 },
+	{ "x^571+x^10+x^5+x^2+1", 72, { 10, 5, 2, 0 }, 571 },
+};
+
+int test_gf2_reduce_sparse() {
+	int failures = 0;
+	std::cout << "\n--- Testing sparse (descriptor) reduction against gf2_reduce_lsb ---\n";
+
+	for (unsigned long m = 0; m < sizeof(gf2_test_moduli) / sizeof(gf2_test_moduli[0]); ++m) {
+		unsigned long len = gf2_test_moduli[m].bytelen;
+		if (len >= GF2_VECTOR_MAX_BYTELEN)
+			continue;
+		unsigned char modulus[GF2_VECTOR_MAX_BYTELEN] = { };
+		modulus[0] = 1;
+		modulus[gf2_test_moduli[m].degree >> 3] |= 1U << (gf2_test_moduli[m].degree & 7);
+		for (int k = 0; k < 4 && gf2_test_moduli[m].terms[k]; ++k)
+			modulus[gf2_test_moduli[m].terms[k] >> 3] |= 1U << (gf2_test_moduli[m].terms[k] & 7);
+
+		GF2ReductionDescriptor desc;
+		int ok = gf2_reduction_descriptor_init(&desc, modulus, len);
+		for (int iter = 0; ok && iter < 200; ++iter) {
+			unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char p1[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char p2[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+			ec_test_random_element(a, len, desc.degree);
+			ec_test_random_element(b, len, desc.degree);
+			gf2_multiply_lsb(a, b, p1, len);
+			for (unsigned long i = 0; i < 2 * len; ++i)
+				p2[i] = p1[i];
+			gf2_reduce_lsb(p1, 2 * len, modulus, len);
+			gf2_reduce_sparse_lsb(p2, 2 * len, &desc);
+			for (unsigned long i = 0; i < 2 * len; ++i)
+				ok &= p1[i] == p2[i];
+		}
+		std::cout << std::left << std::setw(24) << gf2_test_moduli[m].name
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// Dense moduli have no sparse form and must be rejected
+	const unsigned char dense[3] = { 0x87, 0xFF, 0x01 };
+	GF2ReductionDescriptor desc;
+	int ok = !gf2_reduction_descriptor_init(&desc, dense, 3) && desc.degree == 0;
+	std::cout << std::left << std::setw(24) << "dense modulus rejected"
+			<< (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+	return failures;
+}
+
+int test_gf2_constant_time() {
+	int failures = 0;
+	std::cout << "\n--- Testing constant-time field arithmetic against the reference ---\n";
+
+	for (unsigned long m = 0; m < sizeof(gf2_test_moduli) / sizeof(gf2_test_moduli[0]); ++m) {
+		unsigned long len = gf2_test_moduli[m].bytelen;
+		if (len >= GF2_VECTOR_MAX_BYTELEN)
+			continue;
+		unsigned char modulus[GF2_VECTOR_MAX_BYTELEN] = { };
+		modulus[0] = 1;
+		modulus[gf2_test_moduli[m].degree >> 3] |= 1U << (gf2_test_moduli[m].degree & 7);
+		for (int k = 0; k < 4 && gf2_test_moduli[m].terms[k]; ++k)
+			modulus[gf2_test_moduli[m].terms[k] >> 3] |= 1U << (gf2_test_moduli[m].terms[k] & 7);
+
+		GF2ReductionDescriptor desc;
+		gf2_reduction_descriptor_init(&desc, modulus, len);
+		int ok = 1;
+		for (int iter = 0; iter < 50; ++iter) {
+			unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char p1[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char p2[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char i1[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char i2[GF2_VECTOR_MAX_BYTELEN] = { };
+			ec_test_random_element(a, len, desc.degree);
+			ec_test_random_element(b, len, desc.degree);
+
+			gf2_multiply_lsb(a, b, p1, len);
+			gf2_multiply_ct_lsb(a, b, p2, len);
+			for (unsigned long i = 0; i < 2 * len; ++i)
+				ok &= p1[i] == p2[i];
+
+			gf2_multiply_lsb(a, a, p1, len);
+			gf2_square_ct_lsb(a, p2, len);
+			for (unsigned long i = 0; i < 2 * len; ++i)
+				ok &= p1[i] == p2[i];
+
+			gf2_reduce_lsb(p1, 2 * len, modulus, len);
+			gf2_reduce_ct_lsb(p2, 2 * len, modulus, len);
+			for (unsigned long i = 0; i < 2 * len; ++i)
+				ok &= p1[i] == p2[i];
+
+			gf2_binary_inverse_lsb(a, i1, len, modulus);
+			gf2_inverse_ct_lsb(a, i2, len, modulus, (iter & 1) ? &desc : 0);
+			for (unsigned long i = 0; i < len; ++i)
+				ok &= i1[i] == i2[i];
+		}
+		unsigned char zero[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char inv[GF2_VECTOR_MAX_BYTELEN] = { };
+		inv[0] = 0x5A;
+		gf2_inverse_ct_lsb(zero, inv, len, modulus, &desc);
+		for (unsigned long i = 0; i < len; ++i)
+			ok &= inv[i] == 0;
+
+		std::cout << std::left << std::setw(24) << gf2_test_moduli[m].name
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+int test_gf2_multiply_split() {
+	int failures = 0;
+	std::cout << "\n--- Testing Karatsuba / Toom-3 multiplication against the bitwise product ---\n";
+
+	const int kernels[] = { GF2_MULTIPLY_KERNEL_PORTABLE, GF2_MULTIPLY_KERNEL_CLMUL };
+	// (karatsuba, toom3) thresholds: schoolbook only, Karatsuba everywhere,
+	// Toom-3 everywhere, and the two mixed below each other
+	const unsigned short thresholds[][2] = {
+		{ 0xFFFF, 0xFFFF }, { 2, 0xFFFF }, { 0xFFFF, 3 }, { 2, 3 }, { 2, 6 }, { 4, 3 },
+	};
+	for (int kernel = 0; kernel < 2; ++kernel) {
+		if (!gf2_multiply_kernel_available(kernels[kernel]))
+			continue;
+		for (unsigned long t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); ++t) {
+			GF2MultiplyPlan plan;
+			plan.karatsuba_threshold_words = thresholds[t][0];
+			plan.toom3_threshold_words = thresholds[t][1];
+			plan.kernel = (unsigned short) kernels[kernel];
+			int ok = 1;
+			for (unsigned long len = 1; len < GF2_VECTOR_MAX_BYTELEN; ++len) {
+				for (int iter = 0; iter < 8; ++iter) {
+					unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+					unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+					unsigned char p1[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+					unsigned char p2[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+					ec_test_random_element(a, len, (long) (8 * len));
+					ec_test_random_element(b, len, (long) (8 * len));
+					if (iter == 0) {
+						for (unsigned long i = 0; i < len; ++i)
+							a[i] = b[i] = 0xFF;     // all-ones: every carry path taken
+					}
+					gf2_multiply_planned_lsb(a, b, p1, len, &plan);
+					gf2_multiply_ct_lsb(a, b, p2, len);
+					for (unsigned long i = 0; i < 2 * len; ++i)
+						ok &= p1[i] == p2[i];
+				}
+			}
+			std::cout << std::left << std::setw(10) << (kernel ? "clmul" : "portable")
+					<< "karatsuba >= " << std::setw(6) << thresholds[t][0]
+					<< "toom3 >= " << std::setw(7) << thresholds[t][1]
+					<< (ok ? "PASS" : "FAIL") << "\n";
+			failures += !ok;
+		}
+	}
+	return failures;
+}
+
+// ns per multiplication for one plan, operands of bytelen bytes
+static double gf2_benchmark_plan(unsigned long bytelen, unsigned short karatsuba,
+		unsigned short toom3, int kernel) {
+	GF2MultiplyPlan plan;
+	plan.karatsuba_threshold_words = karatsuba;
+	plan.toom3_threshold_words = toom3;
+	plan.kernel = (unsigned short) kernel;
+	unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+	unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+	unsigned char p[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+	ec_test_random_element(a, bytelen, (long) (8 * bytelen));
+	ec_test_random_element(b, bytelen, (long) (8 * bytelen));
+
+	const int runs = 5000;
+	double best = 0;
+	for (int rep = 0; rep < 7; ++rep) {   // best of 7 against scheduler noise
+		auto t0 = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r) {
+			gf2_multiply_planned_lsb(a, b, p, bytelen, &plan);
+			a[0] ^= p[bytelen];     // keep the loop from being folded
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / runs;
+		if (!rep || ns < best)
+			best = ns;
+	}
+	return best;
+}
+
+// Where each split pays off: one level of Karatsuba / Toom-3 over the
+// schoolbook loop, and full recursion, per field size and base kernel.
+void benchmark_gf2_multiply() {
+	const unsigned long degrees[] = { 163, 233, 283, 409, 571 };
+	std::cout << "\n--- Benchmark: GF(2)[x] multiplication, ns per product ---\n";
+
+	for (int kernel = GF2_MULTIPLY_KERNEL_PORTABLE; kernel <= GF2_MULTIPLY_KERNEL_CLMUL; ++kernel) {
+		if (!gf2_multiply_kernel_available(kernel)) {
+			std::cout << "clmul kernel not compiled in (build with -mpclmul)\n";
+			continue;
+		}
+		std::cout << (kernel ? "clmul" : "portable") << " kernel\n" << std::right
+				<< std::setw(8) << "degree" << std::setw(7) << "words"
+				<< std::setw(12) << "schoolbook" << std::setw(12) << "kara x1"
+				<< std::setw(12) << "kara full" << std::setw(12) << "toom3 x1"
+				<< std::setw(12) << "toom3+kara" << std::setw(12) << "default" << "\n";
+		for (unsigned long d = 0; d < sizeof(degrees) / sizeof(degrees[0]); ++d) {
+			unsigned long bytelen = (degrees[d] + 7) / 8;
+			unsigned short words = (unsigned short) ((bytelen + 7) / 8);
+			if (bytelen >= GF2_VECTOR_MAX_BYTELEN) {
+				std::cout << std::setw(8) << degrees[d] << "  needs GF2_VECTOR_MAX_BYTELEN > "
+						<< bytelen << "\n";
+				continue;
+			}
+			GF2MultiplyPlan def;
+			gf2_multiply_plan_default(&def);
+			std::cout << std::setw(8) << degrees[d] << std::setw(7) << words
+					<< std::fixed << std::setprecision(0)
+					<< std::setw(12) << gf2_benchmark_plan(bytelen, 0xFFFF, 0xFFFF, kernel)
+					<< std::setw(12) << gf2_benchmark_plan(bytelen, words, 0xFFFF, kernel)
+					<< std::setw(12) << gf2_benchmark_plan(bytelen, 2, 0xFFFF, kernel)
+					<< std::setw(12) << gf2_benchmark_plan(bytelen, 0xFFFF, words, kernel)
+					<< std::setw(12) << gf2_benchmark_plan(bytelen, 2, words, kernel)
+					<< std::setw(12) << gf2_benchmark_plan(bytelen, def.karatsuba_threshold_words,
+							def.toom3_threshold_words, kernel) << "\n";
+		}
+	}
+}
+
+static void gf2_test_load_modulus(unsigned long m, unsigned char *modulus) {
+	for (unsigned long i = 0; i < GF2_VECTOR_MAX_BYTELEN; ++i)
+		modulus[i] = 0;
+	modulus[0] = 1;
+	modulus[gf2_test_moduli[m].degree >> 3] |= 1U << (gf2_test_moduli[m].degree & 7);
+	for (int k = 0; k < 4 && gf2_test_moduli[m].terms[k]; ++k)
+		modulus[gf2_test_moduli[m].terms[k] >> 3] |= 1U << (gf2_test_moduli[m].terms[k] & 7);
+}
+
+static GF2LinearMaps gf2_test_maps;
+
+int test_gf2_linear_maps() {
+	int failures = 0;
+	std::cout << "\n--- Testing table-driven sqrt / trace / half-trace against the reference ---\n";
+
+	for (unsigned long m = 0; m < sizeof(gf2_test_moduli) / sizeof(gf2_test_moduli[0]); ++m) {
+		unsigned long len = gf2_test_moduli[m].bytelen;
+		if (len >= GF2_VECTOR_MAX_BYTELEN)
+			continue;
+		unsigned char modulus[GF2_VECTOR_MAX_BYTELEN];
+		gf2_test_load_modulus(m, modulus);
+
+		int ok = gf2_linear_maps_init(&gf2_test_maps, modulus, len);
+		for (int iter = 0; iter < 40; ++iter) {
+			unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char r1[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char r2[GF2_VECTOR_MAX_BYTELEN] = { };
+			ec_test_random_element(a, len, gf2_test_moduli[m].degree);
+			if (iter < 2)     // 0 and 1
+				for (unsigned long i = 0; i < len; ++i)
+					a[i] = (unsigned char) (i ? 0 : iter);
+
+			gf2_sqrt_lsb(a, r1, len, modulus);
+			gf2_sqrt(a, r2, &gf2_test_maps);
+			for (unsigned long i = 0; i < len; ++i)
+				ok &= r1[i] == r2[i];
+			ok &= gf2_trace_lsb(a, len, modulus) == gf2_trace(a, &gf2_test_maps);
+			gf2_half_trace_lsb(a, r1, len, modulus);
+			gf2_half_trace(a, r2, &gf2_test_maps);
+			for (unsigned long i = 0; i < len; ++i)
+				ok &= r1[i] == r2[i];
+		}
+		std::cout << std::left << std::setw(24) << gf2_test_moduli[m].name
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// Even degree (AES field): no half-trace, sqrt and trace still valid
+	const unsigned char aes[2] = { 0x1B, 0x01 };
+	int ok = !gf2_linear_maps_init(&gf2_test_maps, aes, 2);
+	for (unsigned int v = 0; v < 256; ++v) {
+		unsigned char a[2] = { (unsigned char) v, 0 };
+		unsigned char r1[2] = { }, r2[2] = { };
+		gf2_sqrt_lsb(a, r1, 2, aes);
+		gf2_sqrt(a, r2, &gf2_test_maps);
+		ok &= r1[0] == r2[0] && r1[1] == r2[1];
+		ok &= gf2_trace_lsb(a, 2, aes) == gf2_trace(a, &gf2_test_maps);
+	}
+	std::cout << std::left << std::setw(24) << "x^8+x^4+x^3+x+1" << (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+	return failures;
+}
+
+// Reference (m squarings) vs. table-driven maps, us per call
+void benchmark_gf2_linear_maps() {
+	const int runs = 200;
+	std::cout << "\n--- Benchmark: sqrt / half-trace, reference vs. precomputed maps (us) ---\n";
+	std::cout << std::left << std::setw(24) << "modulus" << std::right
+			<< std::setw(10) << "sqrt ref" << std::setw(10) << "sqrt" << std::setw(10) << "H ref"
+			<< std::setw(10) << "H" << std::setw(10) << "init" << "\n";
+
+	for (unsigned long m = 0; m < sizeof(gf2_test_moduli) / sizeof(gf2_test_moduli[0]); ++m) {
+		unsigned long len = gf2_test_moduli[m].bytelen;
+		if (len >= GF2_VECTOR_MAX_BYTELEN)
+			continue;
+		unsigned char modulus[GF2_VECTOR_MAX_BYTELEN];
+		unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char r[GF2_VECTOR_MAX_BYTELEN] = { };
+		gf2_test_load_modulus(m, modulus);
+		ec_test_random_element(a, len, gf2_test_moduli[m].degree);
+
+		auto t0 = std::chrono::steady_clock::now();
+		gf2_linear_maps_init(&gf2_test_maps, modulus, len);
+		auto t1 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_sqrt_lsb(a, r, len, modulus);
+		auto t2 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_sqrt(a, r, &gf2_test_maps);
+		auto t3 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_half_trace_lsb(a, r, len, modulus);
+		auto t4 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_half_trace(a, r, &gf2_test_maps);
+		auto t5 = std::chrono::steady_clock::now();
+
+		std::cout << std::left << std::setw(24) << gf2_test_moduli[m].name << std::right
+				<< std::fixed << std::setprecision(2)
+				<< std::setw(10) << std::chrono::duration<double, std::micro>(t2 - t1).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::micro>(t3 - t2).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::micro>(t4 - t3).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::micro>(t5 - t4).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::micro>(t1 - t0).count() << "\n";
+	}
+}
+
+// Reference for the fused kernels: out = (in1 * in2 + in3 * in4) mod modulus
+static void gf2_test_reference_mac(const unsigned char *in1, const unsigned char *in2,
+		const unsigned char *in3, const unsigned char *in4, unsigned char *out,
+		unsigned long len, const unsigned char *modulus) {
+	unsigned char p1[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+	unsigned char p2[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+	gf2_multiply_lsb(in1, in2, p1, len);
+	gf2_multiply_lsb(in3, in4, p2, len);
+	for (unsigned long i = 0; i < 2 * len; ++i)
+		p1[i] ^= p2[i];
+	gf2_reduce_lsb(p1, 2 * len, modulus, len);
+	for (unsigned long i = 0; i < len; ++i)
+		out[i] = p1[i];
+}
+
+// Every kernel with the word fold (descriptor), the byte-level generic
+// reduction (no descriptor) and, for a middle term too close to the degree
+// for the word fold, the byte-level sparse reduction
+static int gf2_test_field_kernels(const unsigned char *modulus, unsigned long len,
+		long degree, const GF2ReductionDescriptor *desc) {
+	const unsigned char zero[GF2_VECTOR_MAX_BYTELEN] = { };
+	int ok = 1;
+	for (int iter = 0; iter < 100; ++iter) {
+		unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char c[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char d[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char one[GF2_VECTOR_MAX_BYTELEN] = { 1 };
+		unsigned char expected[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char r[GF2_VECTOR_MAX_BYTELEN] = { };
+		ec_test_random_element(a, len, degree);
+		ec_test_random_element(b, len, degree);
+		ec_test_random_element(c, len, degree);
+		ec_test_random_element(d, len, degree);
+		if (iter == 0)      // all ones: longest carries through the fold
+			for (unsigned long i = 0; i < len; ++i)
+				a[i] = b[i] = (unsigned char) ((8 * i + 8 <= (unsigned long) degree) ? 0xFF
+						: (1U << (degree & 7)) - 1U);
+
+		gf2_test_reference_mac(a, b, zero, zero, expected, len, modulus);
+		gf2_field_multiply_lsb(a, b, r, len, modulus, desc);
+		for (unsigned long i = 0; i < len; ++i)
+			ok &= r[i] == expected[i];
+
+		gf2_test_reference_mac(a, a, zero, zero, expected, len, modulus);
+		gf2_field_square_lsb(a, r, len, modulus, desc);
+		for (unsigned long i = 0; i < len; ++i)
+			ok &= r[i] == expected[i];
+
+		gf2_test_reference_mac(a, b, c, one, expected, len, modulus);
+		gf2_field_multiply_add_lsb(a, b, c, r, len, modulus, desc);
+		for (unsigned long i = 0; i < len; ++i)
+			ok &= r[i] == expected[i];
+
+		gf2_test_reference_mac(a, b, c, d, expected, len, modulus);
+		gf2_field_multiply2_add_lsb(a, b, c, d, a, len, modulus, desc);   // out aliases in1
+		for (unsigned long i = 0; i < len; ++i)
+			ok &= a[i] == expected[i];
+	}
+	return ok;
+}
+
+int test_gf2_field_kernels() {
+	int failures = 0;
+	std::cout << "\n--- Testing fused multiply-reduce / multiply-add kernels ---\n";
+
+	for (unsigned long m = 0; m < sizeof(gf2_test_moduli) / sizeof(gf2_test_moduli[0]); ++m) {
+		unsigned long len = gf2_test_moduli[m].bytelen;
+		if (len >= GF2_VECTOR_MAX_BYTELEN)
+			continue;
+		unsigned char modulus[GF2_VECTOR_MAX_BYTELEN];
+		GF2ReductionDescriptor desc;
+		gf2_test_load_modulus(m, modulus);
+		int ok = gf2_reduction_descriptor_init(&desc, modulus, len);
+		ok &= gf2_test_field_kernels(modulus, len, gf2_test_moduli[m].degree, &desc);
+		ok &= gf2_test_field_kernels(modulus, len, gf2_test_moduli[m].degree, 0);
+		std::cout << std::left << std::setw(24) << gf2_test_moduli[m].name
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+
+	// x^163 + x^120 + 1: sparse, but the middle term is too high for the word fold
+	unsigned char modulus[GF2_VECTOR_MAX_BYTELEN] = { };
+	GF2ReductionDescriptor desc;
+	modulus[0] = 1;
+	modulus[120 >> 3] |= 1U << (120 & 7);
+	modulus[163 >> 3] |= 1U << (163 & 7);
+	int ok = gf2_reduction_descriptor_init(&desc, modulus, 21);
+	ok &= gf2_test_field_kernels(modulus, 21, 163, &desc);
+	std::cout << std::left << std::setw(24) << "x^163+x^120+1"
+			<< (ok ? "PASS" : "FAIL") << "\n";
+	failures += !ok;
+	return failures;
+}
+
+// Multiply, reduce and copy out vs. the fused kernels, per operation
+void benchmark_gf2_field_kernels() {
+	const int runs = 2000;
+	std::cout << "\n--- Benchmark: separate vs. fused multiply-reduce (ns) ---\n";
+	std::cout << std::left << std::setw(24) << "modulus" << std::right
+			<< std::setw(10) << "mul+red" << std::setw(10) << "fused" << std::setw(10) << "sqr+red"
+			<< std::setw(10) << "fused" << std::setw(12) << "ab+cd sep" << std::setw(10) << "fused" << "\n";
+
+	for (unsigned long m = 0; m < sizeof(gf2_test_moduli) / sizeof(gf2_test_moduli[0]); ++m) {
+		unsigned long len = gf2_test_moduli[m].bytelen;
+		if (len >= GF2_VECTOR_MAX_BYTELEN)
+			continue;
+		unsigned char modulus[GF2_VECTOR_MAX_BYTELEN];
+		unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char r[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char wide2[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		GF2ReductionDescriptor desc;
+		gf2_test_load_modulus(m, modulus);
+		gf2_reduction_descriptor_init(&desc, modulus, len);
+		ec_test_random_element(a, len, gf2_test_moduli[m].degree);
+		ec_test_random_element(b, len, gf2_test_moduli[m].degree);
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i) {
+			gf2_multiply_lsb(a, b, wide, len);
+			gf2_reduce_sparse_lsb(wide, 2 * len, &desc);
+			for (unsigned long j = 0; j < len; ++j)
+				a[j] = wide[j];
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_field_multiply_lsb(a, b, a, len, modulus, &desc);
+		auto t2 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i) {
+			gf2_square_ct_lsb(a, wide, len);
+			gf2_reduce_sparse_lsb(wide, 2 * len, &desc);
+			for (unsigned long j = 0; j < len; ++j)
+				r[j] = wide[j] ^ b[j];
+			a[0] ^= r[0];
+		}
+		auto t3 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i) {
+			gf2_field_square_lsb(a, r, len, modulus, &desc);
+			a[0] ^= r[0] ^ b[0];
+		}
+		auto t4 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i) {
+			gf2_multiply_lsb(a, b, wide, len);
+			gf2_reduce_sparse_lsb(wide, 2 * len, &desc);
+			gf2_multiply_lsb(b, r, wide2, len);
+			gf2_reduce_sparse_lsb(wide2, 2 * len, &desc);
+			for (unsigned long j = 0; j < len; ++j)
+				r[j] = wide[j] ^ wide2[j];
+		}
+		auto t5 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_field_multiply2_add_lsb(a, b, b, r, r, len, modulus, &desc);
+		auto t6 = std::chrono::steady_clock::now();
+
+		std::cout << std::left << std::setw(24) << gf2_test_moduli[m].name << std::right
+				<< std::fixed << std::setprecision(0)
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t1 - t0).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t2 - t1).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t3 - t2).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t4 - t3).count() / runs
+				<< std::setw(12) << std::chrono::duration<double, std::nano>(t5 - t4).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t6 - t5).count() / runs << "\n";
+	}
+}
+
+// Fixed-operand products against the general kernels: reduced (with and
+// without the word fold) and, for the constant-time comb, the wide product
+int test_gf2_mul_fixed() {
+	int failures = 0;
+	std::cout << "\n--- Testing fixed-operand multiplication (window " << GF2_MUL_FIXED_WINDOW_BITS
+			<< " bits) ---\n";
+
+	for (unsigned long m = 0; m < sizeof(gf2_test_moduli) / sizeof(gf2_test_moduli[0]); ++m) {
+		unsigned long len = gf2_test_moduli[m].bytelen;
+		long degree = gf2_test_moduli[m].degree;
+		if (len >= GF2_VECTOR_MAX_BYTELEN)
+			continue;
+		unsigned char modulus[GF2_VECTOR_MAX_BYTELEN];
+		GF2ReductionDescriptor desc;
+		static GF2FixedOperand fixed;
+		gf2_test_load_modulus(m, modulus);
+		int ok = gf2_reduction_descriptor_init(&desc, modulus, len);
+
+		for (int iter = 0; iter < 100; ++iter) {
+			unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char expected[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char r[GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+			unsigned char wide_ct[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+			ec_test_random_element(a, len, degree);
+			ec_test_random_element(b, len, degree);
+			if (iter == 0)      // all ones: every row and every window in use
+				for (unsigned long i = 0; i < len; ++i)
+					a[i] = b[i] = (unsigned char) ((8 * i + 8 <= (unsigned long) degree) ? 0xFF
+							: (1U << (degree & 7)) - 1U);
+			if (iter == 1 || iter == 2)     // fixed operand 1, then 0
+				for (unsigned long i = 0; i < len; ++i)
+					b[i] = (unsigned char) (iter == 1 && i == 0);
+			if (iter % 10 < 3)
+				gf2_mul_fixed_init(&fixed, b, len);
+			else
+				for (unsigned long i = 0; i < len; ++i)     // keep the previous operand
+					b[i] = (unsigned char) (fixed.window[1][i >> 3] >> (8 * (i & 7)));
+
+			gf2_field_multiply_lsb(a, b, expected, len, modulus, &desc);
+			gf2_mul_fixed(&fixed, a, r, modulus, &desc);
+			for (unsigned long i = 0; i < len; ++i)
+				ok &= r[i] == expected[i];
+			gf2_mul_fixed(&fixed, a, r, modulus, 0);
+			for (unsigned long i = 0; i < len; ++i)
+				ok &= r[i] == expected[i];
+
+			gf2_multiply_lsb(a, b, wide, len);
+			gf2_mul_fixed_ct_lsb(&fixed, a, wide_ct);
+			for (unsigned long i = 0; i < 2 * len; ++i)
+				ok &= wide_ct[i] == wide[i];
+
+			gf2_mul_fixed(&fixed, a, a, modulus, &desc);      // out aliases in
+			for (unsigned long i = 0; i < len; ++i)
+				ok &= a[i] == expected[i];
+		}
+		std::cout << std::left << std::setw(24) << gf2_test_moduli[m].name
+				<< (ok ? "PASS" : "FAIL") << "\n";
+		failures += !ok;
+	}
+	return failures;
+}
+
+// General vs. fixed-operand products, reduced, per operation; the
+// constant-time columns include the sparse reduction
+void benchmark_gf2_mul_fixed() {
+	const int runs = 2000;
+	std::cout << "\n--- Benchmark: general vs. fixed-operand multiply-reduce (ns), window "
+			<< GF2_MUL_FIXED_WINDOW_BITS << " bits ---\n";
+	std::cout << std::left << std::setw(24) << "modulus" << std::right
+			<< std::setw(10) << "general" << std::setw(10) << "fixed" << std::setw(10) << "ct"
+			<< std::setw(10) << "fixed ct" << std::setw(10) << "init" << "\n";
+
+	for (unsigned long m = 0; m < sizeof(gf2_test_moduli) / sizeof(gf2_test_moduli[0]); ++m) {
+		unsigned long len = gf2_test_moduli[m].bytelen;
+		if (len >= GF2_VECTOR_MAX_BYTELEN)
+			continue;
+		unsigned char modulus[GF2_VECTOR_MAX_BYTELEN];
+		unsigned char a[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char b[GF2_VECTOR_MAX_BYTELEN] = { };
+		unsigned char wide[2 * GF2_VECTOR_MAX_BYTELEN] = { };
+		GF2ReductionDescriptor desc;
+		static GF2FixedOperand fixed;
+		gf2_test_load_modulus(m, modulus);
+		gf2_reduction_descriptor_init(&desc, modulus, len);
+		ec_test_random_element(a, len, gf2_test_moduli[m].degree);
+		ec_test_random_element(b, len, gf2_test_moduli[m].degree);
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_field_multiply_lsb(a, b, a, len, modulus, &desc);
+		auto t1 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_mul_fixed_init(&fixed, b, len);
+		auto t2 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i)
+			gf2_mul_fixed(&fixed, a, a, modulus, &desc);
+		auto t3 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i) {
+			gf2_multiply_ct_lsb(a, b, wide, len);
+			gf2_reduce_sparse_lsb(wide, 2 * len, &desc);
+			for (unsigned long j = 0; j < len; ++j)
+				a[j] = wide[j];
+		}
+		auto t4 = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; ++i) {
+			gf2_mul_fixed_ct_lsb(&fixed, a, wide);
+			gf2_reduce_sparse_lsb(wide, 2 * len, &desc);
+			for (unsigned long j = 0; j < len; ++j)
+				a[j] = wide[j];
+		}
+		auto t5 = std::chrono::steady_clock::now();
+
+		std::cout << std::left << std::setw(24) << gf2_test_moduli[m].name << std::right
+				<< std::fixed << std::setprecision(0)
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t1 - t0).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t3 - t2).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t4 - t3).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t5 - t4).count() / runs
+				<< std::setw(10) << std::chrono::duration<double, std::nano>(t2 - t1).count() / runs << "\n";
+	}
+}
@@ -0,0 +1,24 @@
+// libFuzzer target for the differential self-checks
+// (elliptic_curve_differential.h); any failing check aborts the run so that
+// libFuzzer saves the input.
+//
+// Build from the repository root with the library sources of
+// tools/ec_difftest.cpp (README, "Building"):
+//   clang++ -O1 -g -fsanitize=fuzzer,address,undefined -I. tools/ec_fuzz.cpp $SOURCES -o ec_fuzz
+//   ./ec_fuzz -max_len=512 corpus/
+//
+// Byte 1 of an input selects the check groups; point and ECDH checks cost
+// some milliseconds per input, -only_ascii=0 -use_value_profile=1 helps the
+// field checks find carries and reduction edge cases. Saved crashes replay
+// with tools/ec_difftest.cpp (--replay).
+
+#include <cstddef>
+#include <cstdint>
+
+#include "elliptic_curve_differential.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	if (!elliptic_curve_differential_run(data, (unsigned long) size, 0))
+		__builtin_trap();
+	return 0;
+}
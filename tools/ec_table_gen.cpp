@@ -0,0 +1,59 @@
+// Generates a precomputed-table file for the built-in curves.
+//
+//   ec_table_gen <output file> [curve name or OID ...]
+//
+// Without curve arguments every curve in the registry is included. The file
+// is only valid for the build configuration (GF2_VECTOR_MAX_BYTELEN,
+// EC_CONTEXT_COMB_WIDTH, byte order) the generator was compiled with; the
+// loader rejects mismatching files.
+//
+// Build from the repository root with the library sources:
+//   g++ -O2 -I. tools/ec_table_gen.cpp $SOURCES -o ec_table_gen
+// where SOURCES is the core plus the "table files" units of the README's
+// "Building" section (the _posix.cpp one is not needed).
+
+#include <cstdio>
+#include <vector>
+
+#include "elliptic_curve_registry.h"
+#include "elliptic_curve_table_file.h"
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		std::fprintf(stderr, "usage: %s <output file> [curve ...]\n", argv[0]);
+		return 2;
+	}
+
+	std::vector<const EllipticCurve*> curves;
+	if (argc == 2) {
+		for (unsigned long c = 0; c < elliptic_curve_registry_count(); ++c)
+			curves.push_back(elliptic_curve_registry_get(c)->curve);
+	} else {
+		for (int i = 2; i < argc; ++i) {
+			const EllipticCurve *curve = elliptic_curve_registry_find_curve(argv[i]);
+			if (!curve) {
+				std::fprintf(stderr, "unknown curve (or not enabled by GF2_VECTOR_MAX_BYTELEN): %s\n", argv[i]);
+				return 1;
+			}
+			curves.push_back(curve);
+		}
+	}
+
+	unsigned long size = elliptic_curve_table_file_write(curves.data(), curves.size(), 0, 0);
+	std::vector<unsigned long long> image((size + 7) / 8); // 8-byte aligned storage
+	unsigned char *out = (unsigned char*) image.data();
+	if (elliptic_curve_table_file_write(curves.data(), curves.size(), out, size) != size) {
+		std::fprintf(stderr, "failed to build table image\n");
+		return 1;
+	}
+
+	std::FILE *f = std::fopen(argv[1], "wb");
+	if (!f || std::fwrite(out, 1, size, f) != size || std::fclose(f) != 0) {
+		std::fprintf(stderr, "failed to write %s\n", argv[1]);
+		return 1;
+	}
+	for (unsigned long c = 0; c < curves.size(); ++c)
+		std::printf("%s\n", (const char*) curves[c]->curve_name_ascii);
+	std::printf("%lu curves, %lu bytes -> %s\n", (unsigned long) curves.size(), size, argv[1]);
+	return 0;
+}